@@ -5,13 +5,15 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "../../../src/xApp/e2_node_arr_xapp.h"
-#include "../../../src/sm/kpm_sm/kpm_sm_v02.03/ie/kpm_data_ie.h"
+
+// The KPM measurements, per UE, are in the xApp DB (tables KPM_Ind, KPM_UE,
+// KPM_MeasRecord and KPM_MeasType). Only the latencies are stored here
+
 // Initialize the database connection
 bool init_metrics_db(const char* db_path);
 
 // Store metrics in the database
-void store_detailed_metrics(const kpm_ind_data_t* ind,
-                            int64_t latency, // latency in microseconds
+void store_detailed_metrics(int64_t latency, // latency in microseconds
                             int counter,
                             const e2_node_arr_xapp_t* nodes,
                             int64_t measurement_timestamp,
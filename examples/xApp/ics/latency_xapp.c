@@ -226,7 +226,7 @@ static void sm_cb_kpm(sm_ag_if_rd_t const* rd)
     e2_node_arr_xapp_t nodes = e2_nodes_xapp_api();
     print_node_metrics(&nodes, counter, latency, now, time_str);
     // Store detailed metrics in database
-    store_detailed_metrics(&rd->ind.kpm.ind, latency, counter, &nodes, now, time_str);
+    store_detailed_metrics(latency, counter, &nodes, now, time_str);
 
     // Reported list of measurements per UE
     for (size_t i = 0; i < msg_frm_3->ue_meas_report_lst_len; i++) {
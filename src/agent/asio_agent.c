@@ -81,6 +81,18 @@ void init_asio_agent(asio_agent_t* io)
   io->pipe = create_pipe_asio_agent(io);
 }
 
+void free_asio_agent(asio_agent_t* io)
+{
+  assert(io != NULL);
+
+  int rc = close(io->pipe.r);
+  assert(rc == 0);
+  rc = close(io->pipe.w);
+  assert(rc == 0);
+  rc = close(io->efd);
+  assert(rc == 0);
+}
+
 void add_fd_asio_agent(asio_agent_t* io, int fd)
 {
   assert(io != NULL);
@@ -92,6 +104,19 @@ void add_fd_asio_agent(asio_agent_t* io, int fd)
   assert(rc != -1);
 }
 
+// Level triggered. The socket is drained up to a budget per wake up, so it
+// may still be readable when the reactor goes back to epoll_wait
+void add_sock_asio_agent(asio_agent_t* io, int fd)
+{
+  assert(io != NULL);
+  const int op = EPOLL_CTL_ADD;
+  const epoll_data_t e_data = {.fd = fd};
+  const int e_events = EPOLLIN; // open for reading
+  struct epoll_event event = {.events = e_events, .data = e_data};
+  int rc = epoll_ctl(io->efd, op, fd, &event);
+  assert(rc != -1);
+}
+
 void rm_fd_asio_agent(asio_agent_t* io, int fd)
 {
   assert(io != NULL);
@@ -137,13 +162,13 @@ int create_timer_ms_asio_agent(asio_agent_t* io, long initial_ms, long interval_
   return tfd;
 }
 
-int event_asio_agent(asio_agent_t const* io)
+int event_asio_agent(asio_agent_t const* io, int timeout_ms)
 {
   assert(io != NULL);
+  assert(timeout_ms > -1);
 
   const int maxevents = 1;
   struct epoll_event events[maxevents];
-  const int timeout_ms = 1000;
 
   const int events_ready = epoll_wait(io->efd, events, maxevents, timeout_ms);
   if (events_ready < 0) {
@@ -38,13 +38,19 @@ typedef struct{
 
 void init_asio_agent(asio_agent_t* io);
 
+// Closes the epoll fd and the pipe. The rest of the fds are closed by their owners
+void free_asio_agent(asio_agent_t* io);
+
 void add_fd_asio_agent(asio_agent_t* io, int fd);
 
+void add_sock_asio_agent(asio_agent_t* io, int fd);
+
 void rm_fd_asio_agent(asio_agent_t* io, int fd);
 
 int create_timer_ms_asio_agent(asio_agent_t* io, long initial_ms, long interval_ms);
 
-int event_asio_agent(asio_agent_t const* io);
+// -1 if nothing happened within timeout_ms. 0 does not wait
+int event_asio_agent(asio_agent_t const* io, int timeout_ms);
 
 #endif
 
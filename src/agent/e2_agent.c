@@ -61,27 +61,6 @@ static ric_indication_t generate_aindication(e2_agent_t* ag, sm_ind_data_t* data
   return ind;
 }
 
-static ric_indication_t generate_indication(e2_agent_t* ag, sm_ind_data_t* data, ind_event_t* i_ev)
-{
-  assert(ag != NULL);
-  assert(data != NULL);
-  assert(i_ev != NULL);
-
-  ric_indication_t ind = {.ric_id = i_ev->ric_id, .action_id = i_ev->action_id, .sn = NULL, .type = RIC_IND_REPORT};
-
-  ind.hdr.len = data->len_hdr;
-  ind.hdr.buf = data->ind_hdr;
-  ind.msg.len = data->len_msg;
-  ind.msg.buf = data->ind_msg;
-  if (data->call_process_id != NULL) {
-    ind.call_process_id = malloc(sizeof(*ind.call_process_id));
-    assert(ind.call_process_id != NULL && "Memory exhausted");
-    ind.call_process_id->buf = data->call_process_id;
-    ind.call_process_id->len = data->len_cpid;
-  }
-  return ind;
-}
-
 static inline void free_fd(void* key, void* value)
 {
   assert(key != NULL);
@@ -111,6 +90,7 @@ static inline void free_indication_event(e2_agent_t* ag)
   assert(ag != NULL);
   bi_map_free(&ag->ind_event);
   pthread_mutex_destroy(&ag->mtx_ind_event);
+  free_sched_agent(&ag->sched, &ag->io);
 }
 
 static inline void init_pending_events(e2_agent_t* ag)
@@ -131,6 +111,8 @@ static inline void free_ind_event_map(void* key, void* value)
   ind_event_t* ev = (ind_event_t*)value;
   if (ev->sm->free_act_def != NULL)
     ev->sm->free_act_def(ev->sm, ev->act_def);
+  if (ev->ad.len > 0)
+    free_byte_array(ev->ad);
 
   free(ev);
 }
@@ -160,18 +142,8 @@ static inline void init_indication_event(e2_agent_t* ag)
 #endif
   int rc = pthread_mutex_init(&ag->mtx_ind_event, &attr);
   assert(rc == 0);
-}
-
-static inline void* ind_fd(e2_agent_t* ag, int fd)
-{
-  assert(ag != NULL);
-  assert(fd > 0);
 
-  void* start_it = assoc_front(&ag->ind_event.left);
-  void* end_it = assoc_end(&ag->ind_event.left);
-
-  void* it = find_if(&ag->ind_event.left, start_it, end_it, &fd, eq_fd);
-  return it;
+  init_sched_agent(&ag->sched, &ag->io);
 }
 
 static inline bool net_pkt(const e2_agent_t* ag, int fd)
@@ -181,18 +153,6 @@ static inline bool net_pkt(const e2_agent_t* ag, int fd)
   return fd == ag->ep.base.fd;
 }
 
-static inline bool ind_event(e2_agent_t* ag, int fd, ind_event_t** i_ev)
-{
-  assert(*i_ev == NULL);
-  void* it = ind_fd(ag, fd);
-  void* end_it = assoc_end(&ag->ind_event.left); // bi_map_end_left(&ag->ind_event);
-  if (it != end_it) {
-    *i_ev = assoc_value(&ag->ind_event.left, it);
-    return true;
-  }
-  return false;
-}
-
 static inline bool aind_event(e2_agent_t* ag, int fd, arr_aind_event_t* dst)
 {
   if (fd != ag->io.pipe.r)
@@ -224,15 +184,8 @@ static inline bool pend_event(e2_agent_t* ag, int fd, pending_event_t** p_ev)
     return false;
   }
 
-  void* start_it = assoc_front(&ag->pending.left);
   void* end_it = assoc_end(&ag->pending.left);
-
-  if (!start_it || !end_it) {
-    printf("[E2-AGENT]: Invalid pending event iterators\n");
-    return false;
-  }
-
-  void* it = find_if(&ag->pending.left, start_it, end_it, &fd, eq_fd);
+  void* it = assoc_find(&ag->pending.left, &fd);
 
   if (it == end_it) {
     printf("[E2-AGENT]: No matching pending event found for fd %d\n", fd);
@@ -261,11 +214,11 @@ static int consume_fd_async(int fd)
   return bytes;
 }
 
-static async_event_t next_async_event_agent(e2_agent_t* ag)
+static async_event_t next_async_event_agent(e2_agent_t* ag, int timeout_ms)
 {
   assert(ag != NULL);
 
-  int const fd = event_asio_agent(&ag->io);
+  int const fd = event_asio_agent(&ag->io, timeout_ms);
 
   async_event_t e = {.type = UNKNOWN_EVENT, .fd = fd};
 
@@ -273,22 +226,14 @@ static async_event_t next_async_event_agent(e2_agent_t* ag)
     e.type = CHECK_STOP_TOKEN_EVENT;
 
   } else if (net_pkt(ag, fd) == true) {
-    e.msg = e2ap_recv_msg_agent(&ag->ep);
-    if (e.msg.type == SCTP_MSG_NOTIFICATION) {
-      e.type = SCTP_CONNECTION_SHUTDOWN_EVENT;
-      printf("[E2-AGENT]: SCTP Connection shutdown detected\n");
-
-    } else if (e.msg.type == SCTP_MSG_PAYLOAD) {
-      e.type = SCTP_MSG_ARRIVED_EVENT;
-
-    } else {
-      assert(0 != 0 && "Unknown type");
-    }
+    // Drain the socket. One epoll round trip for up to rx_batch messages
+    e.msgs = e2ap_recv_msgs_agent(&ag->ep, ag->rx_batch);
+    e.type = SCTP_MSG_BATCH_ARRIVED_EVENT;
 
   } else if (aind_event(ag, fd, &e.ai_ev) == true) {
     e.type = APERIODIC_INDICATION_EVENT;
 
-  } else if (ind_event(ag, fd, &e.i_ev) == true) {
+  } else if (tick_fd_sched_agent(&ag->sched, fd) == true) {
     e.type = INDICATION_EVENT;
 
   } else if (pend_event(ag, fd, &e.p_ev) == true) {
@@ -534,6 +479,57 @@ static void handle_pending_event(e2_agent_t* ag)
   consume_fd_sync(new_timer);
 }
 
+static exp_ind_data_t read_ind_event(void const* arg)
+{
+  ind_event_t const* i_ev = (ind_event_t const*)arg;
+  return i_ev->sm->proc.on_indication(i_ev->sm, i_ev->act_def);
+}
+
+// Scheduler callback. Reads the RAN, or takes the read of another RIC's
+// agent for the same tick, and sends the indication of the subscription id
+static void send_periodic_indication(int id, int64_t period_ms, uint64_t due, void* arg)
+{
+  e2_agent_t* ag = (e2_agent_t*)arg;
+  assert(ag != NULL);
+
+  // Only the reactor modifies the map, no need to lock
+  void* it = assoc_find(&ag->ind_event.left, &id);
+  assert(it != assoc_end(&ag->ind_event.left) && "Scheduler and indication events out of sync");
+  ind_event_t* i_ev = assoc_value(&ag->ind_event.left, it);
+
+  ind_shared_agent_t* shared = NULL;
+  if (ag->ind_cache != NULL) {
+    ind_cache_key_t const k = {.ran_func_id = i_ev->ric_id.ran_func_id, .period_ms = period_ms, .ad = i_ev->ad};
+    shared = get_ind_cache_agent(ag->ind_cache, &k, due, read_ind_event, i_ev);
+  } else {
+    shared = read_ind_shared_agent(read_ind_event, i_ev);
+  }
+
+  // Condition not matched e.g., No UE matches condition
+  if (shared == NULL) {
+    printf(
+        "[E2 AGENT]: Condition not matched e.g., No UE matches condition. Emulator triggers this condition for testing, "
+        "but "
+        "not the RAN \n");
+    return;
+  }
+  defer({ release_ind_shared_agent(shared); });
+
+  // Only the E2AP part is built per RIC. The SM bytes are borrowed
+  sm_ind_data_t const* data = &shared->data;
+  ric_indication_t ind = {.ric_id = i_ev->ric_id, .action_id = i_ev->action_id, .sn = NULL, .type = RIC_IND_REPORT};
+  ind.hdr = (byte_array_t){.buf = data->ind_hdr, .len = data->len_hdr};
+  ind.msg = (byte_array_t){.buf = data->ind_msg, .len = data->len_msg};
+  byte_array_t cpid = {.buf = data->call_process_id, .len = data->len_cpid};
+  if (data->call_process_id != NULL)
+    ind.call_process_id = &cpid;
+
+  byte_array_t ba = e2ap_enc_indication_ag(&ag->ap, &ind);
+  defer({ free_byte_array(ba); });
+
+  e2ap_send_bytes_agent(&ag->ep, ba);
+}
+
 static void handle_connection_shutdown(e2_agent_t* ag)
 {
   assert(ag != NULL);
@@ -568,176 +564,178 @@ static void handle_connection_shutdown(e2_agent_t* ag)
   pthread_mutex_unlock(&ag->mtx_pending);
 }
 
-static void e2_event_loop_agent(e2_agent_t* ag)
+static void handle_sctp_msg_agent(e2_agent_t* ag, sctp_msg_t const* sctp_msg)
 {
   assert(ag != NULL);
-  while (ag->stop_token == false) {
-    async_event_t e = next_async_event_agent(ag);
-    assert(e.type != UNKNOWN_EVENT && "Unknown event triggered ");
+  assert(sctp_msg != NULL);
 
-    switch (e.type) {
-      case SCTP_MSG_ARRIVED_EVENT: {
-        defer({ free_sctp_msg(&e.msg); });
+  e2ap_msg_t msg = e2ap_msg_dec_ag(&ag->ap, sctp_msg->ba);
+  defer({ e2ap_msg_free_ag(&ag->ap, &msg); });
 
-        e2ap_msg_t msg = e2ap_msg_dec_ag(&ag->ap, e.msg.ba);
-        defer({ e2ap_msg_free_ag(&ag->ap, &msg); });
+  e2ap_msg_t ans = e2ap_msg_handle_agent(ag, &msg);
+  defer({ e2ap_msg_free_ag(&ag->ap, &ans); });
 
-        e2ap_msg_t ans = e2ap_msg_handle_agent(ag, &msg);
-        defer({ e2ap_msg_free_ag(&ag->ap, &ans); });
+  if (ans.type != NONE_E2_MSG_TYPE) {
+    byte_array_t ba_ans = e2ap_msg_enc_ag(&ag->ap, &ans);
+    defer({ free_byte_array(ba_ans); });
 
-        if (ans.type != NONE_E2_MSG_TYPE) {
-          byte_array_t ba_ans = e2ap_msg_enc_ag(&ag->ap, &ans);
-          defer({ free_byte_array(ba_ans); });
+    e2ap_send_bytes_agent(&ag->ep, ba_ans);
+  }
+}
 
-          e2ap_send_bytes_agent(&ag->ep, ba_ans);
+static void handle_async_event_agent(e2_agent_t* ag, async_event_t e)
+{
+  assert(ag != NULL);
+  assert(e.type != UNKNOWN_EVENT && "Unknown event triggered ");
+
+  switch (e.type) {
+    case SCTP_MSG_BATCH_ARRIVED_EVENT: {
+      defer({ free_sctp_msg_arr(&e.msgs); });
+
+      for (size_t i = 0; i < e.msgs.len; ++i) {
+        if (e.msgs.msg[i].type == SCTP_MSG_PAYLOAD) {
+          handle_sctp_msg_agent(ag, &e.msgs.msg[i]);
+        } else {
+          // A notification is always the last message of the batch
+          printf("[E2-AGENT]: SCTP Connection shutdown detected\n");
+          printf("[E2-AGENT]: Communication with the nearRT-RIC lost\n");
+          handle_connection_shutdown(ag);
         }
-
-        break;
       }
-      case APERIODIC_INDICATION_EVENT: {
-        arr_aind_event_t* aind = &e.ai_ev;
-        assert(aind->len > 0 && aind->arr != NULL);
-        defer({ free(aind->arr); });
-        for (size_t i = 0; i < aind->len; ++i) {
-          sm_agent_t const* sm = aind->arr[i].sm;
-          sm_ind_data_t* ind_data = aind->arr[i].ind_data;
-
-          if (sm == NULL) {
-            printf("Error: sm (Service Model) pointer is NULL\n");
-            return; // Return empty structure
-          }
-
-          if (sm->proc.on_indication == NULL) {
-            printf("Error: on_indication callback is not initialized\n");
-            return;
-          }
-
-          if (ind_data == NULL) {
-            printf("Error: indication data is NULL\n");
-            return;
-          }
-
-          // Add debug prints for Surrey HiperRAN
-
-          // LOG_SURREY("e2_event_loop_agent: SM ID: %d\n", sm->info.id());
-          // LOG_SURREY("e2_event_loop_agent: SM Agent pointer @: %p\n", (void*)sm);
-          // LOG_SURREY("e2_event_loop_agent: ind_data pointer @: %p\n", (void*)ind_data);
-
-          // print_sm_ind_data(ind_data, "Before");
-          exp_ind_data_t exp = sm->proc.on_indication(sm, ind_data); // , &e.i_ev->ric_id);
-                                                                     // Add handover info print here
-
-          // Print the results
-          // After this function the handover payload information is integrated
-          print_exp_indication_data(&exp, "After");
-
-          // Condition not matched e.g., No UE matches condition
-          if (exp.has_value == false) {
-            int rc = consume_fd_async(ag->io.pipe.r);
-            assert(rc != 1 && "No bytes in the pipe but message in the queue! ");
-            continue;
-          }
+      break;
+    }
+    case APERIODIC_INDICATION_EVENT: {
+      arr_aind_event_t* aind = &e.ai_ev;
+      assert(aind->len > 0 && aind->arr != NULL);
+      defer({ free(aind->arr); });
+      for (size_t i = 0; i < aind->len; ++i) {
+        sm_agent_t const* sm = aind->arr[i].sm;
+        sm_ind_data_t* ind_data = aind->arr[i].ind_data;
+
+        if (sm == NULL) {
+          printf("Error: sm (Service Model) pointer is NULL\n");
+          return; // Return empty structure
+        }
 
-          ric_indication_t ind = generate_aindication(ag, &exp.data, &aind->arr[i]);
-          defer({ e2ap_free_indication(&ind); });
+        if (sm->proc.on_indication == NULL) {
+          printf("Error: on_indication callback is not initialized\n");
+          return;
+        }
 
-          // print_indication_content(&ind);
+        if (ind_data == NULL) {
+          printf("Error: indication data is NULL\n");
+          return;
+        }
 
-          byte_array_t ba = e2ap_enc_indication_ag(&ag->ap, &ind);
+        // Add debug prints for Surrey HiperRAN
 
-          defer({ free_byte_array(ba); });
+        // LOG_SURREY("e2_event_loop_agent: SM ID: %d\n", sm->info.id());
+        // LOG_SURREY("e2_event_loop_agent: SM Agent pointer @: %p\n", (void*)sm);
+        // LOG_SURREY("e2_event_loop_agent: ind_data pointer @: %p\n", (void*)ind_data);
 
-          e2ap_send_bytes_agent(&ag->ep, ba);
+        // print_sm_ind_data(ind_data, "Before");
+        exp_ind_data_t exp = sm->proc.on_indication(sm, ind_data); // , &e.i_ev->ric_id);
+                                                                   // Add handover info print here
 
-          int rc = consume_fd_async(ag->io.pipe.r);
-          assert(rc != 1 && "No bytes in the pipe but message in the queue! ");
+        // Print the results
+        // After this function the handover payload information is integrated
+        print_exp_indication_data(&exp, "After");
 
-          exit(0);
-        }
-        break;
-      }
-      case INDICATION_EVENT: {
-        sm_agent_t const* sm = e.i_ev->sm;
-        void* act_def = e.i_ev->act_def;
-        exp_ind_data_t exp = sm->proc.on_indication(sm, act_def); // , &e.i_ev->ric_id);
         // Condition not matched e.g., No UE matches condition
         if (exp.has_value == false) {
-          printf(
-              "[E2 AGENT]: Condition not matched e.g., No UE matches condition. Emulator triggers this condition for testing, "
-              "but "
-              "not the RAN \n");
-          consume_fd_sync(e.fd);
-          break;
+          int rc = consume_fd_async(ag->io.pipe.r);
+          assert(rc != 1 && "No bytes in the pipe but message in the queue! ");
+          continue;
         }
-        ric_indication_t ind = generate_indication(ag, &exp.data, e.i_ev);
+
+        ric_indication_t ind = generate_aindication(ag, &exp.data, &aind->arr[i]);
         defer({ e2ap_free_indication(&ind); });
 
+        // print_indication_content(&ind);
+
         byte_array_t ba = e2ap_enc_indication_ag(&ag->ap, &ind);
+
         defer({ free_byte_array(ba); });
 
         e2ap_send_bytes_agent(&ag->ep, ba);
 
-        consume_fd_sync(e.fd);
+        int rc = consume_fd_async(ag->io.pipe.r);
+        assert(rc != 1 && "No bytes in the pipe but message in the queue! ");
 
-        break;
+        exit(0);
       }
-      case PENDING_EVENT: {
-        if (!ag || !e.p_ev || e.fd <= 0) {
-          if (e.fd > 0)
-            close(e.fd);
-          // consume_fd_sync(e.fd);
-          break;
-        }
-        // Clean up the current timer
-        close(e.fd);
-        handle_pending_event(ag);
+      break;
+    }
+    case INDICATION_EVENT: {
+      // All the periodic subscriptions due on this tick
+      tick_sched_agent(&ag->sched, send_periodic_indication, ag);
+      break;
+    }
+    case PENDING_EVENT: {
+      if (!ag || !e.p_ev || e.fd <= 0) {
+        if (e.fd > 0)
+          close(e.fd);
+        // consume_fd_sync(e.fd);
         break;
       }
-      case SCTP_CONNECTION_SHUTDOWN_EVENT: {
-        // First check if agent is valid
-        if (!ag) {
-          printf("[E2-AGENT]: Warning - Invalid agent during shutdown\n");
-          break;
-        }
-
-        printf("[E2-AGENT]: Communication with the nearRT-RIC lost\n");
+      // Clean up the current timer
+      close(e.fd);
+      handle_pending_event(ag);
+      break;
+    }
+    case CHECK_STOP_TOKEN_EVENT: {
+      break;
+    }
+    default: {
+      assert(0 != 0 && "Unknown event happened");
+      if (ag->connection_state == DISCONNECTED) {
+        // If disconnected, create new pending event
         handle_connection_shutdown(ag);
-        // Handle notification and free message
-        if (&e.msg) {
-          // notification_handle_ag(ag, &e.msg);
-          free_sctp_msg(&e.msg);
-        }
-
-        break;
-      }
-      case CHECK_STOP_TOKEN_EVENT: {
-        break;
-      }
-      default: {
-        assert(0 != 0 && "Unknown event happened");
-        if (ag->connection_state == DISCONNECTED) {
-          // If disconnected, create new pending event
-          handle_connection_shutdown(ag);
-        }
-        break;
       }
+      break;
     }
   }
+}
+
+static void e2_event_loop_agent(e2_agent_t* ag)
+{
+  assert(ag != NULL);
+  while (ag->stop_token == false) {
+    async_event_t e = next_async_event_agent(ag, 1000);
+    handle_async_event_agent(ag, e);
+  }
 
   printf("ag->agent_stopped = true \n");
   ag->agent_stopped = true;
 }
 
+size_t e2_poll_agent(e2_agent_t* ag, size_t budget)
+{
+  assert(ag != NULL);
+  assert(budget > 0);
+
+  size_t i = 0;
+  for (; i < budget && ag->stop_token == false; ++i) {
+    async_event_t e = next_async_event_agent(ag, 0);
+    if (e.type == CHECK_STOP_TOKEN_EVENT)
+      break;
+    handle_async_event_agent(ag, e);
+  }
+  return i;
+}
+
 e2_agent_t* e2_init_agent(const char* addr,
                           int port,
                           global_e2_node_id_t ge2nid,
                           sm_io_ag_ran_t io,
                           char const* libs_dir,
-                          e2_agent_args_t* args)
+                          e2_agent_args_t* args,
+                          size_t rx_batch)
 {
   assert(addr != NULL);
   assert(port > 0 && port < 65535);
   assert(args != NULL);
+  assert(rx_batch > 0);
 
   printf("[E2 AGENT]: Initializing ... \n");
 
@@ -769,7 +767,9 @@ e2_agent_t* e2_init_agent(const char* addr,
 
   init_asio_agent(&ag->io);
 
-  add_fd_asio_agent(&ag->io, ag->ep.base.fd);
+  add_sock_asio_agent(&ag->io, ag->ep.base.fd);
+
+  ag->rx_batch = rx_batch;
 
   init_ap(&ag->ap.base.type);
 
@@ -799,40 +799,32 @@ e2_agent_t* e2_init_agent(const char* addr,
   return ag;
 }
 
-void e2_start_agent(e2_agent_t* ag)
+bool e2_prepare_agent(e2_agent_t* ag)
 {
   assert(ag != NULL);
 
   // Validate initial state
   if (!ag->ep.base.addr) {
     printf("[E2-AGENT]: Invalid RIC address\n");
-    return;
+    return false;
   }
 
   // Store initial RIC address
+  free((void*)ag->init_ric_addr);
   ag->init_ric_addr = strdup(ag->ep.base.addr);
   if (!ag->init_ric_addr) {
     printf("[E2-AGENT]: Memory allocation failed\n");
-    return;
+    return false;
   }
 
   // Set initial connection state
   ag->connection_state = DISCONNECTED;
 
-  // Initialize mutex
-  if (pthread_mutex_init(&ag->mtx_pending, NULL) != 0) {
-    printf("[E2-AGENT]: Mutex initialization failed\n");
-    free((void*)ag->init_ric_addr);
-    ag->init_ric_addr = NULL;
-    return;
-  }
-
+  // mtx_pending and pending were initialized by e2_init_agent
   pthread_mutex_lock(&ag->mtx_pending);
 
-  // Initialize pending events
-  if (bi_map_size(&ag->pending) > 0) {
-    bi_map_free(&ag->pending);
-  }
+  // Start from an empty set of pending events
+  free_pending_agent(ag);
   init_pending_events(ag);
 
   // Create initial timer
@@ -840,10 +832,9 @@ void e2_start_agent(e2_agent_t* ag)
   if (fd_timer < 0) {
     printf("[E2-AGENT]: Timer creation failed\n");
     pthread_mutex_unlock(&ag->mtx_pending);
-    pthread_mutex_destroy(&ag->mtx_pending);
     free((void*)ag->init_ric_addr);
     ag->init_ric_addr = NULL;
-    return;
+    return false;
   }
 
   // Set up initial pending event
@@ -869,65 +860,62 @@ void e2_start_agent(e2_agent_t* ag)
   free_byte_array(ba);
   e2ap_free_setup_request(&sr);
 
+  return true;
+}
+
+void e2_start_agent(e2_agent_t* ag)
+{
+  assert(ag != NULL);
+
+  if (e2_prepare_agent(ag) == false) {
+    ag->agent_stopped = true;
+    return;
+  }
+
   // Start event loop
   e2_event_loop_agent(ag);
 }
 
-void e2_free_agent(e2_agent_t* ag)
+static void free_args_agent(e2_agent_args_t* args)
 {
-  if (ag == NULL)
+  if (args == NULL)
     return;
 
-  // Free args structure
-  if (ag->args) {
-    if (ag->args->client_ip) {
-      free((void*)ag->args->client_ip); // Cast away const
-    }
-    if (ag->args->sm_dir) {
-      free((void*)ag->args->sm_dir); // Cast away const
-    }
-    free(ag->args);
-    // Add cleanup for ric_ip_addresses
-    if (ag->args->ric_ip_list.ric_ip_addresses[0] != NULL) {
-      free(ag->args->ric_ip_list.ric_ip_addresses[0]);
-      ag->args->ric_ip_list.ric_ip_addresses[0] = NULL;
-    }
-
-    // Clean up RIC connections
-    for (int i = 0; i < ag->num_rics; i++) {
-      free(ag->ric_connections[i].ric_addr);
-      pthread_mutex_destroy(&ag->ric_connections[i].mtx);
-    }
-    free(ag->ric_connections);
-  }
-  if (ag->init_ric_addr) {
-    free((void*)ag->init_ric_addr);
-    ag->init_ric_addr = NULL;
-  }
+  free((void*)args->client_ip);
+  free((void*)args->sm_dir);
+  for (int i = 0; i < args->ric_ip_list.num_ric_addresses; ++i)
+    free(args->ric_ip_list.ric_ip_addresses[i]);
+  free(args);
+}
 
-  // Free endpoint address
-  if (ag->ep.base.addr) {
-    free((void*)ag->ep.base.addr);
-  }
+void e2_free_agent(e2_agent_t* ag)
+{
+  if (ag == NULL)
+    return;
 
+  // Its event loop, or the reactor serving it, must be done with the agent
+  // before anything is freed
   ag->stop_token = true;
   while (ag->agent_stopped == false) {
     usleep(1000);
   }
-  pthread_mutex_lock(&ag->mtx_pending);
-  // Clear all pending events at shutdown
-  if (bi_map_size(&ag->pending) > 0) {
-    bi_map_free(&ag->pending);
+
+  free_args_agent(ag->args);
+
+  for (int i = 0; i < ag->num_rics; i++) {
+    free(ag->ric_connections[i].ric_addr);
+    pthread_mutex_destroy(&ag->ric_connections[i].mtx);
   }
-  pthread_mutex_unlock(&ag->mtx_pending);
+  free(ag->ric_connections);
+
+  free((void*)ag->init_ric_addr);
 
-  // Destroy mutex
+  // Clear all pending events at shutdown
+  free_pending_agent(ag);
   pthread_mutex_destroy(&ag->mtx_pending);
 
   free_plugin_ag(&ag->plugin);
 
-  free_pending_agent(ag);
-
   free_indication_event(ag);
 
   free_tsq(&ag->aind, NULL);
@@ -936,9 +924,17 @@ void e2_free_agent(e2_agent_t* ag)
 
   e2ap_free_ep_agent(&ag->ep);
 
+  free_asio_agent(&ag->io);
+
   free(ag);
 }
 
+sched_stats_agent_t e2_sched_stats_agent(e2_agent_t* ag)
+{
+  assert(ag != NULL);
+  return stats_sched_agent(&ag->sched);
+}
+
 void e2_async_event_agent(e2_agent_t* ag, uint32_t ric_req_id, void* ind_data)
 {
   assert(ag != NULL);
@@ -32,7 +32,9 @@
 #include "asio_agent.h"
 #include "e2ap_agent.h"
 #include "endpoint_agent.h"
+#include "ind_cache_agent.h"
 #include "plugin_agent.h"
+#include "sched_agent.h"
 #include "sm/sm_io.h"
 
 #include "../../../e2_agent_arg.h"
@@ -67,6 +69,8 @@ typedef struct e2_agent_s {
   e2ap_ep_ag_t ep;
   e2ap_agent_t ap;
   asio_agent_t io;
+  // Max. SCTP messages drained per reactor wake up
+  size_t rx_batch;
 
   size_t sz_handle_msg;
   handle_msg_fp_agent handle_msg[NUM_HANDLE_MSG]; // 26 E2AP + 4 E42AP note that not all the slots will be occupied
@@ -84,7 +88,12 @@ typedef struct e2_agent_s {
 
   // Registered Periodic Indication events
   pthread_mutex_t mtx_ind_event;
-  bi_map_t ind_event; // key1:int fd, key2:ind_event_t
+  bi_map_t ind_event; // key1:int scheduler id (0 if aperiodic), key2:ind_event_t
+  // Drives all the periodic subscriptions from a single timerfd
+  sched_agent_t sched;
+  // RAN reads shared with the agents of the other RICs. Not owned, NULL if
+  // the agent reads alone
+  ind_cache_agent_t* ind_cache;
 
   // Pending events
   bi_map_t pending; // left: fd, right: pending_event_t
@@ -104,20 +113,33 @@ typedef struct e2_agent_s {
   atomic_bool agent_stopped;
 } e2_agent_t;
 
+// args and its strings are heap allocated, and owned by the agent from now on
 e2_agent_t* e2_init_agent(const char* addr,
                           int port,
                           global_e2_node_id_t ge2nid,
                           sm_io_ag_ran_t io,
                           char const* libs_dir,
-                          e2_agent_args_t* args);
+                          e2_agent_args_t* args,
+                          size_t rx_batch);
 
-// Blocking call
+// Blocking call. e2_prepare_agent() and the event loop
 void e2_start_agent(e2_agent_t* ag);
 
+// Sends the E2 SETUP REQUEST and arms its retry timer, without running the
+// event loop. For agents served by a shared reactor
+bool e2_prepare_agent(e2_agent_t* ag);
+
+// Serves up to budget of the events already pending in ag->io.efd, without
+// waiting. Returns the number served
+size_t e2_poll_agent(e2_agent_t* ag, size_t budget);
+
+// Waits for its event loop to stop, or for rm_reactor_agent(), first
 void e2_free_agent(e2_agent_t* ag);
 
 void e2_async_event_agent(e2_agent_t* ag, uint32_t ric_req_id, void* ind_data);
 
+sched_stats_agent_t e2_sched_stats_agent(e2_agent_t* ag);
+
 ///////////////////////////////////////////////
 // E2AP AGENT FUNCTIONAL PROCEDURES MESSAGES //
 ///////////////////////////////////////////////
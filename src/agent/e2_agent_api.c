@@ -27,6 +27,7 @@
 #include <stdio.h> // for NULL
 #include "e2_agent.h" // for e2_free_agent
 #include "plugin_agent.h"
+#include "reactor_agent.h"
 #include "lib/e2ap/e2ap_global_node_id_wrapper.h" // for global_e2_...
 #include "lib/e2ap/e2ap_plmn_wrapper.h" // for plmn_t
 #include "util/ngran_types.h" // for ngran_gNB
@@ -43,8 +44,6 @@
 
 #include "../../../RAN_FUNCTION/surrey_log.h"
 
-#define MAC_NEAR_RT_RICS 20
-
 e2_agent_t* agent = NULL;
 
 // static pthread_t thrd_agent;
@@ -55,22 +54,32 @@ struct ric_instance_s {
   pthread_t thread;
   bool active;
   char* ric_ip;
+  // Shared event loop serving the agent. NULL if the agent runs its own thread
+  reactor_agent_t* reactor;
 };
 
-// Global variables to manage multiple agents
-// not static accessible from other c files as extern
-static struct ric_instance_s agents[MAC_NEAR_RT_RICS] = {0};
+// Global variables to manage multiple agents. The instances are allocated
+// one by one, so that their address stays put while the table grows
+static struct ric_instance_s** agents = NULL;
 static int num_active_agents = 0;
+static int cap_agents = 0;
 static pthread_mutex_t agents_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// E2_AGENT_REACTORS shared event loops. None if the agents run one thread each
+static reactor_agent_t* reactors = NULL;
+static size_t num_reactors = 0;
+static bool reactors_init = false;
+
+// RAN reads shared by the agents of all the RICs
+static ind_cache_agent_t ind_cache;
+static bool ind_cache_init = false;
+
 // Thread function that starts an E2 agent
 static inline void* static_start_agent(void* arg)
 {
   agent_instance_t* instance = (agent_instance_t*)arg;
   if (instance && instance->agent) {
-    instance->active = true;
     e2_start_agent(instance->agent);
-    instance->active = false;
   }
   return NULL;
 }
@@ -85,11 +94,55 @@ static inline void* static_start_agent(void* arg)
 // Add getter functions
 agent_instance_t* get_agent_instance(int index)
 {
-  if (index >= 0 && index < MAC_NEAR_RT_RICS) {
-    return &agents[index];
+  if (index >= 0 && index < num_active_agents) {
+    return agents[index];
   }
   return NULL;
 }
+
+static void push_back_agents(struct ric_instance_s* instance)
+{
+  if (num_active_agents == cap_agents) {
+    cap_agents = cap_agents == 0 ? 4 : 2 * cap_agents;
+    agents = realloc(agents, cap_agents * sizeof(agents[0]));
+    assert(agents != NULL && "Memory exhausted");
+  }
+  agents[num_active_agents++] = instance;
+}
+
+static reactor_agent_t* least_loaded_reactor(void)
+{
+  assert(num_reactors > 0);
+
+  reactor_agent_t* r = &reactors[0];
+  size_t sz = size_reactor_agent(r);
+  for (size_t i = 1; i < num_reactors; ++i) {
+    size_t const tmp = size_reactor_agent(&reactors[i]);
+    if (tmp < sz) {
+      sz = tmp;
+      r = &reactors[i];
+    }
+  }
+  return r;
+}
+
+static void free_instance(struct ric_instance_s* instance)
+{
+  if (instance->active) {
+    // Neither the reactor nor the agent thread may touch the agent once it is freed
+    if (instance->reactor != NULL) {
+      rm_reactor_agent(instance->reactor, instance->agent);
+    } else {
+      instance->agent->stop_token = true;
+      int rc = pthread_join(instance->thread, NULL);
+      assert(rc == 0);
+    }
+    e2_free_agent(instance->agent);
+    instance->active = false;
+  }
+  free(instance->ric_ip);
+  free(instance);
+}
 // Implementation of plugin wrapper functions
 // bool init_plugin_mutex(plugin_wrapper_t* plugin)
 // {
@@ -333,13 +386,6 @@ void init_agent_api(int mcc,
 
   pthread_mutex_lock(&agents_mutex);
 
-  // Check if maximum agents limit reached
-  if (num_active_agents >= MAC_NEAR_RT_RICS) {
-    printf("[E2 AGENT]: Maximum number of agents (%d) reached\n", MAC_NEAR_RT_RICS);
-    pthread_mutex_unlock(&agents_mutex);
-    return;
-  }
-
   // Get RIC IP address
   char* server_ip_str = get_near_ric_ip(args);
   if (!server_ip_str) {
@@ -350,7 +396,7 @@ void init_agent_api(int mcc,
 
   // Check if agent already exists for this IP
   for (int i = 0; i < num_active_agents; i++) {
-    if (agents[i].active && agents[i].ric_ip && strcmp(agents[i].ric_ip, server_ip_str) == 0) {
+    if (agents[i]->active && agents[i]->ric_ip && strcmp(agents[i]->ric_ip, server_ip_str) == 0) {
       printf("[E2 AGENT]: Agent already exists for RIC IP %s\n", server_ip_str);
       free(server_ip_str);
       pthread_mutex_unlock(&agents_mutex);
@@ -363,33 +409,36 @@ void init_agent_api(int mcc,
 
   const int e2ap_server_port = 36421;
 
-  // Create and initialize e2_agent_args_t
-  e2_agent_args_t agent_args = {0}; // Zero initialize first
+  // Create and initialize e2_agent_args_t. The agent owns it once created
+  e2_agent_args_t* agent_args = calloc(1, sizeof(e2_agent_args_t));
+  assert(agent_args != NULL && "Memory exhausted");
 
   // Allocate memory for RIC IP address
-  agent_args.ric_ip_list.ric_ip_addresses[0] = (char*)malloc(MAX_RIC_IP_LENGTH);
-  if (agent_args.ric_ip_list.ric_ip_addresses[0] == NULL) {
+  agent_args->ric_ip_list.ric_ip_addresses[0] = (char*)malloc(MAX_RIC_IP_LENGTH);
+  if (agent_args->ric_ip_list.ric_ip_addresses[0] == NULL) {
     printf("[E2 AGENT]: Failed to allocate memory for RIC IP address\n");
+    free(agent_args);
     free(server_ip_str);
     pthread_mutex_unlock(&agents_mutex);
     return;
   }
 
   // Initialize other fields
-  agent_args.ric_ip_list.num_ric_addresses = 1;
-  agent_args.client_ip = args->client_ip ? strdup(args->client_ip) : NULL;
-  agent_args.sm_dir = args->libs_dir ? strdup(args->libs_dir) : NULL;
-  agent_args.enabled = true;
+  agent_args->ric_ip_list.num_ric_addresses = 1;
+  agent_args->client_ip = args->client_ip ? strdup(args->client_ip) : NULL;
+  agent_args->sm_dir = args->libs_dir ? strdup(args->libs_dir) : NULL;
+  agent_args->enabled = true;
 
   // Safely copy the RIC IP address
   if (strlen(server_ip_str) < MAX_RIC_IP_LENGTH) {
-    strncpy(agent_args.ric_ip_list.ric_ip_addresses[0], server_ip_str, MAX_RIC_IP_LENGTH - 1);
-    agent_args.ric_ip_list.ric_ip_addresses[0][MAX_RIC_IP_LENGTH - 1] = '\0';
+    strncpy(agent_args->ric_ip_list.ric_ip_addresses[0], server_ip_str, MAX_RIC_IP_LENGTH - 1);
+    agent_args->ric_ip_list.ric_ip_addresses[0][MAX_RIC_IP_LENGTH - 1] = '\0';
   } else {
     printf("[E2 AGENT]: RIC IP address too long (max length is %d)\n", MAX_RIC_IP_LENGTH - 1);
-    free(agent_args.ric_ip_list.ric_ip_addresses[0]);
-    free(agent_args.client_ip);
-    free(agent_args.sm_dir);
+    free(agent_args->ric_ip_list.ric_ip_addresses[0]);
+    free((void*)agent_args->client_ip);
+    free((void*)agent_args->sm_dir);
+    free(agent_args);
     free(server_ip_str);
     pthread_mutex_unlock(&agents_mutex);
     return;
@@ -416,47 +465,66 @@ void init_agent_api(int mcc,
   printf("%s", str);
 
   // Initialize new agent instance
-  agent_instance_t* instance = &agents[num_active_agents];
-  instance->agent = e2_init_agent(server_ip_str, e2ap_server_port, ge2ni, io, args->libs_dir, &agent_args);
+  agent_instance_t* instance = calloc(1, sizeof(*instance));
+  assert(instance != NULL && "Memory exhausted");
+  instance->agent = e2_init_agent(server_ip_str, e2ap_server_port, ge2ni, io, args->libs_dir, agent_args, get_conf_rx_batch(args));
 
   // Check agent initialization
   if (instance->agent == NULL) {
     printf("[E2 AGENT]: Failed to initialize agent for RIC %s\n", server_ip_str);
+    free(instance);
     free(server_ip_str);
     pthread_mutex_unlock(&agents_mutex);
     return;
   }
 
+  if (ind_cache_init == false) {
+    init_ind_cache_agent(&ind_cache);
+    ind_cache_init = true;
+  }
+  instance->agent->ind_cache = &ind_cache;
+
+  if (reactors_init == false) {
+    num_reactors = get_conf_e2_agent_reactors(args);
+    if (num_reactors > 0) {
+      reactors = calloc(num_reactors, sizeof(reactor_agent_t));
+      assert(reactors != NULL && "Memory exhausted");
+      for (size_t i = 0; i < num_reactors; ++i)
+        init_reactor_agent(&reactors[i]);
+    }
+    reactors_init = true;
+  }
+
   // Set instance parameters
   instance->active = true;
   instance->ric_ip = strdup(server_ip_str);
 
-  // Create thread for this agent
-  int rc = pthread_create(&instance->thread, NULL, static_start_agent, instance);
+  int rc = 0;
+  if (num_reactors > 0) {
+    // The least loaded event loop serves this RIC
+    if (e2_prepare_agent(instance->agent) == true) {
+      instance->reactor = least_loaded_reactor();
+      add_reactor_agent(instance->reactor, instance->agent);
+    } else {
+      rc = -1;
+    }
+  } else {
+    // Create thread for this agent
+    rc = pthread_create(&instance->thread, NULL, static_start_agent, instance);
+  }
   if (rc != 0) {
-    printf("[E2 AGENT]: Failed to create thread for RIC %s\n", server_ip_str);
+    printf("[E2 AGENT]: Failed to start the agent for RIC %s\n", server_ip_str);
+    instance->agent->agent_stopped = true;
     e2_free_agent(instance->agent);
-    instance->active = false;
     free(instance->ric_ip);
-    instance->ric_ip = NULL;
+    free(instance);
     free(server_ip_str);
     pthread_mutex_unlock(&agents_mutex);
     return;
   }
 
-  // Increment active agents counter and cleanup
-
-  // Don't forget to free the duplicated strings if agent initialization fails
-  if (!instance->agent) {
-    free(agent_args.client_ip);
-    free(agent_args.sm_dir);
-    // Add cleanup for ric_ip_addresses
-    if (agent_args.ric_ip_list.ric_ip_addresses[0] != NULL) {
-      free(agent_args.ric_ip_list.ric_ip_addresses[0]);
-      agent_args.ric_ip_list.ric_ip_addresses[0] = NULL;
-    }
-  }
-  num_active_agents++;
+  // Increment active agents counter
+  push_back_agents(instance);
   free(server_ip_str);
   pthread_mutex_unlock(&agents_mutex);
 
@@ -474,23 +542,24 @@ void stop_agent_api(void)
 
   // Stop and cleanup each active agent
   for (int i = 0; i < num_active_agents; i++) {
-    if (agents[i].active) {
-      e2_free_agent(agents[i].agent);
-      int rc = pthread_join(agents[i].thread, NULL);
-      assert(rc == 0);
-      agents[i].active = false;
-      if (agents[i].ric_ip) {
-        free(agents[i].ric_ip);
-        agents[i].ric_ip = NULL;
-      }
-      // Add cleanup for ric_ip_addresses if needed
-      if (agents[i].agent && agents[i].agent->args && agents[i].agent->args->ric_ip_list.ric_ip_addresses[0] != NULL) {
-        free(agents[i].agent->args->ric_ip_list.ric_ip_addresses[0]);
-        agents[i].agent->args->ric_ip_list.ric_ip_addresses[0] = NULL;
-      }
-    }
+    free_instance(agents[i]);
   }
+  free(agents);
+  agents = NULL;
   num_active_agents = 0;
+  cap_agents = 0;
+
+  for (size_t i = 0; i < num_reactors; ++i)
+    free_reactor_agent(&reactors[i]);
+  free(reactors);
+  reactors = NULL;
+  num_reactors = 0;
+  reactors_init = false;
+
+  if (ind_cache_init == true) {
+    free_ind_cache_agent(&ind_cache);
+    ind_cache_init = false;
+  }
 
   pthread_mutex_unlock(&agents_mutex);
   // assert(agent != NULL);
@@ -499,14 +568,49 @@ void stop_agent_api(void)
   // assert(rc == 0);
 }
 
+bool remove_ric_agent_api(char const* ric_ip)
+{
+  assert(ric_ip != NULL);
+
+  pthread_mutex_lock(&agents_mutex);
+
+  for (int i = 0; i < num_active_agents; i++) {
+    if (agents[i]->ric_ip && strcmp(agents[i]->ric_ip, ric_ip) == 0) {
+      printf("[E2 AGENT]: Removing the agent of RIC IP %s\n", ric_ip);
+      free_instance(agents[i]);
+      memmove(&agents[i], &agents[i + 1], (num_active_agents - i - 1) * sizeof(agents[0]));
+      num_active_agents--;
+      pthread_mutex_unlock(&agents_mutex);
+      return true;
+    }
+  }
+
+  pthread_mutex_unlock(&agents_mutex);
+  return false;
+}
+
+bool sched_stats_agent_api(int index, sched_stats_agent_t* st)
+{
+  assert(st != NULL);
+
+  lock_agents_mutex();
+  agent_instance_t* instance = get_agent_instance(index);
+  e2_agent_t* ag = instance != NULL ? instance->agent : NULL;
+  if (ag != NULL)
+    *st = e2_sched_stats_agent(ag);
+  unlock_agents_mutex();
+
+  return ag != NULL;
+}
+
 void async_event_agent_api(uint32_t ric_req_id, void* ind_data)
 {
   pthread_mutex_lock(&agents_mutex);
 
   // Send event to each active agent
   for (int i = 0; i < num_active_agents; i++) {
-    if (agents[i].active && agents[i].agent) {
-      e2_async_event_agent(agents[i].agent, ric_req_id, ind_data);
+    if (agents[i]->active && agents[i]->agent) {
+      e2_async_event_agent(agents[i]->agent, ric_req_id, ind_data);
     }
   }
 
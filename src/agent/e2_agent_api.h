@@ -25,6 +25,7 @@
 #include "../sm/sm_io.h"
 #include "../util/conf_file.h"
 #include "../util/ngran_types.h"
+#include "sched_agent.h"
 
 #include <pthread.h>
 #include <stdbool.h>
@@ -72,8 +73,16 @@ void init_agent_api(int mcc,
 
 void stop_agent_api(void);
 
+// Closes the association with the RIC at ric_ip and frees its agent. The
+// agents of the other RICs keep running. false if no agent for ric_ip
+bool remove_ric_agent_api(char const* ric_ip);
+
 void async_event_agent_api(uint32_t ric_req_id, void* ind_data);
 
+// Periodic indication scheduler stats of the agent of the index-th RIC.
+// false if no agent there
+bool sched_stats_agent_api(int index, sched_stats_agent_t* st);
+
 // Only expose what's needed for the RRC about the handover
 void send_ho_completion_indication();
 
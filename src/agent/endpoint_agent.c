@@ -101,6 +101,18 @@ sctp_msg_t e2ap_recv_msg_agent(e2ap_ep_ag_t* ep)
   return rcv;
 }
 
+sctp_msg_arr_t e2ap_recv_msgs_agent(e2ap_ep_ag_t* ep, size_t max)
+{
+  assert(ep != NULL);
+  assert(max > 0);
+
+  sctp_msg_arr_t arr = {.msg = calloc(max, sizeof(sctp_msg_t))};
+  assert(arr.msg != NULL && "Memory exhausted");
+
+  arr.len = e2ap_recv_sctp_msg_batch(&ep->base, max, arr.msg);
+  return arr;
+}
+
 void e2ap_send_bytes_agent(e2ap_ep_ag_t* ep, byte_array_t ba)
 {
   assert(ep != NULL);
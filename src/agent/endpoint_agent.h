@@ -44,6 +44,9 @@ void e2ap_free_ep_agent(e2ap_ep_ag_t* ep);
 
 sctp_msg_t e2ap_recv_msg_agent(e2ap_ep_ag_t* ep);
 
+// Drain up to max messages. The array must be freed, even if empty
+sctp_msg_arr_t e2ap_recv_msgs_agent(e2ap_ep_ag_t* ep, size_t max);
+
 void e2ap_send_bytes_agent(e2ap_ep_ag_t* ep, byte_array_t ba);
 
 #endif
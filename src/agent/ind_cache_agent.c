@@ -0,0 +1,214 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "ind_cache_agent.h"
+#include "util/alg_ds/ds/lock_guard/lock_guard.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct{
+  // Owns the ad bytes
+  ind_cache_key_t key;
+  // Tick of ind
+  uint64_t due;
+  // A RAN read for due is in flight
+  bool reading;
+  // NULL if the RAN had nothing to report
+  ind_shared_agent_t* ind;
+} ind_cache_entry_t;
+
+ind_shared_agent_t* acquire_ind_shared_agent(ind_shared_agent_t* s)
+{
+  assert(s != NULL);
+
+  // The caller already holds a reference, so it cannot reach zero
+  size_t const prev = atomic_fetch_add_explicit(&s->refs, 1, memory_order_relaxed);
+  assert(prev > 0);
+  (void)prev;
+  return s;
+}
+
+void release_ind_shared_agent(ind_shared_agent_t* s)
+{
+  if (s == NULL)
+    return;
+
+  // acq_rel: the encodings of every other agent happen before the free
+  size_t const prev = atomic_fetch_sub_explicit(&s->refs, 1, memory_order_acq_rel);
+  assert(prev > 0);
+  if (prev > 1)
+    return;
+
+  free_sm_ind_data(&s->data);
+  free(s);
+}
+
+ind_shared_agent_t* read_ind_shared_agent(exp_ind_data_t (*read)(void const* arg), void const* arg)
+{
+  assert(read != NULL);
+
+  exp_ind_data_t exp = read(arg);
+  if (exp.has_value == false)
+    return NULL;
+
+  ind_shared_agent_t* s = malloc(sizeof(ind_shared_agent_t));
+  assert(s != NULL && "Memory exhausted");
+  s->data = exp.data;
+  atomic_init(&s->refs, 1);
+  return s;
+}
+
+void init_ind_cache_agent(ind_cache_agent_t* c)
+{
+  assert(c != NULL);
+
+  int rc = pthread_mutex_init(&c->mtx, NULL);
+  assert(rc == 0);
+
+  rc = pthread_cond_init(&c->cv, NULL);
+  assert(rc == 0);
+
+  seq_arr_init(&c->arr, sizeof(ind_cache_entry_t));
+}
+
+static void free_entry(void* it)
+{
+  ind_cache_entry_t* e = (ind_cache_entry_t*)it;
+  assert(e->reading == false && "Agents still running");
+  if (e->key.ad.len > 0)
+    free_byte_array(e->key.ad);
+  release_ind_shared_agent(e->ind);
+}
+
+void free_ind_cache_agent(ind_cache_agent_t* c)
+{
+  assert(c != NULL);
+
+  seq_arr_free(&c->arr, free_entry);
+
+  int rc = pthread_cond_destroy(&c->cv);
+  assert(rc == 0);
+
+  rc = pthread_mutex_destroy(&c->mtx);
+  assert(rc == 0);
+}
+
+static bool eq_key(ind_cache_key_t const* a, ind_cache_key_t const* b)
+{
+  return a->ran_func_id == b->ran_func_id && a->period_ms == b->period_ms && a->ad.len == b->ad.len
+         && (a->ad.len == 0 || memcmp(a->ad.buf, b->ad.buf, a->ad.len) == 0);
+}
+
+// Precondition: c->mtx locked. The entries move when the array grows or
+// shrinks, so they are looked up again after every wait
+static ind_cache_entry_t* find_entry(ind_cache_agent_t* c, ind_cache_key_t const* k)
+{
+  ind_cache_entry_t* it = seq_arr_front(&c->arr);
+  ind_cache_entry_t* end = seq_arr_end(&c->arr);
+  for (; it != end; it = seq_arr_next(&c->arr, it)) {
+    if (eq_key(&it->key, k))
+      return it;
+  }
+  return NULL;
+}
+
+// Precondition: c->mtx locked. Entries two periods behind due belong to
+// subscriptions already deleted
+static void prune_entries(ind_cache_agent_t* c, uint64_t due)
+{
+  size_t i = 0;
+  while (i < seq_arr_size(&c->arr)) {
+    ind_cache_entry_t* e = seq_arr_at(&c->arr, i);
+    if (e->reading == false && e->due + 2 * (uint64_t)e->key.period_ms < due) {
+      free_entry(e);
+      seq_arr_erase(&c->arr, e, seq_arr_next(&c->arr, e));
+      continue;
+    }
+    ++i;
+  }
+}
+
+ind_shared_agent_t* get_ind_cache_agent(ind_cache_agent_t* c,
+                                        ind_cache_key_t const* k,
+                                        uint64_t due,
+                                        exp_ind_data_t (*read)(void const* arg),
+                                        void const* arg)
+{
+  assert(c != NULL);
+  assert(k != NULL);
+  assert(k->period_ms > 0);
+  assert(read != NULL);
+
+  ind_shared_agent_t* old = NULL;
+  {
+    lock_guard(&c->mtx);
+
+    ind_cache_entry_t* e = find_entry(c, k);
+    while (e != NULL && e->reading == true && e->due == due) {
+      pthread_cond_wait(&c->cv, &c->mtx);
+      e = find_entry(c, k);
+    }
+
+    if (e != NULL && e->due == due)
+      return e->ind != NULL ? acquire_ind_shared_agent(e->ind) : NULL;
+
+    // This agent is late. The tick was already replaced by a newer one
+    if (e != NULL && e->due > due)
+      return read_ind_shared_agent(read, arg);
+
+    if (e == NULL) {
+      prune_entries(c, due);
+      ind_cache_entry_t tmp = {.key = *k};
+      if (k->ad.len > 0)
+        tmp.key.ad = copy_byte_array(k->ad);
+      seq_arr_push_back(&c->arr, &tmp, sizeof(tmp));
+      e = seq_arr_at(&c->arr, seq_arr_size(&c->arr) - 1);
+    }
+
+    // First agent of the tick
+    e->due = due;
+    e->reading = true;
+    old = e->ind;
+    e->ind = NULL;
+  }
+
+  release_ind_shared_agent(old);
+
+  // The RAN is read without holding the lock
+  ind_shared_agent_t* ind = read_ind_shared_agent(read, arg);
+
+  lock_guard(&c->mtx);
+  // A faster agent may already be reading a newer tick
+  ind_cache_entry_t* e = find_entry(c, k);
+  if (e != NULL && e->due == due) {
+    assert(e->reading == true);
+    e->ind = ind != NULL ? acquire_ind_shared_agent(ind) : NULL;
+    e->reading = false;
+  }
+  // Even if the tick was replaced, as the agents waiting for it have to
+  // notice it and read on their own
+  pthread_cond_broadcast(&c->cv);
+
+  return ind;
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef INDICATION_CACHE_AGENT_H
+#define INDICATION_CACHE_AGENT_H
+
+// Indications read from the RAN and encoded by the SM, shared by the agents
+// of all the nearRT-RICs of the node. The schedulers of the agents are all
+// aligned to the multiples of the period, so the periodic subscriptions with
+// the same RAN function, period and action definition are due on the same
+// tick. The first agent reaching the tick reads the RAN and the SM encodes
+// it, while the rest only build their E2AP message around the same bytes.
+
+#include "sm/sm_proc_data.h"
+#include "util/byte_array.h"
+#include "util/alg_ds/ds/seq_container/seq_arr.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+typedef struct{
+  sm_ind_data_t data;
+  atomic_size_t refs;
+} ind_shared_agent_t;
+
+ind_shared_agent_t* acquire_ind_shared_agent(ind_shared_agent_t* s);
+
+// The last release frees the data
+void release_ind_shared_agent(ind_shared_agent_t* s);
+
+typedef struct{
+  uint16_t ran_func_id;
+  int64_t period_ms;
+  // Action definition as received from the RIC. Not owned
+  byte_array_t ad;
+} ind_cache_key_t;
+
+typedef struct{
+  pthread_mutex_t mtx;
+  // Signaled when a RAN read finished
+  pthread_cond_t cv;
+  // ind_cache_entry_t. A handful of them, one per RAN function, period and
+  // action definition
+  seq_arr_t arr;
+} ind_cache_agent_t;
+
+void init_ind_cache_agent(ind_cache_agent_t* c);
+
+void free_ind_cache_agent(ind_cache_agent_t* c);
+
+// The indication of k for the tick due. read(arg) is only called by the
+// first agent of the tick, the rest wait for it and share its result.
+// NULL if the RAN had nothing to report. Release it after use
+ind_shared_agent_t* get_ind_cache_agent(ind_cache_agent_t* c,
+                                        ind_cache_key_t const* k,
+                                        uint64_t due,
+                                        exp_ind_data_t (*read)(void const* arg),
+                                        void const* arg);
+
+// Without cache, e.g., an agent outside the agent API
+ind_shared_agent_t* read_ind_shared_agent(exp_ind_data_t (*read)(void const* arg), void const* arg);
+
+#endif
@@ -41,12 +41,12 @@ static bool check_valid_msg_type(e2_msg_type_t msg_type)
          || msg_type == E2_CONNECTION_UPDATE;
 }
 
-static inline bool not_aperiodic_ind_event(int fd)
+static inline bool not_aperiodic_ind_event(int id)
 {
-  assert(fd > -1);
+  assert(id > -1);
 
   // 0 value used for aperiodic indication events
-  return fd != 0;
+  return id != 0;
 }
 
 static bool stop_ind_event(e2_agent_t* ag, ric_gen_id_t id)
@@ -75,15 +75,16 @@ static bool stop_ind_event(e2_agent_t* ag, ric_gen_id_t id)
   //
   if (ind_ev->type == APERIODIC_SUBSCRIPTION_FLRC)
     ind_ev->free_subs_aperiodic(id.ric_req_id);
+  if (ind_ev->ad.len > 0)
+    free_byte_array(ind_ev->ad);
 
   void (*free_ind_event)(void*) = NULL;
-  int* fd = bi_map_extract_right(&ag->ind_event, &tmp, sizeof(tmp), free_ind_event);
-  assert(*fd > -1);
-  // printf("fd value in stopping pending event = %d \n", *fd);
+  int* sched_id = bi_map_extract_right(&ag->ind_event, &tmp, sizeof(tmp), free_ind_event);
+  assert(*sched_id > -1);
 
-  if (not_aperiodic_ind_event(*fd))
-    rm_fd_asio_agent(&ag->io, *fd);
-  free(fd);
+  if (not_aperiodic_ind_event(*sched_id))
+    rm_sched_agent(&ag->sched, *sched_id);
+  free(sched_id);
 
   return true;
   ;
@@ -188,11 +189,14 @@ e2ap_msg_t e2ap_handle_subscription_request_agent(e2_agent_t* ag, const e2ap_msg
   if (ev.type == PERIODIC_SUBSCRIPTION_FLRC) {
     subscribe_timer_t const t = subs.per.t;
     ev.act_def = t.act_def;
+    if (data.len_ad > 0)
+      ev.ad = copy_byte_array((byte_array_t){.buf = data.action_def, .len = data.len_ad});
     // Periodic indication message generated i.e., every 5 ms
     assert(t.ms < 10001 && "Subscription for granularity larger than 10 seconds requested? ");
-    int fd_timer = create_timer_ms_asio_agent(&ag->io, t.ms, t.ms);
+    // Served by the agent scheduler together with the rest of subscriptions due on the same tick
+    int const id = add_sched_agent(&ag->sched, t.ms);
     lock_guard(&ag->mtx_ind_event);
-    bi_map_insert(&ag->ind_event, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    bi_map_insert(&ag->ind_event, &id, sizeof(id), &ev, sizeof(ev));
   } else if (ev.type == APERIODIC_SUBSCRIPTION_FLRC) {
     ev.free_subs_aperiodic = subs.aper.free_aper_subs;
     // Aperiodic indication generated i.e., the RAN will generate it via
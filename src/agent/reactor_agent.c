@@ -0,0 +1,152 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "reactor_agent.h"
+#include "e2_agent.h"
+#include "util/alg_ds/ds/lock_guard/lock_guard.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// Events served per agent and wake up, so that a busy association does not
+// starve the rest. The agent's efd stays readable, so it is served again in
+// the next round
+#define REACTOR_AGENT_BUDGET 16
+
+#define REACTOR_AGENT_MAX_EVENTS 32
+
+static struct e2_agent_s** find_agent(reactor_agent_t* r, struct e2_agent_s* ag)
+{
+  struct e2_agent_s** it = seq_arr_front(&r->ag);
+  struct e2_agent_s** end = seq_arr_end(&r->ag);
+  for (; it != end; it = seq_arr_next(&r->ag, it)) {
+    if (*it == ag)
+      return it;
+  }
+  return NULL;
+}
+
+static void* reactor_loop(void* arg)
+{
+  reactor_agent_t* r = (reactor_agent_t*)arg;
+
+  while (r->stop_token == false) {
+    struct epoll_event events[REACTOR_AGENT_MAX_EVENTS];
+    // Wake up every second to check the stop_token
+    int const n = epoll_wait(r->efd, events, REACTOR_AGENT_MAX_EVENTS, 1000);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "epoll_wait() returned -1: errno %d, %s\n", errno, strerror(errno));
+      assert(0 != 0 && "epoll_wait failed");
+    }
+
+    lock_guard(&r->mtx);
+    for (int i = 0; i < n; ++i) {
+      e2_agent_t* ag = events[i].data.ptr;
+      // Removed after epoll_wait returned
+      if (find_agent(r, ag) == NULL)
+        continue;
+      e2_poll_agent(ag, REACTOR_AGENT_BUDGET);
+    }
+  }
+
+  return NULL;
+}
+
+void init_reactor_agent(reactor_agent_t* r)
+{
+  assert(r != NULL);
+
+  r->efd = epoll_create1(EPOLL_CLOEXEC);
+  assert(r->efd != -1);
+
+  int rc = pthread_mutex_init(&r->mtx, NULL);
+  assert(rc == 0);
+
+  seq_arr_init(&r->ag, sizeof(struct e2_agent_s*));
+  atomic_init(&r->stop_token, false);
+
+  rc = pthread_create(&r->thread, NULL, reactor_loop, r);
+  assert(rc == 0);
+}
+
+void free_reactor_agent(reactor_agent_t* r)
+{
+  assert(r != NULL);
+
+  r->stop_token = true;
+  int rc = pthread_join(r->thread, NULL);
+  assert(rc == 0);
+
+  seq_arr_free(&r->ag, NULL);
+
+  rc = pthread_mutex_destroy(&r->mtx);
+  assert(rc == 0);
+
+  rc = close(r->efd);
+  assert(rc == 0);
+}
+
+void add_reactor_agent(reactor_agent_t* r, struct e2_agent_s* ag)
+{
+  assert(r != NULL);
+  assert(ag != NULL);
+
+  lock_guard(&r->mtx);
+  assert(find_agent(r, ag) == NULL);
+  seq_arr_push_back(&r->ag, &ag, sizeof(ag));
+
+  // Level triggered. The agent's efd is readable while any of its fds has
+  // an event not yet served
+  struct epoll_event event = {.events = EPOLLIN, .data.ptr = ag};
+  int rc = epoll_ctl(r->efd, EPOLL_CTL_ADD, ag->io.efd, &event);
+  assert(rc != -1);
+}
+
+void rm_reactor_agent(reactor_agent_t* r, struct e2_agent_s* ag)
+{
+  assert(r != NULL);
+  assert(ag != NULL);
+
+  lock_guard(&r->mtx);
+  struct e2_agent_s** it = find_agent(r, ag);
+  assert(it != NULL && "Agent not registered in the reactor");
+
+  int rc = epoll_ctl(r->efd, EPOLL_CTL_DEL, ag->io.efd, NULL);
+  assert(rc != -1);
+  seq_arr_erase(&r->ag, it, seq_arr_next(&r->ag, it));
+
+  // No event loop to wait for
+  ag->agent_stopped = true;
+}
+
+size_t size_reactor_agent(reactor_agent_t* r)
+{
+  assert(r != NULL);
+
+  lock_guard(&r->mtx);
+  return seq_arr_size(&r->ag);
+}
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef REACTOR_AGENT_H
+#define REACTOR_AGENT_H
+
+// Event loop shared by the agents of several nearRT-RICs. The epoll fd of
+// every agent is registered in the reactor's own epoll fd, so a single
+// thread waits for all the associations, timers and pipes of its agents and
+// serves each ready agent up to a budget of events per wake up.
+// Agents can be added and removed at any time from any thread
+
+#include "../util/alg_ds/ds/seq_container/seq_arr.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct e2_agent_s;
+
+typedef struct{
+  int efd;
+  pthread_t thread;
+
+  // Held while the agents are served
+  pthread_mutex_t mtx;
+  // struct e2_agent_s*
+  seq_arr_t ag;
+
+  atomic_bool stop_token;
+} reactor_agent_t;
+
+// Spawns the reactor thread
+void init_reactor_agent(reactor_agent_t* r);
+
+// Stops and joins the reactor thread. The agents still registered are not
+// freed
+void free_reactor_agent(reactor_agent_t* r);
+
+// The agent must be prepared, i.e., e2_prepare_agent()
+void add_reactor_agent(reactor_agent_t* r, struct e2_agent_s* ag);
+
+// Once it returns, the reactor does not touch ag anymore and ag is marked
+// as stopped, so that it can be freed
+void rm_reactor_agent(reactor_agent_t* r, struct e2_agent_s* ag);
+
+size_t size_reactor_agent(reactor_agent_t* r);
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "sched_agent.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t now_ms(void)
+{
+  struct timespec ts = {0};
+  int rc = clock_gettime(CLOCK_MONOTONIC, &ts);
+  assert(rc == 0);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t next_due(sched_agent_t* s)
+{
+  uint64_t due = UINT64_MAX;
+
+  sched_grp_agent_t* it = seq_arr_front(&s->grp);
+  sched_grp_agent_t* end = seq_arr_end(&s->grp);
+  for (; it != end; it = seq_arr_next(&s->grp, it)) {
+    if (it->due < due)
+      due = it->due;
+  }
+
+  return due;
+}
+
+static void program_timerfd(sched_agent_t* s)
+{
+  uint64_t const due = next_due(s);
+  if (due == s->tfd_due)
+    return;
+
+  // A zero it_value disarms the timerfd
+  struct itimerspec new_value = {0};
+  if (due != UINT64_MAX) {
+    new_value.it_value.tv_sec = due / 1000;
+    new_value.it_value.tv_nsec = (due % 1000) * 1000000;
+  }
+
+  int rc = timerfd_settime(s->tfd, TFD_TIMER_ABSTIME, &new_value, NULL);
+  assert(rc != -1);
+  s->tfd_due = due;
+}
+
+void init_sched_agent(sched_agent_t* s, asio_agent_t* io)
+{
+  assert(s != NULL);
+  assert(io != NULL);
+
+  s->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  assert(s->tfd != -1);
+  s->tfd_due = UINT64_MAX;
+  s->next_id = 1;
+
+  seq_arr_init(&s->grp, sizeof(sched_grp_agent_t));
+
+  atomic_init(&s->ticks, 0);
+  atomic_init(&s->fired, 0);
+  atomic_init(&s->overruns, 0);
+  atomic_init(&s->max_late_ms, 0);
+
+  add_fd_asio_agent(io, s->tfd);
+}
+
+static void free_grp(void* it)
+{
+  sched_grp_agent_t* g = (sched_grp_agent_t*)it;
+  seq_arr_free(&g->id, NULL);
+}
+
+void free_sched_agent(sched_agent_t* s, asio_agent_t* io)
+{
+  assert(s != NULL);
+  assert(io != NULL);
+
+  rm_fd_asio_agent(io, s->tfd);
+  seq_arr_free(&s->grp, free_grp);
+}
+
+static sched_grp_agent_t* find_grp(sched_agent_t* s, int64_t period_ms)
+{
+  sched_grp_agent_t* it = seq_arr_front(&s->grp);
+  sched_grp_agent_t* end = seq_arr_end(&s->grp);
+  for (; it != end; it = seq_arr_next(&s->grp, it)) {
+    if (it->period_ms == period_ms)
+      return it;
+  }
+  return NULL;
+}
+
+int add_sched_agent(sched_agent_t* s, int64_t period_ms)
+{
+  assert(s != NULL);
+  assert(period_ms > 0);
+
+  sched_grp_agent_t* g = find_grp(s, period_ms);
+  if (g == NULL) {
+    sched_grp_agent_t tmp = {.period_ms = period_ms};
+    tmp.due = (now_ms() / period_ms + 1) * period_ms;
+    seq_arr_init(&tmp.id, sizeof(int));
+    seq_arr_push_back(&s->grp, &tmp, sizeof(tmp));
+    g = seq_arr_at(&s->grp, seq_arr_size(&s->grp) - 1);
+  }
+
+  int const id = s->next_id++;
+  assert(id > 0 && "Subscription ids exhausted");
+  seq_arr_push_back(&g->id, (void*)&id, sizeof(id));
+
+  // Only touch the timerfd if the group is due before the programmed time
+  if (g->due < s->tfd_due)
+    program_timerfd(s);
+
+  return id;
+}
+
+void rm_sched_agent(sched_agent_t* s, int id)
+{
+  assert(s != NULL);
+  assert(id > 0);
+
+  sched_grp_agent_t* g = seq_arr_front(&s->grp);
+  sched_grp_agent_t* end = seq_arr_end(&s->grp);
+  for (; g != end; g = seq_arr_next(&s->grp, g)) {
+    int* it = seq_arr_front(&g->id);
+    int* end_id = seq_arr_end(&g->id);
+    for (; it != end_id; it = seq_arr_next(&g->id, it)) {
+      if (*it != id)
+        continue;
+
+      seq_arr_erase(&g->id, it, seq_arr_next(&g->id, it));
+      if (seq_arr_size(&g->id) > 0)
+        return;
+
+      // Last one of the group. The timerfd follows the remaining groups, and
+      // it is disarmed once none is left
+      seq_arr_free(&g->id, NULL);
+      seq_arr_erase(&s->grp, g, seq_arr_next(&s->grp, g));
+      program_timerfd(s);
+      return;
+    }
+  }
+
+  assert(0 != 0 && "Subscription id not found in the scheduler");
+}
+
+bool tick_fd_sched_agent(sched_agent_t const* s, int fd)
+{
+  assert(s != NULL);
+  return fd == s->tfd;
+}
+
+static void max_late(sched_agent_t* s, uint64_t late)
+{
+  if (late > atomic_load_explicit(&s->max_late_ms, memory_order_relaxed))
+    atomic_store_explicit(&s->max_late_ms, late, memory_order_relaxed);
+}
+
+void tick_sched_agent(sched_agent_t* s, void (*f)(int id, int64_t period_ms, uint64_t due, void* arg), void* arg)
+{
+  assert(s != NULL);
+  assert(f != NULL);
+
+  uint64_t read_buf = 0;
+  ssize_t bytes = read(s->tfd, &read_buf, sizeof(read_buf));
+  (void)bytes; // EAGAIN if the timer was re-programmed meanwhile
+
+  atomic_fetch_add_explicit(&s->ticks, 1, memory_order_relaxed);
+
+  uint64_t const now = now_ms();
+
+  size_t const sz = seq_arr_size(&s->grp);
+  for (size_t i = 0; i < sz; ++i) {
+    sched_grp_agent_t* g = seq_arr_at(&s->grp, i);
+    if (g->due > now)
+      continue;
+
+    // Stay on the multiples of the period, even if late
+    uint64_t const late = now - g->due;
+    uint64_t const missed = late / g->period_ms;
+    uint64_t const due = g->due + missed * g->period_ms;
+    g->due = due + g->period_ms;
+
+    atomic_fetch_add_explicit(&s->overruns, missed, memory_order_relaxed);
+    max_late(s, late);
+
+    size_t const len = seq_arr_size(&g->id);
+    for (size_t j = 0; j < len; ++j)
+      f(*(int*)seq_arr_at(&g->id, j), g->period_ms, due, arg);
+
+    atomic_fetch_add_explicit(&s->fired, len, memory_order_relaxed);
+  }
+
+  // Force the re-arm, as the timerfd already fired
+  s->tfd_due = 0;
+  program_timerfd(s);
+}
+
+sched_stats_agent_t stats_sched_agent(sched_agent_t* s)
+{
+  assert(s != NULL);
+
+  sched_stats_agent_t st = {.ticks = atomic_load_explicit(&s->ticks, memory_order_relaxed),
+                            .fired = atomic_load_explicit(&s->fired, memory_order_relaxed),
+                            .overruns = atomic_load_explicit(&s->overruns, memory_order_relaxed),
+                            .max_late_ms = atomic_load_explicit(&s->max_late_ms, memory_order_relaxed)};
+  return st;
+}
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef SCHEDULER_AGENT_H
+#define SCHEDULER_AGENT_H
+
+// Periodic indication scheduler. A single timerfd, programmed with absolute
+// CLOCK_MONOTONIC times, drives all the periodic subscriptions of the agent.
+// Subscriptions with the same period form a group, and every group is due
+// at the multiples of its period, so e.g., the 1 ms, 5 ms and 10 ms groups
+// are served in the same wake up every 10 ms.
+// Not thread-safe, only the agent reactor calls it. The stats can be read
+// from any thread
+
+#include "asio_agent.h"
+#include "../util/alg_ds/ds/seq_container/seq_arr.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct{
+  // Timer wake ups
+  uint64_t ticks;
+  // Subscriptions served
+  uint64_t fired;
+  // Periods skipped as the reactor came too late to a tick
+  uint64_t overruns;
+  // Worst delay between a due time and its service
+  uint64_t max_late_ms;
+} sched_stats_agent_t;
+
+typedef struct{
+  int64_t period_ms;
+  // Absolute ms, multiple of period_ms
+  uint64_t due;
+  // int subscription ids
+  seq_arr_t id;
+} sched_grp_agent_t;
+
+typedef struct{
+  int tfd;
+  // Programmed due. UINT64_MAX if disarmed
+  uint64_t tfd_due;
+  int next_id;
+
+  // sched_grp_agent_t
+  seq_arr_t grp;
+
+  _Atomic uint64_t ticks;
+  _Atomic uint64_t fired;
+  _Atomic uint64_t overruns;
+  _Atomic uint64_t max_late_ms;
+} sched_agent_t;
+
+void init_sched_agent(sched_agent_t* s, asio_agent_t* io);
+
+void free_sched_agent(sched_agent_t* s, asio_agent_t* io);
+
+// Returns a positive subscription id. First due at the next multiple of period_ms
+int add_sched_agent(sched_agent_t* s, int64_t period_ms);
+
+// The timerfd is reprogrammed only when a group goes away
+void rm_sched_agent(sched_agent_t* s, int id);
+
+bool tick_fd_sched_agent(sched_agent_t const* s, int fd);
+
+// Calls f with the ids of all the subscriptions due, group after group, and
+// the tick served. The periods missed are skipped and accounted as overruns
+void tick_sched_agent(sched_agent_t* s, void (*f)(int id, int64_t period_ms, uint64_t due, void* arg), void* arg);
+
+sched_stats_agent_t stats_sched_agent(sched_agent_t* s);
+
+#endif
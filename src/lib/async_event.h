@@ -25,6 +25,7 @@
 #include "aind_event.h"
 #include "ind_event.h"
 #include "pending_events.h"
+#include "pending_event_ric.h"
 #include "ep/sctp_msg.h"
 
 typedef enum
@@ -32,9 +33,11 @@ typedef enum
   CHECK_STOP_TOKEN_EVENT,
   SCTP_CONNECTION_SHUTDOWN_EVENT,
   SCTP_MSG_ARRIVED_EVENT, 
+  SCTP_MSG_BATCH_ARRIVED_EVENT,
   INDICATION_EVENT,
   APERIODIC_INDICATION_EVENT,
   PENDING_EVENT,
+  SHM_CHANNEL_EVENT,
 
   UNKNOWN_EVENT,
 } async_event_e;
@@ -45,9 +48,12 @@ typedef struct
   int fd;
   union{
     pending_event_t* p_ev;
+    // Copied out of the RIC pending map, which no longer holds it
+    pending_event_ric_t p_ev_ric;
     ind_event_t* i_ev;
     arr_aind_event_t ai_ev;
     sctp_msg_t msg; 
+    sctp_msg_arr_t msgs;
   };
 } async_event_t;
 
@@ -0,0 +1,221 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "e2ap_ind_aper.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+// E2AP-PDU ::= CHOICE { initiatingMessage, ... }
+// InitiatingMessage ::= SEQUENCE { procedureCode, criticality, value }
+// RICindication ::= SEQUENCE { protocolIEs ProtocolIE-Container, ... }
+// ProtocolIE-Field ::= SEQUENCE { id, criticality, value }
+#define ID_RIC_INDICATION 5
+#define ID_RIC_REQUEST_ID 29
+#define ID_RAN_FUNCTION_ID 5
+#define ID_RIC_ACTION_ID 15
+#define ID_RIC_CALL_PROCESS_ID 20
+#define ID_RIC_INDICATION_HEADER 25
+#define ID_RIC_INDICATION_MESSAGE 26
+#define ID_RIC_INDICATION_SN 27
+#define ID_RIC_INDICATION_TYPE 28
+
+typedef struct {
+  uint8_t const* b;
+  size_t len;
+  size_t pos;
+} aper_t;
+
+static inline bool u8(aper_t* a, uint8_t* out)
+{
+  if (a->pos + 1 > a->len)
+    return false;
+  *out = a->b[a->pos++];
+  return true;
+}
+
+// Constrained whole number with a range of 65536, i.e., two aligned octets
+static inline bool u16(aper_t* a, uint16_t* out)
+{
+  if (a->pos + 2 > a->len)
+    return false;
+  *out = (uint16_t)(a->b[a->pos] << 8 | a->b[a->pos + 1]);
+  a->pos += 2;
+  return true;
+}
+
+// Length determinant. A fragment (i.e., >= 16K) sets frag, and its content
+// is only partially in front of the next length determinant
+static bool length(aper_t* a, size_t* out, bool* frag)
+{
+  uint8_t c = 0;
+  if (u8(a, &c) == false)
+    return false;
+
+  *frag = false;
+  if ((c & 0x80) == 0) {
+    *out = c;
+  } else if ((c & 0xC0) == 0x80) {
+    uint8_t c2 = 0;
+    if (u8(a, &c2) == false)
+      return false;
+    *out = (size_t)(c & 0x3F) << 8 | c2;
+  } else {
+    *out = (size_t)(c & 0x3F) * 16384;
+    *frag = true;
+  }
+  return true;
+}
+
+// Criticality ::= ENUMERATED { reject, ignore, notify }, i.e., 2 bits
+static inline bool criticality(aper_t* a)
+{
+  uint8_t c = 0;
+  return u8(a, &c) == true && (c >> 6) < 3;
+}
+
+// Walks the rest of the fragments of an open type. true if all of them are
+// in the buffer
+static bool fragments_fit(aper_t a, size_t len, bool frag)
+{
+  while (frag == true) {
+    if (a.pos + len > a.len)
+      return false;
+    a.pos += len;
+    if (length(&a, &len, &frag) == false)
+      return false;
+  }
+  return a.pos + len <= a.len;
+}
+
+// OCTET STRING filling the whole IE value
+static bool octet_string(aper_t* a)
+{
+  size_t len = 0;
+  bool frag = false;
+  return length(a, &len, &frag) == true && frag == false && a->pos + len == a->len;
+}
+
+// The value of a RICindication IE, as the asn1c decoder would accept it
+static bool ie_value(uint16_t id, aper_t* v, ric_gen_id_t* ric_id)
+{
+  uint8_t c = 0;
+  switch (id) {
+    case ID_RIC_REQUEST_ID: {
+      // Extension bit, ricRequestorID, ricInstanceID
+      uint16_t req = 0;
+      uint16_t inst = 0;
+      if (v->len != 5 || u8(v, &c) == false || (c & 0x80) != 0 || u16(v, &req) == false || u16(v, &inst) == false)
+        return false;
+      ric_id->ric_req_id = req;
+      ric_id->ric_inst_id = inst;
+      return true;
+    }
+    case ID_RAN_FUNCTION_ID: {
+      // RANfunctionID ::= INTEGER (0..4095)
+      uint16_t rf = 0;
+      if (v->len != 2 || u16(v, &rf) == false || rf > 4095)
+        return false;
+      ric_id->ran_func_id = rf;
+      return true;
+    }
+    case ID_RIC_ACTION_ID:
+      return v->len == 1;
+    case ID_RIC_INDICATION_SN:
+      return v->len == 2;
+    case ID_RIC_INDICATION_TYPE:
+      // ENUMERATED { report, insert, ... }. No extension values
+      return v->len == 1 && u8(v, &c) == true && (c & 0x80) == 0;
+    case ID_RIC_INDICATION_HEADER:
+    case ID_RIC_INDICATION_MESSAGE:
+    case ID_RIC_CALL_PROCESS_ID:
+      return octet_string(v);
+    default:
+      return false;
+  }
+}
+
+bool peek_ric_indication_aper(byte_array_t ba, ric_gen_id_t* ric_id)
+{
+  assert(ric_id != NULL);
+
+  aper_t a = {.b = ba.buf, .len = ba.len};
+
+  // Extension bit and choice index 0, i.e., initiatingMessage
+  uint8_t c = 0;
+  if (u8(&a, &c) == false || (c & 0xE0) != 0)
+    return false;
+
+  uint8_t proc = 0;
+  if (u8(&a, &proc) == false || proc != ID_RIC_INDICATION)
+    return false;
+
+  if (criticality(&a) == false)
+    return false;
+
+  // Open type. Only its head is read, thus a fragment is fine as long as
+  // the whole value is in the buffer
+  size_t len = 0;
+  bool frag = false;
+  if (length(&a, &len, &frag) == false || fragments_fit(a, len, frag) == false)
+    return false;
+
+  // The IEs are only read from the first fragment
+  aper_t v = {.b = a.b + a.pos, .len = len};
+
+  // Extension bit of RICindication
+  if (u8(&v, &c) == false || (c & 0x80) != 0)
+    return false;
+
+  uint16_t num_ie = 0;
+  if (u16(&v, &num_ie) == false)
+    return false;
+
+  bool req_id = false;
+  bool ran_func = false;
+
+  // All the IEs are checked when the value is not fragmented, so that a
+  // malformed indication is left to the full decoder. Otherwise, only the
+  // ones in front of the ids
+  for (uint16_t i = 0; i < num_ie && (frag == false || req_id == false || ran_func == false); ++i) {
+    uint16_t id = 0;
+    if (u16(&v, &id) == false || criticality(&v) == false)
+      return false;
+
+    bool ie_frag = false;
+    if (length(&v, &len, &ie_frag) == false || ie_frag == true || v.pos + len > v.len)
+      return false;
+
+    aper_t ie = {.b = v.b + v.pos, .len = len};
+    v.pos += len;
+
+    if (ie_value(id, &ie, ric_id) == false)
+      return false;
+
+    req_id |= id == ID_RIC_REQUEST_ID;
+    ran_func |= id == ID_RAN_FUNCTION_ID;
+  }
+
+  if (frag == false && v.pos != v.len)
+    return false;
+
+  return req_id && ran_func;
+}
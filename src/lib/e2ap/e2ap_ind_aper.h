@@ -0,0 +1,38 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef E2AP_IND_APER_H
+#define E2AP_IND_APER_H
+
+// Fast path for RIC INDICATION in APER. Reads the ids of the message straight
+// from the bytes, without the asn1c decoder, so that it can be relayed as
+// received. The layout is the same in E2AP v1, v2 and v3
+
+#include "ric_gen_id_wrapper.h"
+#include "../../util/byte_array.h"
+
+#include <stdbool.h>
+
+// false if ba is not a RIC INDICATION, or if the ids could not be found
+// before a fragmented length (i.e., the full decoder is needed)
+bool peek_ric_indication_aper(byte_array_t ba, ric_gen_id_t* ric_id);
+
+#endif
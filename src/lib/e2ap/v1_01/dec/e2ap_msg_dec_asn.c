@@ -52,6 +52,7 @@
 #include "../free/e2ap_msg_free.h"
 #include "../global_consts.h"
 
+#include "util/asn_arena.h"
 #include "util/conversions.h"
 #include "util/ngran_types.h"
 
@@ -2434,7 +2435,8 @@ E2AP_PDU_t* e2ap_create_pdu(const uint8_t* buffer, int buffer_len)
   assert(buffer != NULL);
   assert(buffer_len > -1);
 
-  E2AP_PDU_t* pdu = calloc(1, sizeof(E2AP_PDU_t));
+  // Allocated by the decoder, i.e., from the asn arena if a scope is open
+  E2AP_PDU_t* pdu = NULL;
   const enum asn_transfer_syntax syntax = ATS_ALIGNED_BASIC_PER;
   const asn_dec_rval_t rval = asn_decode_e2ap_v1_01(NULL, syntax, &asn_DEF_E2AP_PDU_e2ap_v1_01, (void**)&pdu, buffer, buffer_len);
   //printf("rval.code = %d\n", rval.code);
@@ -2450,6 +2452,10 @@ E2AP_PDU_t* e2ap_create_pdu(const uint8_t* buffer, int buffer_len)
 e2ap_msg_t e2ap_msg_dec_asn(e2ap_asn_t* asn, byte_array_t ba)
 {
   assert(ba.buf != NULL && ba.len > 0);
+
+  // The asn1c tree only lives until it is converted into e2ap_msg_t
+  asn_arena_mark_t const mark = begin_asn_arena();
+
   E2AP_PDU_t* pdu = e2ap_create_pdu(ba.buf, ba.len);
   assert(pdu != NULL);
   const e2_msg_type_t msg_type = e2ap_get_msg_type(pdu);  
@@ -2458,7 +2464,9 @@ e2ap_msg_t e2ap_msg_dec_asn(e2ap_asn_t* asn, byte_array_t ba)
   e2ap_msg_t msg = asn->dec_msg[msg_type](pdu);
 //  xer_fprint_e2ap_v1_01(stdout, &asn_DEF_E2AP_PDU_e2ap_v1_01, pdu);
 //  fflush(stdout);
-  ASN_STRUCT_FREE(asn_DEF_E2AP_PDU_e2ap_v1_01,pdu);
+  if(must_free_asn_arena(mark))
+    ASN_STRUCT_FREE(asn_DEF_E2AP_PDU_e2ap_v1_01,pdu);
+  end_asn_arena(mark);
   return msg; 
 }
 
@@ -56,6 +56,7 @@
 
 #include "util/conversions.h"
 #include "../global_consts.h"
+#include "../../../../util/byte_array_pool.h"
 
 static
 void free_pdu(E2AP_PDU_t* pdu)
@@ -376,10 +377,10 @@ E2nodeComponentConfigUpdate_ItemIEs_t* copy_e2_node_component_conf_update(const
 byte_array_t e2ap_enc_asn_pdu_ba(struct E2AP_PDU* pdu)
 {
   assert(pdu != NULL);
-  byte_array_t ba = {.buf = malloc(32*1024), .len =32*1024};
+  byte_array_t ba = alloc_byte_array_pool(BYTE_ARRAY_POOL_MAX_SZ);
   const bool success = encode(&ba, pdu);
   assert(success);
-  return ba;
+  return trim_byte_array_pool(ba);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
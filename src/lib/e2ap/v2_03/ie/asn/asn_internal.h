@@ -34,10 +34,12 @@ extern "C" {
 #define	ASN1C_ENVIRONMENT_VERSION	923	/* Compile-time version */
 int get_asn1c_environment_version_e2ap_v2_03(void);	/* Run-time version */
 
-#define	CALLOC(nmemb, size)	calloc(nmemb, size)
-#define	MALLOC(size)		malloc(size)
-#define	REALLOC(oldptr, size)	realloc(oldptr, size)
-#define	FREEMEM(ptr)		free(ptr)
+/* Served by the per thread arena within a begin/end_asn_arena() scope */
+#include "../../../../../util/asn_arena.h"
+#define	CALLOC(nmemb, size)	calloc_asn_arena(nmemb, size)
+#define	MALLOC(size)		malloc_asn_arena(size)
+#define	REALLOC(oldptr, size)	realloc_asn_arena(oldptr, size)
+#define	FREEMEM(ptr)		free_asn_arena(ptr)
 
 #define	asn_debug_indent	0
 #define ASN_DEBUG_INDENT_ADD(i) do{}while(0)
@@ -21,6 +21,7 @@
 
 #include "e2ap_ep.h"
 #include "../../util/alg_ds/ds/lock_guard/lock_guard.h"
+#include "../../util/byte_array_pool.h"
 
 #include <pthread.h>
 
@@ -61,6 +62,12 @@ void e2ap_send_sctp_msg(const e2ap_ep_t* ep, sctp_msg_t* msg)
   struct sctp_sndrcvinfo const* sri = &msg->info.sri;
   byte_array_t const ba = msg->ba;
 
+  // Peeled off association. The socket is not shared with the receive path
+  if (msg->info.fd > 0) {
+    e2ap_send_sctp_msg_fd(msg->info.fd, msg);
+    return;
+  }
+
   lock_guard(&((e2ap_ep_t*)ep)->mtx);
 
   const int rc = sctp_sendmsg(ep->fd,
@@ -79,6 +86,31 @@ void e2ap_send_sctp_msg(const e2ap_ep_t* ep, sctp_msg_t* msg)
   }
 }
 
+void e2ap_send_sctp_msg_fd(int fd, sctp_msg_t const* msg)
+{
+  assert(fd > 0);
+  assert(msg != NULL);
+  assert(msg->ba.buf && msg->ba.len > 0);
+
+  struct sctp_sndrcvinfo const* sri = &msg->info.sri;
+
+  // One-to-one socket. The kernel serializes the writers
+  const int rc = sctp_sendmsg(fd,
+                              (void*)msg->ba.buf,
+                              msg->ba.len,
+                              NULL,
+                              0,
+                              sri->sinfo_ppid,
+                              sri->sinfo_flags,
+                              sri->sinfo_stream,
+                              0,
+                              0);
+  assert(rc != 0);
+  if (rc == -1) {
+    printf("Error sending sctp message \n");
+  }
+}
+
 static struct sctp_shutdown_event cp_sn_shutdown_event(struct sctp_shutdown_event const* src)
 {
   struct sctp_shutdown_event dst = {.sse_type = src->sse_type,
@@ -213,39 +245,152 @@ static union sctp_notification cp_sctp_notification(union sctp_notification cons
   return dst;
 }
 
+// from->ba holds the rc bytes read with hdr
+static void fill_sctp_msg(struct msghdr* hdr, sctp_msg_t* from, int rc)
+{
+  for (struct cmsghdr* c = CMSG_FIRSTHDR(hdr); c != NULL; c = CMSG_NXTHDR(hdr, c)) {
+    if (c->cmsg_level == IPPROTO_SCTP && c->cmsg_type == SCTP_SNDRCV)
+      memcpy(&from->info.sri, CMSG_DATA(c), sizeof(from->info.sri));
+  }
+
+  if (hdr->msg_flags & MSG_NOTIFICATION) {
+    assert((hdr->msg_flags & MSG_EOR) && "Notification received but the buffer is not large enough");
+    uint8_t buf[2048] = {0};
+    memcpy(buf, from->ba.buf, (size_t)rc < sizeof(buf) ? (size_t)rc : sizeof(buf));
+    free_byte_array(from->ba);
+
+    from->type = SCTP_MSG_NOTIFICATION;
+    from->notif = calloc(1, sizeof(union sctp_notification));
+    assert(from->notif != NULL && "Memory exhausted");
+
+    *from->notif = cp_sctp_notification((union sctp_notification*)buf, rc);
+  } else {
+    from->type = SCTP_MSG_PAYLOAD;
+    from->ba.len = rc; // set actually received number of bytes
+    // Small messages move to a smaller class, large ones are handed off as they are
+    from->ba = trim_byte_array_pool(from->ba);
+  }
+}
+
+// sctp_recvmsg() does not accept input flags. Same as it, but with them.
+// Returns -1 if nothing to read and 0 if the peer closed a one-to-one socket
+static int recv_sctp_msg(int fd, sctp_msg_t* from, int flags)
+{
+  assert(fd > 0);
+  assert(from != NULL);
+
+  from->ba = alloc_byte_array_pool(BYTE_ARRAY_POOL_MAX_SZ);
+
+  char cmsg_buf[CMSG_SPACE(sizeof(struct sctp_sndrcvinfo))] = {0};
+  struct iovec iov = {.iov_base = from->ba.buf, .iov_len = from->ba.len};
+  struct msghdr hdr = {.msg_name = &from->info.addr,
+                       .msg_namelen = sizeof(from->info.addr),
+                       .msg_iov = &iov,
+                       .msg_iovlen = 1,
+                       .msg_control = cmsg_buf,
+                       .msg_controllen = sizeof(cmsg_buf)};
+
+  int const rc = recvmsg(fd, &hdr, flags);
+  if (rc == -1 && (flags & MSG_DONTWAIT) && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    free_byte_array(from->ba);
+    return rc;
+  }
+  if (rc == 0 || (rc == -1 && (errno == ECONNRESET || errno == ENOTCONN))) {
+    free_byte_array(from->ba);
+    return 0;
+  }
+  assert(rc > -1 && rc != 0 && rc < (int)from->ba.len);
+
+  fill_sctp_msg(&hdr, from, rc);
+
+  return rc;
+}
+
 sctp_msg_t e2ap_recv_sctp_msg(e2ap_ep_t* ep)
 {
   assert(ep != NULL);
 
   sctp_msg_t from = {0};
 
-  from.ba.len = 32 * 1024;
-  from.ba.buf = malloc(32 * 1024);
-  assert(from.ba.buf != NULL && "Memory exhausted");
+  lock_guard(&ep->mtx);
+  int const rc = recv_sctp_msg(ep->fd, &from, 0);
+  assert(rc > 0);
 
-  socklen_t len = sizeof(from.info.addr);
-  int msg_flags = 0;
+  return from;
+}
 
-  lock_guard(&((e2ap_ep_t*)ep)->mtx);
-  int const rc =
-      sctp_recvmsg(ep->fd, from.ba.buf, from.ba.len, (struct sockaddr*)&from.info.addr, &len, &from.info.sri, &msg_flags);
-  assert(rc > -1 && rc != 0 && rc < (int)from.ba.len);
+static size_t recv_sctp_msg_batch(int fd, size_t len, sctp_msg_t msg[len], bool* eof)
+{
+  size_t i = 0;
+  while (i < len) {
+    memset(&msg[i], 0, sizeof(msg[i]));
+    int const rc = recv_sctp_msg(fd, &msg[i], MSG_DONTWAIT);
+    if (rc == -1)
+      break;
 
-  if (msg_flags & MSG_NOTIFICATION) {
-    assert((msg_flags & MSG_EOR) && "Notification received but the buffer is not large enough");
-    uint8_t buf[2048] = {0};
-    memcpy(buf, from.ba.buf, 2048);
-    free(from.ba.buf);
+    if (rc == 0) {
+      *eof = true;
+      break;
+    }
 
-    from.type = SCTP_MSG_NOTIFICATION;
-    from.notif = calloc(1, sizeof(union sctp_notification));
-    assert(from.notif != NULL && "Memory exhausted");
+    i += 1;
+    // The association state changed. Let the caller act before reading more
+    if (msg[i - 1].type == SCTP_MSG_NOTIFICATION)
+      break;
+  }
 
-    *from.notif = cp_sctp_notification((union sctp_notification*)buf, rc);
-  } else {
-    from.type = SCTP_MSG_PAYLOAD;
-    from.ba.len = rc; // set actually received number of bytes
+  return i;
+}
+
+size_t e2ap_recv_sctp_msg_batch(e2ap_ep_t* ep, size_t len, sctp_msg_t msg[len])
+{
+  assert(ep != NULL);
+  assert(len > 0);
+
+  bool eof = false;
+
+  lock_guard(&ep->mtx);
+  size_t const n = recv_sctp_msg_batch(ep->fd, len, msg, &eof);
+  assert(eof == false && "One-to-many sockets are never closed by the peer");
+
+  return n;
+}
+
+size_t e2ap_recv_sctp_msg_batch_fd(int fd, size_t len, sctp_msg_t msg[len], bool* eof)
+{
+  assert(fd > 0);
+  assert(len > 0);
+  assert(eof != NULL);
+
+  *eof = false;
+
+  size_t const n = recv_sctp_msg_batch(fd, len, msg, eof);
+  for (size_t i = 0; i < n; ++i)
+    msg[i].info.fd = fd;
+
+  return n;
+}
+
+bool e2ap_sctp_msg_from_buf(struct msghdr const* hdr, uint8_t const* buf, size_t len, sctp_msg_t* out)
+{
+  assert(hdr != NULL);
+  assert(buf != NULL);
+  assert(len > 0);
+  assert(out != NULL);
+
+  if (len > BYTE_ARRAY_POOL_MAX_SZ) {
+    printf("[E2AP-EP]: Message of %zu bytes larger than %d. Dropped \n", len, BYTE_ARRAY_POOL_MAX_SZ);
+    return false;
   }
 
-  return from;
+  sctp_msg_t from = {0};
+  if (hdr->msg_name != NULL)
+    memcpy(&from.info.addr, hdr->msg_name, hdr->msg_namelen < sizeof(from.info.addr) ? hdr->msg_namelen : sizeof(from.info.addr));
+
+  from.ba = alloc_byte_array_pool(len);
+  memcpy(from.ba.buf, buf, len);
+
+  fill_sctp_msg((struct msghdr*)hdr, &from, len);
+  *out = from;
+  return true;
 }
@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <netinet/in.h>
 #include <netinet/sctp.h>
 #include <stdlib.h>
@@ -48,9 +49,26 @@ void e2ap_ep_init(e2ap_ep_t* ep);
 
 void e2ap_ep_free(e2ap_ep_t* ep);
 
+// Sent through msg->info.fd if the association was peeled off
 void e2ap_send_sctp_msg(const e2ap_ep_t* ep, sctp_msg_t* msg);
 
+// Lock free. fd is a peeled off (one-to-one) SCTP socket
+void e2ap_send_sctp_msg_fd(int fd, sctp_msg_t const* msg);
+
 sctp_msg_t e2ap_recv_sctp_msg(e2ap_ep_t* ep);
 
-#endif
+// Non-blocking reads until the socket is drained or len messages arrived.
+// A notification stops the batch and is always its last message
+size_t e2ap_recv_sctp_msg_batch(e2ap_ep_t* ep, size_t len, sctp_msg_t msg[len]);
+
+// Same as above for a peeled off (one-to-one) SCTP socket. Lock free, as
+// the caller must be the only reader of fd. eof is set if the peer closed
+// the association. info.fd of the messages is set to fd
+size_t e2ap_recv_sctp_msg_batch_fd(int fd, size_t len, sctp_msg_t msg[len], bool* eof);
 
+// Message out of a datagram read by other means, e.g., io_uring. hdr carries
+// the source address, the control data and the flags of the read. buf is copied.
+// False if len exceeds BYTE_ARRAY_POOL_MAX_SZ, i.e., the message is dropped
+bool e2ap_sctp_msg_from_buf(struct msghdr const* hdr, uint8_t const* buf, size_t len, sctp_msg_t* out);
+
+#endif
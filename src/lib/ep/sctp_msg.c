@@ -33,6 +33,16 @@ void free_sctp_msg(sctp_msg_t* rcv)
    assert(0!=0 && "Unknown type");
 }
 
+void free_sctp_msg_arr(sctp_msg_arr_t* arr)
+{
+  assert(arr != NULL);
+
+  for(size_t i = 0; i < arr->len; ++i)
+    free_sctp_msg(&arr->msg[i]);
+
+  free(arr->msg);
+}
+
 
 static
 int cmp_sockaddr_in(struct sockaddr_in const* m0, struct sockaddr_in const* m1)
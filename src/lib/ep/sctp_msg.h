@@ -44,6 +44,9 @@ typedef enum {
 typedef struct{
   struct sockaddr_in addr; 
   struct sctp_sndrcvinfo sri;
+  // Peeled off socket of the association. 0 if it is reached
+  // through the endpoint socket
+  int fd;
 } sctp_info_t ;
 
 int cmp_sctp_info_wrapper(void const* m0, void const* m1);
@@ -61,5 +64,13 @@ typedef struct{
 
 void free_sctp_msg(sctp_msg_t* rcv);
 
+// Messages drained from a socket in one reactor wake up
+typedef struct{
+  sctp_msg_t* msg;
+  size_t len;
+} sctp_msg_arr_t;
+
+void free_sctp_msg_arr(sctp_msg_arr_t* arr);
+
 #endif
 
@@ -0,0 +1,560 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "sctp_uring.h"
+#include "e2ap_ep.h"
+#include "../../util/byte_array_pool.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SCTP_URING_SQ_ENTRIES 64
+#define SCTP_URING_CQ_ENTRIES 1024
+// Power of 2. Buffers the kernel can fill before the loop reaps them
+#define SCTP_URING_BUFS 64
+#define SCTP_URING_BGID 0
+#define SCTP_URING_MAX_FD 64
+
+// Low byte of the user_data. The slot index goes above it, and the
+// generation of the slot in the upper 32 bits
+enum{
+  POLL_UD = 1,
+  RECV_UD = 2,
+  CANCEL_UD = 3,
+};
+
+typedef struct{
+  int fd;
+  // POLL_UD or RECV_UD. 0 if the slot is free
+  int kind;
+  // Bumped every time the slot is taken. The completions of the requests
+  // of a removed fd, or of a closed fd number reused, do not match it
+  uint32_t gen;
+  // Readable since the last wait
+  bool ready;
+  // The multishot request ended and has to be submitted again
+  bool rearm;
+
+  // FIFO of the messages read and not taken
+  sctp_msg_t* msg;
+  size_t head;
+  size_t tail;
+  size_t cap;
+} slot_uring_t;
+
+struct sctp_uring_s{
+  int fd;
+
+  // Submission and completion queues share the mapping
+  void* ring;
+  size_t ring_sz;
+
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_array;
+  unsigned sq_mask;
+  unsigned sq_entries;
+  // Queued and not submitted yet
+  unsigned sq_pending;
+  struct io_uring_sqe* sqes;
+  size_t sqes_sz;
+
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned cq_mask;
+  struct io_uring_cqe* cqes;
+
+  // Buffers provided to the multishot receives
+  struct io_uring_buf_ring* br;
+  size_t br_sz;
+  uint16_t br_tail;
+  uint8_t* bufs;
+  size_t buf_sz;
+
+  // Sizes of the name and control areas of every buffer. The kernel keeps
+  // a copy of it per receive
+  struct msghdr hdr;
+
+  slot_uring_t slot[SCTP_URING_MAX_FD];
+};
+
+static int setup_uring(unsigned entries, struct io_uring_params* p)
+{
+  return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int enter_uring(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, size_t sz)
+{
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, sz);
+}
+
+static int register_uring(int fd, unsigned op, void* arg, unsigned nr)
+{
+  return syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+static uint64_t user_data(uint32_t gen, size_t idx, int kind)
+{
+  return ((uint64_t)gen << 32) | ((uint64_t)idx << 8) | (uint64_t)kind;
+}
+
+static uint64_t slot_user_data(sctp_uring_t const* u, slot_uring_t const* s)
+{
+  return user_data(s->gen, s - u->slot, s->kind);
+}
+
+static void submit_uring(sctp_uring_t* u)
+{
+  while (u->sq_pending > 0) {
+    int const rc = enter_uring(u->fd, u->sq_pending, 0, 0, NULL, 0);
+    assert((rc > 0 || errno == EINTR || errno == EAGAIN) && "io_uring_enter failed");
+    if (rc > 0)
+      u->sq_pending -= rc;
+  }
+}
+
+static void push_sqe(sctp_uring_t* u, struct io_uring_sqe const* sqe)
+{
+  unsigned const tail = *u->sq_tail;
+  if (tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) == u->sq_entries)
+    submit_uring(u);
+
+  unsigned const idx = tail & u->sq_mask;
+  u->sqes[idx] = *sqe;
+  u->sq_array[idx] = idx;
+  __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  u->sq_pending += 1;
+}
+
+static void push_poll(sctp_uring_t* u, int fd, uint64_t ud)
+{
+  struct io_uring_sqe const sqe = {.opcode = IORING_OP_POLL_ADD,
+                                   .fd = fd,
+                                   .len = IORING_POLL_ADD_MULTI,
+                                   .poll32_events = POLLIN,
+                                   .user_data = ud};
+  push_sqe(u, &sqe);
+}
+
+static void push_recv(sctp_uring_t* u, int fd, uint64_t ud)
+{
+  struct io_uring_sqe const sqe = {.opcode = IORING_OP_RECVMSG,
+                                   .flags = IOSQE_BUFFER_SELECT,
+                                   .ioprio = IORING_RECV_MULTISHOT,
+                                   .fd = fd,
+                                   .addr = (uint64_t)(uintptr_t)&u->hdr,
+                                   .len = 1,
+                                   .buf_group = SCTP_URING_BGID,
+                                   .user_data = ud};
+  push_sqe(u, &sqe);
+}
+
+static void push_cancel(sctp_uring_t* u, uint64_t ud)
+{
+  struct io_uring_sqe const sqe = {.opcode = IORING_OP_ASYNC_CANCEL,
+                                   .fd = -1,
+                                   .addr = ud,
+                                   .user_data = user_data(0, 0, CANCEL_UD)};
+  push_sqe(u, &sqe);
+}
+
+// The kernel sees it after commit_bufs
+static void recycle_buf(sctp_uring_t* u, uint16_t bid)
+{
+  struct io_uring_buf* b = &u->br->bufs[u->br_tail & (SCTP_URING_BUFS - 1)];
+  b->addr = (uint64_t)(uintptr_t)(u->bufs + bid * u->buf_sz);
+  b->len = u->buf_sz;
+  b->bid = bid;
+  u->br_tail += 1;
+}
+
+static void commit_bufs(sctp_uring_t* u)
+{
+  __atomic_store_n(&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+}
+
+static slot_uring_t* find_slot(sctp_uring_t* u, int fd, int kind)
+{
+  for (size_t i = 0; i < SCTP_URING_MAX_FD; ++i) {
+    if (u->slot[i].kind == kind && u->slot[i].fd == fd)
+      return &u->slot[i];
+  }
+  return NULL;
+}
+
+static slot_uring_t* add_slot(sctp_uring_t* u, int fd, int kind)
+{
+  assert(find_slot(u, fd, POLL_UD) == NULL && find_slot(u, fd, RECV_UD) == NULL && "fd already added");
+
+  slot_uring_t* s = find_slot(u, 0, 0);
+  assert(s != NULL && "No room for more fds");
+
+  // Never 0, that the probe uses
+  uint32_t const gen = s->gen + 1 == 0 ? 1 : s->gen + 1;
+  *s = (slot_uring_t){.fd = fd, .kind = kind, .gen = gen};
+  return s;
+}
+
+static void push_msg(slot_uring_t* s, sctp_msg_t msg)
+{
+  if (s->head == s->tail) {
+    s->head = 0;
+    s->tail = 0;
+  }
+
+  if (s->tail == s->cap) {
+    if (s->head > 0) {
+      memmove(s->msg, s->msg + s->head, (s->tail - s->head) * sizeof(sctp_msg_t));
+      s->tail -= s->head;
+      s->head = 0;
+    } else {
+      s->cap = s->cap == 0 ? 64 : 2 * s->cap;
+      s->msg = realloc(s->msg, s->cap * sizeof(sctp_msg_t));
+      assert(s->msg != NULL && "Memory exhausted");
+    }
+  }
+
+  s->msg[s->tail++] = msg;
+}
+
+// Layout of the buffer: io_uring_recvmsg_out, name area, control area, payload
+static void read_buf(sctp_uring_t* u, slot_uring_t* s, uint8_t* buf)
+{
+  struct io_uring_recvmsg_out const* out = (struct io_uring_recvmsg_out const*)buf;
+  if (out->flags & MSG_TRUNC) {
+    printf("[SCTP-URING]: Message larger than %d bytes on fd = %d. Dropped \n", BYTE_ARRAY_POOL_MAX_SZ, s->fd);
+    return;
+  }
+
+  uint8_t* name = buf + sizeof(*out);
+  uint8_t* ctrl = name + u->hdr.msg_namelen;
+  uint8_t* payload = ctrl + u->hdr.msg_controllen;
+
+  // E.g., the end of the stream of a one-to-one socket
+  if (out->payloadlen == 0)
+    return;
+
+  struct msghdr const hdr = {.msg_name = name,
+                             .msg_namelen = out->namelen < u->hdr.msg_namelen ? out->namelen : u->hdr.msg_namelen,
+                             .msg_control = ctrl,
+                             .msg_controllen = out->controllen < u->hdr.msg_controllen ? out->controllen : u->hdr.msg_controllen,
+                             .msg_flags = out->flags};
+
+  sctp_msg_t msg = {0};
+  if (e2ap_sctp_msg_from_buf(&hdr, payload, out->payloadlen, &msg) == true)
+    push_msg(s, msg);
+}
+
+static void on_cqe(sctp_uring_t* u, struct io_uring_cqe const* cqe)
+{
+  uint32_t const gen = cqe->user_data >> 32;
+  size_t const idx = (cqe->user_data >> 8) & 0xffffff;
+  int const kind = cqe->user_data & 0xff;
+  bool const has_buf = (cqe->flags & IORING_CQE_F_BUFFER) != 0;
+  uint16_t const bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+  // Removed meanwhile, e.g., the completions of a cancelled request that
+  // arrive after its slot was taken again, maybe by the same fd number
+  slot_uring_t* s = NULL;
+  if (kind != CANCEL_UD && idx < SCTP_URING_MAX_FD && u->slot[idx].kind == kind && u->slot[idx].gen == gen)
+    s = &u->slot[idx];
+
+  if (s != NULL) {
+    if (cqe->res >= 0 && kind == POLL_UD) {
+      s->ready = true;
+    } else if (cqe->res >= 0 && has_buf) {
+      read_buf(u, s, u->bufs + bid * u->buf_sz);
+    } else if (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -ECANCELED) {
+      printf("[SCTP-URING]: Request on fd = %d failed: %s\n", s->fd, strerror(-cqe->res));
+    }
+
+    // -ENOBUFS ends a receive. It is submitted again once the buffers return
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0)
+      s->rearm = true;
+  }
+
+  if (has_buf)
+    recycle_buf(u, bid);
+}
+
+static size_t reap_uring(sctp_uring_t* u)
+{
+  unsigned head = *u->cq_head;
+  unsigned const tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+  size_t n = 0;
+  for (; head != tail; ++head, ++n)
+    on_cqe(u, &u->cqes[head & u->cq_mask]);
+
+  __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+  commit_bufs(u);
+
+  for (size_t i = 0; i < SCTP_URING_MAX_FD; ++i) {
+    slot_uring_t* s = &u->slot[i];
+    if (s->kind == 0 || s->rearm == false)
+      continue;
+
+    s->rearm = false;
+    if (s->kind == POLL_UD)
+      push_poll(u, s->fd, slot_user_data(u, s));
+    else
+      push_recv(u, s->fd, slot_user_data(u, s));
+  }
+
+  return n;
+}
+
+// Multishot receives with provided buffers arrived in Linux 6.0. Older
+// kernels accept the request, and only fail at its completion
+static bool probe_recv_uring(sctp_uring_t* u)
+{
+  int sv[2] = {0};
+  int rc = socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sv);
+  assert(rc == 0);
+
+  uint8_t const b = 0;
+  ssize_t const sent = write(sv[1], &b, sizeof(b));
+  assert(sent == sizeof(b));
+
+  // Generation 0 matches no slot
+  uint64_t const ud = user_data(0, 0, RECV_UD);
+  push_recv(u, sv[0], ud);
+
+  struct __kernel_timespec ts = {.tv_sec = 1};
+  struct io_uring_getevents_arg arg = {.ts = (uint64_t)(uintptr_t)&ts};
+  rc = enter_uring(u->fd, u->sq_pending, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  u->sq_pending = 0;
+
+  bool ok = false;
+  unsigned const tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+  for (unsigned head = *u->cq_head; head != tail; ++head) {
+    struct io_uring_cqe const* cqe = &u->cqes[head & u->cq_mask];
+    ok |= cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER) != 0;
+  }
+  // No slot holds the probe. Its completions only return the buffers
+  reap_uring(u);
+
+  push_cancel(u, ud);
+  submit_uring(u);
+  close(sv[0]);
+  close(sv[1]);
+
+  return rc > -1 && ok;
+}
+
+sctp_uring_t* init_sctp_uring(void)
+{
+  struct io_uring_params p = {.flags = IORING_SETUP_CQSIZE, .cq_entries = SCTP_URING_CQ_ENTRIES};
+  int const fd = setup_uring(SCTP_URING_SQ_ENTRIES, &p);
+  if (fd == -1) {
+    printf("[SCTP-URING]: io_uring not available: %s\n", strerror(errno));
+    return NULL;
+  }
+
+  unsigned const feat = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  if ((p.features & feat) != feat) {
+    printf("[SCTP-URING]: io_uring lacks needed features\n");
+    close(fd);
+    return NULL;
+  }
+
+  sctp_uring_t* u = calloc(1, sizeof(sctp_uring_t));
+  assert(u != NULL && "Memory exhausted");
+  u->fd = fd;
+
+  size_t const sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  size_t const cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  u->ring_sz = sq_sz > cq_sz ? sq_sz : cq_sz;
+  u->ring = mmap(NULL, u->ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  assert(u->ring != MAP_FAILED);
+
+  uint8_t* r = u->ring;
+  u->sq_head = (unsigned*)(r + p.sq_off.head);
+  u->sq_tail = (unsigned*)(r + p.sq_off.tail);
+  u->sq_array = (unsigned*)(r + p.sq_off.array);
+  u->sq_mask = *(unsigned*)(r + p.sq_off.ring_mask);
+  u->sq_entries = p.sq_entries;
+  u->cq_head = (unsigned*)(r + p.cq_off.head);
+  u->cq_tail = (unsigned*)(r + p.cq_off.tail);
+  u->cq_mask = *(unsigned*)(r + p.cq_off.ring_mask);
+  u->cqes = (struct io_uring_cqe*)(r + p.cq_off.cqes);
+
+  u->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+  u->sqes = mmap(NULL, u->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  assert(u->sqes != MAP_FAILED);
+
+  u->hdr.msg_namelen = sizeof(struct sockaddr_in);
+  u->hdr.msg_controllen = CMSG_SPACE(sizeof(struct sctp_sndrcvinfo));
+  u->buf_sz = sizeof(struct io_uring_recvmsg_out) + u->hdr.msg_namelen + u->hdr.msg_controllen + BYTE_ARRAY_POOL_MAX_SZ;
+  u->bufs = mmap(NULL, SCTP_URING_BUFS * u->buf_sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  assert(u->bufs != MAP_FAILED);
+
+  u->br_sz = SCTP_URING_BUFS * sizeof(struct io_uring_buf);
+  u->br = mmap(NULL, u->br_sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  assert(u->br != MAP_FAILED);
+
+  struct io_uring_buf_reg reg = {.ring_addr = (uint64_t)(uintptr_t)u->br,
+                                 .ring_entries = SCTP_URING_BUFS,
+                                 .bgid = SCTP_URING_BGID};
+  if (register_uring(fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+    printf("[SCTP-URING]: Provided buffer rings not supported: %s\n", strerror(errno));
+    free_sctp_uring(u);
+    return NULL;
+  }
+
+  for (uint16_t i = 0; i < SCTP_URING_BUFS; ++i)
+    recycle_buf(u, i);
+  commit_bufs(u);
+
+  if (probe_recv_uring(u) == false) {
+    printf("[SCTP-URING]: Multishot receives not supported\n");
+    free_sctp_uring(u);
+    return NULL;
+  }
+
+  return u;
+}
+
+void free_sctp_uring(sctp_uring_t* u)
+{
+  assert(u != NULL);
+
+  for (size_t i = 0; i < SCTP_URING_MAX_FD; ++i) {
+    slot_uring_t* s = &u->slot[i];
+    for (size_t j = s->head; j < s->tail; ++j)
+      free_sctp_msg(&s->msg[j]);
+    free(s->msg);
+  }
+
+  // Closing the ring cancels the requests in flight
+  close(u->fd);
+  munmap(u->br, u->br_sz);
+  munmap(u->bufs, SCTP_URING_BUFS * u->buf_sz);
+  munmap(u->sqes, u->sqes_sz);
+  munmap(u->ring, u->ring_sz);
+  free(u);
+}
+
+void add_poll_sctp_uring(sctp_uring_t* u, int fd)
+{
+  assert(u != NULL);
+  assert(fd > 0);
+
+  slot_uring_t const* s = add_slot(u, fd, POLL_UD);
+  push_poll(u, fd, slot_user_data(u, s));
+}
+
+void add_recv_sctp_uring(sctp_uring_t* u, int fd)
+{
+  assert(u != NULL);
+  assert(fd > 0);
+
+  slot_uring_t const* s = add_slot(u, fd, RECV_UD);
+  push_recv(u, fd, slot_user_data(u, s));
+}
+
+void rm_fd_sctp_uring(sctp_uring_t* u, int fd)
+{
+  assert(u != NULL);
+
+  slot_uring_t* s = find_slot(u, fd, POLL_UD);
+  if (s == NULL)
+    s = find_slot(u, fd, RECV_UD);
+  assert(s != NULL && "fd not added");
+
+  // Before the caller closes fd
+  push_cancel(u, slot_user_data(u, s));
+  submit_uring(u);
+
+  for (size_t j = s->head; j < s->tail; ++j)
+    free_sctp_msg(&s->msg[j]);
+  free(s->msg);
+  // The generation stays, so that its completions still in flight are ignored
+  *s = (slot_uring_t){.gen = s->gen};
+}
+
+static bool stashed_msgs(sctp_uring_t const* u)
+{
+  for (size_t i = 0; i < SCTP_URING_MAX_FD; ++i) {
+    if (u->slot[i].head != u->slot[i].tail)
+      return true;
+  }
+  return false;
+}
+
+int wait_sctp_uring(sctp_uring_t* u, int timeout_ms, int len, int fd[len])
+{
+  assert(u != NULL);
+  assert(timeout_ms > -1);
+  assert(len > 0);
+
+  // Queued requests are submitted and completions waited in one syscall
+  struct __kernel_timespec ts = {.tv_sec = timeout_ms / 1000, .tv_nsec = (timeout_ms % 1000) * 1000000L};
+  struct io_uring_getevents_arg arg = {.ts = (uint64_t)(uintptr_t)&ts};
+  unsigned const min_complete = stashed_msgs(u) ? 0 : 1;
+
+  int const rc = enter_uring(u->fd, u->sq_pending, min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  assert((rc > -1 || errno == ETIME || errno == EINTR || errno == EBUSY) && "io_uring_enter failed");
+  if (rc > 0)
+    u->sq_pending -= rc;
+
+  reap_uring(u);
+
+  int n = 0;
+  for (size_t i = 0; i < SCTP_URING_MAX_FD && n < len; ++i) {
+    slot_uring_t* s = &u->slot[i];
+    if (s->ready == true || s->head != s->tail)
+      fd[n++] = s->fd;
+    s->ready = false;
+  }
+
+  return n;
+}
+
+size_t take_msgs_sctp_uring(sctp_uring_t* u, int fd, size_t len, sctp_msg_t msg[len])
+{
+  assert(u != NULL);
+  assert(len > 0);
+
+  slot_uring_t* s = find_slot(u, fd, RECV_UD);
+  assert(s != NULL && "fd not added");
+
+  size_t n = 0;
+  while (n < len && s->head != s->tail) {
+    msg[n] = s->msg[s->head++];
+    // The association state changed. Let the caller act before taking more
+    if (msg[n++].type == SCTP_MSG_NOTIFICATION)
+      break;
+  }
+
+  return n;
+}
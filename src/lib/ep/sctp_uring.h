@@ -0,0 +1,62 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef SCTP_URING_H
+#define SCTP_URING_H
+
+// io_uring reactor for the event loops. The readiness of plain fds, e.g.,
+// timerfds, is reported through multishot polls. SCTP sockets are read by
+// multishot receives into a ring of buffers provided to the kernel, so
+// one io_uring_enter() both waits and drains all the sockets. The messages
+// read are kept until the loop takes them. Needs Linux >= 6.0.
+// Not thread-safe: only the thread that waits may call the functions
+
+#include "sctp_msg.h"
+
+#include <stddef.h>
+
+typedef struct sctp_uring_s sctp_uring_t;
+
+// NULL if the kernel lacks any of the needed features. The caller then
+// keeps its epoll loop
+sctp_uring_t* init_sctp_uring(void);
+
+void free_sctp_uring(sctp_uring_t* u);
+
+// Reported when readable. The caller reads fd. Requests are queued, and
+// submitted by the next wait
+void add_poll_sctp_uring(sctp_uring_t* u, int fd);
+
+// SCTP socket. Reported when messages were read from it
+void add_recv_sctp_uring(sctp_uring_t* u, int fd);
+
+// Messages read from fd and not taken yet are freed. fd is not closed
+void rm_fd_sctp_uring(sctp_uring_t* u, int fd);
+
+// Waits up to timeout_ms for events. Does not block if messages were
+// read and not taken. Returns the number of fds reported
+int wait_sctp_uring(sctp_uring_t* u, int timeout_ms, int len, int fd[len]);
+
+// Messages read from fd in arrival order. A notification stops the batch
+// and is always its last message. Ownership of the messages is transferred
+size_t take_msgs_sctp_uring(sctp_uring_t* u, int fd, size_t len, sctp_msg_t msg[len]);
+
+#endif
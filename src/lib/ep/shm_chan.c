@@ -0,0 +1,491 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#define _GNU_SOURCE // memfd_create, SO_PEERCRED
+
+#include "shm_chan.h"
+#include "../../util/alg_ds/ds/lock_guard/lock_guard.h"
+#include "../../util/byte_array_pool.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The rings are shared across processes");
+
+#define SHM_CHAN_MAGIC 0x45343253u // E42S
+
+struct shm_ring_s{
+  // Written by the consumer
+  alignas(64) _Atomic uint64_t head;
+  // Written by the producer
+  alignas(64) _Atomic uint64_t tail;
+  alignas(64) uint64_t cap;
+  uint32_t magic;
+  uint8_t data[];
+};
+
+// E42 SCTP port of the xApp, so that the iApp can check that
+// the xApp ID belongs to the association
+typedef struct{
+  uint32_t magic;
+  uint16_t xapp_id;
+  uint16_t sctp_port;
+} shm_hello_t;
+
+typedef struct{
+  uint32_t magic;
+  uint64_t cap;
+} shm_ack_t;
+
+enum{
+  SHM_RING_IAPP_XAPP,
+  SHM_RING_XAPP_IAPP,
+  SHM_RING_END
+};
+
+static size_t ring_stride(size_t cap)
+{
+  size_t const page = sysconf(_SC_PAGESIZE);
+  size_t const sz = sizeof(shm_ring_t) + cap;
+  return (sz + page - 1) / page * page;
+}
+
+static shm_ring_t* ring_at(void* mem, size_t cap, size_t i)
+{
+  assert(i < SHM_RING_END);
+  return (shm_ring_t*)((uint8_t*)mem + i * ring_stride(cap));
+}
+
+static size_t round_up_pow2(size_t n)
+{
+  size_t p = SHM_CHAN_RING_MIN;
+  while (p < n && p < SHM_CHAN_RING_MAX)
+    p <<= 1;
+  return p;
+}
+
+static void cp_to_ring(shm_ring_t* r, size_t cap, uint64_t pos, void const* src, size_t len)
+{
+  size_t const off = pos & (cap - 1);
+  size_t const first = len < cap - off ? len : cap - off;
+  memcpy(&r->data[off], src, first);
+  memcpy(r->data, (uint8_t const*)src + first, len - first);
+}
+
+static void cp_from_ring(shm_ring_t const* r, size_t cap, uint64_t pos, void* dst, size_t len)
+{
+  size_t const off = pos & (cap - 1);
+  size_t const first = len < cap - off ? len : cap - off;
+  memcpy(dst, &r->data[off], first);
+  memcpy((uint8_t*)dst + first, r->data, len - first);
+}
+
+static void notify_fd(int fd)
+{
+  uint64_t const one = 1;
+  ssize_t const rc = write(fd, &one, sizeof(one));
+  // EAGAIN only if the counter saturated, i.e., the consumer is awake anyway
+  assert(rc == sizeof(one) || (rc == -1 && errno == EAGAIN));
+}
+
+static socklen_t abstract_addr(int port, struct sockaddr_un* addr)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  // Abstract namespace. Leading '\0', gone with the last socket
+  int const n = snprintf(&addr->sun_path[1], sizeof(addr->sun_path) - 1, "flexric-e42-%d", port);
+  assert(n > 0 && (size_t)n < sizeof(addr->sun_path) - 1);
+  return offsetof(struct sockaddr_un, sun_path) + 1 + n;
+}
+
+static void set_timeout(int fd, long ms)
+{
+  struct timeval const tv = {.tv_sec = ms / 1000, .tv_usec = (ms % 1000) * 1000};
+  int rc = setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  assert(rc == 0);
+  rc = setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  assert(rc == 0);
+}
+
+static shm_chan_t* init_chan(void* mem, size_t sz, size_t cap, size_t tx, size_t rx, int tx_fd, int rx_fd)
+{
+  shm_chan_t* ch = calloc(1, sizeof(shm_chan_t));
+  assert(ch != NULL && "Memory exhausted");
+
+  ch->mem = mem;
+  ch->sz = sz;
+  ch->cap = cap;
+  ch->tx = ring_at(mem, cap, tx);
+  ch->rx = ring_at(mem, cap, rx);
+  ch->tx_fd = tx_fd;
+  ch->rx_fd = rx_fd;
+  ch->full_ms = SHM_CHAN_FULL_MS;
+  atomic_init(&ch->refs, 1);
+  atomic_init(&ch->closed, false);
+
+  int const rc = pthread_mutex_init(&ch->tx_mtx, NULL);
+  assert(rc == 0);
+
+  return ch;
+}
+
+int listen_shm_chan(int port)
+{
+  assert(port > 0 && port < 65535);
+
+  int const fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  assert(fd != -1);
+
+  struct sockaddr_un addr;
+  socklen_t const len = abstract_addr(port, &addr);
+  if (bind(fd, (struct sockaddr*)&addr, len) == -1) {
+    printf("[E42-SHM]: Shared memory channels not offered: %s \n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  int const rc = listen(fd, 32);
+  assert(rc == 0);
+
+  return fd;
+}
+
+// Only the same user, or root, is handed a channel
+static bool same_user(int fd)
+{
+  struct ucred cred = {0};
+  socklen_t len = sizeof(cred);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1)
+    return false;
+  return cred.uid == geteuid() || cred.uid == 0;
+}
+
+static bool send_fds(int fd, shm_ack_t const* ack, size_t len, int const fds[len])
+{
+  char cmsg_buf[CMSG_SPACE(sizeof(int) * SHM_RING_END + sizeof(int))] = {0};
+  assert(CMSG_SPACE(sizeof(int) * len) <= sizeof(cmsg_buf));
+
+  struct iovec iov = {.iov_base = (void*)ack, .iov_len = sizeof(*ack)};
+  struct msghdr hdr = {.msg_iov = &iov,
+                       .msg_iovlen = 1,
+                       .msg_control = cmsg_buf,
+                       .msg_controllen = CMSG_SPACE(sizeof(int) * len)};
+
+  struct cmsghdr* c = CMSG_FIRSTHDR(&hdr);
+  c->cmsg_level = SOL_SOCKET;
+  c->cmsg_type = SCM_RIGHTS;
+  c->cmsg_len = CMSG_LEN(sizeof(int) * len);
+  memcpy(CMSG_DATA(c), fds, sizeof(int) * len);
+
+  return sendmsg(fd, &hdr, MSG_NOSIGNAL) == sizeof(*ack);
+}
+
+shm_chan_t* accept_shm_chan(int lfd, size_t ring, bool (*valid)(void* data, uint16_t xapp_id, uint16_t sctp_port), void* data, uint16_t* xapp_id)
+{
+  assert(lfd > -1);
+  assert(ring > 0);
+  assert(valid != NULL);
+  assert(xapp_id != NULL);
+
+  int const fd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC);
+  if (fd == -1)
+    return NULL;
+  defer({ close(fd); });
+
+  // The iApp event loop must not stall on a misbehaving peer
+  set_timeout(fd, 100);
+
+  shm_hello_t hello = {0};
+  if (same_user(fd) == false || recv(fd, &hello, sizeof(hello), 0) != sizeof(hello) || hello.magic != SHM_CHAN_MAGIC
+      || valid(data, hello.xapp_id, hello.sctp_port) == false) {
+    printf("[E42-SHM]: Shared memory channel refused \n");
+    return NULL;
+  }
+
+  size_t const cap = round_up_pow2(ring);
+  size_t const sz = SHM_RING_END * ring_stride(cap);
+
+  int const mem_fd = memfd_create("flexric-e42", MFD_CLOEXEC);
+  assert(mem_fd != -1);
+  defer({ close(mem_fd); });
+
+  int rc = ftruncate(mem_fd, sz);
+  assert(rc == 0);
+
+  void* mem = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+  assert(mem != MAP_FAILED);
+
+  for (size_t i = 0; i < SHM_RING_END; ++i) {
+    shm_ring_t* r = ring_at(mem, cap, i);
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->cap = cap;
+    r->magic = SHM_CHAN_MAGIC;
+  }
+
+  int const ev_fd[SHM_RING_END] = {eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+  assert(ev_fd[0] != -1 && ev_fd[1] != -1);
+
+  shm_ack_t const ack = {.magic = SHM_CHAN_MAGIC, .cap = cap};
+  int const fds[] = {mem_fd, ev_fd[SHM_RING_IAPP_XAPP], ev_fd[SHM_RING_XAPP_IAPP]};
+  if (send_fds(fd, &ack, sizeof(fds) / sizeof(fds[0]), fds) == false) {
+    printf("[E42-SHM]: Shared memory channel not handed over: %s \n", strerror(errno));
+    rc = munmap(mem, sz);
+    assert(rc == 0);
+    close(ev_fd[0]);
+    close(ev_fd[1]);
+    return NULL;
+  }
+
+  *xapp_id = hello.xapp_id;
+  return init_chan(mem, sz, cap, SHM_RING_IAPP_XAPP, SHM_RING_XAPP_IAPP, ev_fd[SHM_RING_IAPP_XAPP], ev_fd[SHM_RING_XAPP_IAPP]);
+}
+
+shm_chan_t* connect_shm_chan(int port, uint16_t xapp_id, uint16_t sctp_port)
+{
+  assert(port > 0 && port < 65535);
+
+  int const fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  assert(fd != -1);
+  defer({ close(fd); });
+
+  struct sockaddr_un addr;
+  socklen_t const len = abstract_addr(port, &addr);
+  // E.g., the nearRT-RIC is not on this host, or it does not offer channels
+  if (connect(fd, (struct sockaddr*)&addr, len) == -1)
+    return NULL;
+
+  set_timeout(fd, 1000);
+
+  shm_hello_t const hello = {.magic = SHM_CHAN_MAGIC, .xapp_id = xapp_id, .sctp_port = sctp_port};
+  if (send(fd, &hello, sizeof(hello), MSG_NOSIGNAL) != sizeof(hello))
+    return NULL;
+
+  shm_ack_t ack = {0};
+  char cmsg_buf[CMSG_SPACE(sizeof(int) * (SHM_RING_END + 1))] = {0};
+  struct iovec iov = {.iov_base = &ack, .iov_len = sizeof(ack)};
+  struct msghdr hdr = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = cmsg_buf, .msg_controllen = sizeof(cmsg_buf)};
+
+  // Refused if the iApp closes the socket without answering
+  ssize_t const rc = recvmsg(fd, &hdr, MSG_CMSG_CLOEXEC);
+  struct cmsghdr* c = CMSG_FIRSTHDR(&hdr);
+  if (rc != sizeof(ack) || c == NULL || c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS)
+    return NULL;
+
+  int fds[SHM_RING_END + 1] = {0};
+  assert(c->cmsg_len == CMSG_LEN(sizeof(fds)) && "iApp and xApp versions do not match");
+  memcpy(fds, CMSG_DATA(c), sizeof(fds));
+  int const mem_fd = fds[0];
+  defer({ close(mem_fd); });
+
+  size_t const cap = ack.cap;
+  assert(ack.magic == SHM_CHAN_MAGIC);
+  assert(cap >= SHM_CHAN_RING_MIN && cap <= SHM_CHAN_RING_MAX && (cap & (cap - 1)) == 0);
+
+  size_t const sz = SHM_RING_END * ring_stride(cap);
+  struct stat st = {0};
+  int const rc_st = fstat(mem_fd, &st);
+  assert(rc_st == 0 && (size_t)st.st_size == sz);
+
+  void* mem = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+  assert(mem != MAP_FAILED);
+
+  for (size_t i = 0; i < SHM_RING_END; ++i)
+    assert(ring_at(mem, cap, i)->magic == SHM_CHAN_MAGIC && ring_at(mem, cap, i)->cap == cap);
+
+  return init_chan(mem, sz, cap, SHM_RING_XAPP_IAPP, SHM_RING_IAPP_XAPP, fds[2], fds[1]);
+}
+
+void free_shm_chan(shm_chan_t* ch)
+{
+  assert(ch != NULL);
+
+  // Only the owner receives. Closing it also removes it from its epoll set
+  close(ch->rx_fd);
+  ch->rx_fd = -1;
+
+  atomic_store(&ch->closed, true);
+  release_shm_chan(ch);
+}
+
+shm_chan_t* acquire_shm_chan(shm_chan_t* ch)
+{
+  assert(ch != NULL);
+
+  // The caller reached it through the owner, that still holds its reference
+  unsigned const prev = atomic_fetch_add_explicit(&ch->refs, 1, memory_order_relaxed);
+  assert(prev > 0);
+  (void)prev;
+  return ch;
+}
+
+void release_shm_chan(shm_chan_t* ch)
+{
+  assert(ch != NULL);
+
+  unsigned const prev = atomic_fetch_sub_explicit(&ch->refs, 1, memory_order_acq_rel);
+  assert(prev > 0);
+  if (prev > 1)
+    return;
+
+  if (ch->waits > 0)
+    printf("[E42-SHM]: Senders waited %" PRIu64 " times for room in the ring \n", ch->waits);
+
+  int rc = munmap(ch->mem, ch->sz);
+  assert(rc == 0);
+
+  close(ch->tx_fd);
+
+  rc = pthread_mutex_destroy(&ch->tx_mtx);
+  assert(rc == 0);
+
+  free(ch);
+}
+
+static int64_t now_ms(void)
+{
+  struct timespec ts;
+  int const rc = clock_gettime(CLOCK_MONOTONIC, &ts);
+  assert(rc == 0);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t room_ring(shm_chan_t const* ch, uint64_t t)
+{
+  return ch->cap - (t - atomic_load_explicit(&ch->tx->head, memory_order_acquire));
+}
+
+// tx_mtx held. The consumer does not signal the room it makes, so back off
+// from 1 us up to 1 ms until need bytes are free, full_ms elapsed or the
+// owner closed the channel
+static bool wait_room(shm_chan_t* ch, uint64_t t, size_t need)
+{
+  if (room_ring(ch, t) >= need)
+    return true;
+
+  ch->waits += 1;
+  int64_t const deadline = now_ms() + ch->full_ms;
+  long ns = 1000;
+  while (room_ring(ch, t) < need) {
+    if (now_ms() > deadline || atomic_load_explicit(&ch->closed, memory_order_relaxed) == true)
+      return false;
+    struct timespec const ts = {.tv_nsec = ns};
+    nanosleep(&ts, NULL);
+    ns = ns < 1000000 ? 2 * ns : ns;
+  }
+  return true;
+}
+
+bool send_shm_chan(shm_chan_t* ch, byte_array_t ba)
+{
+  assert(ch != NULL);
+  assert(ba.buf != NULL && ba.len > 0);
+
+  size_t const need = sizeof(uint32_t) + ba.len;
+
+  lock_guard(&ch->tx_mtx);
+
+  if (ch->down == true || atomic_load(&ch->closed) == true)
+    return false;
+
+  shm_ring_t* r = ch->tx;
+  uint64_t const t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  // A message larger than the ring waits for the ring to drain, so that
+  // the peer got all the previous ones before it reads this from SCTP
+  if (need > ch->cap) {
+    if (wait_room(ch, t, ch->cap) == false)
+      printf("[E42-SHM]: Peer not draining the ring. Messages may be reordered \n");
+    printf("[E42-SHM]: Message of %zu bytes larger than the ring. SCTP from now on \n", ba.len);
+    ch->down = true;
+    return false;
+  }
+
+  if (wait_room(ch, t, need) == false) {
+    if (atomic_load(&ch->closed) == false)
+      printf("[E42-SHM]: Peer not making room in %u ms. SCTP from now on, messages may be reordered \n", ch->full_ms);
+    ch->down = true;
+    return false;
+  }
+
+  uint32_t const len = ba.len;
+  cp_to_ring(r, ch->cap, t, &len, sizeof(len));
+  cp_to_ring(r, ch->cap, t + sizeof(len), ba.buf, ba.len);
+  atomic_store_explicit(&r->tail, t + need, memory_order_seq_cst);
+
+  // The consumer stores head before it checks tail. If it got up to t,
+  // it may be waiting on the eventfd. Otherwise, it will see the new tail
+  if (atomic_load_explicit(&r->head, memory_order_seq_cst) == t)
+    notify_fd(ch->tx_fd);
+
+  return true;
+}
+
+size_t recv_shm_chan(shm_chan_t* ch, size_t len, byte_array_t ba[len])
+{
+  assert(ch != NULL);
+  assert(len > 0);
+
+  uint64_t cnt = 0;
+  ssize_t const rc = read(ch->rx_fd, &cnt, sizeof(cnt));
+  assert(rc == sizeof(cnt) || (rc == -1 && errno == EAGAIN));
+
+  shm_ring_t* r = ch->rx;
+  uint64_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+  size_t n = 0;
+  while (n < len) {
+    uint64_t const t = atomic_load_explicit(&r->tail, memory_order_seq_cst);
+    if (t == h)
+      break;
+
+    uint32_t sz = 0;
+    cp_from_ring(r, ch->cap, h, &sz, sizeof(sz));
+    assert(sz > 0 && sz <= t - h - sizeof(sz) && "Corrupted ring");
+
+    ba[n] = alloc_byte_array_pool(sz);
+    cp_from_ring(r, ch->cap, h + sizeof(sz), ba[n].buf, sz);
+    ++n;
+
+    h += sizeof(sz) + sz;
+    atomic_store_explicit(&r->head, h, memory_order_seq_cst);
+  }
+
+  // Batch full. Wake up again for the rest
+  if (n == len && atomic_load_explicit(&r->tail, memory_order_seq_cst) != h)
+    notify_fd(ch->rx_fd);
+
+  return n;
+}
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef SHM_CHANNEL_E42_H
+#define SHM_CHANNEL_E42_H
+
+// Shared memory transport between the iApp and a co-located xApp. One
+// memfd holds a single producer single consumer ring per direction, and
+// an eventfd per direction wakes up the consumer. The channel is handed
+// over through an abstract Unix socket once the E42 Setup is completed.
+// The E42 association remains, and carries every message once the
+// channel is down, i.e., a message larger than the ring or a peer that
+// does not make room in time. Messages never go back to the ring, so
+// none overtakes the ones still waiting in it
+
+#include "../../util/byte_array.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHM_CHAN_RING_MIN (64*1024)
+#define SHM_CHAN_RING_MAX (1024*1024*1024)
+
+// Time a sender waits for the peer to make room before giving up the channel
+#define SHM_CHAN_FULL_MS 1000
+
+typedef struct shm_ring_s shm_ring_t;
+
+typedef struct{
+  // Mapping of the memfd
+  void* mem;
+  size_t sz;
+
+  // Produced by this process, consumed by the peer
+  shm_ring_t* tx;
+  // Produced by the peer, consumed by this process
+  shm_ring_t* rx;
+
+  // Bytes of each ring. Power of 2
+  size_t cap;
+
+  // Written when tx turns non-empty
+  int tx_fd;
+  // Polled. Readable when rx turns non-empty
+  int rx_fd;
+
+  // Several threads send, e.g., the RIC workers forwarding indications
+  pthread_mutex_t tx_mtx;
+
+  // Times a sender waited for room in tx
+  uint64_t waits;
+  // Defaults to SHM_CHAN_FULL_MS
+  uint32_t full_ms;
+  // Every message goes through SCTP from now on
+  bool down;
+
+  // The owner plus the senders that pinned it to wait for room out of
+  // their own locks. The last one frees it
+  atomic_uint refs;
+  // free_shm_chan called. Waiting senders give up
+  atomic_bool closed;
+} shm_chan_t;
+
+// Abstract Unix socket where the iApp listening at E42 port hands over the channels
+int listen_shm_chan(int port);
+
+// iApp side. Creates a channel with rings of ring bytes, rounded up to a power of 2,
+// and hands it over to the xApp connecting to lfd. The hello of the xApp, i.e.,
+// its ID and E42 SCTP port, is checked through valid. NULL if refused
+shm_chan_t* accept_shm_chan(int lfd, size_t ring, bool (*valid)(void* data, uint16_t xapp_id, uint16_t sctp_port), void* data, uint16_t* xapp_id);
+
+// xApp side. NULL if the iApp at E42 port does not offer channels
+shm_chan_t* connect_shm_chan(int port, uint16_t xapp_id, uint16_t sctp_port);
+
+// Closes the receiving side and drops the reference of the owner. The
+// senders still holding one stop waiting for room
+void free_shm_chan(shm_chan_t* ch);
+
+// Pins ch, e.g., to send after releasing the lock that keeps it alive
+shm_chan_t* acquire_shm_chan(shm_chan_t* ch);
+
+void release_shm_chan(shm_chan_t* ch);
+
+// Waits while tx is full. False once the channel is down, and the caller
+// sends this and every later message through SCTP
+bool send_shm_chan(shm_chan_t* ch, byte_array_t ba);
+
+// Only one thread receives. Up to len messages, allocated from the byte array pool.
+// If more are left, rx_fd remains readable
+size_t recv_shm_chan(shm_chan_t* ch, size_t len, byte_array_t ba[len]);
+
+#endif
@@ -24,7 +24,9 @@
 #include <bits/types/struct_itimerspec.h> // for itimerspec
 #include <errno.h> // for errno
 #include <fcntl.h> // for fcntl, F_GETFL, F_SETFL
+#include <stdint.h> // for uint64_t, UINT64_MAX
 #include <stdio.h> // for NULL, printf, fflush, stdout
+#include <stdlib.h> // for calloc
 #include <string.h> // for strerror
 #include <sys/epoll.h> // for epoll_event, epoll_ctl
 #include <sys/time.h> // for CLOCK_MONOTONIC
@@ -32,6 +34,8 @@
 #include <time.h> // for time_t, timespec
 #include <unistd.h> // for close
 
+#include "../util/alg_ds/ds/lock_guard/lock_guard.h"
+
 static void set_fd_non_blocking(int sfd)
 {
   int flags = fcntl(sfd, F_GETFL, 0);
@@ -39,13 +43,82 @@ static void set_fd_non_blocking(int sfd)
   fcntl(sfd, F_SETFL, flags);
 }
 
+// The timer wheel tick is 1 ms of CLOCK_MONOTONIC
+static uint64_t now_ms(void)
+{
+  struct timespec ts = {0};
+  int rc = clock_gettime(CLOCK_MONOTONIC, &ts);
+  assert(rc == 0);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Precondition: io->tw_mtx locked
+static void program_timerfd(asio_ric_t* io)
+{
+  uint64_t const tick = next_tick_timer_wheel(&io->tw);
+  if (tick == io->tfd_tick)
+    return;
+
+  // A zero it_value disarms the timerfd. Expired but not yet popped timers
+  // are signaled with an absolute time in the past
+  struct itimerspec new_value = {0};
+  if (tick == 0) {
+    new_value.it_value.tv_nsec = 1;
+  } else if (tick != UINT64_MAX) {
+    new_value.it_value.tv_sec = tick / 1000;
+    new_value.it_value.tv_nsec = (tick % 1000) * 1000000;
+  }
+
+  int rc = timerfd_settime(io->tfd, TFD_TIMER_ABSTIME, &new_value, NULL);
+  assert(rc != -1);
+  io->tfd_tick = tick;
+}
+
 void init_asio_ric(asio_ric_t* io)
 {
   assert(io != NULL);
-  const int flags = EPOLL_CLOEXEC;
-  const int efd = epoll_create1(flags);
-  assert(efd != -1);
-  io->efd = efd;
+
+  io->efd = -1;
+#ifdef ASIO_IO_URING
+  io->ring = init_sctp_uring();
+  if (io->ring != NULL)
+    printf("[NEAR-RIC]: io_uring event loop\n");
+  else
+#endif
+  {
+    const int flags = EPOLL_CLOEXEC;
+    const int efd = epoll_create1(flags);
+    assert(efd != -1);
+    io->efd = efd;
+  }
+
+  const int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  assert(tfd != -1);
+  io->tfd = tfd;
+  io->tfd_tick = UINT64_MAX;
+  init_timer_wheel(&io->tw, now_ms());
+
+  int rc = pthread_mutex_init(&io->tw_mtx, NULL);
+  assert(rc == 0);
+
+  add_fd_asio_ric(io, tfd);
+}
+
+void free_asio_ric(asio_ric_t* io)
+{
+  assert(io != NULL);
+
+#ifdef ASIO_IO_URING
+  if (io->ring != NULL)
+    free_sctp_uring(io->ring);
+  else
+#endif
+    close(io->efd);
+  close(io->tfd);
+  free_timer_wheel(&io->tw);
+
+  int rc = pthread_mutex_destroy(&io->tw_mtx);
+  assert(rc == 0);
 }
 
 void add_fd_asio_ric(asio_ric_t* io, int fd)
@@ -53,6 +126,13 @@ void add_fd_asio_ric(asio_ric_t* io, int fd)
   assert(io != NULL);
   assert(fd > 0 && "fd cannot be negative, data corrupted");
 
+#ifdef ASIO_IO_URING
+  if (io->ring != NULL) {
+    add_poll_sctp_uring(io->ring, fd);
+    return;
+  }
+#endif
+
   set_fd_non_blocking(io->efd);
   const int op = EPOLL_CTL_ADD;
   const epoll_data_t e_data = {.fd = fd};
@@ -62,6 +142,47 @@ void add_fd_asio_ric(asio_ric_t* io, int fd)
   assert(rc != -1);
 }
 
+void add_sock_asio_ric(asio_ric_t* io, int fd)
+{
+  assert(io != NULL);
+  assert(fd > 0 && "fd cannot be negative, data corrupted");
+
+#ifdef ASIO_IO_URING
+  if (io->ring != NULL) {
+    add_recv_sctp_uring(io->ring, fd);
+    return;
+  }
+#endif
+  add_fd_asio_ric(io, fd);
+}
+
+bool reads_sock_asio_ric(asio_ric_t const* io)
+{
+  assert(io != NULL);
+#ifdef ASIO_IO_URING
+  return io->ring != NULL;
+#else
+  return false;
+#endif
+}
+
+sctp_msg_arr_t take_msgs_asio_ric(asio_ric_t* io, int fd, size_t max)
+{
+  assert(io != NULL);
+  assert(reads_sock_asio_ric(io) == true);
+  assert(max > 0);
+
+  sctp_msg_arr_t arr = {.msg = calloc(max, sizeof(sctp_msg_t))};
+  assert(arr.msg != NULL && "Memory exhausted");
+
+#ifdef ASIO_IO_URING
+  arr.len = take_msgs_sctp_uring(io->ring, fd, max, arr.msg);
+#else
+  (void)fd;
+#endif
+  return arr;
+}
+
 int create_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms)
 {
   if (io == NULL || initial_ms <= 0 || interval_ms <= 0) {
@@ -85,6 +206,54 @@ int create_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms)
   return tfd;
 }
 
+int arm_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms)
+{
+  assert(io != NULL);
+  assert(initial_ms > 0);
+  assert(interval_ms >= 0);
+
+  lock_guard(&io->tw_mtx);
+
+  int const id = arm_timer_wheel(&io->tw, now_ms(), initial_ms, interval_ms);
+  // Only touch the timerfd if the new timer expires before the programmed one
+  if (next_tick_timer_wheel(&io->tw) < io->tfd_tick)
+    program_timerfd(io);
+
+  return id;
+}
+
+void cancel_timer_asio_ric(asio_ric_t* io, int id)
+{
+  assert(io != NULL);
+  assert(id > 0);
+
+  lock_guard(&io->tw_mtx);
+  // The timerfd is left as it is. A spurious wake up is cheaper than a syscall
+  cancel_timer_wheel(&io->tw, id);
+}
+
+static int expired_timers_asio_ric(asio_ric_t* io, int len, int tmr[len])
+{
+  assert(io != NULL);
+  assert(len > 0);
+
+  uint64_t read_buf = 0;
+  ssize_t bytes = read(io->tfd, &read_buf, sizeof(read_buf));
+  (void)bytes; // EAGAIN if the timer was re-programmed meanwhile
+
+  lock_guard(&io->tw_mtx);
+
+  uint64_t const now = now_ms();
+  advance_timer_wheel(&io->tw, now);
+  int const sz = pop_expired_timer_wheel(&io->tw, now, len, tmr);
+
+  // Force the re-arm, as the timerfd already fired
+  io->tfd_tick = 0;
+  program_timerfd(io);
+
+  return sz;
+}
+
 // int create_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms)
 // {
 //   assert(io != NULL);
@@ -121,6 +290,15 @@ int create_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms)
 void rm_fd_asio_ric(asio_ric_t* io, int fd)
 {
   assert(io != NULL);
+#ifdef ASIO_IO_URING
+  if (io->ring != NULL) {
+    rm_fd_sctp_uring(io->ring, fd);
+    int rc = close(fd);
+    assert(rc == 0);
+    return;
+  }
+#endif
+
   const int op = EPOLL_CTL_DEL;
   const epoll_data_t e_data = {.fd = fd};
   const int e_events = EPOLLIN; // open for reading
@@ -131,31 +309,62 @@ void rm_fd_asio_ric(asio_ric_t* io, int fd)
   assert(rc == 0);
 }
 
-fd_read_t event_asio_ric(asio_ric_t const* io)
+static int wait_epoll(asio_ric_t* io, int timeout_ms, int len, int fd[len])
 {
-  assert(io != NULL);
-
-  const int maxevents = 64;
-  struct epoll_event events[maxevents];
-  const int timeout_ms = 1000;
+  struct epoll_event events[len];
 
-  const int events_ready = epoll_wait(io->efd, events, maxevents, timeout_ms);
+  const int events_ready = epoll_wait(io->efd, events, len, timeout_ms);
   if (events_ready == -1) {
     printf("Error detected = %s \n", strerror(errno));
     fflush(stdout);
   }
-  assert(events_ready == 0 || events_ready <= maxevents);
+  assert(events_ready == -1 || events_ready <= len);
+
+  for (int i = 0; i < events_ready; ++i) {
+    assert((events[i].events & EPOLLERR) == 0);
+    fd[i] = events[i].data.fd;
+  }
+
+  return events_ready;
+}
+
+fd_read_t event_asio_ric(asio_ric_t* io)
+{
+  assert(io != NULL);
+
+  const int maxevents = 64;
+  int fd[maxevents];
+  const int timeout_ms = 1000;
+
+#ifdef ASIO_IO_URING
+  // With io_uring, the sockets are also drained in this wait
+  const int events_ready = io->ring != NULL ? wait_sctp_uring(io->ring, timeout_ms, maxevents, fd)
+                                            : wait_epoll(io, timeout_ms, maxevents, fd);
+#else
+  const int events_ready = wait_epoll(io, timeout_ms, maxevents, fd);
+#endif
 
   fd_read_t fd_read = {.len = -1};
-  if (events_ready == 0)
+  if (events_ready < 1)
     return fd_read;
 
-  fd_read.len = events_ready;
+  fd_read.len = 0;
+  bool timer_expired = false;
   // Max. 64 event ready
   for (int i = 0; i < events_ready; ++i) {
-    assert((events[i].events & EPOLLERR) == 0);
-    fd_read.fd[i] = events[i].data.fd;
+    if (fd[i] == io->tfd) {
+      timer_expired = true;
+      continue;
+    }
+    fd_read.fd[fd_read.len++] = fd[i];
   }
 
+  // The timers that do not fit stay in the wheel and fire again in the next call
+  if (timer_expired == true)
+    fd_read.len_tmr = expired_timers_asio_ric(io, maxevents - fd_read.len, fd_read.tmr);
+
+  if (fd_read.len == 0 && fd_read.len_tmr == 0)
+    fd_read.len = -1;
+
   return fd_read;
 }
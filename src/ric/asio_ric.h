@@ -23,29 +23,67 @@
 #ifndef ASYNC_INPUT_OUTPUT_RIC_H
 #define ASYNC_INPUT_OUTPUT_RIC_H
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "../lib/ep/sctp_msg.h"
+#ifdef ASIO_IO_URING
+#include "../lib/ep/sctp_uring.h"
+#endif
+#include "../util/alg_ds/ds/timer_wheel/timer_wheel.h"
+
 typedef struct{
-  // epoll based fd
+  // epoll based fd. -1 if the io_uring backend is used
   int efd; 
 
+#ifdef ASIO_IO_URING
+  // io_uring backend. NULL if the kernel lacks the needed features
+  sctp_uring_t* ring;
+#endif
+
+  // Single timerfd driving the timer wheel
+  int tfd;
+  uint64_t tfd_tick;
+  timer_wheel_t tw;
+  pthread_mutex_t tw_mtx;
 } asio_ric_t;
 
 
 void init_asio_ric(asio_ric_t* io);
 
+void free_asio_ric(asio_ric_t* io);
+
 void add_fd_asio_ric(asio_ric_t* io, int fd);
 
+// SCTP socket. With io_uring, the loop itself reads the messages, which
+// are then taken through take_msgs_asio_ric
+void add_sock_asio_ric(asio_ric_t* io, int fd);
+
+bool reads_sock_asio_ric(asio_ric_t const* io);
+
+// Up to max messages read from fd. Only if reads_sock_asio_ric()
+sctp_msg_arr_t take_msgs_asio_ric(asio_ric_t* io, int fd, size_t max);
+
 int create_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms);
 
 void rm_fd_asio_ric(asio_ric_t* io, int fd);
 
+// Timers multiplexed in the timer wheel. No fd is created per timer.
+// Thread-safe. Returns a positive timer id
+int arm_timer_ms_asio_ric(asio_ric_t* io, long initial_ms, long interval_ms);
+
+void cancel_timer_asio_ric(asio_ric_t* io, int id);
+
 typedef struct{
   int fd[64];
   int len;
+  // Expired timer wheel ids
+  int tmr[64];
+  int len_tmr;
 } fd_read_t;
 
-fd_read_t event_asio_ric(asio_ric_t const* io);
+fd_read_t event_asio_ric(asio_ric_t* io);
 
 #endif
 
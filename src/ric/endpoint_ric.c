@@ -115,6 +115,18 @@ sctp_msg_t e2ap_recv_msg_ric(e2ap_ep_ric_t* ep)
   return rcv;
 }
 
+sctp_msg_arr_t e2ap_recv_msgs_ric(e2ap_ep_ric_t* ep, size_t max)
+{
+  assert(ep != NULL);
+  assert(max > 0);
+
+  sctp_msg_arr_t arr = {.msg = calloc(max, sizeof(sctp_msg_t))};
+  assert(arr.msg != NULL && "Memory exhausted");
+
+  arr.len = e2ap_recv_sctp_msg_batch(&ep->base, max, arr.msg);
+  return arr;
+}
+
 void e2ap_send_bytes_ric(const e2ap_ep_ric_t* ep, global_e2_node_id_t const* id , byte_array_t ba)
 {
   assert(ba.buf && ba.len > 0);
@@ -153,3 +165,19 @@ global_e2_node_id_t* e2ap_rm_sock_addr_ric(e2ap_ep_ric_t* ep, sctp_info_t const*
   return rm_map_sad_e2_node(&ep->e2_nodes, s);
 }
 
+bool e2ap_find_e2_node_ric(e2ap_ep_ric_t* ep, sctp_info_t const* s, global_e2_node_id_t* id)
+{
+  assert(ep != NULL);
+  assert(s != NULL);
+  assert(id != NULL);
+
+  return find_e2_node_map_sad(&ep->e2_nodes, s, id);
+}
+
+bool e2ap_find_sock_fd_ric(e2ap_ep_ric_t* ep, int fd, sctp_info_t* s)
+{
+  assert(ep != NULL);
+  assert(s != NULL);
+
+  return find_fd_map_e2_node_sad(&ep->e2_nodes, fd, s);
+}
@@ -42,6 +42,9 @@ void e2ap_free_ep_ric(e2ap_ep_ric_t* ep);
 
 sctp_msg_t e2ap_recv_msg_ric(e2ap_ep_ric_t* ep);
 
+// Drain up to max messages. The array must be freed, even if empty
+sctp_msg_arr_t e2ap_recv_msgs_ric(e2ap_ep_ric_t* ep, size_t max);
+
 void e2ap_send_bytes_ric(const e2ap_ep_ric_t* ep, global_e2_node_id_t const* id, byte_array_t ba);
 
 void e2ap_send_sctp_msg_ric(const e2ap_ep_ric_t* ep, sctp_msg_t* msg);
@@ -50,5 +53,10 @@ void e2ap_reg_sock_addr_ric(e2ap_ep_ric_t* ric, global_e2_node_id_t const* id, s
 
 global_e2_node_id_t* e2ap_rm_sock_addr_ric(e2ap_ep_ric_t* ric, sctp_info_t const* s);
 
+// E2 Node behind the association s. The copy is owned by the caller
+bool e2ap_find_e2_node_ric(e2ap_ep_ric_t* ric, sctp_info_t const* s, global_e2_node_id_t* id);
+
+bool e2ap_find_sock_fd_ric(e2ap_ep_ric_t* ric, int fd, sctp_info_t* s);
+
 #endif
 
@@ -46,11 +46,10 @@ accepted_pair_t accept_ran_func(near_ric_t* ric, const e2_setup_request_t* req)
   assert(dst.acc != NULL && "Memory exhausted");
 
   for (size_t i = 0; i < dst.len_acc; ++i) {
-    void* start_it = assoc_front(&ric->plugin.sm_ds);
     void* end_it = assoc_end(&ric->plugin.sm_ds);
     uint16_t const id = req->ran_func_item[i].id;
 
-    void* it = find_if(&ric->plugin.sm_ds, start_it, end_it, &id, eq_ran_func_id); 
+    void* it = assoc_find(&ric->plugin.sm_ds, &id);
 
     if(it != end_it){
       assert(id == *(uint16_t*)assoc_key(&ric->plugin.sm_ds, it) );
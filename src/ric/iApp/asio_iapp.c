@@ -82,6 +82,19 @@ void add_fd_asio_iapp(asio_iapp_t* io, int fd)
 
 }
 
+// Level triggered. The socket is drained up to a budget per wake up, so it
+// may still be readable when the reactor goes back to epoll_wait
+void add_sock_asio_iapp(asio_iapp_t* io, int fd)
+{
+  assert(io != NULL);
+  const int op = EPOLL_CTL_ADD;
+  const epoll_data_t e_data = {.fd = fd};
+  const int e_events = EPOLLIN; // open for reading
+  struct epoll_event event = {.events = e_events, .data = e_data};
+  int rc = epoll_ctl(io->efd, op, fd, &event);
+  assert(rc != -1);
+}
+
 void rm_fd_asio_iapp(asio_iapp_t* io, int fd)
 {
   assert(io != NULL);
@@ -45,6 +45,8 @@ void init_asio_iapp(asio_iapp_t* io);
 
 void add_fd_asio_iapp(asio_iapp_t* io, int fd);
 
+void add_sock_asio_iapp(asio_iapp_t* io, int fd);
+
 void rm_fd_asio_iapp(asio_iapp_t* io, int fd);
 
 int create_timer_ms_asio_iapp(asio_iapp_t* io, long initial_ms, long interval_ms);
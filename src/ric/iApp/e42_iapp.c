@@ -17,9 +17,10 @@
 #include <stdio.h>
 #include <pthread.h>
 
-e42_iapp_t* init_e42_iapp(const char* addr, near_ric_if_t ric_if)
+e42_iapp_t* init_e42_iapp(const char* addr, near_ric_if_t ric_if, size_t rx_batch, size_t shm_ring)
 {
   assert(addr != NULL);
+  assert(rx_batch > 0);
   //  assert(ric != NULL);
 
   printf("[iApp]: Initializing ... \n");
@@ -32,19 +33,20 @@ e42_iapp_t* init_e42_iapp(const char* addr, near_ric_if_t ric_if)
   // Emulator
   start_near_ric_iapp_gen(iapp->ric_if.type);
 
-  // Initialize mutex here, before any other initialization
-  init_forward_indication_mutex(iapp); // ADD THIS LINE
-
-  // Initialize subscription registry
-  init_subscription_registry(&iapp->subscription_registry);
+  init_ind_route_iapp(&iapp->ind_route);
 
   uint32_t const port = 36422;
   printf("[iApp]: nearRT-RIC IP Address = %s, PORT = %d\n", addr, port);
-  e2ap_init_ep_iapp(&iapp->ep, addr, port);
+  e2ap_init_ep_iapp(&iapp->ep, addr, port, shm_ring);
 
   init_asio_iapp(&iapp->io);
 
-  add_fd_asio_iapp(&iapp->io, iapp->ep.base.fd);
+  add_sock_asio_iapp(&iapp->io, iapp->ep.base.fd);
+
+  if (iapp->ep.shm_fd > -1)
+    add_sock_asio_iapp(&iapp->io, iapp->ep.shm_fd);
+
+  iapp->rx_batch = rx_batch;
 
   assert(iapp->io.efd < 1024);
 
@@ -71,16 +73,6 @@ e42_iapp_t* init_e42_iapp(const char* addr, near_ric_if_t ric_if)
   return iapp;
 }
 
-void init_forward_indication_mutex(e42_iapp_t* iapp)
-{
-  assert(iapp != NULL);
-  pthread_mutexattr_t attr;
-  pthread_mutexattr_init(&attr);
-  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-  pthread_mutex_init(&iapp->forward_mutex, &attr);
-  pthread_mutexattr_destroy(&attr);
-}
-
 static inline bool net_pkt(const e42_iapp_t* iapp, int fd)
 {
   assert(iapp != NULL);
@@ -130,19 +122,15 @@ static async_event_t next_async_event_iapp(e42_iapp_t* iapp)
   if (fd == -1) { // no event happened. Just for checking the stop_token condition
     e.type = CHECK_STOP_TOKEN_EVENT;
   } else if (net_pkt(iapp, fd) == true) {
-    e.msg = e2ap_recv_msg_iapp(&iapp->ep);
-    if (e.msg.type == SCTP_MSG_NOTIFICATION) {
-      if (e.msg.notif->sn_header.sn_type == SCTP_ASSOC_CHANGE) {
-        printf(" SCTP_ASSOC_CHANGE recived \n");
-        e.type = UNKNOWN_EVENT;
-        return e;
-      }
-      e.type = SCTP_CONNECTION_SHUTDOWN_EVENT;
-    } else if (e.msg.type == SCTP_MSG_PAYLOAD) {
-      e.type = SCTP_MSG_ARRIVED_EVENT;
-    } else {
-      assert(0 != 0 && "Unknown type");
-    }
+    // Drain the socket. One epoll round trip for up to rx_batch messages
+    e.msgs = e2ap_recv_msgs_iapp(&iapp->ep, iapp->rx_batch);
+    e.type = SCTP_MSG_BATCH_ARRIVED_EVENT;
+  } else if (fd == iapp->ep.shm_fd) {
+    e.type = SHM_CHANNEL_EVENT;
+  } else if (e2ap_shm_fd_iapp(&iapp->ep, fd) == true) {
+    // Handled as if they had arrived through the xApp association
+    e.msgs = e2ap_recv_shm_msgs_iapp(&iapp->ep, fd, iapp->rx_batch);
+    e.type = SCTP_MSG_BATCH_ARRIVED_EVENT;
     /*
       } else if(aind_event(iapp, fd, &e.ai_ev) == true) {
         e.type = APERIODIC_INDICATION_EVENT;
@@ -189,61 +177,88 @@ static void rm_if_pending_subs(e42_iapp_t* iapp, uint16_t xapp_id)
   for_each_arr(&arr, f, l, gen_e2ap_subs_delete, data);
 }
 
-static void e2_event_loop_iapp(e42_iapp_t* iapp)
+static void handle_sctp_msg_iapp(e42_iapp_t* iapp, sctp_msg_t const* sctp_msg_rx)
 {
   assert(iapp != NULL);
-  while (iapp->stop_token == false) {
-    async_event_t e = next_async_event_iapp(iapp);
-    assert(e.type != UNKNOWN_EVENT && "Unknown event triggered ");
+  assert(sctp_msg_rx != NULL);
 
-    switch (e.type) {
-      case SCTP_MSG_ARRIVED_EVENT: {
-        defer({ free_sctp_msg(&e.msg); });
+  e2ap_msg_t msg = e2ap_msg_dec_iapp(&iapp->ap, sctp_msg_rx->ba);
+  defer({ e2ap_msg_free_iapp(&iapp->ap, &msg); });
 
-        e2ap_msg_t msg = e2ap_msg_dec_iapp(&iapp->ap, e.msg.ba);
-        defer({ e2ap_msg_free_iapp(&iapp->ap, &msg); });
+  e2ap_msg_t ans = e2ap_msg_handle_iapp(iapp, &msg);
+  defer({ e2ap_msg_free_iapp(&iapp->ap, &ans); });
+
+  if (ans.type == E42_SETUP_RESPONSE) {
+    const uint16_t xapp_id = ans.u_msgs.e42_stp_resp.xapp_id;
+    e2ap_reg_sock_addr_iapp(&iapp->ep, xapp_id, (sctp_info_t*)&sctp_msg_rx->info);
+  }
 
-        e2ap_msg_t ans = e2ap_msg_handle_iapp(iapp, &msg);
-        defer({ e2ap_msg_free_iapp(&iapp->ap, &ans); });
+  if (ans.type != NONE_E2_MSG_TYPE) {
+    sctp_msg_t sctp_msg = {
+        .info.addr = sctp_msg_rx->info.addr,
+        .info.sri = sctp_msg_rx->info.sri,
+    };
 
-        if (ans.type == E42_SETUP_RESPONSE) {
-          const uint16_t xapp_id = ans.u_msgs.e42_stp_resp.xapp_id;
-          e2ap_reg_sock_addr_iapp(&iapp->ep, xapp_id, &e.msg.info);
-          ;
-        }
+    sctp_msg.ba = e2ap_msg_enc_iapp(&iapp->ap, &ans);
+    defer({ free_sctp_msg(&sctp_msg); });
+
+    e2ap_send_sctp_msg_iapp(&iapp->ep, &sctp_msg);
+
+    if (ans.type == RIC_SUBSCRIPTION_DELETE_RESPONSE)
+      printf("RIC_SUBSCRIPTION_DELETE_RESPONSE sent with size = %ld \n", sctp_msg.ba.len);
+    if (ans.type == RIC_INDICATION) {
+      int64_t now = time_now_us();
+      printf("Time diff at iapp after sending = %ld \n", now - msg.tstamp);
+    }
+  }
+}
 
-        if (ans.type != NONE_E2_MSG_TYPE) {
-          sctp_msg_t sctp_msg = {
-              .info.addr = e.msg.info.addr,
-              .info.sri = e.msg.info.sri,
-          };
+static void handle_shutdown_iapp(e42_iapp_t* iapp, sctp_msg_t const* notif)
+{
+  assert(iapp != NULL);
+  assert(notif != NULL);
 
-          sctp_msg.ba = e2ap_msg_enc_iapp(&iapp->ap, &ans);
-          defer({ free_sctp_msg(&sctp_msg); });
+  uint16_t const xapp_id = find_map_xapps_xid(&iapp->ep.xapps, &notif->info);
+  printf("[NEAR-RIC]: xApp %d disconnected!\n", xapp_id);
+  rm_xapp_ind_route_iapp(&iapp->ind_route, xapp_id);
+  e2ap_rm_shm_iapp(&iapp->ep, &notif->info);
+  rm_if_pending_subs(iapp, xapp_id);
+}
 
-          e2ap_send_sctp_msg_iapp(&iapp->ep, &sctp_msg);
+static void e2_event_loop_iapp(e42_iapp_t* iapp)
+{
+  assert(iapp != NULL);
+  while (iapp->stop_token == false) {
+    async_event_t e = next_async_event_iapp(iapp);
+    assert(e.type != UNKNOWN_EVENT && "Unknown event triggered ");
 
-          if (ans.type == RIC_SUBSCRIPTION_DELETE_RESPONSE)
-            printf("RIC_SUBSCRIPTION_DELETE_RESPONSE sent with size = %ld \n", sctp_msg.ba.len);
-          if (ans.type == RIC_INDICATION) {
-            int64_t now = time_now_us();
-            printf("Time diff at iapp after sending = %ld \n", now - msg.tstamp);
+    switch (e.type) {
+      case SCTP_MSG_BATCH_ARRIVED_EVENT: {
+        defer({ free_sctp_msg_arr(&e.msgs); });
+
+        for (size_t i = 0; i < e.msgs.len; ++i) {
+          sctp_msg_t const* m = &e.msgs.msg[i];
+          if (m->type == SCTP_MSG_PAYLOAD) {
+            handle_sctp_msg_iapp(iapp, m);
+          } else if (m->notif->sn_header.sn_type == SCTP_ASSOC_CHANGE) {
+            printf(" SCTP_ASSOC_CHANGE recived \n");
+          } else {
+            handle_shutdown_iapp(iapp, m);
           }
         }
         break;
       }
+      case SHM_CHANNEL_EVENT: {
+        int const fd = e2ap_accept_shm_iapp(&iapp->ep);
+        if (fd > -1)
+          add_sock_asio_iapp(&iapp->io, fd);
+        break;
+      }
       case PENDING_EVENT: {
         printf("[nearRT-RIC] Pending event timeout happened. Communication lost?\n");
         consume_fd(e.fd);
         break;
       }
-      case SCTP_CONNECTION_SHUTDOWN_EVENT: {
-        defer({ free_sctp_msg(&e.msg); });
-        uint16_t const xapp_id = find_map_xapps_xid(&iapp->ep.xapps, &e.msg.info);
-        printf("[NEAR-RIC]: xApp %d disconnected!\n", xapp_id);
-        rm_if_pending_subs(iapp, xapp_id);
-        break;
-      }
       case CHECK_STOP_TOKEN_EVENT: {
         /*
                socklen_t opt_len = sizeof(struct sctp_status);
@@ -279,12 +294,6 @@ void start_e42_iapp(e42_iapp_t* iapp)
   e2_event_loop_iapp(iapp);
 }
 
-void cleanup_forward_indication_mutex(e42_iapp_t* iapp)
-{
-  assert(iapp != NULL);
-  pthread_mutex_destroy(&iapp->forward_mutex);
-}
-
 void free_e42_iapp(e42_iapp_t* iapp)
 {
   assert(iapp != NULL);
@@ -301,10 +310,7 @@ void free_e42_iapp(e42_iapp_t* iapp)
 
   free_map_ric_id(&iapp->map_ric_id);
 
-  // Free subscription registry
-  free_subscription_registry(&iapp->subscription_registry);
-
-  cleanup_forward_indication_mutex(iapp);
+  free_ind_route_iapp(&iapp->ind_route);
 
   free(iapp);
 }
@@ -348,7 +354,7 @@ void notify_msg_iapp(e42_iapp_t* iapp, e2ap_msg_t const* msg)
 {
   assert(iapp != NULL);
   assert(msg != NULL);
-  assert(msg->type == RIC_INDICATION || msg->type == RIC_SUBSCRIPTION_RESPONSE || msg->type == RIC_SUBSCRIPTION_DELETE_RESPONSE
+  assert(msg->type == RIC_SUBSCRIPTION_RESPONSE || msg->type == RIC_SUBSCRIPTION_DELETE_RESPONSE
          || msg->type == RIC_CONTROL_ACKNOWLEDGE);
 
   e2ap_msg_t ans = e2ap_msg_handle_iapp(iapp, msg);
@@ -356,3 +362,23 @@ void notify_msg_iapp(e42_iapp_t* iapp, e2ap_msg_t const* msg)
 
   assert(ans.type == NONE_E2_MSG_TYPE);
 }
+
+void notify_ind_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, e2ap_msg_t const* msg)
+{
+  assert(iapp != NULL);
+  assert(id != NULL);
+  assert(msg != NULL);
+  assert(msg->type == RIC_INDICATION);
+
+  e2ap_msg_t ans = e2ap_handle_ric_indication_iapp(iapp, id, msg);
+  assert(ans.type == NONE_E2_MSG_TYPE);
+}
+
+void notify_ind_bytes_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, ric_gen_id_t const* ric_id, byte_array_t ba)
+{
+  assert(iapp != NULL);
+  assert(id != NULL);
+  assert(ric_id != NULL);
+
+  e2ap_fwd_ric_indication_iapp(iapp, id, ric_id, ba);
+}
@@ -40,7 +40,7 @@
 #include "endpoint_iapp.h"
 #include "map_ric_id.h"
 
-#include "subscription_registry.h"
+#include "ind_route_iapp.h"
 
 #include <stdatomic.h>
 #include <stdbool.h>
@@ -63,15 +63,16 @@ typedef struct e42_iapp_s {
   e2ap_ep_iapp_t ep;
   e2ap_iapp_t ap;
   asio_iapp_t io;
+  // Max. SCTP messages drained per reactor wake up
+  size_t rx_batch;
   size_t sz_handle_msg;
-  pthread_mutex_t forward_mutex;
   handle_msg_fp_iapp handle_msg[NUM_HANDLE_MSG]; // note that not all the slots will be occupied
 
   // Registered xApps
   uint32_t xapp_id;
 
-  // Registration of number of xApps
-  subscription_registry_t subscription_registry;
+  // Indication routing. (E2 Node, RAN func ID, RIC req ID) -> xApps
+  ind_route_iapp_t ind_route;
 
   // Registered E2 Nodes
   reg_e2_nodes_t e2_nodes;
@@ -84,10 +85,8 @@ typedef struct e42_iapp_s {
   atomic_bool stopped;
 } e42_iapp_t;
 
-e42_iapp_t* init_e42_iapp(const char* addr, near_ric_if_t ric_if); //, int port);
-
-void init_forward_indication_mutex(e42_iapp_t* iapp);
-void cleanup_forward_indication_mutex(e42_iapp_t* iapp);
+// Shared memory channels of shm_ring bytes offered to co-located xApps if shm_ring > 0
+e42_iapp_t* init_e42_iapp(const char* addr, near_ric_if_t ric_if, size_t rx_batch, size_t shm_ring); //, int port);
 
 // Blocking call
 void start_e42_iapp(e42_iapp_t* iapp);
@@ -109,6 +108,12 @@ void rm_e2_node_iapp(e42_iapp_t* i, global_e2_node_id_t* id);
 
 void notify_msg_iapp(e42_iapp_t* iapp, e2ap_msg_t const* msg);
 
+// RIC indication received from the E2 Node id
+void notify_ind_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, e2ap_msg_t const* msg);
+
+// RIC indication PDU, relayed as received from the E2 Node id
+void notify_ind_bytes_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, ric_gen_id_t const* ric_id, byte_array_t ba);
+
 #undef NUM_HANDLE_MSG
 
 #endif
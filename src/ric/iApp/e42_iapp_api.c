@@ -32,6 +32,7 @@
 #include "../../lib/e2ap/e2ap_plmn_wrapper.h"            // for plmn_t
 #include "../../util/ngran_types.h"                              // for ngran_gNB                
 #include "../../util/conf_file.h"
+#include "../../util/thread_affinity.h"
 
 static
 e42_iapp_t* iapp = NULL;
@@ -48,16 +49,18 @@ void* static_start_iapp(void* a)
   return NULL;
 }
 
-void init_iapp_api(const char* addr, near_ric_if_t ric_if)
+void init_iapp_api(const char* addr, near_ric_if_t ric_if, size_t rx_batch, size_t shm_ring, size_t len_cpus, int const cpus[len_cpus])
 {
   assert(iapp == NULL);
 
-  iapp = init_e42_iapp(addr, ric_if);
+  iapp = init_e42_iapp(addr, ric_if, rx_batch, shm_ring);
   assert(iapp->io.efd < 1024);
 
   // Spawn a new thread for the iapp
   const int rc = pthread_create(&thrd_iapp, NULL, static_start_iapp, NULL);
   assert(rc == 0);
+
+  pin_thread_cpus(thrd_iapp, len_cpus, cpus);
 }
 
 void stop_iapp_api(void)
@@ -101,3 +104,18 @@ void notify_msg_iapp_api(e2ap_msg_t const* msg)
   notify_msg_iapp(iapp, msg);
 }
 
+void notify_ind_iapp_api(global_e2_node_id_t const* id, e2ap_msg_t const* msg)
+{
+  assert(iapp != NULL);
+  assert(id != NULL);
+  assert(msg != NULL);
+  notify_ind_iapp(iapp, id, msg);
+}
+
+void notify_ind_bytes_iapp_api(global_e2_node_id_t const* id, ric_gen_id_t const* ric_id, byte_array_t ba)
+{
+  assert(iapp != NULL);
+  assert(id != NULL);
+  assert(ric_id != NULL);
+  notify_ind_bytes_iapp(iapp, id, ric_id, ba);
+}
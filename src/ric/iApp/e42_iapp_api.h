@@ -33,7 +33,8 @@
 
 typedef struct near_ric_s near_ric_t;
 
-void init_iapp_api(const char* addr, near_ric_if_t ric);
+// The iApp event loop is restricted to cpus. Not pinned if len_cpus == 0
+void init_iapp_api(const char* addr, near_ric_if_t ric, size_t rx_batch, size_t shm_ring, size_t len_cpus, int const cpus[len_cpus]);
   
 void stop_iapp_api(void);     
 
@@ -49,5 +50,11 @@ void rm_e2_node_iapp_api(global_e2_node_id_t* id);
 
 void notify_msg_iapp_api(e2ap_msg_t const* msg);
 
+// RIC indication received from the E2 Node id
+void notify_ind_iapp_api(global_e2_node_id_t const* id, e2ap_msg_t const* msg);
+
+// RIC indication PDU, relayed as received from the E2 Node id
+void notify_ind_bytes_iapp_api(global_e2_node_id_t const* id, ric_gen_id_t const* ric_id, byte_array_t ba);
+
 #endif
 
@@ -21,6 +21,7 @@
 
 
 #include "endpoint_iapp.h"
+#include "../../util/alg_ds/alg/defer.h"
 #include <arpa/inet.h>   // for inet_pton
 #include <assert.h>      // for assert
 #include <errno.h>       // for errno
@@ -86,7 +87,60 @@ int init_sctp_conn_server(const char* addr, int port)
   return server_fd;
 }
 
-void e2ap_init_ep_iapp(e2ap_ep_iapp_t* ep, const char* addr, int port)
+typedef struct{
+  sctp_info_t info;
+  shm_chan_t* ch;
+} shm_xapp_iapp_t;
+
+static
+void free_shm_xapp_iapp(void* it)
+{
+  assert(it != NULL);
+  shm_xapp_iapp_t* x = (shm_xapp_iapp_t*)it;
+  free_shm_chan(x->ch);
+}
+
+static
+void init_shm_iapp(e2ap_ep_iapp_t* ep, int port, size_t shm_ring)
+{
+  ep->shm_ring = shm_ring;
+  ep->shm_fd = shm_ring > 0 ? listen_shm_chan(port) : -1;
+  if(ep->shm_fd > -1)
+    printf("[iApp]: Shared memory channels with %zu KiB rings offered to co-located xApps\n", shm_ring / 1024);
+
+  seq_init(&ep->shm, sizeof(shm_xapp_iapp_t));
+  int const rc = pthread_rwlock_init(&ep->shm_rw, NULL);
+  assert(rc == 0);
+}
+
+// shm_rw held
+static
+shm_xapp_iapp_t* find_shm_iapp(e2ap_ep_iapp_t const* ep, bool (*eq)(shm_xapp_iapp_t const*, void const*), void const* key)
+{
+  seq_arr_t* arr = (seq_arr_t*)&ep->shm;
+  void* it = seq_front(arr);
+  void* end = seq_end(arr);
+  while(it != end){
+    if(eq(it, key))
+      return it;
+    it = seq_next(arr, it);
+  }
+  return NULL;
+}
+
+static
+bool eq_assoc_shm(shm_xapp_iapp_t const* x, void const* key)
+{
+  return eq_sctp_info_wrapper(&x->info, key);
+}
+
+static
+bool eq_fd_shm(shm_xapp_iapp_t const* x, void const* key)
+{
+  return x->ch->rx_fd == *(int const*)key;
+}
+
+void e2ap_init_ep_iapp(e2ap_ep_iapp_t* ep, const char* addr, int port, size_t shm_ring)
 {
   assert(ep != NULL);
   assert(addr != NULL);
@@ -100,6 +154,8 @@ void e2ap_init_ep_iapp(e2ap_ep_iapp_t* ep, const char* addr, int port)
   strncpy((char*)(&ep->base.addr), addr, 16);
 
   init_map_xapps_sad(&ep->xapps);
+
+  init_shm_iapp(ep, port, shm_ring);
 }
 
 sctp_msg_t e2ap_recv_msg_iapp(e2ap_ep_iapp_t* ep)
@@ -111,6 +167,18 @@ sctp_msg_t e2ap_recv_msg_iapp(e2ap_ep_iapp_t* ep)
   return rcv;
 }
 
+sctp_msg_arr_t e2ap_recv_msgs_iapp(e2ap_ep_iapp_t* ep, size_t max)
+{
+  assert(ep != NULL);
+  assert(max > 0);
+
+  sctp_msg_arr_t arr = {.msg = calloc(max, sizeof(sctp_msg_t))};
+  assert(arr.msg != NULL && "Memory exhausted");
+
+  arr.len = e2ap_recv_sctp_msg_batch(&ep->base, max, arr.msg);
+  return arr;
+}
+
 void e2ap_send_bytes_iapp(const e2ap_ep_iapp_t* ep, int xapp_id, byte_array_t ba)
 {
   assert(ba.buf && ba.len > 0);
@@ -129,6 +197,26 @@ void e2ap_send_sctp_msg_iapp(const e2ap_ep_iapp_t* ep,sctp_msg_t* msg)
   assert(ep != NULL);
   assert(msg->ba.buf && msg->ba.len > 0);
 
+  if(ep->shm_fd > -1){
+    pthread_rwlock_t* rw = (pthread_rwlock_t*)&ep->shm_rw;
+    int rc = pthread_rwlock_rdlock(rw);
+    assert(rc == 0);
+    shm_xapp_iapp_t* x = find_shm_iapp(ep, eq_assoc_shm, &msg->info);
+    // Pinned, as the sender may wait for room. Only the senders of the
+    // same channel queue behind it, and the iApp thread can still remove it
+    shm_chan_t* ch = x != NULL ? acquire_shm_chan(x->ch) : NULL;
+    rc = pthread_rwlock_unlock(rw);
+    assert(rc == 0);
+
+    bool sent = false;
+    if(ch != NULL){
+      sent = send_shm_chan(ch, msg->ba);
+      release_shm_chan(ch);
+    }
+    if(sent == true)
+      return;
+  }
+
   e2ap_send_sctp_msg(&ep->base, msg);
 }
 
@@ -139,6 +227,12 @@ void e2ap_free_ep_iapp(e2ap_ep_iapp_t* ep)
 
   e2ap_ep_free(&ep->base);
   free_map_xapps_sad(&ep->xapps);
+
+  if(ep->shm_fd > -1)
+    close(ep->shm_fd);
+  seq_free(&ep->shm, free_shm_xapp_iapp);
+  int const rc = pthread_rwlock_destroy(&ep->shm_rw);
+  assert(rc == 0);
 }
 
 void e2ap_reg_sock_addr_iapp(e2ap_ep_iapp_t* ep, uint16_t xapp_id,   sctp_info_t* s)
@@ -149,3 +243,83 @@ void e2ap_reg_sock_addr_iapp(e2ap_ep_iapp_t* ep, uint16_t xapp_id,   sctp_info_t
   add_map_xapps_sad(&ep->xapps, xapp_id, s);
 }
 
+static
+bool valid_shm_iapp(void* data, uint16_t xapp_id, uint16_t sctp_port)
+{
+  e2ap_ep_iapp_t* ep = (e2ap_ep_iapp_t*)data;
+  // Unknown xApp IDs have port 0
+  sctp_info_t const s = find_map_xapps_sad(&ep->xapps, xapp_id);
+  return s.addr.sin_port != 0 && s.addr.sin_port == sctp_port;
+}
+
+int e2ap_accept_shm_iapp(e2ap_ep_iapp_t* ep)
+{
+  assert(ep != NULL);
+  assert(ep->shm_fd > -1);
+
+  uint16_t xapp_id = 0;
+  shm_chan_t* ch = accept_shm_chan(ep->shm_fd, ep->shm_ring, valid_shm_iapp, ep, &xapp_id);
+  if(ch == NULL)
+    return -1;
+
+  shm_xapp_iapp_t x = {.info = find_map_xapps_sad(&ep->xapps, xapp_id), .ch = ch};
+
+  int rc = pthread_rwlock_wrlock(&ep->shm_rw);
+  assert(rc == 0);
+  // Same association, e.g., the xApp asked twice
+  shm_xapp_iapp_t* old = find_shm_iapp(ep, eq_assoc_shm, &x.info);
+  if(old != NULL){
+    free_shm_chan(old->ch);
+    seq_erase(&ep->shm, old, seq_next(&ep->shm, old));
+  }
+  seq_push_back(&ep->shm, &x, sizeof(x));
+  rc = pthread_rwlock_unlock(&ep->shm_rw);
+  assert(rc == 0);
+
+  printf("[iApp]: xApp %d reached through shared memory\n", xapp_id);
+  return ch->rx_fd;
+}
+
+bool e2ap_shm_fd_iapp(e2ap_ep_iapp_t* ep, int fd)
+{
+  assert(ep != NULL);
+
+  // Only the iApp thread writes
+  return find_shm_iapp(ep, eq_fd_shm, &fd) != NULL;
+}
+
+sctp_msg_arr_t e2ap_recv_shm_msgs_iapp(e2ap_ep_iapp_t* ep, int fd, size_t max)
+{
+  assert(ep != NULL);
+  assert(max > 0);
+
+  shm_xapp_iapp_t* x = find_shm_iapp(ep, eq_fd_shm, &fd);
+  assert(x != NULL && "Not a shared memory channel");
+
+  sctp_msg_arr_t arr = {.msg = calloc(max, sizeof(sctp_msg_t))};
+  assert(arr.msg != NULL && "Memory exhausted");
+
+  byte_array_t ba[max];
+  arr.len = recv_shm_chan(x->ch, max, ba);
+  for(size_t i = 0; i < arr.len; ++i)
+    arr.msg[i] = (sctp_msg_t){.type = SCTP_MSG_PAYLOAD, .info = x->info, .ba = ba[i]};
+
+  return arr;
+}
+
+void e2ap_rm_shm_iapp(e2ap_ep_iapp_t* ep, sctp_info_t const* s)
+{
+  assert(ep != NULL);
+  assert(s != NULL);
+
+  int rc = pthread_rwlock_wrlock(&ep->shm_rw);
+  assert(rc == 0);
+  shm_xapp_iapp_t* x = find_shm_iapp(ep, eq_assoc_shm, s);
+  if(x != NULL){
+    // Closing its fd also removes it from the epoll set
+    free_shm_chan(x->ch);
+    seq_erase(&ep->shm, x, seq_next(&ep->shm, x));
+  }
+  rc = pthread_rwlock_unlock(&ep->shm_rw);
+  assert(rc == 0);
+}
@@ -24,6 +24,7 @@
 #define E2AP_ENDPOINT_IAPP_H
 
 #include "lib/ep/e2ap_ep.h"   // for e2ap_ep_t
+#include "lib/ep/shm_chan.h"  // for shm_chan_t
 #include "util/byte_array.h"  // for byte_array_t
 #include "map_xapps_sockaddr.h"
 
@@ -34,14 +35,26 @@ typedef struct{
   // xApp ID -> sctp_info_t  
   map_xapps_sockaddr_t xapps; 
 
+  // Shared memory channels with co-located xApps. Listening socket,
+  // or -1 if not offered
+  int shm_fd;
+  size_t shm_ring;
+  // shm_xapp_iapp_t. Read by the RIC threads that send indications
+  seq_arr_t shm;
+  pthread_rwlock_t shm_rw;
+
 } e2ap_ep_iapp_t;
 
-void e2ap_init_ep_iapp(e2ap_ep_iapp_t* ep, const char* addr, int port);
+// Shared memory channels of shm_ring bytes per direction offered if shm_ring > 0
+void e2ap_init_ep_iapp(e2ap_ep_iapp_t* ep, const char* addr, int port, size_t shm_ring);
 
 void e2ap_free_ep_iapp(e2ap_ep_iapp_t* ep);
 
 sctp_msg_t e2ap_recv_msg_iapp(e2ap_ep_iapp_t* ep);
 
+// Drain up to max messages. The array must be freed, even if empty
+sctp_msg_arr_t e2ap_recv_msgs_iapp(e2ap_ep_iapp_t* ep, size_t max);
+
 //void e2ap_send_bytes_iapp(const e2ap_ep_iapp_t* ep, byte_array_t ba);
 void e2ap_send_bytes_iapp(const e2ap_ep_iapp_t* ep, int xapp_id, byte_array_t ba);
 
@@ -49,5 +62,18 @@ void e2ap_send_sctp_msg_iapp(const e2ap_ep_iapp_t* ep, sctp_msg_t* msg);
 
 void e2ap_reg_sock_addr_iapp(e2ap_ep_iapp_t* ep, uint16_t xapp_id, sctp_info_t* s);
 
+// Hand over a channel to the xApp connecting to shm_fd. From then on, the
+// messages to the xApp go through it. Its fd to poll, or -1 if refused
+int e2ap_accept_shm_iapp(e2ap_ep_iapp_t* ep);
+
+bool e2ap_shm_fd_iapp(e2ap_ep_iapp_t* ep, int fd);
+
+// Drain up to max messages from the channel polled through fd. They carry the
+// SCTP info of the xApp association, as if they had arrived through it
+sctp_msg_arr_t e2ap_recv_shm_msgs_iapp(e2ap_ep_iapp_t* ep, int fd, size_t max);
+
+// Channel of the xApp association gone, if any
+void e2ap_rm_shm_iapp(e2ap_ep_iapp_t* ep, sctp_info_t const* s);
+
 #endif
 
@@ -0,0 +1,430 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "ind_route_iapp.h"
+
+#include "../../util/alg_ds/ds/lock_guard/lock_guard.h"
+#include "../../util/ngran_types.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Open addressing, linear probing. Load factor <= 0.5
+typedef struct {
+  uint64_t hash;
+  global_e2_node_id_t node;
+  uint16_t ran_func_id;
+  uint16_t ric_req_id;
+  // 0 marks an empty bucket
+  uint32_t len;
+  // First xApp ID in ids
+  uint32_t off;
+} bucket_t;
+
+struct ind_route_snap_s {
+  size_t mask;
+  bucket_t* bucket;
+  uint32_t* ids;
+};
+
+///////////////////////////////
+// Epoch based reclamation
+///////////////////////////////
+
+// Threads that can read lock free. The rest fall back to the writers' mutex
+#define NUM_READERS 128
+
+typedef struct {
+  // Global epoch seen when the read started. 0 if not reading
+  _Alignas(64) atomic_uint_fast64_t epoch;
+} reader_t;
+
+static struct {
+  _Alignas(64) atomic_uint_fast64_t epoch;
+  reader_t reader[NUM_READERS];
+
+  // Readers handed out so far. Only grows
+  atomic_size_t hi;
+
+  pthread_mutex_t mtx;
+  uint32_t free_slot[NUM_READERS];
+  size_t len_free;
+} rcu = {.epoch = 1, .mtx = PTHREAD_MUTEX_INITIALIZER};
+
+static pthread_once_t rcu_once = PTHREAD_ONCE_INIT;
+static pthread_key_t reader_key;
+
+// -1: not assigned yet, -2: no slot left
+static _Thread_local int64_t reader_slot = -1;
+
+static void free_reader(void* v)
+{
+  uint32_t const slot = (uintptr_t)v - 1;
+  assert(atomic_load(&rcu.reader[slot].epoch) == 0);
+
+  lock_guard(&rcu.mtx);
+  rcu.free_slot[rcu.len_free++] = slot;
+}
+
+static void init_reader_key(void)
+{
+  // The destructor gives the slot back when the thread exits
+  int rc = pthread_key_create(&reader_key, free_reader);
+  assert(rc == 0);
+}
+
+static reader_t* get_reader(void)
+{
+  if (reader_slot == -1) {
+    pthread_once(&rcu_once, init_reader_key);
+
+    lock_guard(&rcu.mtx);
+
+    size_t const hi = atomic_load(&rcu.hi);
+    if (rcu.len_free > 0) {
+      reader_slot = rcu.free_slot[--rcu.len_free];
+    } else if (hi < NUM_READERS) {
+      reader_slot = hi;
+      atomic_store(&rcu.hi, hi + 1);
+    } else {
+      reader_slot = -2;
+    }
+
+    if (reader_slot >= 0) {
+      int rc = pthread_setspecific(reader_key, (void*)(uintptr_t)(reader_slot + 1));
+      assert(rc == 0);
+    }
+  }
+
+  return reader_slot < 0 ? NULL : &rcu.reader[reader_slot];
+}
+
+// Returns once every reader that may hold a snapshot unpublished before the
+// call has finished
+static void synchronize_readers(void)
+{
+  uint64_t const target = atomic_fetch_add(&rcu.epoch, 1) + 1;
+
+  size_t const hi = atomic_load(&rcu.hi);
+  for (size_t i = 0; i < hi; ++i) {
+    for (;;) {
+      uint64_t const e = atomic_load(&rcu.reader[i].epoch);
+      if (e == 0 || e >= target)
+        break;
+      sched_yield();
+    }
+  }
+}
+
+///////////////////////////////
+// Snapshot
+///////////////////////////////
+
+static inline uint64_t mix64(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static uint64_t hash_route(global_e2_node_id_t const* n, uint16_t ran_func_id, uint16_t ric_req_id)
+{
+  uint64_t h = mix64(n->type);
+  h = mix64(h ^ ((uint64_t)n->plmn.mcc << 24 | (uint64_t)n->plmn.mnc << 8 | n->plmn.mnc_digit_len));
+  h = mix64(h ^ ((uint64_t)n->nb_id.nb_id << 32 | n->nb_id.unused));
+  // As eq_global_e2_node_id(), that only looks at it for the CU-UP and the DU
+  if (NODE_IS_CUUP(n->type) || NODE_IS_DU(n->type)) {
+    assert(n->cu_du_id != NULL);
+    h = mix64(h ^ *n->cu_du_id);
+  }
+  return mix64(h ^ ((uint64_t)ran_func_id << 16 | ric_req_id));
+}
+
+static ind_route_snap_t* build_snap(size_t len, ind_route_t const route[len])
+{
+  size_t num_ids = 0;
+  for (size_t i = 0; i < len; ++i)
+    num_ids += route[i].len;
+
+  size_t num_buckets = 16;
+  while (num_buckets < 2 * len)
+    num_buckets <<= 1;
+
+  ind_route_snap_t* s = calloc(1, sizeof(ind_route_snap_t));
+  assert(s != NULL && "Memory exhausted");
+  s->mask = num_buckets - 1;
+  s->bucket = calloc(num_buckets, sizeof(bucket_t));
+  assert(s->bucket != NULL && "Memory exhausted");
+  s->ids = calloc(num_ids + 1, sizeof(uint32_t));
+  assert(s->ids != NULL && "Memory exhausted");
+
+  uint32_t off = 0;
+  for (size_t i = 0; i < len; ++i) {
+    ind_route_t const* r = &route[i];
+    assert(r->len > 0);
+
+    uint64_t const h = hash_route(&r->node, r->ran_func_id, r->ric_req_id);
+    size_t b = h & s->mask;
+    while (s->bucket[b].len != 0)
+      b = (b + 1) & s->mask;
+
+    s->bucket[b] = (bucket_t){.hash = h,
+                              .node = cp_global_e2_node_id(&r->node),
+                              .ran_func_id = r->ran_func_id,
+                              .ric_req_id = r->ric_req_id,
+                              .len = r->len,
+                              .off = off};
+
+    memcpy(s->ids + off, r->xapp_id, r->len * sizeof(uint32_t));
+    off += r->len;
+  }
+
+  return s;
+}
+
+static void free_snap(ind_route_snap_t* s)
+{
+  if (s == NULL)
+    return;
+
+  for (size_t b = 0; b <= s->mask; ++b) {
+    if (s->bucket[b].len != 0)
+      free_global_e2_node_id(&s->bucket[b].node);
+  }
+
+  free(s->bucket);
+  free(s->ids);
+  free(s);
+}
+
+static size_t find_snap(ind_route_snap_t const* s,
+                        global_e2_node_id_t const* node,
+                        uint16_t ran_func_id,
+                        uint16_t ric_req_id,
+                        size_t cap,
+                        uint32_t xapp_id[cap])
+{
+  if (s == NULL)
+    return 0;
+
+  uint64_t const h = hash_route(node, ran_func_id, ric_req_id);
+
+  for (size_t b = h & s->mask; s->bucket[b].len != 0; b = (b + 1) & s->mask) {
+    bucket_t const* it = &s->bucket[b];
+    if (it->hash == h && it->ran_func_id == ran_func_id && it->ric_req_id == ric_req_id
+        && eq_global_e2_node_id(&it->node, node)) {
+      size_t const n = it->len < cap ? it->len : cap;
+      memcpy(xapp_id, s->ids + it->off, n * sizeof(uint32_t));
+      return it->len;
+    }
+  }
+
+  return 0;
+}
+
+// Called with the mutex held
+static void publish(ind_route_iapp_t* r)
+{
+  ind_route_snap_t* s = build_snap(r->len, r->route);
+  ind_route_snap_t* old = atomic_exchange(&r->snap, s);
+
+  synchronize_readers();
+  free_snap(old);
+}
+
+///////////////////////////////
+// Writers' copy
+///////////////////////////////
+
+static ind_route_t* find_route(ind_route_iapp_t* r, global_e2_node_id_t const* node, uint16_t ran_func_id, uint16_t ric_req_id)
+{
+  for (size_t i = 0; i < r->len; ++i) {
+    ind_route_t* it = &r->route[i];
+    if (it->ran_func_id == ran_func_id && it->ric_req_id == ric_req_id && eq_global_e2_node_id(&it->node, node))
+      return it;
+  }
+  return NULL;
+}
+
+static bool rm_xapp_route(ind_route_t* route, uint32_t xapp_id)
+{
+  for (size_t i = 0; i < route->len; ++i) {
+    if (route->xapp_id[i] == xapp_id) {
+      route->xapp_id[i] = route->xapp_id[--route->len];
+      return true;
+    }
+  }
+  return false;
+}
+
+static void free_route(ind_route_t* route)
+{
+  free_global_e2_node_id(&route->node);
+  free(route->xapp_id);
+}
+
+// Drops the routes without xApps
+static void compact(ind_route_iapp_t* r)
+{
+  size_t i = 0;
+  while (i < r->len) {
+    if (r->route[i].len == 0) {
+      free_route(&r->route[i]);
+      r->route[i] = r->route[--r->len];
+    } else {
+      ++i;
+    }
+  }
+}
+
+void init_ind_route_iapp(ind_route_iapp_t* r)
+{
+  assert(r != NULL);
+
+  *r = (ind_route_iapp_t){0};
+  atomic_init(&r->snap, NULL);
+
+  int rc = pthread_mutex_init(&r->mtx, NULL);
+  assert(rc == 0);
+}
+
+void free_ind_route_iapp(ind_route_iapp_t* r)
+{
+  assert(r != NULL);
+
+  {
+    lock_guard(&r->mtx);
+
+    ind_route_snap_t* old = atomic_exchange(&r->snap, NULL);
+    synchronize_readers();
+    free_snap(old);
+
+    for (size_t i = 0; i < r->len; ++i)
+      free_route(&r->route[i]);
+    free(r->route);
+    r->route = NULL;
+    r->len = 0;
+    r->cap = 0;
+  }
+
+  int rc = pthread_mutex_destroy(&r->mtx);
+  assert(rc == 0);
+}
+
+void add_ind_route_iapp(ind_route_iapp_t* r, global_e2_node_id_t const* node, uint16_t ran_func_id, uint16_t ric_req_id, uint32_t xapp_id)
+{
+  assert(r != NULL);
+  assert(node != NULL);
+
+  lock_guard(&r->mtx);
+
+  ind_route_t* route = find_route(r, node, ran_func_id, ric_req_id);
+  if (route == NULL) {
+    if (r->len == r->cap) {
+      r->cap = r->cap == 0 ? 32 : 2 * r->cap;
+      r->route = realloc(r->route, r->cap * sizeof(ind_route_t));
+      assert(r->route != NULL && "Memory exhausted");
+    }
+
+    route = &r->route[r->len++];
+    *route = (ind_route_t){.node = cp_global_e2_node_id(node), .ran_func_id = ran_func_id, .ric_req_id = ric_req_id};
+  }
+
+  for (size_t i = 0; i < route->len; ++i) {
+    if (route->xapp_id[i] == xapp_id)
+      return;
+  }
+
+  if (route->len == route->cap) {
+    route->cap = route->cap == 0 ? 4 : 2 * route->cap;
+    route->xapp_id = realloc(route->xapp_id, route->cap * sizeof(uint32_t));
+    assert(route->xapp_id != NULL && "Memory exhausted");
+  }
+  route->xapp_id[route->len++] = xapp_id;
+
+  publish(r);
+}
+
+bool rm_ind_route_iapp(ind_route_iapp_t* r, global_e2_node_id_t const* node, uint16_t ran_func_id, uint16_t ric_req_id, uint32_t xapp_id)
+{
+  assert(r != NULL);
+  assert(node != NULL);
+
+  lock_guard(&r->mtx);
+
+  ind_route_t* route = find_route(r, node, ran_func_id, ric_req_id);
+  if (route == NULL || rm_xapp_route(route, xapp_id) == false)
+    return false;
+
+  compact(r);
+  publish(r);
+  return true;
+}
+
+size_t rm_xapp_ind_route_iapp(ind_route_iapp_t* r, uint32_t xapp_id)
+{
+  assert(r != NULL);
+
+  lock_guard(&r->mtx);
+
+  size_t num = 0;
+  for (size_t i = 0; i < r->len; ++i)
+    num += rm_xapp_route(&r->route[i], xapp_id);
+
+  if (num > 0) {
+    compact(r);
+    publish(r);
+  }
+
+  return num;
+}
+
+size_t find_ind_route_iapp(ind_route_iapp_t* r,
+                           global_e2_node_id_t const* node,
+                           uint16_t ran_func_id,
+                           uint16_t ric_req_id,
+                           size_t cap,
+                           uint32_t xapp_id[cap])
+{
+  assert(r != NULL);
+  assert(node != NULL);
+
+  reader_t* rd = get_reader();
+  if (rd == NULL) {
+    // Writers free the snapshots with the mutex held
+    lock_guard(&r->mtx);
+    return find_snap(atomic_load(&r->snap), node, ran_func_id, ric_req_id, cap, xapp_id);
+  }
+
+  // The epoch must be visible before the snapshot is loaded. Both seq_cst
+  atomic_store(&rd->epoch, atomic_load(&rcu.epoch));
+  ind_route_snap_t const* s = atomic_load(&r->snap);
+
+  size_t const num = find_snap(s, node, ran_func_id, ric_req_id, cap, xapp_id);
+
+  atomic_store_explicit(&rd->epoch, 0, memory_order_release);
+  return num;
+}
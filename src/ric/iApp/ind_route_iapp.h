@@ -0,0 +1,85 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef IND_ROUTE_IAPP_H
+#define IND_ROUTE_IAPP_H
+
+// Indication routing table of the iApp
+// key: (E2 Node, RAN function ID, RIC request ID) | value: xApp IDs
+//
+// Readers (i.e., the indication path) do not lock. They look up an immutable
+// snapshot that the writers (i.e., subscribe/unsubscribe) rebuild and publish.
+// A replaced snapshot is freed once every reader that could still see it is
+// done (epoch based reclamation)
+
+#include "../../lib/e2ap/e2ap_global_node_id_wrapper.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ind_route_snap_s ind_route_snap_t;
+
+typedef struct {
+  global_e2_node_id_t node;
+  uint16_t ran_func_id;
+  uint16_t ric_req_id;
+
+  size_t len;
+  size_t cap;
+  uint32_t* xapp_id;
+} ind_route_t;
+
+typedef struct {
+  // Read by the indication path
+  _Atomic(ind_route_snap_t*) snap;
+
+  // Writers' copy. Protected by mtx
+  ind_route_t* route;
+  size_t len;
+  size_t cap;
+  pthread_mutex_t mtx;
+} ind_route_iapp_t;
+
+void init_ind_route_iapp(ind_route_iapp_t* r);
+
+void free_ind_route_iapp(ind_route_iapp_t* r);
+
+void add_ind_route_iapp(ind_route_iapp_t* r, global_e2_node_id_t const* node, uint16_t ran_func_id, uint16_t ric_req_id, uint32_t xapp_id);
+
+// false if the xApp was not subscribed
+bool rm_ind_route_iapp(ind_route_iapp_t* r, global_e2_node_id_t const* node, uint16_t ran_func_id, uint16_t ric_req_id, uint32_t xapp_id);
+
+// All the routes of a disconnected xApp. Returns the number removed
+size_t rm_xapp_ind_route_iapp(ind_route_iapp_t* r, uint32_t xapp_id);
+
+// Lock free. Copies up to cap xApp IDs and returns how many are subscribed,
+// which may be more than cap
+size_t find_ind_route_iapp(ind_route_iapp_t* r,
+                           global_e2_node_id_t const* node,
+                           uint16_t ran_func_id,
+                           uint16_t ric_req_id,
+                           size_t cap,
+                           uint32_t xapp_id[cap]);
+
+#endif
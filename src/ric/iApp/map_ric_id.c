@@ -136,12 +136,8 @@ void add_map_ric_id(map_ric_id_t* map, e2_node_ric_id_t* node, xapp_ric_id_t* xa
   }
 
   // First try to remove any existing mapping for this node
-  assoc_rb_tree_t* left = &map->bimap.left;
-  void* it = assoc_front(left);
-  void* end = assoc_end(left);
-
-  it = find_if(left, it, end, node, eq_e2_node_ric_req);
-  if (it != end) {
+  bml_iter_t it = bi_map_find_left(&map->bimap, node);
+  if (it.it != bi_map_end_left(&map->bimap).it) {
     // Remove existing mapping using bi_map_extract_left
     void (*free_fn)(void*) = NULL; // We don't want to free the value
     bi_map_extract_left(&map->bimap, node, sizeof(*node), free_fn);
@@ -226,14 +222,10 @@ xapp_ric_id_xpct_t find_xapp_map_ric_id(map_ric_id_t* map, uint16_t ric_req_id)
     return ans;
   }
 
-  assoc_rb_tree_t* left = &map->bimap.left;
-  void* it = assoc_front(left);
-  void* end = assoc_end(left);
-
-  it = find_if(left, it, end, &dummy_node, eq_e2_node_ric_req);
+  bml_iter_t it = bi_map_find_left(&map->bimap, &dummy_node);
 
-  if (it != end) {
-    void* value = assoc_value(left, it);
+  if (it.it != bi_map_end_left(&map->bimap).it) {
+    void* value = bi_map_value_left(&map->bimap, it);
     if (value != NULL) {
       ans.has_value = true;
       memcpy(&ans.xapp_ric_id, value, sizeof(xapp_ric_id_t));
@@ -256,10 +248,8 @@ e2_node_ric_id_t find_ric_req_map_ric_id(map_ric_id_t* map, xapp_ric_id_t* x)
 
   assoc_rb_tree_t* r = &map->bimap.right;
 
-  void* it = assoc_front(r);
-  void* end = assoc_end(r);
-  it = find_if(r, it, end, x, eq_xapp_ric_gen_id_wrapper);
-  assert(it != end && "Not found xApp RIC ID ");
+  void* it = assoc_find(r, x);
+  assert(it != assoc_end(r) && "Not found xApp RIC ID ");
 
   e2_node_ric_id_t const id = *(e2_node_ric_id_t*)assoc_value(r, it);
 
@@ -285,11 +275,12 @@ seq_arr_t find_all_subs_map_ric_id(map_ric_id_t* map, uint16_t xapp_id)
 
   assoc_rb_tree_t* right = &map->bimap.right;
 
-  void* it = assoc_front(right);
+  // The right tree is ordered by xApp ID first, and the zeroed RIC ID is the
+  // smallest one. Thus, all the xApp subscriptions are contiguous from here
+  void* it = assoc_lower_bound(right, &first_xapp_id);
   void* end = assoc_end(right);
-  it = find_if(right, it, end, &first_xapp_id, eq_xapp_id_gen_wrapper);
 
-  while (it != end) {
+  while (it != end && eq_xapp_id_gen_wrapper(assoc_key(right, it), &first_xapp_id) == true) {
     e2_node_ric_id_t* n = (e2_node_ric_id_t*)assoc_value(right, it);
 
     if (n->ric_req_type == SUBSCRIPTION_RIC_REQUEST_TYPE) {
@@ -297,7 +288,7 @@ seq_arr_t find_all_subs_map_ric_id(map_ric_id_t* map, uint16_t xapp_id)
       seq_arr_push_back(&arr, &tmp, sizeof(e2_node_ric_id_t));
     }
 
-    it = find_if(right, assoc_next(right, it), end, &first_xapp_id, eq_xapp_id_gen_wrapper);
+    it = assoc_next(right, it);
   }
 
   rc = pthread_rwlock_unlock(&map->rw);
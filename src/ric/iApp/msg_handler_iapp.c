@@ -59,7 +59,7 @@ static bool check_valid_msg_type(e2_msg_type_t msg_type)
 {
   return msg_type == RIC_SUBSCRIPTION_RESPONSE || msg_type == E42_SETUP_REQUEST || msg_type == E42_RIC_SUBSCRIPTION_REQUEST
          || msg_type == E42_RIC_SUBSCRIPTION_DELETE_REQUEST || msg_type == E42_RIC_CONTROL_REQUEST
-         || msg_type == RIC_CONTROL_ACKNOWLEDGE || msg_type == RIC_INDICATION || msg_type == RIC_SUBSCRIPTION_DELETE_RESPONSE;
+         || msg_type == RIC_CONTROL_ACKNOWLEDGE || msg_type == RIC_SUBSCRIPTION_DELETE_RESPONSE;
 }
 
 void init_handle_msg_iapp(size_t len, handle_msg_fp_iapp (*handle_msg)[len])
@@ -74,7 +74,6 @@ void init_handle_msg_iapp(size_t len, handle_msg_fp_iapp (*handle_msg)[len])
   (*handle_msg)[E42_RIC_SUBSCRIPTION_DELETE_REQUEST] = e2ap_handle_e42_ric_subscription_delete_request_iapp;
   (*handle_msg)[E42_RIC_CONTROL_REQUEST] = e2ap_handle_e42_ric_control_request_iapp;
   (*handle_msg)[RIC_CONTROL_ACKNOWLEDGE] = e2ap_handle_e42_ric_control_ack_iapp;
-  (*handle_msg)[RIC_INDICATION] = e2ap_handle_ric_indication_iapp;
   (*handle_msg)[RIC_SUBSCRIPTION_DELETE_RESPONSE] = e2ap_handle_subscription_delete_response_iapp;
 
   //  (*handle_msg)[RIC_SUBSCRIPTION_REQUEST] = e2ap_handle_subscription_request_iapp;
@@ -428,120 +427,97 @@ gtp_ho_info_t extract_handover_info_ric(const uint8_t* buffer, size_t len)
 //   free_decoded_gtp_indication(&decoded);
 // }
 
-static void forward_indication_to_xapp(e42_iapp_t* iapp, uint32_t xapp_id, const ric_indication_t* ind)
+// xApps subscribed to the indication. *xapp_id spills to the heap past cap
+static size_t find_xapps_ind_iapp(e42_iapp_t* iapp,
+                                  global_e2_node_id_t const* id,
+                                  uint16_t ran_func_id,
+                                  uint16_t ric_req_id,
+                                  size_t cap,
+                                  uint32_t** xapp_id)
 {
-  assert(iapp != NULL);
-  assert(ind != NULL);
-  // Lock using the structure mutex
-  pthread_mutex_lock(&iapp->forward_mutex);
+  size_t len = find_ind_route_iapp(&iapp->ind_route, id, ran_func_id, ric_req_id, cap, *xapp_id);
+  if (len > cap) {
+    // Subscribed in between
+    cap = 2 * len;
+    *xapp_id = calloc(cap, sizeof(uint32_t));
+    assert(*xapp_id != NULL && "Memory exhausted");
+    len = find_ind_route_iapp(&iapp->ind_route, id, ran_func_id, ric_req_id, cap, *xapp_id);
+    len = len < cap ? len : cap;
+  }
 
-  // LOG_SURREY_RIC("[iApp]: Starting indication forward to xApp %d\n", xapp_id);
+  if (len == 0)
+    LOG_SURREY_RIC("[iApp]: No active subscriptions found for RAN function %d RIC_REQ_ID %d\n", ran_func_id, ric_req_id);
 
-  e2ap_msg_t ans = {.type = RIC_INDICATION};
-  // defer({ e2ap_msg_free_iapp(&iapp->ap, &ans); });
+  return len;
+}
 
-  ric_indication_t* dst = &ans.u_msgs.ric_ind;
+// The same buffer goes to every xApp
+static void send_xapps_ind_iapp(e42_iapp_t* iapp, size_t len, uint32_t const xapp_id[len], byte_array_t ba)
+{
+  for (size_t i = 0; i < len; ++i) {
+    sctp_msg_t sctp_msg = {.ba = ba};
+    sctp_msg.info = find_map_xapps_sad(&iapp->ep.xapps, xapp_id[i]);
 
-  // Create a copy of the indication
-  ric_indication_t temp_ind = {0};
-  memcpy(&temp_ind, ind, sizeof(ric_indication_t));
+    if (sctp_msg.info.addr.sin_port == 0) {
+      LOG_SURREY_RIC("[iApp]: ERROR - xApp %d not connected for indication forwarding\n", xapp_id[i]);
+      continue;
+    }
 
-  // Copy buffer contents if present
-  if (ind->hdr.buf != NULL) {
-    temp_ind.hdr.buf = malloc(ind->hdr.len);
-    assert(temp_ind.hdr.buf != NULL);
-    memcpy(temp_ind.hdr.buf, ind->hdr.buf, ind->hdr.len);
-    temp_ind.hdr.len = ind->hdr.len;
+    e2ap_send_sctp_msg_iapp(&iapp->ep, &sctp_msg);
   }
+}
 
-  if (ind->msg.buf != NULL) {
-    temp_ind.msg.buf = malloc(ind->msg.len);
-    assert(temp_ind.msg.buf != NULL);
-    memcpy(temp_ind.msg.buf, ind->msg.buf, ind->msg.len);
-    temp_ind.msg.len = ind->msg.len;
-  }
+// The iApp hands the xApp the same RIC request ID that it used towards the
+// E2 Node, so every subscriber receives identical bytes. Encode once
+e2ap_msg_t e2ap_handle_ric_indication_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, const e2ap_msg_t* msg)
+{
+  assert(iapp != NULL);
+  assert(id != NULL);
+  assert(msg != NULL);
+  assert(msg->type == RIC_INDICATION);
 
-  *dst = mv_ric_indication(&temp_ind);
+  ric_indication_t const* src = &msg->u_msgs.ric_ind;
+  e2ap_msg_t none = {.type = NONE_E2_MSG_TYPE};
 
-  sctp_msg_t sctp_msg = {0};
-  sctp_msg.info = find_map_xapps_sad(&iapp->ep.xapps, xapp_id);
+  uint32_t stack_id[64] = {0};
+  uint32_t* xapp_id = stack_id;
+  defer({ if (xapp_id != stack_id) free(xapp_id); });
 
-  if (sctp_msg.info.addr.sin_port == 0) {
-    LOG_SURREY_RIC("[iApp]: ERROR - xApp %d not connected for indication forwarding\n", xapp_id);
-    return;
-  }
+  size_t const len = find_xapps_ind_iapp(iapp, id, src->ric_id.ran_func_id, src->ric_id.ric_req_id, 64, &xapp_id);
+  if (len == 0)
+    return none;
 
-  // LOG_SURREY_RIC("[iApp]: Encoding indication message for xApp %d\n", xapp_id);
-  sctp_msg.ba = e2ap_msg_enc_iapp(&iapp->ap, &ans);
+  // Shallow view of the indication. The encoder only reads it, so no copy
+  e2ap_msg_t ind = {.type = RIC_INDICATION, .u_msgs.ric_ind = *src};
 
-  if (sctp_msg.ba.buf == NULL || sctp_msg.ba.len == 0) {
+  byte_array_t ba = e2ap_msg_enc_iapp(&iapp->ap, &ind);
+  if (ba.buf == NULL || ba.len == 0) {
     LOG_SURREY_RIC("[iApp]: ERROR - Failed to encode indication message\n");
-    return;
+    return none;
   }
-  e2ap_send_sctp_msg_iapp(&iapp->ep, &sctp_msg);
-  // defer({ free_sctp_msg(&sctp_msg); });
+  defer({ free_byte_array(ba); });
+
+  send_xapps_ind_iapp(iapp, len, xapp_id, ba);
 
-  // LOG_SURREY_RIC("[iApp]: Sending indication to xApp %d (message size: %zu bytes)\n", xapp_id, sctp_msg.ba.len);
-  // Cleanup
-  free_sctp_msg(&sctp_msg);
-  e2ap_msg_free_iapp(&iapp->ap, &ans);
-  // Unlock using the structure mutex
-  pthread_mutex_unlock(&iapp->forward_mutex);
+  return none;
 }
 
-e2ap_msg_t e2ap_handle_ric_indication_iapp(e42_iapp_t* iapp, const e2ap_msg_t* msg)
+// Relay. For the same reason as above, the PDU of the E2 Node is forwarded
+// as is
+void e2ap_fwd_ric_indication_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, ric_gen_id_t const* ric_id, byte_array_t ba)
 {
   assert(iapp != NULL);
-  assert(msg != NULL);
-  assert(msg->type == RIC_INDICATION);
-
-  ric_indication_t const* src = &msg->u_msgs.ric_ind;
-
-  // LOG_SURREY_RIC("[iApp]: Received RIC Indication for RAN Function ID: %d\n", src->ric_id.ran_func_id);
-
-  // Debug print subscription registry state
-  pthread_mutex_lock(&iapp->subscription_registry.mutex);
-  // LOG_SURREY_RIC("[iApp]: Current Subscription Registry State:\n");
-  // LOG_SURREY_RIC("        Total subscriptions: %zu\n", iapp->subscription_registry.count);
-
-  bool indication_forwarded = false;
-
-  // Check all active subscriptions
-  for (size_t i = 0; i < iapp->subscription_registry.count; i++) {
-    subscription_entry_t* entry = &iapp->subscription_registry.entries[i];
-
-    // LOG_SURREY_RIC(
-    //     "[iApp]: Checking subscription entry %zu:\n"
-    //     "        xApp ID: %d\n"
-    //     "        RAN Function ID: %d (Received: %d)\n"
-    //     "        Active: %s\n",
-    //     i,
-    //     entry->xapp_id,
-    //     entry->ran_func_id,
-    //     src->ric_id.ran_func_id,
-    //     entry->active ? "true" : "false");
-
-    if (entry->active && entry->ran_func_id == src->ric_id.ran_func_id) {
-      // LOG_SURREY_RIC(
-      //     "[iApp]: Found matching subscription - forwarding indication\n"
-      //     "        From RAN func %d to xApp %d\n",
-      //     src->ric_id.ran_func_id,
-      //     entry->xapp_id);
-
-      // Forward indication to subscribed xApp
-      forward_indication_to_xapp(iapp, entry->xapp_id, src);
-      indication_forwarded = true;
-    }
-  }
+  assert(id != NULL);
+  assert(ric_id != NULL);
+  assert(ba.buf != NULL && ba.len > 0);
 
-  pthread_mutex_unlock(&iapp->subscription_registry.mutex);
+  uint32_t stack_id[64] = {0};
+  uint32_t* xapp_id = stack_id;
+  defer({ if (xapp_id != stack_id) free(xapp_id); });
 
-  if (!indication_forwarded) {
-    LOG_SURREY_RIC("[iApp]: No active subscriptions found for RAN function %d\n", src->ric_id.ran_func_id);
-  }
+  size_t const len = find_xapps_ind_iapp(iapp, id, ric_id->ran_func_id, ric_id->ric_req_id, 64, &xapp_id);
 
-  e2ap_msg_t none = {.type = NONE_E2_MSG_TYPE};
-  return none;
+  send_xapps_ind_iapp(iapp, len, xapp_id, ba);
 }
 
 static bool valid_xapp_id(e42_iapp_t* iapp, uint32_t xapp_id)
@@ -583,6 +559,8 @@ e2ap_msg_t e2ap_handle_e42_ric_subscription_delete_request_iapp(e42_iapp_t* iapp
   e2_node_ric_id_t n = find_ric_req_map_ric_id(&iapp->map_ric_id, &x);
   assert(n.ric_req_type == SUBSCRIPTION_RIC_REQUEST_TYPE);
 
+  rm_ind_route_iapp(&iapp->ind_route, &n.e2_node_id, n.ric_id.ran_func_id, n.ric_id.ric_req_id, src->xapp_id);
+
   ric_subscription_delete_request_t dst = cp_ric_subscription_delete_request(&src->sdr);
   dst.ric_id.ric_req_id = n.ric_id.ric_req_id;
 
@@ -659,14 +637,8 @@ e2ap_msg_t e2ap_handle_e42_ric_subscription_request_iapp(e42_iapp_t* iapp, const
   //   iapp->subscription_registry.entries = new_entries;
   //   iapp->subscription_registry.capacity = new_capacity;
   // }
-  // Replace the manual subscription handling with register_subscription
-  bool reg_success =
-      register_subscription(&iapp->subscription_registry, e42_sr->xapp_id, e42_sr->sr.ric_id.ran_func_id, new_ric_id);
-
-  if (!reg_success) {
-    LOG_SURREY_RIC("[iApp]: ERROR - Failed to register subscription\n");
-    return none;
-  }
+  // Route the indications of this subscription to the xApp
+  add_ind_route_iapp(&iapp->ind_route, &e42_sr->id, e42_sr->sr.ric_id.ran_func_id, new_ric_id, e42_sr->xapp_id);
   // // Add new subscription
   // size_t idx = iapp->subscription_registry.count;
   // iapp->subscription_registry.entries[idx].xapp_id = e42_sr->xapp_id;
@@ -93,7 +93,12 @@ e2ap_msg_t e2ap_handle_e42_ric_subscription_delete_request_iapp(e42_iapp_t* ag,
 e2ap_msg_t e2ap_handle_e42_ric_control_request_iapp(e42_iapp_t* ag, const e2ap_msg_t* msg);
 
 // iApp -> xApp
-e2ap_msg_t e2ap_handle_ric_indication_iapp(e42_iapp_t* iapp, const e2ap_msg_t* msg);
+// Not in the handler table: the E2 Node is not part of the message
+e2ap_msg_t e2ap_handle_ric_indication_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, const e2ap_msg_t* msg);
+
+// iApp -> xApp
+// RIC INDICATION PDU as received from the E2 Node id
+void e2ap_fwd_ric_indication_iapp(e42_iapp_t* iapp, global_e2_node_id_t const* id, ric_gen_id_t const* ric_id, byte_array_t ba);
 
 // iApp -> xApp
 e2ap_msg_t e2ap_handle_subscription_delete_response_iapp(e42_iapp_t* iapp, const e2ap_msg_t* msg);
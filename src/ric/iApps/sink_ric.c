@@ -0,0 +1,222 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "sink_ric.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Indications taken from the queue per lock acquisition
+#define SINK_BATCH 32
+
+sink_ind_ric_t* init_sink_ind_ric(sm_ag_if_rd_ind_t d, void (*free_ind)(void*), uint32_t refs)
+{
+  assert(free_ind != NULL);
+  assert(refs > 0);
+
+  sink_ind_ric_t* ind = malloc(sizeof(sink_ind_ric_t));
+  assert(ind != NULL && "Memory exhausted");
+
+  ind->d = d;
+  ind->free_ind = free_ind;
+  atomic_init(&ind->refs, refs);
+  return ind;
+}
+
+void release_sink_ind_ric(sink_ind_ric_t* ind)
+{
+  assert(ind != NULL);
+
+  if (atomic_fetch_sub_explicit(&ind->refs, 1, memory_order_acq_rel) > 1)
+    return;
+
+  ind->free_ind(&ind->d);
+  free(ind);
+}
+
+// Called with the mutex locked
+static sink_ind_ric_t* pop_front(sink_ric_t* s)
+{
+  assert(s->len > 0);
+  sink_ind_ric_t* ind = s->buf[s->head];
+  s->head = (s->head + 1) % s->conf.cap;
+  s->len -= 1;
+  return ind;
+}
+
+static void* sink_loop(void* arg)
+{
+  sink_ric_t* s = (sink_ric_t*)arg;
+
+  sink_ind_ric_t* batch[SINK_BATCH];
+
+  while (true) {
+    size_t n = 0;
+
+    int rc = pthread_mutex_lock(&s->mtx);
+    assert(rc == 0);
+
+    while (s->len == 0 && s->stop == false)
+      pthread_cond_wait(&s->not_empty, &s->mtx);
+
+    // Stopped and drained
+    if (s->len == 0) {
+      rc = pthread_mutex_unlock(&s->mtx);
+      assert(rc == 0);
+      break;
+    }
+
+    while (s->len > 0 && n < SINK_BATCH)
+      batch[n++] = pop_front(s);
+    s->st.depth = s->len;
+
+    pthread_cond_broadcast(&s->not_full);
+    rc = pthread_mutex_unlock(&s->mtx);
+    assert(rc == 0);
+
+    for (size_t i = 0; i < n; ++i) {
+      s->conf.subs.fp(&batch[i]->d);
+      release_sink_ind_ric(batch[i]);
+    }
+
+    rc = pthread_mutex_lock(&s->mtx);
+    assert(rc == 0);
+    s->st.done += n;
+    rc = pthread_mutex_unlock(&s->mtx);
+    assert(rc == 0);
+  }
+
+  return NULL;
+}
+
+void init_sink_ric(sink_ric_t* s, sink_conf_ric_t conf)
+{
+  assert(s != NULL);
+  assert(conf.subs.fp != NULL);
+  assert(conf.cap > 0);
+  assert(conf.overflow < SINK_OVERFLOW_END);
+  assert(conf.overflow != SINK_OVERFLOW_SAMPLE || conf.sample_rate > 0);
+
+  memset(s, 0, sizeof(*s));
+  s->conf = conf;
+
+  s->buf = calloc(conf.cap, sizeof(sink_ind_ric_t*));
+  assert(s->buf != NULL && "Memory exhausted");
+
+  int rc = pthread_mutex_init(&s->mtx, NULL);
+  assert(rc == 0);
+  rc = pthread_cond_init(&s->not_empty, NULL);
+  assert(rc == 0);
+  rc = pthread_cond_init(&s->not_full, NULL);
+  assert(rc == 0);
+
+  rc = pthread_create(&s->thr, NULL, sink_loop, s);
+  assert(rc == 0);
+}
+
+sink_stats_ric_t free_sink_ric(sink_ric_t* s)
+{
+  assert(s != NULL);
+
+  int rc = pthread_mutex_lock(&s->mtx);
+  assert(rc == 0);
+  s->stop = true;
+  pthread_cond_broadcast(&s->not_empty);
+  // Blocked producers, if any, give up
+  pthread_cond_broadcast(&s->not_full);
+  rc = pthread_mutex_unlock(&s->mtx);
+  assert(rc == 0);
+
+  rc = pthread_join(s->thr, NULL);
+  assert(rc == 0);
+  assert(s->len == 0);
+
+  free(s->buf);
+  pthread_cond_destroy(&s->not_full);
+  pthread_cond_destroy(&s->not_empty);
+  pthread_mutex_destroy(&s->mtx);
+
+  return s->st;
+}
+
+void push_sink_ric(sink_ric_t* s, sink_ind_ric_t* ind)
+{
+  assert(s != NULL);
+  assert(ind != NULL);
+
+  // Released out of the critical section
+  sink_ind_ric_t* dropped = NULL;
+
+  int rc = pthread_mutex_lock(&s->mtx);
+  assert(rc == 0);
+
+  size_t const cap = s->conf.cap;
+  bool queue = true;
+
+  if (s->stop == true) {
+    queue = false;
+  } else if (s->conf.overflow == SINK_OVERFLOW_BLOCK) {
+    while (s->len == cap && s->stop == false)
+      pthread_cond_wait(&s->not_full, &s->mtx);
+    queue = s->stop == false;
+  } else if (s->conf.overflow == SINK_OVERFLOW_DROP_OLDEST) {
+    if (s->len == cap)
+      dropped = pop_front(s);
+  } else if (s->len >= cap / 2) {
+    s->sampled += 1;
+    queue = s->len < cap && s->sampled % s->conf.sample_rate == 0;
+  }
+
+  if (queue == true) {
+    s->buf[(s->head + s->len) % cap] = ind;
+    s->len += 1;
+    s->st.enq += 1;
+    pthread_cond_signal(&s->not_empty);
+  } else {
+    dropped = ind;
+  }
+
+  if (dropped != NULL)
+    s->st.drop += 1;
+  s->st.depth = s->len;
+  if (s->len > s->st.max_depth)
+    s->st.max_depth = s->len;
+
+  rc = pthread_mutex_unlock(&s->mtx);
+  assert(rc == 0);
+
+  if (dropped != NULL)
+    release_sink_ind_ric(dropped);
+}
+
+sink_stats_ric_t stats_sink_ric(sink_ric_t* s)
+{
+  assert(s != NULL);
+
+  int rc = pthread_mutex_lock(&s->mtx);
+  assert(rc == 0);
+  sink_stats_ric_t const st = s->st;
+  rc = pthread_mutex_unlock(&s->mtx);
+  assert(rc == 0);
+
+  return st;
+}
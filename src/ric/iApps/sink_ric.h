@@ -0,0 +1,117 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef SINK_RIC_H
+#define SINK_RIC_H
+
+/*
+ * Asynchronous delivery of the indications to the pub/sub listeners
+ * (stdout, redis, influx).
+ *
+ * Every sink owns a bounded queue and a thread that calls its listener,
+ * so a slow listener no longer stalls the task manager workers. The
+ * indication is not copied: all the sinks share it, and the last one
+ * done releases it through the SM that produced it.
+*/
+
+#include "subscription_ric.h"
+#include "../../sm/agent_if/read/sm_ag_if_rd.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// What push_sink_ric does when the queue is full
+typedef enum{
+  // Wait for room. Backpressure to the E2 ingest, as the synchronous listeners
+  SINK_OVERFLOW_BLOCK,
+  // Discard the oldest queued indication
+  SINK_OVERFLOW_DROP_OLDEST,
+  // Beyond half the capacity, only 1 out of sample_rate indications is queued.
+  // The newest is discarded when full
+  SINK_OVERFLOW_SAMPLE,
+
+  SINK_OVERFLOW_END,
+} sink_overflow_e;
+
+typedef struct{
+  subs_ric_t subs;
+  size_t cap;
+  sink_overflow_e overflow;
+  uint32_t sample_rate;
+} sink_conf_ric_t;
+
+typedef struct{
+  uint64_t enq;
+  uint64_t done;
+  uint64_t drop;
+  size_t depth;
+  size_t max_depth;
+} sink_stats_ric_t;
+
+// Shared by the sinks of one indication. The action definitions
+// referenced by d are non-owning, and may be gone when a sink thread
+// gets to it. Listeners must not dereference them
+typedef struct{
+  sm_ag_if_rd_ind_t d;
+  // free_ind_data of the SM that produced d
+  void (*free_ind)(void* d);
+  atomic_uint refs;
+} sink_ind_ric_t;
+
+typedef struct{
+  sink_conf_ric_t conf;
+
+  pthread_t thr;
+  pthread_mutex_t mtx;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+
+  // Ring of conf.cap
+  sink_ind_ric_t** buf;
+  size_t head;
+  size_t len;
+  // Indications offered while over the sampling threshold
+  uint64_t sampled;
+  bool stop;
+
+  sink_stats_ric_t st;
+} sink_ric_t;
+
+// refs references, i.e., one per sink it will be pushed to
+sink_ind_ric_t* init_sink_ind_ric(sm_ag_if_rd_ind_t d, void (*free_ind)(void*), uint32_t refs);
+
+void release_sink_ind_ric(sink_ind_ric_t* ind);
+
+void init_sink_ric(sink_ric_t* s, sink_conf_ric_t conf);
+
+// The queued indications are delivered before the thread is joined.
+// Returns the final counters
+sink_stats_ric_t free_sink_ric(sink_ric_t* s);
+
+// Consumes one reference of ind, even if dropped
+void push_sink_ric(sink_ric_t* s, sink_ind_ric_t* ind);
+
+sink_stats_ric_t stats_sink_ric(sink_ric_t* s);
+
+#endif
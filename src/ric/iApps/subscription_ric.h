@@ -25,11 +25,19 @@
 #ifndef SUBSCRIPTION_RIC_H
 #define SUBSCRIPTION_RIC_H
 
+#include <stdint.h>
+
 #include "../../sm/agent_if/read/sm_ag_if_rd.h"
 
+// Capability bit of a decoded indication type
+#define SUBS_CAP_RIC(t) (1u << (t))
+
 typedef struct{
   char name[32];
   void (*fp)(sm_ag_if_rd_ind_t const* data);
+  // SUBS_CAP_RIC(sm_ag_if_rd_ind_e) of the indications that the listener
+  // reads. The RIC does not decode the SM payload if no listener reads it
+  uint32_t caps;
 } subs_ric_t;
 
 
@@ -160,3 +160,44 @@ sctp_info_t find_map_e2_node_sad(map_e2_node_sockaddr_t* m, global_e2_node_id_t
   return *s;
 }
 
+bool find_e2_node_map_sad(map_e2_node_sockaddr_t* m, sctp_info_t const* s, global_e2_node_id_t* out)
+{
+  assert(m != NULL);
+  assert(s != NULL);
+  assert(out != NULL);
+
+  lock_guard(&m->mtx);
+
+  assoc_rb_tree_t* tree = &m->map.right;
+
+  void* it = assoc_find(tree, s);
+  if(it == assoc_end(tree))
+    return false;
+
+  *out = cp_global_e2_node_id(assoc_value(tree, it));
+  return true;
+}
+
+bool find_fd_map_e2_node_sad(map_e2_node_sockaddr_t* m, int fd, sctp_info_t* out)
+{
+  assert(m != NULL);
+  assert(fd > 0);
+  assert(out != NULL);
+
+  lock_guard(&m->mtx);
+
+  assoc_rb_tree_t* tree = &m->map.right;
+
+  void* it = assoc_front(tree);
+  void* end = assoc_end(tree);
+  while(it != end){
+    sctp_info_t const* s = assoc_key(tree, it);
+    if(s->fd == fd){
+      *out = *s;
+      return true;
+    }
+    it = assoc_next(tree, it);
+  }
+
+  return false;
+}
@@ -32,6 +32,7 @@
 
 #include <netinet/in.h>
 #include <pthread.h>
+#include <stdbool.h>
 
 typedef struct{
 //  assoc_rb_tree_t tree; // key: global_e2_node_id_t | value: sctp_info_t     
@@ -57,5 +58,11 @@ sctp_info_t find_map_e2_node_sad(map_e2_node_sockaddr_t* m, global_e2_node_id_t
 
 sctp_info_t find_map_e2_node_sad(map_e2_node_sockaddr_t * m, global_e2_node_id_t const* id);
 
+// E2 Node behind the association s. The copy is owned by the caller
+bool find_e2_node_map_sad(map_e2_node_sockaddr_t* m, sctp_info_t const* s, global_e2_node_id_t* out);
+
+// E2 Node reached through the peeled off socket fd. Linear
+bool find_fd_map_e2_node_sad(map_e2_node_sockaddr_t* m, int fd, sctp_info_t* out);
+
 #endif
 
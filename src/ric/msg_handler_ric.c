@@ -37,7 +37,7 @@
 #include "lib/pending_events.h"
 #include "lib/pending_event_ric.h"
 #include "lib/e2ap/e2ap_msg_free_wrapper.h"
-#include "iApps/subscription_ric.h"
+#include "iApps/sink_ric.h"
 #include "iApp/e42_iapp_api.h"
 
 #include "util/alg_ds/ds/lock_guard/lock_guard.h"
@@ -73,16 +73,22 @@ void stop_pending_event(near_ric_t* ric, pending_event_ric_t* ev )
 
   int rc = pthread_mutex_lock(&ric->pend_mtx);
   assert(rc == 0);
+  // Answered after it expired. The event loop already reported and removed it
+  if (bi_map_find_right(&ric->pending, ev).it == bi_map_end_right(&ric->pending).it) {
+    rc = pthread_mutex_unlock(&ric->pend_mtx);
+    assert(rc == 0);
+    printf("[NEAR-RIC]: Answer for RIC request ID %u arrived after its timeout\n", ev->id.ric_req_id);
+    return;
+  }
   void (*free_pending_event)(void*) = NULL; 
-  int* fd = bi_map_extract_right(&ric->pending, ev, sizeof(*ev), free_pending_event);
+  int* tmr_id = bi_map_extract_right(&ric->pending, ev, sizeof(*ev), free_pending_event);
   rc = pthread_mutex_unlock(&ric->pend_mtx);
   assert(rc == 0);
 
 //  assert(bi_map_size(&ric->pending) == 0 && "Just one SM supported");
-  assert(*fd > 0);
-  //printf("fd value in stopping pending event = %d \n", *fd);
-  rm_fd_asio_ric(&ric->io, *fd);
-  free(fd);
+  assert(*tmr_id > 0);
+  cancel_timer_asio_ric(&ric->io, *tmr_id);
+  free(tmr_id);
 }
 
 e2ap_msg_t e2ap_msg_handle_ric(near_ric_t* ric, const e2ap_msg_t* msg)
@@ -176,30 +182,43 @@ e2ap_msg_t e2ap_msg_handle_ric(near_ric_t* ric, const e2ap_msg_t* msg)
   return ans;
 }
 
-static
-void publish_ind_msg(near_ric_t* ric,  uint16_t ran_func_id, sm_ag_if_rd_ind_t* d)
+bool skip_ind_dec_ric(near_ric_t* ric, uint16_t ran_func_id)
 {
+  assert(ric != NULL);
 
-  // find RIC request ID, pass the data to the assoc. SM
-  void* start_it = assoc_front(&ric->pub_sub);
-  void* end_it = assoc_end(&ric->pub_sub);
+  // Only the sinks that read the SM of ran_func_id are registered. See load_pub_sub_ric
+  void* it = assoc_find(&ric->pub_sub, &ran_func_id);
+  if(it != assoc_end(&ric->pub_sub) && seq_size(assoc_value(&ric->pub_sub, it)) > 0)
+    return false;
 
-  void* sm_it = find_if(&ric->pub_sub, start_it, end_it, &ran_func_id, eq_ran_func_id);
-  assert(sm_it != end_it && "Could not find a RAN function that matches the SM");
+  atomic_fetch_add_explicit(&ric->skip_dec, 1, memory_order_relaxed);
+  return true;
+}
 
+// Ownership of d passes to the sinks. The last one done releases it
+static
+void publish_ind_msg(near_ric_t* ric,  uint16_t ran_func_id, sm_ric_t* sm, sm_ag_if_rd_ind_t d)
+{
+  void* end_it = assoc_end(&ric->pub_sub);
+  void* sm_it = assoc_find(&ric->pub_sub, &ran_func_id);
+
+  // No sink enabled, or SM loaded after the RIC started
+  seq_arr_t* arr = sm_it != end_it ? assoc_value(&ric->pub_sub, sm_it) : NULL;
+  size_t const len = arr != NULL ? seq_size(arr) : 0;
+  if(len == 0){
+    sm->alloc.free_ind_data(&d);
+    return;
+  }
 
-  if(sm_it != end_it){
-    seq_arr_t* arr = assoc_value(&ric->pub_sub, start_it);  
-    void* it = seq_front(arr);
-    void* it_end = seq_end(arr);
-    while(it != it_end){
-      subs_ric_t* sub = (subs_ric_t*)it;
-      sub->fp(d);
-      it = seq_next(arr, it);
-    }
-    start_it = assoc_next(&ric->pub_sub, start_it);
+  sink_ind_ric_t* ind = init_sink_ind_ric(d, sm->alloc.free_ind_data, len);
+
+  void* it = seq_front(arr);
+  void* it_end = seq_end(arr);
+  while(it != it_end){
+    sink_ric_t* sink = *(sink_ric_t**)it;
+    push_sink_ric(sink, ind);
+    it = seq_next(arr, it);
   }
- 
 }
 
 // E2 -> RIC
@@ -212,6 +231,11 @@ void publish_ind_msg(near_ric_t* ric,  uint16_t ran_func_id, sm_ag_if_rd_ind_t*
   ric_indication_t const* ric_ind = &msg->u_msgs.ric_ind;
 
   const uint16_t ran_func_id = ric_ind->ric_id.ran_func_id;  
+
+  e2ap_msg_t ans = {.type = NONE_E2_MSG_TYPE };
+  if(skip_ind_dec_ric(ric, ran_func_id) == true)
+    return ans;
+
   sm_ric_t* sm = sm_plugin_ric(&ric->plugin, ran_func_id);
 
   sm_ind_data_t data = {.ind_hdr = ric_ind->hdr.buf,
@@ -225,20 +249,15 @@ void publish_ind_msg(near_ric_t* ric,  uint16_t ran_func_id, sm_ag_if_rd_ind_t*
   }
 
   sm_ag_if_rd_ind_t d = sm->proc.on_indication(sm, &data);
-  defer({ sm->alloc.free_ind_data(&d); } );
   assert(d.type == MAC_STATS_V0 || d.type == RLC_STATS_V0 
         || d.type == PDCP_STATS_V0 || d.type == SLICE_STATS_V0 
         || d.type == KPM_STATS_V3_0 || d.type == RAN_CTRL_STATS_V1_03 
         || d.type == GTP_STATS_V0 || d.type == TC_STATS_V0 );
 
-  publish_ind_msg(ric, ran_func_id, &d);
+  publish_ind_msg(ric, ran_func_id, sm, d);
 
-  // Notify the iApp
-#ifndef TEST_AGENT_RIC  
-  notify_msg_iapp_api(msg);
-#endif
+  // The iApp is notified by the caller, which knows the E2 Node
 
-  e2ap_msg_t ans = {.type = NONE_E2_MSG_TYPE };
   return ans;
 }
 
@@ -48,6 +48,9 @@ e2ap_msg_t e2ap_handle_subscription_delete_failure_ric(struct near_ric_s* ric, c
 // E2 -> RIC
 e2ap_msg_t e2ap_handle_indication_ric(struct near_ric_s* ric, const struct e2ap_msg_s* msg);
 
+// True, and counted as a skipped decode, if no sink reads the indications of ran_func_id
+bool skip_ind_dec_ric(struct near_ric_s* ric, uint16_t ran_func_id);
+
 // E2 -> RIC
 e2ap_msg_t e2ap_handle_control_ack_ric(struct near_ric_s* ric, const struct e2ap_msg_s* msg);
 
@@ -22,6 +22,7 @@
 #include "near_ric.h"
 #include "e2_node.h"
 #include "iApp/e42_iapp_api.h"
+#include "lib/e2ap/e2ap_ind_aper.h"
 
 #include "msg_handler_ric.h"
 #include "not_handler_ric.h"
@@ -35,13 +36,23 @@
 
 #include "lib/pending_event_ric.h"
 #include "sm/sm_ric.h"
+#include "sm/gtp_sm/gtp_sm_id.h"
+#include "sm/kpm_sm/kpm_sm_id_wrapper.h"
+#include "sm/mac_sm/mac_sm_id.h"
+#include "sm/pdcp_sm/pdcp_sm_id.h"
+#include "sm/rc_sm/rc_sm_id.h"
+#include "sm/rlc_sm/rlc_sm_id.h"
+#include "sm/slice_sm/slice_sm_id.h"
+#include "sm/tc_sm/tc_sm_id.h"
 #include "util/alg_ds/ds/assoc_container/assoc_generic.h"
 #include "util/alg_ds/alg/alg.h"
 #include "util/alg_ds/ds/lock_guard/lock_guard.h"
 #include "util/compare.h"
+#include "util/thread_affinity.h"
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
 #include <stdlib.h>
@@ -54,12 +65,12 @@
 #define THREAD_TERMINATION_TIMEOUT 15 // seconds
 #define RIC_THREAD_NAME "nearRT-RIC"
 
-static inline void free_fd(void* key, void* value)
+static inline void free_tmr_id(void* key, void* value)
 {
   assert(key != NULL);
   assert(value != NULL);
-  int* fd = (int*)key;
-  assert(*fd > 0);
+  int* tmr_id = (int*)key;
+  assert(*tmr_id > 0);
   free(value);
 }
 
@@ -82,17 +93,16 @@ static inline void free_subscribed(void* key, void* value)
   free(arr);
 }
 
-static void register_listeners_for_ran_func_id(near_ric_t* ric, uint16_t const* ran_func_id, subs_ric_t subs)
+static void register_listeners_for_ran_func_id(near_ric_t* ric, uint16_t const* ran_func_id, sink_ric_t* sink)
 {
-  void* start_it = assoc_front(&ric->pub_sub);
   void* end_it = assoc_end(&ric->pub_sub);
-  void* it = find_if(&ric->pub_sub, start_it, end_it, ran_func_id, eq_ran_func_id);
+  void* it = assoc_find(&ric->pub_sub, ran_func_id);
 
   if (it == end_it) {
     seq_arr_t* arr = malloc(sizeof(seq_arr_t));
     assert(arr != NULL && "Memory exhausted!!!");
-    seq_init(arr, sizeof(subs_ric_t)); //
-    seq_push_back(arr, &subs, sizeof(subs_ric_t));
+    seq_init(arr, sizeof(sink_ric_t*)); //
+    seq_push_back(arr, &sink, sizeof(sink_ric_t*));
     assoc_insert(&ric->pub_sub, ran_func_id, sizeof(*ran_func_id), arr);
 
     // For testing for only one SM
@@ -104,35 +114,124 @@ static void register_listeners_for_ran_func_id(near_ric_t* ric, uint16_t const*
     // End testing
   } else {
     seq_arr_t* arr = assoc_value(&ric->pub_sub, it);
-    seq_push_back(arr, &subs, sizeof(subs_ric_t));
+    seq_push_back(arr, &sink, sizeof(sink_ric_t*));
   }
 }
 
-static void load_default_pub_sub_ric(near_ric_t* ric)
+static subs_ric_t const listeners_ric[] = {
+    {.name = "stdout",
+     .fp = notify_stdout_listener,
+     .caps = SUBS_CAP_RIC(MAC_STATS_V0) | SUBS_CAP_RIC(RLC_STATS_V0) | SUBS_CAP_RIC(PDCP_STATS_V0)
+             | SUBS_CAP_RIC(SLICE_STATS_V0) | SUBS_CAP_RIC(GTP_STATS_V0)},
+    // Placeholders. They do not read the indications yet
+    {.name = "redis", .fp = notify_redis_listener, .caps = 0},
+    {.name = "influx", .fp = notify_influx_listener, .caps = 0},
+    //    {.name = "nanomsg", .fp = notify_nng_listener },
+};
+
+static subs_ric_t find_listener_ric(const char* name)
+{
+  size_t const len = sizeof(listeners_ric) / sizeof(listeners_ric[0]);
+  for (size_t i = 0; i < len; ++i) {
+    if (strcmp(listeners_ric[i].name, name) == 0)
+      return listeners_ric[i];
+  }
+
+  printf("[NEAR-RIC]: RIC_SINKS: unknown sink %s. It should be stdout, redis or influx\n", name);
+  exit(EXIT_FAILURE);
+}
+
+static sink_overflow_e sink_overflow_ric(fr_sink_overflow_e o)
+{
+  if (o == FR_SINK_BLOCK)
+    return SINK_OVERFLOW_BLOCK;
+  if (o == FR_SINK_DROP_OLDEST)
+    return SINK_OVERFLOW_DROP_OLDEST;
+  assert(o == FR_SINK_SAMPLE);
+  return SINK_OVERFLOW_SAMPLE;
+}
+
+// Indication type of the SMs shipped with FlexRIC. SM_AGENT_IF_READ_V0_END if unknown
+static sm_ag_if_rd_ind_e ind_type_ran_func_ric(uint16_t ran_func_id)
+{
+  if (ran_func_id == SM_KPM_ID)
+    return KPM_STATS_V3_0;
+  if (ran_func_id == SM_RC_ID)
+    return RAN_CTRL_STATS_V1_03;
+  if (ran_func_id == SM_MAC_ID)
+    return MAC_STATS_V0;
+  if (ran_func_id == SM_RLC_ID)
+    return RLC_STATS_V0;
+  if (ran_func_id == SM_PDCP_ID)
+    return PDCP_STATS_V0;
+  if (ran_func_id == SM_SLICE_ID)
+    return SLICE_STATS_V0;
+  if (ran_func_id == SM_TC_ID)
+    return TC_STATS_V0;
+  if (ran_func_id == SM_GTP_ID)
+    return GTP_STATS_V0;
+  return SM_AGENT_IF_READ_V0_END;
+}
+
+// An SM of unknown type is decoded for any sink that reads indications
+static bool sink_reads_ran_func_ric(sink_ric_t const* sink, uint16_t ran_func_id)
+{
+  uint32_t const caps = sink->conf.subs.caps;
+  sm_ag_if_rd_ind_e const t = ind_type_ran_func_ric(ran_func_id);
+  if (t == SM_AGENT_IF_READ_V0_END)
+    return caps != 0;
+  return (caps & SUBS_CAP_RIC(t)) != 0;
+}
+
+static void load_pub_sub_ric(near_ric_t* ric, fr_args_t const* args)
 {
   assert(ric != NULL);
+  assert(args != NULL);
+
+  fr_sink_list_t const l = get_conf_ric_sinks(args);
+  assert(l.len <= FR_RIC_SINKS_MAX);
+
+  for (size_t i = 0; i < l.len; ++i) {
+    sink_conf_ric_t const conf = {.subs = find_listener_ric(l.sink[i].name),
+                                  .cap = l.queue,
+                                  .overflow = sink_overflow_ric(l.sink[i].overflow),
+                                  .sample_rate = l.sample};
+    printf("[NEAR-RIC]: Sink %s enabled, up to %zu queued indications \n", conf.subs.name, conf.cap);
+    init_sink_ric(&ric->sinks[i], conf);
+  }
+  ric->len_sinks = l.len;
+
+  if (ric->len_sinks == 0)
+    printf("[NEAR-RIC]: No sinks. RIC indications are relayed to the xApps without being decoded \n");
 
   void* it = assoc_front(&ric->plugin.sm_ds);
   void* end_it = assoc_end(&ric->plugin.sm_ds);
   while (it != end_it) {
     const uint16_t* ran_func_id = assoc_key(&ric->plugin.sm_ds, it);
 
-    subs_ric_t std_listener = {.name = "stdout listener", .fp = notify_stdout_listener};
-    register_listeners_for_ran_func_id(ric, ran_func_id, std_listener);
-
-    subs_ric_t redis_listener = {.name = "redis listener", .fp = notify_redis_listener};
-    register_listeners_for_ran_func_id(ric, ran_func_id, redis_listener);
-
-    subs_ric_t influx_listener = {.name = "influx listener", .fp = notify_influx_listener};
-    register_listeners_for_ran_func_id(ric, ran_func_id, influx_listener);
-
-    //    subs_ric_t nng_listener = {.name = "nanomsg listener", .fp = notify_nng_listener };
-    //    register_listeners_for_ran_func_id(ric, ran_func_id, nng_listener);
+    // The indications of a RAN function without sinks are not decoded. See skip_ind_dec_ric
+    for (size_t i = 0; i < ric->len_sinks; ++i) {
+      if (sink_reads_ran_func_ric(&ric->sinks[i], *ran_func_id))
+        register_listeners_for_ran_func_id(ric, ran_func_id, &ric->sinks[i]);
+    }
 
     it = assoc_next(&ric->plugin.sm_ds, it);
   }
 }
 
+static void free_sinks_ric(near_ric_t* ric)
+{
+  for (size_t i = 0; i < ric->len_sinks; ++i) {
+    sink_ric_t* s = &ric->sinks[i];
+    sink_stats_ric_t const st = free_sink_ric(s);
+    printf("[NEAR-RIC]: Sink %s: %" PRIu64 " indications delivered, %" PRIu64 " dropped, max. queue depth %zu \n",
+           s->conf.subs.name,
+           st.done,
+           st.drop,
+           st.max_depth);
+  }
+}
+
 static void init_handle_msg_ric(size_t len, e2ap_handle_msg_fp_ric (*handle_msg)[len])
 {
   assert(len == NONE_E2_MSG_TYPE);
@@ -181,9 +280,9 @@ static inline void init_e2_nodes_ric(near_ric_t* ric)
 static inline void init_pending_events(near_ric_t* ric)
 {
   assert(ric != NULL);
-  size_t const fd_sz = sizeof(int);
+  size_t const tmr_id_sz = sizeof(int);
   size_t const event_sz = sizeof(pending_event_ric_t);
-  bi_map_init(&ric->pending, fd_sz, event_sz, cmp_fd, cmp_pending_event_ric, free_fd, free_pending_ev_ric);
+  bi_map_init(&ric->pending, tmr_id_sz, event_sz, cmp_fd, cmp_pending_event_ric, free_tmr_id, free_pending_ev_ric);
 
   pthread_mutexattr_t attr = {0};
 #ifdef DEBUG
@@ -194,12 +293,32 @@ static inline void init_pending_events(near_ric_t* ric)
   assert(rc == 0);
 }
 
+static void peeled_batch_ric(void* data, int fd, sctp_msg_arr_t arr, bool last);
+
 near_ric_t* init_near_ric(fr_args_t const* args)
 {
   assert(args != NULL);
+
+  // Before any thread or large allocation. The threads inherit it
+  int const numa_node = get_conf_ric_numa_node(args);
+  if (numa_node > -1) {
+    printf("[NEAR-RIC]: Preferring memory from NUMA node %d \n", numa_node);
+    prefer_numa_node(numa_node);
+  }
+
   near_ric_t* ric = calloc(1, sizeof(near_ric_t));
   assert(ric != NULL);
 
+  fr_cpu_list_t worker_cpus = get_conf_ric_worker_cpus(args);
+  ric->reactor_cpus = get_conf_ric_reactor_cpus(args);
+  if (numa_node > -1) {
+    fr_cpu_list_t const node_cpus = cpus_numa_node(numa_node);
+    if (worker_cpus.len == 0)
+      worker_cpus = node_cpus;
+    if (ric->reactor_cpus.len == 0)
+      ric->reactor_cpus = node_cpus;
+  }
+
   char* addr = get_near_ric_ip(args);
   defer({ free(addr); });
 
@@ -209,7 +328,9 @@ near_ric_t* init_near_ric(fr_args_t const* args)
 
   init_asio_ric(&ric->io);
 
-  add_fd_asio_ric(&ric->io, ric->ep.base.fd);
+  add_sock_asio_ric(&ric->io, ric->ep.base.fd);
+
+  ric->rx_batch = get_conf_rx_batch(args);
 
   init_ap(&ric->ap.base.type);
 
@@ -220,18 +341,39 @@ near_ric_t* init_near_ric(fr_args_t const* args)
 
   init_pub_sub_ds_ric(ric);
 
-  load_default_pub_sub_ric(ric);
+  load_pub_sub_ric(ric, args);
 
   init_e2_nodes_ric(ric);
 
   init_pending_events(ric);
 
   near_ric_if_t ric_if = {.type = ric};
-  init_iapp_api(addr, ric_if);
-
-  uint32_t const num_threads = TASK_MAN_NUMBER_THREADS;
-  printf("[NEAR-RIC]: Initializing Task Manager with %u threads \n", num_threads);
-  init_task_manager(&ric->man, num_threads);
+  init_iapp_api(addr, ric_if, ric->rx_batch, get_conf_e42_shm_ring(args), ric->reactor_cpus.len, ric->reactor_cpus.cpu);
+
+  // The build default, unless configured
+  uint32_t num_threads = get_conf_ric_workers(args);
+  if (num_threads == 0)
+    num_threads = TASK_MAN_NUMBER_THREADS;
+
+  printf("[NEAR-RIC]: Initializing Task Manager with %u threads, pinned to %zu CPUs \n", num_threads, worker_cpus.len);
+  task_man_conf_t const man_conf = {.spin = TASK_MAN_SPIN_DEFAULT,
+                                    .yield = TASK_MAN_YIELD_DEFAULT,
+                                    .cpus = worker_cpus.cpu,
+                                    .len_cpus = worker_cpus.len};
+  init_conf_task_manager(&ric->man, num_threads, man_conf);
+
+  // The reactors feed the task manager
+  ric->num_reactors = get_conf_ric_reactors(args);
+  if (ric->num_reactors > 0) {
+    printf("[NEAR-RIC]: Peeling off the SCTP associations into %zu reactors \n", ric->num_reactors);
+    init_reactor_pool_ric(&ric->reactors,
+                          ric->num_reactors,
+                          ric->rx_batch,
+                          ric->reactor_cpus.len,
+                          ric->reactor_cpus.cpu,
+                          peeled_batch_ric,
+                          ric);
+  }
 
   // Initialize subscription tracking
   ric->req_id = 0; // Start from 0, increment when needed
@@ -253,29 +395,6 @@ static inline bool net_pkt(e2ap_ep_t const* ep, int fd)
   return fd == ep->fd;
 }
 
-static inline void consume_fd(int fd)
-{
-  // assert(fd > 0);
-  // uint64_t read_buf = 0;
-  // ssize_t const bytes = read(fd, &read_buf, sizeof(read_buf));
-  // assert(bytes == sizeof(read_buf));
-
-  if (fd <= 0) {
-    fprintf(stderr, "[NEAR-RIC] Warning: Invalid file descriptor (%d)\n", fd);
-  }
-
-  uint64_t read_buf = 0;
-  ssize_t bytes = read(fd, &read_buf, sizeof(read_buf));
-
-  if (bytes < 0) {
-    fprintf(stderr, "[NEAR-RIC] Error reading fd: %s\n", strerror(errno));
-  }
-
-  if (bytes != sizeof(read_buf)) {
-    fprintf(stderr, "[NEAR-RIC] Warning: Incomplete read\n");
-  }
-}
-
 /*
 static inline
 bool eq_sock_addr(void const* m0_v, void const* m1_v)
@@ -339,25 +458,31 @@ async_event_t find_event_type(near_ric_t* ric, int fd)
 }
 */
 
-static inline bool pend_event(near_ric_t* ric, int fd, pending_event_t** p_ev)
+// The expired request is copied out and removed from the pending map, along
+// with its periodic timer. Nothing is answered after it expired
+static inline bool pend_event(near_ric_t* ric, int tmr_id, pending_event_ric_t* p_ev)
 {
   assert(ric != NULL);
-  assert(fd > 0);
-  assert(*p_ev == NULL);
+  assert(tmr_id > 0);
+  assert(p_ev != NULL);
 
   {
     lock_guard(&ric->pend_mtx);
-    // assert(bi_map_size(&ric->pending) == 1 );
 
-    void* start_it = assoc_front(&ric->pending.left);
     void* end_it = assoc_end(&ric->pending.left);
+    void* it = assoc_find(&ric->pending.left, &tmr_id);
 
-    void* it = find_if(&ric->pending.left, start_it, end_it, &fd, eq_fd);
+    // The answer arrived while the timer was expiring
+    if (it == end_it)
+      return false;
 
-    assert(it != end_it);
-    *p_ev = assoc_value(&ric->pending.left, it);
+    pending_event_ric_t* ev = bi_map_extract_left(&ric->pending, &tmr_id, sizeof(tmr_id), NULL);
+    *p_ev = *ev;
+    free(ev);
   }
-  return *p_ev != NULL;
+
+  cancel_timer_asio_ric(&ric->io, tmr_id);
+  return true;
 }
 
 static async_event_arr_t next_asio_event_ric(near_ric_t* ric)
@@ -366,6 +491,7 @@ static async_event_arr_t next_asio_event_ric(near_ric_t* ric)
 
   fd_read_t const fd_read = event_asio_ric(&ric->io);
   assert(fd_read.len > -2 && fd_read.len < 65);
+  assert(fd_read.len_tmr > -1 && fd_read.len + fd_read.len_tmr < 65);
 
   async_event_arr_t arr = {0};
 
@@ -381,40 +507,86 @@ static async_event_arr_t next_asio_event_ric(near_ric_t* ric)
   for (int i = 0; i < arr.len; ++i) {
     async_event_t* dst = &arr.ev[i];
     if (net_pkt(&ric->ep.base, fd_read.fd[i]) == true) {
-      dst->msg = e2ap_recv_msg_ric(&ric->ep);
-      if (dst->msg.type == SCTP_MSG_NOTIFICATION) {
-        dst->type = SCTP_CONNECTION_SHUTDOWN_EVENT;
-      } else if (dst->msg.type == SCTP_MSG_PAYLOAD) {
-        dst->type = SCTP_MSG_ARRIVED_EVENT;
-      } else {
-        assert(0 != 0 && "Unknown type");
-      }
-    } else if (pend_event(ric, fd_read.fd[i], &dst->p_ev) == true) {
-      dst->type = PENDING_EVENT;
+      // Drain the socket. One epoll round trip for up to rx_batch messages.
+      // With io_uring, the messages were already read by the wait
+      dst->msgs = reads_sock_asio_ric(&ric->io) ? take_msgs_asio_ric(&ric->io, fd_read.fd[i], ric->rx_batch)
+                                                : e2ap_recv_msgs_ric(&ric->ep, ric->rx_batch);
+      dst->type = SCTP_MSG_BATCH_ARRIVED_EVENT;
     } else {
       assert(0 != 0 && "Unknown event happened!");
     }
   }
 
+  for (int i = 0; i < fd_read.len_tmr; ++i) {
+    async_event_t* dst = &arr.ev[arr.len++];
+    dst->fd = fd_read.tmr[i];
+    if (pend_event(ric, fd_read.tmr[i], &dst->p_ev_ric) == true) {
+      dst->type = PENDING_EVENT;
+    } else {
+      // Already cancelled
+      dst->type = CHECK_STOP_TOKEN_EVENT;
+    }
+  }
+
   return arr;
 }
 
 typedef struct {
   near_ric_t* ric;
-  sctp_msg_t msg;
-} ric_sctp_msg_t;
+  sctp_msg_arr_t arr;
+} ric_sctp_msg_arr_t;
 
-// This task will run in parallel
-static void sctp_msg_arrived_event(void* arg)
+#ifndef TEST_AGENT_RIC
+static void notify_ind_iapp_ric(near_ric_t* ric, sctp_info_t const* info, e2ap_msg_t const* msg)
 {
-  assert(arg != NULL);
+  global_e2_node_id_t id = {0};
+  if (e2ap_find_e2_node_ric(&ric->ep, info, &id) == false) {
+    printf("[NEAR-RIC]: RIC_INDICATION from an unknown E2 Node. Not forwarded to the xApps\n");
+    return;
+  }
+  defer({ free_global_e2_node_id(&id); });
 
-  ric_sctp_msg_t* ric_ev = (ric_sctp_msg_t*)arg;
-  defer({ free(ric_ev); });
+  notify_ind_iapp_api(&id, msg);
+}
+
+// The xApps get the PDU as sent by the E2 Node. The E2AP and SM decoders
+// only run if a sink needs the content
+static void relay_ind_ric(near_ric_t* ric, sctp_msg_t const* sctp_msg, ric_gen_id_t const* ric_id)
+{
+  // Neither the E2AP message nor the SM payload are decoded if no sink reads them
+  if (skip_ind_dec_ric(ric, ric_id->ran_func_id) == false) {
+    e2ap_msg_t const msg = e2ap_msg_dec_ric(&ric->ap, sctp_msg->ba);
+    defer({ e2ap_msg_free_ric(&ric->ap, (e2ap_msg_t*)&msg); });
+    assert(msg.type == RIC_INDICATION);
+
+    e2ap_msg_t const ans = e2ap_msg_handle_ric(ric, &msg);
+    assert(ans.type == NONE_E2_MSG_TYPE);
+  }
+
+  global_e2_node_id_t id = {0};
+  if (e2ap_find_e2_node_ric(&ric->ep, &sctp_msg->info, &id) == false) {
+    printf("[NEAR-RIC]: RIC_INDICATION from an unknown E2 Node. Not forwarded to the xApps\n");
+    return;
+  }
+  defer({ free_global_e2_node_id(&id); });
+
+  notify_ind_bytes_iapp_api(&id, ric_id, sctp_msg->ba);
+}
+#endif
+
+static void handle_sctp_msg_ric(near_ric_t* ric, sctp_msg_t const* sctp_msg)
+{
+  assert(ric != NULL);
+  assert(sctp_msg != NULL);
+  assert(sctp_msg->type == SCTP_MSG_PAYLOAD);
 
-  near_ric_t* ric = ric_ev->ric;
-  sctp_msg_t const* sctp_msg = &ric_ev->msg;
-  defer({ free_sctp_msg((sctp_msg_t*)sctp_msg); });
+#if defined(ASN) && !defined(TEST_AGENT_RIC)
+  ric_gen_id_t ric_id = {0};
+  if (peek_ric_indication_aper(sctp_msg->ba, &ric_id) == true) {
+    relay_ind_ric(ric, sctp_msg, &ric_id);
+    return;
+  }
+#endif
 
   e2ap_msg_t const msg = e2ap_msg_dec_ric(&ric->ap, sctp_msg->ba);
   defer({ e2ap_msg_free_ric(&ric->ap, (e2ap_msg_t*)&msg); });
@@ -428,6 +600,13 @@ static void sctp_msg_arrived_event(void* arg)
   e2ap_msg_t ans = e2ap_msg_handle_ric(ric, &msg);
   defer({ e2ap_msg_free_ric(&ric->ap, &ans); });
 
+#ifndef TEST_AGENT_RIC
+  // Indications do not carry the E2 Node ID. The iApp routes on it, so that
+  // an xApp only gets the indications of the E2 Nodes it subscribed to
+  if (msg.type == RIC_INDICATION)
+    notify_ind_iapp_ric(ric, &sctp_msg->info, &msg);
+#endif
+
   if (ans.type != NONE_E2_MSG_TYPE) {
     sctp_msg_t sctp_msg2 = {.info = sctp_msg->info};
     defer({ free_sctp_msg(&sctp_msg2); });
@@ -437,6 +616,161 @@ static void sctp_msg_arrived_event(void* arg)
   }
 }
 
+// This task will run in parallel. The messages of a batch are handled in
+// arrival order, and the task manager is paid once per batch
+static void sctp_msg_arr_arrived_event(void* arg)
+{
+  assert(arg != NULL);
+
+  ric_sctp_msg_arr_t* ric_ev = (ric_sctp_msg_arr_t*)arg;
+  defer({ free(ric_ev); });
+  defer({ free_sctp_msg_arr(&ric_ev->arr); });
+
+  for (size_t i = 0; i < ric_ev->arr.len; ++i)
+    handle_sctp_msg_ric(ric_ev->ric, &ric_ev->arr.msg[i]);
+}
+
+// Strand key of a message. The peeled off associations are keyed by their
+// socket, which stays valid (i.e., not reused) until their last task ran
+static uint64_t strand_key_ric(sctp_info_t const* info)
+{
+  assert(info != NULL);
+  if (info->fd > 0)
+    return ((uint64_t)1 << 32) | (uint32_t)info->fd;
+
+  return (uint32_t)info->sri.sinfo_assoc_id;
+}
+
+// Split the batch per SCTP association, keeping the arrival order. The
+// associations run in parallel, while the messages of one association
+// (i.e., one E2 Node) are handled in order, by one task at a time.
+// With reactors, new associations are peeled off the listening socket
+static void submit_per_assoc_ric(near_ric_t* ric, sctp_msg_arr_t arr)
+{
+  assert(ric != NULL);
+  assert(arr.len > 0);
+
+  bool* taken = calloc(arr.len, sizeof(bool));
+  assert(taken != NULL && "Memory exhausted");
+  defer({ free(taken); });
+
+  for (size_t i = 0; i < arr.len; ++i) {
+    if (taken[i] == true)
+      continue;
+
+    sctp_assoc_t const id = arr.msg[i].info.sri.sinfo_assoc_id;
+    size_t len = 0;
+    for (size_t j = i; j < arr.len; ++j)
+      len += taken[j] == false && arr.msg[j].info.sri.sinfo_assoc_id == id;
+
+    ric_sctp_msg_arr_t* ric_sctp = calloc(1, sizeof(ric_sctp_msg_arr_t));
+    assert(ric_sctp != NULL && "Memory exhausted");
+    ric_sctp->ric = ric;
+    ric_sctp->arr.msg = calloc(len, sizeof(sctp_msg_t));
+    assert(ric_sctp->arr.msg != NULL && "Memory exhausted");
+
+    for (size_t j = i; j < arr.len; ++j) {
+      if (taken[j] == false && arr.msg[j].info.sri.sinfo_assoc_id == id) {
+        // Shallow copy. Pass ownership of the payload
+        ric_sctp->arr.msg[ric_sctp->arr.len++] = arr.msg[j];
+        taken[j] = true;
+      }
+    }
+
+    // The messages still queued in the listening socket move with it
+    int peeled_fd = 0;
+    if (ric->num_reactors > 0 && ric_sctp->arr.msg[0].info.fd == 0) {
+      peeled_fd = sctp_peeloff(ric->ep.base.fd, id);
+      if (peeled_fd == -1) {
+        printf("[NEAR-RIC]: sctp_peeloff failed: %s. Association served by the listening socket \n", strerror(errno));
+        peeled_fd = 0;
+      }
+      for (size_t j = 0; j < ric_sctp->arr.len; ++j)
+        ric_sctp->arr.msg[j].info.fd = peeled_fd;
+    }
+
+    uint64_t const key = strand_key_ric(&ric_sctp->arr.msg[0].info);
+    task_t t = {.args = ric_sctp, .func = sctp_msg_arr_arrived_event};
+    async_key_task_manager(&ric->man, key, t);
+
+    // After submitting, so that these messages precede the ones read by the reactor
+    if (peeled_fd > 0)
+      add_fd_reactor_pool_ric(&ric->reactors, peeled_fd);
+  }
+
+  // The payloads moved to the tasks
+  free(arr.msg);
+}
+
+typedef struct {
+  near_ric_t* ric;
+  int fd;
+  // SCTP_MSG_PAYLOAD if the peer closed without notifying
+  sctp_msg_t notif;
+} ric_peeled_close_t;
+
+// Last task of a peeled off association
+static void close_peeled_assoc_ric(void* arg)
+{
+  assert(arg != NULL);
+
+  ric_peeled_close_t* c = (ric_peeled_close_t*)arg;
+  defer({ free(c); });
+
+  if (c->notif.type == SCTP_MSG_NOTIFICATION) {
+    defer({ free_sctp_msg(&c->notif); });
+    notification_handle_ric(c->ric, &c->notif);
+  } else {
+    // Lost without SHUTDOWN (e.g., ABORT). Deregister the E2 Node before
+    // closing, as the fd may be reused by a new association
+    sctp_info_t info = {0};
+    if (e2ap_find_sock_fd_ric(&c->ric->ep, c->fd, &info) == true) {
+      union sctp_notification n = {.sn_shutdown_event = {.sse_type = SCTP_SHUTDOWN_EVENT,
+                                                         .sse_length = sizeof(struct sctp_shutdown_event),
+                                                         .sse_assoc_id = info.sri.sinfo_assoc_id}};
+      sctp_msg_t const msg = {.type = SCTP_MSG_NOTIFICATION, .info = info, .notif = &n};
+      notification_handle_ric(c->ric, &msg);
+    }
+  }
+
+  close(c->fd);
+}
+
+// Run by the reactor threads
+static void peeled_batch_ric(void* data, int fd, sctp_msg_arr_t arr, bool last)
+{
+  assert(data != NULL);
+  assert(fd > 0);
+
+  near_ric_t* ric = (near_ric_t*)data;
+
+  ric_peeled_close_t* c = NULL;
+  if (last == true) {
+    c = calloc(1, sizeof(ric_peeled_close_t));
+    assert(c != NULL && "Memory exhausted");
+    c->ric = ric;
+    c->fd = fd;
+    // A notification is always the last message of the batch
+    if (arr.len > 0 && arr.msg[arr.len - 1].type == SCTP_MSG_NOTIFICATION) {
+      c->notif = arr.msg[arr.len - 1];
+      arr.len -= 1;
+    }
+  }
+
+  if (arr.len > 0) {
+    // Pass ownership
+    submit_per_assoc_ric(ric, arr);
+  } else {
+    free(arr.msg);
+  }
+
+  if (c != NULL) {
+    sctp_info_t const info = {.fd = fd};
+    task_t t = {.args = c, .func = close_peeled_assoc_ric};
+    async_key_task_manager(&ric->man, strand_key_ric(&info), t);
+  }
+}
+
 // static
 // void e2_event_loop_ric(near_ric_t* ric)
 // {
@@ -489,10 +823,24 @@ static void sctp_msg_arrived_event(void* arg)
 //   ric->server_stopped = true;
 // }
 
+static char const* str_pending_event(pending_event_t ev)
+{
+  switch (ev) {
+    case SUBSCRIPTION_REQUEST_PENDING_EVENT:
+      return "RIC SUBSCRIPTION REQUEST";
+    case SUBSCRIPTION_DELETE_REQUEST_PENDING_EVENT:
+      return "RIC SUBSCRIPTION DELETE REQUEST";
+    case CONTROL_REQUEST_PENDING_EVENT:
+      return "RIC CONTROL REQUEST";
+    default:
+      assert(0 != 0 && "Not a nearRT-RIC pending event");
+  }
+  return NULL;
+}
+
 static void e2_event_loop_ric(near_ric_t* ric)
 {
   assert(ric != NULL);
-  int retry_count = 0;
 
   while (ric->stop_token == false) {
     async_event_arr_t arr = next_asio_event_ric(ric);
@@ -503,34 +851,35 @@ static void e2_event_loop_ric(near_ric_t* ric)
       assert(e.type != UNKNOWN_EVENT && "Unknown event triggered ");
 
       switch (e.type) {
-        case SCTP_MSG_ARRIVED_EVENT: {
-          ric_sctp_msg_t* ric_sctp = calloc(1, sizeof(ric_sctp_msg_t));
-          assert(ric_sctp != NULL && "Memory exhausted");
-          ric_sctp->ric = ric;
-          // Pass ownership
-          ric_sctp->msg = e.msg;
-          task_t t = {.args = ric_sctp, .func = sctp_msg_arrived_event};
-          // Execute tasks in parallel
-          async_task_manager(&ric->man, t);
-          break;
-        }
-        case PENDING_EVENT: {
-          if (retry_count < 3) {
-            retry_count++;
-            printf("Pending event timeout happened. Retrying (%d/%d)...\n", retry_count, 3);
-            // Handle retry logic here
-            consume_fd(e.fd);
+        case SCTP_MSG_BATCH_ARRIVED_EVENT: {
+          sctp_msg_arr_t arr = e.msgs;
+
+          // A notification is always the last message of the batch
+          sctp_msg_t notif = {.type = SCTP_MSG_PAYLOAD};
+          if (arr.len > 0 && arr.msg[arr.len - 1].type == SCTP_MSG_NOTIFICATION) {
+            notif = arr.msg[arr.len - 1];
+            arr.len -= 1;
+          }
+
+          if (arr.len > 0) {
+            // Pass ownership
+            submit_per_assoc_ric(ric, arr);
           } else {
-            printf("Pending event timeout happened. Communication with E2 Node lost after %d retries.\n", 3);
-            retry_count = 0; // Reset retry count for future events
-            // Optional: Additional handling for communication loss
+            free(arr.msg);
           }
 
+          if (notif.type == SCTP_MSG_NOTIFICATION) {
+            defer({ free_sctp_msg(&notif); });
+            notification_handle_ric(ric, &notif);
+          }
           break;
         }
-        case SCTP_CONNECTION_SHUTDOWN_EVENT: {
-          defer({ free_sctp_msg(&e.msg); });
-          notification_handle_ric(ric, &e.msg);
+        case PENDING_EVENT: {
+          pending_event_ric_t const* p = &e.p_ev_ric;
+          printf("[NEAR-RIC]: %s expired without answer. RIC request ID %u, RAN function ID %u\n",
+                 str_pending_event(p->ev),
+                 p->id.ric_req_id,
+                 p->id.ran_func_id);
           break;
         }
         case CHECK_STOP_TOKEN_EVENT: {
@@ -549,6 +898,7 @@ static void e2_event_loop_ric(near_ric_t* ric)
 void start_near_ric(near_ric_t* ric)
 {
   assert(ric != NULL);
+  pin_thread_cpus(pthread_self(), ric->reactor_cpus.len, ric->reactor_cpus.cpu);
   e2_event_loop_ric(ric);
 }
 
@@ -635,12 +985,21 @@ void free_near_ric(near_ric_t* ric)
     }
   }
 
+  // The reactors submit tasks
+  if (ric->num_reactors > 0)
+    free_reactor_pool_ric(&ric->reactors);
+
   // Free task manager resources
   void (*clean)(void*) = NULL; // You might want to provide a proper cleanup function if needed
   free_task_manager(&ric->man, clean);
 
   // At this point, all task manager threads should be joined
 
+  // Deliver the queued indications while their SMs are still loaded
+  free_sinks_ric(ric);
+  printf("[NEAR-RIC]: %" PRIu64 " SM indication payloads not decoded, as no sink reads them \n",
+         (uint64_t)atomic_load(&ric->skip_dec));
+
   // Free other resources
   e2ap_free_ep_ric(&ric->ep);
   free_plugin_ric(&ric->plugin);
@@ -660,6 +1019,8 @@ void free_near_ric(near_ric_t* ric)
 
   bi_map_free(&ric->pending);
 
+  free_asio_ric(&ric->io);
+
   stop_iapp_api();
 
   // Cleanup request ID mutex
@@ -753,11 +1114,11 @@ uint16_t report_service_near_ric(near_ric_t* ric, global_e2_node_id_t const* id,
   pending_event_ric_t ev = {.ev = SUBSCRIPTION_REQUEST_PENDING_EVENT, .id = sr.ric_id};
 
   long const wait_ms = 3000;
-  int fd_timer = create_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
+  int tmr_id = arm_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
 
   {
     lock_guard(&ric->pend_mtx);
-    bi_map_insert(&ric->pending, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    bi_map_insert(&ric->pending, &tmr_id, sizeof(tmr_id), &ev, sizeof(ev));
   }
 
   byte_array_t ba_msg = e2ap_enc_subscription_request_ric(&ric->ap, &sr);
@@ -821,11 +1182,11 @@ void rm_report_service_near_ric(near_ric_t* ric, global_e2_node_id_t const* id,
   pending_event_ric_t ev = {.ev = SUBSCRIPTION_DELETE_REQUEST_PENDING_EVENT, .id = sd.ric_id};
 
   long const wait_ms = 3000;
-  int fd_timer = create_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
+  int tmr_id = arm_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
 
   {
     lock_guard(&ric->pend_mtx);
-    bi_map_insert(&ric->pending, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    bi_map_insert(&ric->pending, &tmr_id, sizeof(tmr_id), &ev, sizeof(ev));
   }
 
   byte_array_t ba_msg = e2ap_enc_subscription_delete_request_ric(&ric->ap, &sd);
@@ -877,12 +1238,11 @@ void control_service_near_ric(near_ric_t* ric, global_e2_node_id_t const* id, ui
   pending_event_ric_t ev = {.ev = CONTROL_REQUEST_PENDING_EVENT, .id = ctrl_req.ric_id};
 
   long const wait_ms = 3000;
-  int fd_timer = create_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
-  // printf("RIC: Control fd_timer for control with value created == %d\n", fd_timer);
+  int tmr_id = arm_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
 
   {
     lock_guard(&ric->pend_mtx);
-    bi_map_insert(&ric->pending, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    bi_map_insert(&ric->pending, &tmr_id, sizeof(tmr_id), &ev, sizeof(ev));
   }
 
   byte_array_t ba_msg = e2ap_enc_control_request_ric(&ric->ap, &ctrl_req);
@@ -970,12 +1330,12 @@ uint16_t fwd_ric_subscription_request(near_ric_t* ric,
   pending_event_ric_t ev = {.ev = SUBSCRIPTION_REQUEST_PENDING_EVENT, .id = sr->ric_id};
 
   long const wait_ms = 3000;
-  int fd_timer = create_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
+  int tmr_id = arm_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
 
   // Store pending event
   {
     lock_guard(&ric->pend_mtx);
-    bi_map_insert(&ric->pending, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    bi_map_insert(&ric->pending, &tmr_id, sizeof(tmr_id), &ev, sizeof(ev));
   }
 
   byte_array_t ba_msg = e2ap_enc_subscription_request_ric(&ric->ap, sr);
@@ -1002,12 +1362,9 @@ void fwd_ric_subscription_request_delete(near_ric_t* ric,
   {
     lock_guard(&ric->pend_mtx);
 
-    // left: fd, right: pending_event_t
-    assoc_rb_tree_t* tree = &ric->pending.right;
-
-    void* first = assoc_front(tree);
-    void* end = assoc_end(tree);
-    if (find_if(tree, first, end, &ev, eq_pending_event_ric) != end) {
+    // left: timer id, right: pending_event_t
+    bmr_iter_t it = bi_map_find_right(&ric->pending, &ev);
+    if (it.it != bi_map_end_right(&ric->pending).it) {
       printf("[NEAR-RIC]: SUBSCRIPTION REQUEST DELETE RAN FUNC ID %d RIC_REQ_ID %d MSG ALREADY PENDING\n",
              sdr->ric_id.ran_func_id,
              sdr->ric_id.ric_req_id);
@@ -1015,8 +1372,8 @@ void fwd_ric_subscription_request_delete(near_ric_t* ric,
     }
 
     long const wait_ms = 3000;
-    int fd_timer = create_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
-    bi_map_insert(&ric->pending, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    int tmr_id = arm_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
+    bi_map_insert(&ric->pending, &tmr_id, sizeof(tmr_id), &ev, sizeof(ev));
   }
 
   byte_array_t ba_msg = e2ap_enc_subscription_delete_request_ric(&ric->ap, sdr);
@@ -1046,10 +1403,10 @@ uint16_t fwd_ric_control_request(near_ric_t* ric,
   pending_event_ric_t ev = {.ev = CONTROL_REQUEST_PENDING_EVENT, .id = cr->ric_id};
 
   long const wait_ms = 3000;
-  int fd_timer = create_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
+  int tmr_id = arm_timer_ms_asio_ric(&ric->io, wait_ms, wait_ms);
   {
     lock_guard(&ric->pend_mtx);
-    bi_map_insert(&ric->pending, &fd_timer, sizeof(fd_timer), &ev, sizeof(ev));
+    bi_map_insert(&ric->pending, &tmr_id, sizeof(tmr_id), &ev, sizeof(ev));
   }
 
   byte_array_t ba_msg = e2ap_enc_control_request_ric(&ric->ap, cr);
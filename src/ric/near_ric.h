@@ -25,6 +25,8 @@ e* For more information about the OpenAirInterface (OAI) Software Alliance:
 #include "asio_ric.h"
 #include "e2ap_ric.h"
 #include "endpoint_ric.h"
+#include "iApps/sink_ric.h"
+#include "reactor_ric.h"
 #include "util/alg_ds/ds/seq_container/seq_generic.h"
 #include "util/alg_ds/ds/assoc_container/assoc_generic.h"
 #include "util/alg_ds/ds/assoc_container/bimap.h"
@@ -54,14 +56,29 @@ typedef struct near_ric_s {
   e2ap_ep_ric_t ep;
   e2ap_ric_t ap;
   asio_ric_t io;
+  // Max. SCTP messages drained per reactor wake up
+  size_t rx_batch;
+  // Reactors serving the peeled off associations. None if 0, and
+  // then all the associations are served through ep
+  size_t num_reactors;
+  reactor_pool_ric_t reactors;
+  // CPUs of the RIC, reactors and iApp event loops. Not pinned if empty
+  fr_cpu_list_t reactor_cpus;
   size_t sz_handle_msg;
   e2ap_handle_msg_fp_ric handle_msg[NUM_HANDLE_MSG]; // 26 E2AP + 4 E42AP note that not all the slots will be occupied
 
   // Registered SMs
   plugin_ric_t plugin;
 
-  // Publish/Subscribed update function pointers per sm
-  assoc_rb_tree_t pub_sub; // seq_arr_t per SM
+  // Listeners enabled in the config, each one behind its own queue and thread
+  sink_ric_t sinks[FR_RIC_SINKS_MAX];
+  size_t len_sinks;
+
+  // Publish/Subscribed sinks per sm
+  assoc_ht_open_t pub_sub; // key: ran_func_id, value: seq_arr_t of sink_ric_t*
+
+  // SM payloads not decoded as no sink reads them
+  atomic_uint_fast64_t skip_dec;
 
   // Connected E2 Nodes
   seq_arr_t conn_e2_nodes; // e2_node_t
@@ -72,7 +89,7 @@ typedef struct near_ric_s {
   atomic_int req_id;
 
   // Pending events
-  bi_map_t pending; // left: fd, right: pending_event_ric_t
+  bi_map_t pending; // left: timer wheel id, right: pending_event_ric_t
   pthread_mutex_t pend_mtx;
 
   // Task manager/Thread pool
@@ -198,10 +198,8 @@ sm_ric_t* sm_plugin_ric(plugin_ric_t* p, uint16_t  ran_func_id)
   assert(p != NULL);
   assert(ran_func_id > 0 && "Reserved value");
 
-  void* start_it = assoc_front(&p->sm_ds);
-  void* end_it = assoc_end(&p->sm_ds);
-  void* it = find_if(&p->sm_ds, start_it, end_it, &ran_func_id, eq_ran_func_id); 
-  assert(it != end_it && "RAN function ID not found in the RAN"); 
+  void* it = assoc_find(&p->sm_ds, &ran_func_id);
+  assert(it != assoc_end(&p->sm_ds) && "RAN function ID not found in the RAN"); 
 
   sm_ric_t* sm = assoc_value(&p->sm_ds, it);
   assert(sm->ran_func_id == ran_func_id);
@@ -0,0 +1,153 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "reactor_ric.h"
+#include "../lib/ep/e2ap_ep.h"
+#include "../util/thread_affinity.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static void detach_fd(reactor_ric_t* r, int fd)
+{
+  int rc = epoll_ctl(r->efd, EPOLL_CTL_DEL, fd, NULL);
+  assert(rc != -1);
+  atomic_fetch_sub_explicit(&r->num_fd, 1, memory_order_relaxed);
+}
+
+static void read_fd(reactor_ric_t* r, int fd)
+{
+  reactor_pool_ric_t* pool = r->pool;
+
+  sctp_msg_arr_t arr = {.msg = calloc(pool->rx_batch, sizeof(sctp_msg_t))};
+  assert(arr.msg != NULL && "Memory exhausted");
+
+  bool eof = false;
+  arr.len = e2ap_recv_sctp_msg_batch_fd(fd, pool->rx_batch, arr.msg, &eof);
+
+  // The association is over. Leave before handing the fd to the owner,
+  // as it may be closed and reused at any time after the callback
+  bool const last = eof == true || (arr.len > 0 && arr.msg[arr.len - 1].type == SCTP_MSG_NOTIFICATION);
+  if (last == true)
+    detach_fd(r, fd);
+
+  if (arr.len == 0 && last == false) {
+    free(arr.msg);
+    return;
+  }
+
+  // Pass ownership
+  pool->fp(pool->data, fd, arr, last);
+}
+
+static void* reactor_loop(void* arg)
+{
+  reactor_ric_t* r = (reactor_ric_t*)arg;
+
+  const int maxevents = 64;
+  struct epoll_event events[maxevents];
+  // Latency to notice the stop token
+  const int timeout_ms = 1000;
+
+  while (atomic_load_explicit(&r->pool->stop_token, memory_order_relaxed) == false) {
+    const int events_ready = epoll_wait(r->efd, events, maxevents, timeout_ms);
+    if (events_ready == -1) {
+      assert(errno == EINTR);
+      continue;
+    }
+
+    // EPOLLERR and EPOLLHUP surface as end of file when reading
+    for (int i = 0; i < events_ready; ++i)
+      read_fd(r, events[i].data.fd);
+  }
+
+  return NULL;
+}
+
+void init_reactor_pool_ric(reactor_pool_ric_t* pool, size_t len, size_t rx_batch, size_t len_cpus, int const cpus[len_cpus], reactor_batch_fp_ric fp, void* data)
+{
+  assert(pool != NULL);
+  assert(len > 0);
+  assert(rx_batch > 0);
+  assert(fp != NULL);
+
+  pool->len = len;
+  pool->rx_batch = rx_batch;
+  pool->fp = fp;
+  pool->data = data;
+  atomic_init(&pool->stop_token, false);
+
+  pool->arr = calloc(len, sizeof(reactor_ric_t));
+  assert(pool->arr != NULL && "Memory exhausted");
+
+  for (size_t i = 0; i < len; ++i) {
+    reactor_ric_t* r = &pool->arr[i];
+    r->efd = epoll_create1(EPOLL_CLOEXEC);
+    assert(r->efd != -1);
+    atomic_init(&r->num_fd, 0);
+    r->pool = pool;
+
+    int rc = pthread_create(&r->thr, NULL, reactor_loop, r);
+    assert(rc == 0);
+
+    if (len_cpus > 0)
+      pin_thread_cpus(r->thr, 1, &cpus[i % len_cpus]);
+  }
+}
+
+void free_reactor_pool_ric(reactor_pool_ric_t* pool)
+{
+  assert(pool != NULL);
+
+  atomic_store(&pool->stop_token, true);
+
+  for (size_t i = 0; i < pool->len; ++i) {
+    int rc = pthread_join(pool->arr[i].thr, NULL);
+    assert(rc == 0);
+    close(pool->arr[i].efd);
+  }
+
+  free(pool->arr);
+}
+
+void add_fd_reactor_pool_ric(reactor_pool_ric_t* pool, int fd)
+{
+  assert(pool != NULL);
+  assert(fd > 0);
+
+  reactor_ric_t* r = &pool->arr[0];
+  for (size_t i = 1; i < pool->len; ++i) {
+    if (atomic_load_explicit(&pool->arr[i].num_fd, memory_order_relaxed) < atomic_load_explicit(&r->num_fd, memory_order_relaxed))
+      r = &pool->arr[i];
+  }
+
+  atomic_fetch_add_explicit(&r->num_fd, 1, memory_order_relaxed);
+
+  // Level triggered. Whatever is left after rx_batch messages wakes the reactor up again
+  struct epoll_event event = {.events = EPOLLIN, .data.fd = fd};
+  int rc = epoll_ctl(r->efd, EPOLL_CTL_ADD, fd, &event);
+  assert(rc != -1);
+}
@@ -0,0 +1,75 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+#ifndef REACTOR_RIC_H
+#define REACTOR_RIC_H
+
+/*
+ * Pool of reactor threads serving peeled off (one-to-one) SCTP sockets.
+ * Every association lives in exactly one reactor, which is its only reader,
+ * so the receive path takes no lock. The messages are handed to the owner
+ * through a callback, run in the reactor thread.
+*/
+
+#include "../lib/ep/sctp_msg.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// last: no more batches will come from fd. The fd was already removed from
+// the reactor (i.e., a notification ended the batch or the peer closed the
+// association) and closing it is up to the callback
+typedef void (*reactor_batch_fp_ric)(void* data, int fd, sctp_msg_arr_t arr, bool last);
+
+typedef struct{
+  int efd;
+  pthread_t thr;
+  // Sockets served. Used to place the new ones
+  atomic_size_t num_fd;
+  struct reactor_pool_ric_s* pool;
+} reactor_ric_t;
+
+typedef struct reactor_pool_ric_s{
+  reactor_ric_t* arr;
+  size_t len;
+  // Max. SCTP messages drained per socket and wake up
+  size_t rx_batch;
+
+  reactor_batch_fp_ric fp;
+  void* data;
+
+  atomic_bool stop_token;
+} reactor_pool_ric_t;
+
+// Reactor i is pinned to cpus[i % len_cpus]. Not pinned if len_cpus == 0
+void init_reactor_pool_ric(reactor_pool_ric_t* pool, size_t len, size_t rx_batch, size_t len_cpus, int const cpus[len_cpus], reactor_batch_fp_ric fp, void* data);
+
+// Stops and joins the threads. The sockets are not closed
+void free_reactor_pool_ric(reactor_pool_ric_t* pool);
+
+// Thread-safe. fd is served by the reactor with the fewest sockets
+void add_fd_reactor_pool_ric(reactor_pool_ric_t* pool, int fd);
+
+#endif
+
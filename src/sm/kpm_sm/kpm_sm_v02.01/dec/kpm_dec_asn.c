@@ -35,6 +35,7 @@
 #include "dec_asn/dec_ric_ind_msg_frm_3.h"
 
 #include "kpm_dec_asn.h"
+#include "../../../../util/asn_arena.h"
 #include "../../../../util/conversions.h"
 
 #include <assert.h>
@@ -139,8 +140,10 @@ kpm_ind_hdr_t kpm_dec_ind_hdr_asn(size_t len, uint8_t const ind_hdr[len])
 
   kpm_ind_hdr_t ret = {0};
 
-  E2SM_KPM_IndicationHeader_t *pdu = calloc(1, sizeof(E2SM_KPM_IndicationHeader_t));
-  assert( pdu !=NULL && "Memory exhausted" );
+  // The asn1c tree is released at once when the arena scope ends
+  asn_arena_mark_t const mark = begin_asn_arena();
+  E2SM_KPM_IndicationHeader_t src = {0};
+  E2SM_KPM_IndicationHeader_t* pdu = &src;
 
   const enum asn_transfer_syntax syntax = ATS_ALIGNED_BASIC_PER;
   const asn_dec_rval_t rval = asn_decode(NULL, syntax, &asn_DEF_E2SM_KPM_IndicationHeader, (void**)&pdu, ind_hdr, len);
@@ -161,8 +164,9 @@ kpm_ind_hdr_t kpm_dec_ind_hdr_asn(size_t len, uint8_t const ind_hdr[len])
   }
 
 
-	ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_E2SM_KPM_IndicationHeader, pdu);
-  free(pdu);
+  if(must_free_asn_arena(mark))
+    ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_E2SM_KPM_IndicationHeader, pdu);
+  end_asn_arena(mark);
 
   return ret;
 }
@@ -176,8 +180,10 @@ kpm_ind_msg_t kpm_dec_ind_msg_asn(size_t len, uint8_t const ind_msg[len])
 
   kpm_ind_msg_t ret = {0};
 
-  E2SM_KPM_IndicationMessage_t *pdu = calloc(1, sizeof(E2SM_KPM_IndicationMessage_t));
-  assert( pdu !=NULL && "Memory exhausted" );
+  // The asn1c tree is released at once when the arena scope ends
+  asn_arena_mark_t const mark = begin_asn_arena();
+  E2SM_KPM_IndicationMessage_t src = {0};
+  E2SM_KPM_IndicationMessage_t* pdu = &src;
 
   const enum asn_transfer_syntax syntax = ATS_ALIGNED_BASIC_PER;
   const asn_dec_rval_t rval = asn_decode(NULL, syntax, &asn_DEF_E2SM_KPM_IndicationMessage, (void**)&pdu, ind_msg, len);
@@ -208,8 +214,9 @@ kpm_ind_msg_t kpm_dec_ind_msg_asn(size_t len, uint8_t const ind_msg[len])
   }
 
 
-  ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_E2SM_KPM_IndicationMessage, pdu);
-  free(pdu); 
+  if(must_free_asn_arena(mark))
+    ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_E2SM_KPM_IndicationMessage, pdu);
+  end_asn_arena(mark);
 
   return ret;
 }
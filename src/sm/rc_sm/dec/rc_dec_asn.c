@@ -24,6 +24,7 @@
 #include <assert.h>
 
 #include "../../../util/alg_ds/alg/defer.h"
+#include "../../../util/asn_arena.h"
 
 #include "../ie/ir/ran_param_struct.h"
 
@@ -1799,8 +1800,10 @@ e2sm_rc_ind_hdr_t rc_dec_ind_hdr_asn(size_t len, uint8_t const ind_hdr[len])
   assert(ind_hdr != NULL);
   assert(len != 0);
 
+  // The asn1c tree is released at once when the arena scope ends
+  asn_arena_mark_t const mark = begin_asn_arena();
   E2SM_RC_IndicationHeader_t src = {0};
-  defer({  ASN_STRUCT_RESET(asn_DEF_E2SM_RC_IndicationHeader, &src); });
+  defer({ if(must_free_asn_arena(mark)) ASN_STRUCT_RESET(asn_DEF_E2SM_RC_IndicationHeader, &src); end_asn_arena(mark); });
   E2SM_RC_IndicationHeader_t* src_ref = &src;
 
   asn_dec_rval_t const ret = aper_decode(NULL, &asn_DEF_E2SM_RC_IndicationHeader, (void **)&src_ref, ind_hdr, len, 0, 0);
@@ -2244,8 +2247,10 @@ e2sm_rc_ind_msg_t rc_dec_ind_msg_asn(size_t len, uint8_t const ind_msg[len])
   assert(ind_msg != NULL);
   assert(len != 0);
 
+  // The asn1c tree is released at once when the arena scope ends
+  asn_arena_mark_t const mark = begin_asn_arena();
   E2SM_RC_IndicationMessage_t src = {0};
-  defer({  ASN_STRUCT_RESET(asn_DEF_E2SM_RC_IndicationMessage, &src); });
+  defer({ if(must_free_asn_arena(mark)) ASN_STRUCT_RESET(asn_DEF_E2SM_RC_IndicationMessage, &src); end_asn_arena(mark); });
   E2SM_RC_IndicationMessage_t* src_ref = &src;
 
   asn_dec_rval_t const ret = aper_decode(NULL, &asn_DEF_E2SM_RC_IndicationMessage, (void **)&src_ref, ind_msg, len, 0, 0);
@@ -56,6 +56,18 @@ SOFTWARE.
                                        assoc_ht_open_t*:  assoc_ht_open_value,\
                                        default:   assoc_rb_tree_value)(T,U)
 
+// Lookup
+// O(log n) for the tree and O(1) for the hash table. End iterator if not found
+#define assoc_find(T, K)  _Generic ((T), assoc_rb_tree_t*: assoc_rb_tree_find, \
+                                       assoc_rb_tree_t const*: assoc_rb_tree_find, \
+                                       assoc_ht_open_t*:  assoc_ht_open_find,\
+                                       assoc_ht_open_t const*:  assoc_ht_open_find,\
+                                       default:   assoc_rb_tree_find)(T,K)
+
+// Only ordered containers
+#define assoc_lower_bound(T, K)  _Generic ((T), assoc_rb_tree_t*: assoc_rb_tree_lower_bound, \
+                                       assoc_rb_tree_t const*: assoc_rb_tree_lower_bound, \
+                                       default:   assoc_rb_tree_lower_bound)(T,K)
 
 // Capacity
 #define assoc_size(T) _Generic ((T), assoc_rb_tree_t*:  assoc_rb_tree_size, \
@@ -22,8 +22,6 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-#include "assoc_ht_open_address.h"
-
 #include "assoc_ht_open_address.h"
 #include "../../alg/murmur_hash_32.h"
 
@@ -47,15 +45,24 @@ typedef struct hentry_s{
   bool has_value;
 } hentry_t;
 
-/*
-static inline
-uint32_t hash_func(const void* key_v)
+static
+uint32_t hash_func_bytes(const void* key, size_t key_sz)
 {
-  int32_t* key = (int32_t*)key_v;
   static const uint32_t seed = 42;
-  return murmur3_32((uint8_t*)key, sizeof(uint32_t), seed);
+  return murmur3_32((uint8_t const*)key, key_sz, seed);
+}
+
+static inline
+uint32_t hash_key(assoc_ht_open_t const* htab, const void* key)
+{
+  return htab->hash_func(key, htab->key_sz);
+}
+
+static inline
+bool key_eq(assoc_ht_open_t const* htab, const void* a, const void* b)
+{
+  return htab->comp(a, b) == 0;
 }
-*/
 
 static
 uint32_t find_idx(assoc_ht_open_t* htab, const void* key, uint32_t hash)
@@ -67,7 +74,7 @@ uint32_t find_idx(assoc_ht_open_t* htab, const void* key, uint32_t hash)
     if(entry->is_dirty == false)
       return idx;
 
-    if(entry->has_value == true && htab->key_eq(key, entry->kv.key) == true){
+    if(entry->has_value == true && key_eq(htab, key, entry->kv.key) == true){
       return idx;
     }
 
@@ -111,7 +118,9 @@ static
 void expand_or_shrink_if_neccesary(assoc_ht_open_t* htab)
 {
   if(htab->num_dirty * 2 > htab->cap){
-    rehash_table(htab, htab->cap * 2);
+    // Many tombstones, the same capacity is enough
+    uint32_t const cap = htab->sz * 4 > htab->cap ? htab->cap * 2 : htab->cap;
+    rehash_table(htab, cap);
   } else if (htab->sz * 4 < htab->cap && htab->cap > MIN_SIZE_HT){
     rehash_table(htab, htab->cap/2);
   } 
@@ -119,10 +128,17 @@ void expand_or_shrink_if_neccesary(assoc_ht_open_t* htab)
   assert(htab->num_dirty * 2 <= htab->cap);
 }
 
-void assoc_ht_open_init(assoc_ht_open_t* htab, size_t key_sz, key_eq_func_fp  key_eq, free_func_ht_open_fp free_func, hash_func_ht_open_fp hash_func)
+void assoc_ht_open_init(assoc_ht_open_t* htab, size_t key_sz, key_cmp_func_fp comp, free_func_ht_open_fp free_func)
+{
+  assoc_ht_open_init_hash(htab, key_sz, comp, free_func, hash_func_bytes);
+}
+
+void assoc_ht_open_init_hash(assoc_ht_open_t* htab, size_t key_sz, key_cmp_func_fp comp, free_func_ht_open_fp free_func, hash_func_ht_open_fp hash_func)
 {
   assert(htab != NULL);
   assert(key_sz > 0);
+  assert(comp != NULL);
+  assert(hash_func != NULL);
 
   htab->arr = calloc(MIN_SIZE_HT, sizeof(hentry_t));
   assert(htab->arr != NULL);
@@ -130,7 +146,7 @@ void assoc_ht_open_init(assoc_ht_open_t* htab, size_t key_sz, key_eq_func_fp  ke
   htab->sz = 0;
   htab->num_dirty = 0;
   htab->key_sz = key_sz;
-  htab->key_eq = key_eq;
+  htab->comp = comp;
   htab->free_func = free_func;
   htab->hash_func = hash_func;
 }
@@ -162,7 +178,7 @@ void assoc_ht_open_insert(assoc_ht_open_t* htab, void const* key, size_t key_sz,
   expand_or_shrink_if_neccesary(htab);
   assert(htab->num_dirty * 2 <= htab->cap);
 
-  const uint32_t hash = htab->hash_func(key);
+  const uint32_t hash = hash_key(htab, key);
   const uint32_t idx = find_idx(htab, key, hash);
   assert(idx < htab->cap); 
 
@@ -170,9 +186,9 @@ void assoc_ht_open_insert(assoc_ht_open_t* htab, void const* key, size_t key_sz,
   // Replace if the key already exists
   if(entry->has_value == true){
     assert(entry->is_dirty == true);
-    assert(htab->key_eq(key, entry->kv.key) == true && "Different keys?");
-//    htab->free_kv(&entry->kv);
-    free(entry->kv.value);
+    assert(key_eq(htab, key, entry->kv.key) == true && "Different keys?");
+    if(htab->free_func != NULL)
+      htab->free_func((void*)entry->kv.key, entry->kv.value);
   } else {
     void* key_dst = malloc(key_sz);
     assert(key_dst != NULL && "Memory exhausted");
@@ -190,9 +206,9 @@ void assoc_ht_open_insert(assoc_ht_open_t* htab, void const* key, size_t key_sz,
 }
 
 static
-hentry_t* find_entry(assoc_ht_open_t* htab, const void* key)
+hentry_t* find_entry(assoc_ht_open_t const* htab, const void* key)
 {
-  const uint32_t hash = htab->hash_func(key);
+  const uint32_t hash = hash_key(htab, key);
   const uint32_t start_idx = hash % htab->cap;
   uint32_t idx = start_idx;
 
@@ -202,7 +218,7 @@ hentry_t* find_entry(assoc_ht_open_t* htab, const void* key)
       assert(entry->has_value == false);
       return NULL;
     }
-    if(entry->has_value && htab->key_eq(key, entry->kv.key) == true){
+    if(entry->has_value && entry->hash == hash && key_eq(htab, key, entry->kv.key) == true){
       return entry;
     }
     idx += 1;
@@ -215,56 +231,57 @@ hentry_t* find_entry(assoc_ht_open_t* htab, const void* key)
   return NULL;
 }
 
-void remove_value_htab(assoc_ht_open_t* htab, const void* key)
+// It returns the void* of value. the void* of the key is freed
+void* assoc_ht_open_extract(assoc_ht_open_t* htab, void* key)
 {
-  expand_or_shrink_if_neccesary(htab);
-  assert(htab->num_dirty * 2 <= htab->cap );
+  assert(htab != NULL);
+  assert(key != NULL);
 
   hentry_t* entry = find_entry(htab, key);
-  if(entry == NULL) return;
-
+  assert(entry != NULL && "Trying to extract a key not found in the hash table");
   assert(entry->is_dirty == true && entry->has_value == true);
-  
+
+  void* value = entry->kv.value;
   free((void*)entry->kv.key);
-  free(entry->kv.value);
-//  htab->arr->kv free_kv(&entry->kv);
 
+  // Tombstone. Keeps the probing sequence of the other keys
+  entry->kv.key = NULL;
+  entry->kv.value = NULL;
   entry->has_value = false;
-  htab->sz -=1;
-}
-
-// It returns the void* of value. the void* of the key is freed
-void* assoc_ht_open_extract(assoc_ht_open_t* ht, void* key)
-{
-  assert(0!=0 && "Not implemented");
-
-  assert(ht != NULL);
-  assert(key != NULL);
-
-  return NULL;
-};
+  htab->sz -= 1;
 
+  expand_or_shrink_if_neccesary(htab);
 
+  return value;
+}
 
 // Get the key from an iterator 
-void* assoc_ht_open_key(assoc_ht_open_t* ht, void* it)
+void* assoc_ht_open_key(assoc_ht_open_t* htab, void* it)
 {
-  assert(0!=0 && "Not implemented in the hash table");
-
-  assert(ht != NULL);
+  assert(htab != NULL);
   assert(it != NULL);
+  assert(it != assoc_ht_open_end(htab) && "end iterator passed?");
 
-  return NULL;
+  return (void*)((hentry_t*)it)->kv.key;
 }
 
+// Get the value pointer from an iterator 
+void* assoc_ht_open_value(assoc_ht_open_t* htab, void* it)
+{
+  assert(htab != NULL);
+  assert(it != NULL);
+  assert(it != assoc_ht_open_end(htab) && "end iterator passed?");
 
-void* assoc_ht_open_value(assoc_ht_open_t* htab, const void* key)
+  return ((hentry_t*)it)->kv.value;
+}
+
+void* assoc_ht_open_find(assoc_ht_open_t const* htab, void const* key)
 {
   assert(htab != NULL);
   assert(key != NULL);
-  hentry_t* entry = find_entry(htab, key); 
 
-  return entry != NULL ? entry->kv.value : NULL;
+  hentry_t* entry = find_entry(htab, key); 
+  return entry != NULL ? entry : assoc_ht_open_end(htab);
 }
 
 // Capacity
@@ -275,28 +292,33 @@ size_t assoc_ht_open_size(assoc_ht_open_t* htab)
 }
 
 // Forward Iterator Concept
-void* assoc_ht_open_front(assoc_ht_open_t const* ht)
+static
+hentry_t* next_with_value(assoc_ht_open_t const* htab, hentry_t* it)
 {
-  assert(0!=0 && "Do not use a hash table for iterating");
-  assert(ht != NULL);
-  return NULL;
+  hentry_t* end = htab->arr + htab->cap;
+  while(it != end && it->has_value == false)
+    ++it;
+  return it;
 }
 
-void* assoc_ht_open_next(assoc_ht_open_t const* ht, void* it)
+void* assoc_ht_open_front(assoc_ht_open_t const* htab)
 {
-  assert(0!=0 && "Do not use a hash table for iterating");
-  assert(ht != NULL);
-  assert(it != NULL);
-
-  return NULL;
+  assert(htab != NULL);
+  return next_with_value(htab, htab->arr);
 }
 
-void* assoc_ht_open_end(assoc_ht_open_t const* ht)
+void* assoc_ht_open_next(assoc_ht_open_t const* htab, void* it)
 {
-  assert(0!=0 && "Do not use a hash table for iterating");
-  assert(ht != NULL);
+  assert(htab != NULL);
+  assert(it != NULL);
+  assert(it != assoc_ht_open_end(htab) && "No next entry since the end reached");
 
+  return next_with_value(htab, (hentry_t*)it + 1);
+}
 
-  return NULL;
+void* assoc_ht_open_end(assoc_ht_open_t const* htab)
+{
+  assert(htab != NULL);
+  return htab->arr + htab->cap;
 }
 
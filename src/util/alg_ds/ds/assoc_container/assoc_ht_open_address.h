@@ -30,12 +30,14 @@ SOFTWARE.
 #include <stdint.h>
 
 
-typedef bool (*key_eq_func_fp)(const void* a, const void* b);
+typedef int (*key_cmp_func_fp)(const void* a, const void* b);
 typedef void (*free_func_ht_open_fp)(void* key, void* value);
-typedef uint32_t (*hash_func_ht_open_fp)(const void* key);
+typedef uint32_t (*hash_func_ht_open_fp)(const void* key, size_t key_sz);
 
 typedef struct hentry_s hentry_t;
 
+// Open addressing with linear probing. Same interface as assoc_rb_tree_t,
+// but O(1) lookups and no ordered iteration
 typedef struct {
   hentry_t* arr;
   size_t key_sz;
@@ -43,18 +45,20 @@ typedef struct {
   uint32_t cap;
   // # of used entries, even if they are now freed
   uint32_t num_dirty; 
-  key_eq_func_fp key_eq;
+  key_cmp_func_fp comp;
   free_func_ht_open_fp free_func;
   hash_func_ht_open_fp hash_func;
 } assoc_ht_open_t;
 
+// The key bytes are hashed. Use it only with keys without padding or pointers
+void assoc_ht_open_init(assoc_ht_open_t* ht, size_t key_sz, key_cmp_func_fp comp, free_func_ht_open_fp free);
 
-void assoc_ht_open_init(assoc_ht_open_t* htab, size_t key_sz, key_eq_func_fp eq, free_func_ht_open_fp free, hash_func_ht_open_fp hash_func);
+void assoc_ht_open_init_hash(assoc_ht_open_t* ht, size_t key_sz, key_cmp_func_fp comp, free_func_ht_open_fp free, hash_func_ht_open_fp hash_func);
 
 void assoc_ht_open_free(assoc_ht_open_t* ht);
 
 // Modifiers
-// The tree is responsible for freeing the void* key and value memory later
+// The table is responsible for freeing the void* key and value memory later
 void assoc_ht_open_insert(assoc_ht_open_t* ht, void const* key, size_t key_sz, void* value);
 
 // It returns the void* of value. the void* of the key is freed
@@ -63,13 +67,17 @@ void* assoc_ht_open_extract(assoc_ht_open_t* ht, void* key);
 // Get the key from an iterator 
 void* assoc_ht_open_key(assoc_ht_open_t* ht, void* it);
 
-// Get the value pointer from the key 
-void* assoc_ht_open_value(assoc_ht_open_t* htab, const void* key);
+// Get the value pointer from an iterator 
+void* assoc_ht_open_value(assoc_ht_open_t* ht, void* it);
+
+// Iterator to the key or the end iterator if not found. O(1)
+void* assoc_ht_open_find(assoc_ht_open_t const* ht, void const* key);
 
 // Capacity
 size_t assoc_ht_open_size(assoc_ht_open_t* ht);
 
 // Forward Iterator Concept
+// Iterators are invalidated by insert and extract
 void* assoc_ht_open_front(assoc_ht_open_t const* ht);
 
 void* assoc_ht_open_next(assoc_ht_open_t const* ht, void* it);
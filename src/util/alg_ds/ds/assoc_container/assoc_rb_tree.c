@@ -388,7 +388,7 @@ assoc_node_t* minimum(assoc_rb_tree_t const* tree, assoc_node_t* x_node)
 }
 
 static
-assoc_node_t* find_rb_tree(assoc_rb_tree_t* tree, assoc_node_t* node, void* key)
+assoc_node_t* find_rb_tree(assoc_rb_tree_t const* tree, assoc_node_t* node, void const* key)
 {
   assert(tree != NULL);
   assert(node != NULL);
@@ -408,6 +408,33 @@ assoc_node_t* find_rb_tree(assoc_rb_tree_t* tree, assoc_node_t* node, void* key)
   return node;
 }
 
+void* assoc_rb_tree_find(assoc_rb_tree_t const* tree, void const* key)
+{
+  assert(tree != NULL);
+  assert(key != NULL);
+
+  return find_rb_tree(tree, tree->root, key);
+}
+
+void* assoc_rb_tree_lower_bound(assoc_rb_tree_t const* tree, void const* key)
+{
+  assert(tree != NULL);
+  assert(key != NULL);
+
+  assoc_node_t* node = tree->root;
+  assoc_node_t* ans = tree->dummy;
+  while(node != tree->dummy){
+    // node->key ordered before key
+    if(tree->comp(node->key, key) == 1){
+      node = node->right;
+    } else {
+      ans = node;
+      node = node->left;
+    }
+  }
+  return ans;
+}
+
 
 static
 void assoc_rb_tree_extract_node(assoc_rb_tree_t* tree, assoc_node_t* z_node)
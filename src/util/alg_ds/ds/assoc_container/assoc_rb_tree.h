@@ -78,6 +78,13 @@ void* assoc_rb_tree_key(assoc_rb_tree_t* tree, void* it);
 // Get the value pointer form an iterator
 void* assoc_rb_tree_value(assoc_rb_tree_t* tree, void* it);
 
+// Lookup using the tree's comparator. O(log n)
+// Iterator to the key or the end iterator if not found 
+void* assoc_rb_tree_find(assoc_rb_tree_t const* tree, void const* key);
+
+// Iterator to the first key not ordered before key or the end iterator 
+void* assoc_rb_tree_lower_bound(assoc_rb_tree_t const* tree, void const* key);
+
 // Capacity
 size_t assoc_rb_tree_size(assoc_rb_tree_t* tree);
 
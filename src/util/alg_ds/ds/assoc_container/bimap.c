@@ -139,6 +139,22 @@ void* bi_map_extract_right(bi_map_t* map, void* key2, size_t key2_sz, free_fp_ke
   return key1;
 }
 
+bml_iter_t bi_map_find_left(bi_map_t* map, void const* key1)
+{
+  assert(map != NULL);
+  assert(key1 != NULL);
+  bml_iter_t it = {.it = assoc_find(&map->left, key1)};
+  return it;
+}
+
+bmr_iter_t bi_map_find_right(bi_map_t* map, void const* key2)
+{
+  assert(map != NULL);
+  assert(key2 != NULL);
+  bmr_iter_t it = {.it = assoc_find(&map->right, key2)};
+  return it;
+}
+
 // Capacity
 size_t bi_map_size(bi_map_t* map)
 {
@@ -70,6 +70,12 @@ void* bi_map_value_left(bi_map_t* map, bml_iter_t it);
 // returns a pointer to the value
 void* bi_map_value_right(bi_map_t* map, bml_iter_t it);
 
+// Lookup using the comparators. O(log n)
+// Returns the end iterator if not found
+bml_iter_t bi_map_find_left(bi_map_t* map, void const* key1);
+
+bmr_iter_t bi_map_find_right(bi_map_t* map, void const* key2);
+
 // Capacity
 size_t bi_map_size(bi_map_t* map);
 
@@ -0,0 +1,236 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lock_guard/lock_guard.h"
+#include "mpsc_queue.h"
+
+static
+size_t next_pow_2(size_t v)
+{
+  size_t p = 1;
+  while(p < v)
+    p <<= 1;
+  return p;
+}
+
+void init_mpscq(mpscq_t* q, size_t elm_sz, size_t cap)
+{
+  assert(q != NULL);
+  assert(elm_sz > 0);
+  assert(cap > 0);
+
+  cap = next_pow_2(cap);
+
+  q->elm_sz = elm_sz;
+  q->mask = cap - 1;
+
+  q->seq = calloc(cap, sizeof(atomic_size_t));
+  assert(q->seq != NULL && "Memory exhausted");
+  for(size_t i = 0; i < cap; ++i)
+    atomic_init(&q->seq[i], i);
+
+  q->buf = calloc(cap, elm_sz);
+  assert(q->buf != NULL && "Memory exhausted");
+
+  atomic_init(&q->tail, 0);
+  q->head = 0;
+  atomic_init(&q->sleeping, false);
+  atomic_init(&q->stop_token, false);
+
+  int rc = pthread_mutex_init(&q->mtx, NULL);
+  assert(rc == 0);
+
+  rc = pthread_cond_init(&q->cv, NULL);
+  assert(rc == 0);
+}
+
+// Consumer side. Moves the published elements from head onwards
+static
+size_t drain(mpscq_t* q, uint8_t* out, size_t max)
+{
+  size_t n = 0;
+  while(n < max){
+    size_t const pos = q->head;
+    atomic_size_t* s = &q->seq[pos & q->mask];
+    // Empty, or the producer that claimed it did not finish the copy yet.
+    // seq_cst pairs with the producer's store, see wake_consumer
+    if(atomic_load_explicit(s, memory_order_seq_cst) != pos + 1)
+      break;
+
+    memcpy(out + n*q->elm_sz, q->buf + (pos & q->mask)*q->elm_sz, q->elm_sz);
+    // Free for the producers of the next lap
+    atomic_store_explicit(s, pos + q->mask + 1, memory_order_release);
+    q->head = pos + 1;
+    ++n;
+  }
+  return n;
+}
+
+void free_mpscq(mpscq_t* q, void (*f)(void*))
+{
+  assert(q != NULL);
+
+  if(f != NULL){
+    uint8_t* tmp = malloc(q->elm_sz);
+    assert(tmp != NULL && "Memory exhausted");
+    while(drain(q, tmp, 1) == 1)
+      f(tmp);
+    free(tmp);
+  }
+
+  free(q->seq);
+  free(q->buf);
+
+  int rc = pthread_cond_destroy(&q->cv);
+  assert(rc == 0);
+
+  rc = pthread_mutex_destroy(&q->mtx);
+  assert(rc == 0);
+}
+
+static
+void wake_consumer(mpscq_t* q)
+{
+  // The slot was published with a seq_cst store and the consumer marks
+  // itself sleeping with another before draining. Either the consumer sees
+  // the new element before parking, or the producer sees it parked
+  if(atomic_load_explicit(&q->sleeping, memory_order_seq_cst) == false)
+    return;
+
+  lock_guard(&q->mtx);
+  pthread_cond_signal(&q->cv);
+}
+
+bool try_push_mpscq(mpscq_t* q, void const* val)
+{
+  assert(q != NULL);
+  assert(val != NULL);
+
+  size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  atomic_size_t* s = NULL;
+  for(;;){
+    s = &q->seq[pos & q->mask];
+    size_t const seq = atomic_load_explicit(s, memory_order_acquire);
+    intptr_t const dif = (intptr_t)seq - (intptr_t)pos;
+    if(dif == 0){
+      if(atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+        break;
+    } else if(dif < 0){
+      // The consumer did not free the slot of the previous lap
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    }
+  }
+
+  memcpy(q->buf + (pos & q->mask)*q->elm_sz, val, q->elm_sz);
+  atomic_store_explicit(s, pos + 1, memory_order_seq_cst);
+
+  wake_consumer(q);
+  return true;
+}
+
+bool push_mpscq(mpscq_t* q, void const* val)
+{
+  assert(q != NULL);
+
+  while(try_push_mpscq(q, val) == false){
+    if(atomic_load_explicit(&q->stop_token, memory_order_acquire) == true)
+      return false;
+    sched_yield();
+  }
+  return true;
+}
+
+size_t pop_n_mpscq(mpscq_t* q, void* out, size_t max, int64_t timeout_ms)
+{
+  assert(q != NULL);
+  assert(out != NULL);
+  assert(max > 0);
+
+  if(atomic_load_explicit(&q->stop_token, memory_order_acquire) == true)
+    return 0;
+
+  size_t n = drain(q, out, max);
+  if(n > 0 || timeout_ms == 0)
+    return n;
+
+  // pthread_cond_timedwait measures against the CLOCK_REALTIME
+  struct timespec deadline = {0};
+  if(timeout_ms > 0){
+    int rc = clock_gettime(CLOCK_REALTIME, &deadline);
+    assert(rc == 0);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+    if(deadline.tv_nsec >= 1000000000){
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+  }
+
+  pthread_mutex_lock(&q->mtx);
+
+  int rc = 0;
+  while(true){
+    atomic_store_explicit(&q->sleeping, true, memory_order_seq_cst);
+
+    n = drain(q, out, max);
+    if(n > 0 || rc != 0 || atomic_load_explicit(&q->stop_token, memory_order_acquire) == true)
+      break;
+
+    if(timeout_ms < 0)
+      rc = pthread_cond_wait(&q->cv, &q->mtx);
+    else
+      rc = pthread_cond_timedwait(&q->cv, &q->mtx, &deadline);
+    assert(rc == 0 || rc == ETIMEDOUT);
+  }
+
+  atomic_store_explicit(&q->sleeping, false, memory_order_relaxed);
+  pthread_mutex_unlock(&q->mtx);
+
+  return n;
+}
+
+void stop_mpscq(mpscq_t* q)
+{
+  assert(q != NULL);
+
+  atomic_store_explicit(&q->stop_token, true, memory_order_release);
+
+  lock_guard(&q->mtx);
+  pthread_cond_broadcast(&q->cv);
+}
+
+bool stopped_mpscq(mpscq_t* q)
+{
+  assert(q != NULL);
+  return atomic_load_explicit(&q->stop_token, memory_order_acquire);
+}
@@ -0,0 +1,83 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MPSC_QUEUE_MIR_H
+#define MPSC_QUEUE_MIR_H
+
+// Bounded lock-free multi-producer single-consumer queue (Vyukov's bounded
+// queue with one consumer). Every slot carries a sequence number that tells
+// whether it is free for the producer of that lap or holds a value for the
+// consumer. Producers only contend on the tail CAS. The consumer parks on a
+// condition variable when the queue is empty, and the producers only take
+// the mutex if the consumer is actually parked.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct{
+  // Producers
+  atomic_size_t tail;
+  uint8_t pad_tail[64 - sizeof(atomic_size_t)];
+
+  // Consumer
+  size_t head;
+  uint8_t pad_head[64 - sizeof(size_t)];
+
+  atomic_bool sleeping;
+  atomic_bool stop_token;
+
+  size_t elm_sz;
+  size_t mask;
+  atomic_size_t* seq;
+  uint8_t* buf;
+
+  pthread_mutex_t mtx;
+  pthread_cond_t cv;
+} mpscq_t;
+
+// cap is rounded up to the next power of 2
+void init_mpscq(mpscq_t* q, size_t elm_sz, size_t cap);
+
+// Only after the consumer stopped. f called for every element left
+void free_mpscq(mpscq_t* q, void (*f)(void*));
+
+// false if full. val is not pushed
+bool try_push_mpscq(mpscq_t* q, void const* val);
+
+// Yields while full. false if the queue was stopped meanwhile
+bool push_mpscq(mpscq_t* q, void const* val);
+
+// Single consumer. Moves up to max elements into out. Waits timeout_ms for
+// the first one (< 0 forever, 0 not at all). 0 after the timeout or if stopped
+size_t pop_n_mpscq(mpscq_t* q, void* out, size_t max, int64_t timeout_ms);
+
+// Wakes up the consumer. Pops and pushes return immediately afterwards
+void stop_mpscq(mpscq_t* q);
+
+bool stopped_mpscq(mpscq_t* q);
+
+#endif
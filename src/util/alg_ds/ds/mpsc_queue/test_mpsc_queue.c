@@ -0,0 +1,171 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "mpsc_queue.h"
+
+#define NUM_PROD 4
+#define NUM_VAL (1 << 16)
+#define CAP 64
+#define BATCH 32
+
+typedef struct
+{
+  uint32_t prod;
+  uint32_t n;
+} val_t;
+
+static
+void* producer_thread(void* arg)
+{
+  mpscq_t* q = (mpscq_t*)arg;
+
+  static _Atomic uint32_t id = 0;
+  uint32_t const prod = id++;
+
+  for(uint32_t i = 0; i < NUM_VAL; ++i){
+    val_t v = {.prod = prod, .n = i};
+    bool const pushed = push_mpscq(q, &v);
+    assert(pushed == true);
+    // Give the consumer the chance to park
+    if(i % 4096 == 0)
+      usleep(100);
+  }
+
+  return NULL;
+}
+
+static
+void test_mpsc(void)
+{
+  mpscq_t q = {0};
+  init_mpscq(&q, sizeof(val_t), CAP);
+
+  pthread_t p[NUM_PROD];
+  for(size_t i = 0; i < NUM_PROD; ++i){
+    int rc = pthread_create(&p[i], NULL, producer_thread, &q);
+    assert(rc == 0);
+  }
+
+  // FIFO per producer
+  uint32_t next[NUM_PROD] = {0};
+  size_t total = 0;
+  val_t out[BATCH] = {0};
+  while(total < NUM_PROD*NUM_VAL){
+    size_t const n = pop_n_mpscq(&q, out, BATCH, -1);
+    assert(n > 0 && n <= BATCH);
+    for(size_t i = 0; i < n; ++i){
+      assert(out[i].n == next[out[i].prod]);
+      next[out[i].prod] += 1;
+    }
+    total += n;
+  }
+
+  for(size_t i = 0; i < NUM_PROD; ++i)
+    pthread_join(p[i], NULL);
+
+  assert(pop_n_mpscq(&q, out, BATCH, 0) == 0);
+  assert(pop_n_mpscq(&q, out, BATCH, 10) == 0);
+
+  free_mpscq(&q, NULL);
+}
+
+static
+int num_freed = 0;
+
+static
+void count_free(void* it)
+{
+  assert(it != NULL);
+  num_freed += 1;
+}
+
+static
+void test_full(void)
+{
+  mpscq_t q = {0};
+  // Rounded up to 4
+  init_mpscq(&q, sizeof(val_t), 3);
+
+  val_t v = {0};
+  for(size_t i = 0; i < 4; ++i)
+    assert(try_push_mpscq(&q, &v) == true);
+  assert(try_push_mpscq(&q, &v) == false);
+
+  val_t out[2] = {0};
+  assert(pop_n_mpscq(&q, out, 2, 0) == 2);
+  assert(try_push_mpscq(&q, &v) == true);
+
+  // The elements left go through the free function
+  stop_mpscq(&q);
+  assert(push_mpscq(&q, &v) == true);
+  assert(push_mpscq(&q, &v) == false);
+  assert(pop_n_mpscq(&q, out, 2, -1) == 0);
+  free_mpscq(&q, count_free);
+  assert(num_freed == 4);
+}
+
+static
+void* blocked_consumer(void* arg)
+{
+  mpscq_t* q = (mpscq_t*)arg;
+  val_t out[BATCH] = {0};
+  size_t const n = pop_n_mpscq(q, out, BATCH, -1);
+  assert(n == 0);
+  assert(stopped_mpscq(q) == true);
+  return NULL;
+}
+
+static
+void test_stop(void)
+{
+  mpscq_t q = {0};
+  init_mpscq(&q, sizeof(val_t), CAP);
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, blocked_consumer, &q);
+  assert(rc == 0);
+
+  usleep(10000);
+  stop_mpscq(&q);
+  pthread_join(t, NULL);
+  free_mpscq(&q, NULL);
+}
+
+int main()
+{
+  test_mpsc();
+  test_full();
+  test_stop();
+
+  printf("Success\n");
+  return 0;
+}
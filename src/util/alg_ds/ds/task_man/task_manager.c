@@ -22,13 +22,21 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#define _GNU_SOURCE // pthread_setaffinity_np
 #include "task_manager.h"
+#include "../assoc_container/assoc_ht_open_address.h"
 
 #include <assert.h> 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 //////////////////////////////////////////////
 //////////////////////////////////////////////
@@ -46,9 +54,6 @@ typedef struct seq_ring_buf_s
   uint32_t tail;
 } seq_ring_t;
 
-// For working correctly, maintain the default elements to a multiple of 2
-#define DEFAULT_ELM 32768 
-
 inline static
 uint32_t mask(uint32_t cap, uint32_t val)
 {
@@ -94,14 +99,14 @@ void enlarge_buffer(seq_ring_t* r)
 }
 
 static
-void seq_ring_init(seq_ring_t* r, size_t elt_size)
+void seq_ring_init_cap(seq_ring_t* r, size_t elt_size, size_t cap)
 {
   assert(r != NULL);
-  uint8_t* tmp_buffer = calloc(DEFAULT_ELM, elt_size); 
+  assert(cap > 1 && (cap & (cap - 1)) == 0 && "Capacity must be a power of 2");
+  uint8_t* tmp_buffer = calloc(cap, elt_size); 
   assert(tmp_buffer != NULL);
-  seq_ring_t tmp = {.elt_size = elt_size, .array = tmp_buffer, .head = 0, .tail = 0, .cap = DEFAULT_ELM};
+  seq_ring_t tmp = {.elt_size = elt_size, .array = tmp_buffer, .head = 0, .tail = 0, .cap = cap};
   memcpy(r, &tmp, sizeof(seq_ring_t));
-
 }
 
 static
@@ -262,215 +267,675 @@ void seq_ring_swap(seq_ring_t* cb, void* it_1, void* it_2)
 
 
 
-
 //////////////////////////////////////////////
 //////////////////////////////////////////////
-//////////////// Notification Queue //////////
+//////////////// Chase-Lev Deque /////////////
 //////////////////////////////////////////////
 //////////////////////////////////////////////
 
-typedef struct {
-  pthread_mutex_t mtx;
-  pthread_cond_t cv;
-  seq_ring_t r;
-  int done;
-} not_q_t;
+// Work-stealing deque from "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (Le et al., PPoPP'13). Only the owner pushes and pops at
+// the bottom, while the thieves steal from the top, lock free.
+// The task fields are stored as separate atomics. A thief may read a slot
+// while it is being overwritten, but then its CAS on top fails and the
+// torn value is discarded
+
+typedef struct{
+  _Atomic(uintptr_t) args;
+  _Atomic(uintptr_t) func;
+} slot_t;
+
+typedef struct cl_array_s{
+  int64_t cap;
+  // Replaced arrays. Thieves may still read them, so they are freed with the deque
+  struct cl_array_s* prev;
+  slot_t buf[];
+} cl_array_t;
 
 typedef struct{
-  task_t t[4096];
-  int len;
-  bool success;
-} ret_try_t;
+  atomic_int_fast64_t top;
+  atomic_int_fast64_t bottom;
+  _Atomic(cl_array_t*) arr;
+} cl_deque_t;
+
+#define CL_DEQUE_INIT_CAP 1024
 
 static
-void init_not_q(not_q_t* q)
+cl_array_t* alloc_cl_array(int64_t cap)
 {
-  assert(q != NULL);
+  cl_array_t* a = calloc(1, sizeof(cl_array_t) + cap*sizeof(slot_t));
+  assert(a != NULL && "Memory exhausted");
+  a->cap = cap;
+  return a;
+}
 
-  q->done = 0;
-  seq_ring_init(&q->r, sizeof(task_t));
+static inline
+void put_cl_array(cl_array_t* a, int64_t i, task_t t)
+{
+  slot_t* s = &a->buf[i & (a->cap - 1)];
+  atomic_store_explicit(&s->args, (uintptr_t)t.args, memory_order_relaxed);
+  atomic_store_explicit(&s->func, (uintptr_t)t.func, memory_order_relaxed);
+}
 
-  pthread_mutexattr_t attr = {0};
-#ifdef _DEBUG
-  int const rc_mtx = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
-  assert(rc_mtx == 0);
-#endif
-  int rc = pthread_mutex_init(&q->mtx, &attr);
-  assert(rc == 0 && "Error while creating the mtx");
+static inline
+task_t get_cl_array(cl_array_t* a, int64_t i)
+{
+  slot_t* s = &a->buf[i & (a->cap - 1)];
+  task_t t = {.args = (void*)atomic_load_explicit(&s->args, memory_order_relaxed),
+              .func = (void (*)(void*))atomic_load_explicit(&s->func, memory_order_relaxed)};
+  return t;
+}
 
-  pthread_condattr_t* c_attr = NULL; 
-  rc = pthread_cond_init(&q->cv, c_attr);
-  assert(rc == 0);
+static
+void init_cl_deque(cl_deque_t* q)
+{
+  assert(q != NULL);
+  atomic_init(&q->top, 0);
+  atomic_init(&q->bottom, 0);
+  atomic_init(&q->arr, alloc_cl_array(CL_DEQUE_INIT_CAP));
 }
 
 static
-void free_not_q(not_q_t* q, void (*clean)(void*) )
+void free_cl_deque(cl_deque_t* q)
 {
   assert(q != NULL);
-  assert(q->done == 1);
+  cl_array_t* a = atomic_load_explicit(&q->arr, memory_order_relaxed);
+  while(a != NULL){
+    cl_array_t* prev = a->prev;
+    free(a);
+    a = prev;
+  }
+}
 
-  seq_ring_free(&q->r, clean);
+static inline
+int64_t size_cl_deque(cl_deque_t* q)
+{
+  int64_t const b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+  int64_t const t = atomic_load_explicit(&q->top, memory_order_relaxed);
+  return b > t ? b - t : 0;
+}
 
-  int rc = pthread_mutex_destroy(&q->mtx);
-  assert(rc == 0);
+// Owner only
+static
+void push_cl_deque(cl_deque_t* q, task_t x)
+{
+  int64_t const b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+  int64_t const t = atomic_load_explicit(&q->top, memory_order_acquire);
+  cl_array_t* a = atomic_load_explicit(&q->arr, memory_order_relaxed);
+
+  if(b - t > a->cap - 1){
+    cl_array_t* n = alloc_cl_array(2*a->cap);
+    for(int64_t i = t; i < b; ++i)
+      put_cl_array(n, i, get_cl_array(a, i));
+    n->prev = a;
+    atomic_store_explicit(&q->arr, n, memory_order_release);
+    a = n;
+  }
 
-  rc = pthread_cond_destroy(&q->cv);
-  assert(rc == 0);
+  put_cl_array(a, b, x);
+  atomic_store_explicit(&q->bottom, b + 1, memory_order_release);
 }
 
+// Owner only
 static
-bool try_push_not_q(not_q_t* q, task_t t)
+bool pop_cl_deque(cl_deque_t* q, task_t* out)
 {
-  assert(q != NULL);
-  assert(q->done == 0 || q->done ==1);
-  assert(t.func != NULL);
-  assert(t.args != NULL);
+  int64_t const b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+  cl_array_t* a = atomic_load_explicit(&q->arr, memory_order_relaxed);
+  atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+  if(t > b){
+    // Empty
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
 
-  if(pthread_mutex_trylock(&q->mtx ) != 0)
+  *out = get_cl_array(a, b);
+  if(t < b)
+    return true;
+
+  // Last element. Race against the thieves
+  bool const won = atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+  atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+  return won;
+}
+
+// Any thread
+static
+bool steal_cl_deque(cl_deque_t* q, task_t* out)
+{
+  int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t const b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+
+  if(t >= b)
     return false;
 
-  seq_ring_push_back(&q->r, (uint8_t*)&t, sizeof(task_t));
+  cl_array_t* a = atomic_load_explicit(&q->arr, memory_order_acquire);
+  *out = get_cl_array(a, t);
 
-  int rc = pthread_mutex_unlock(&q->mtx);
-  assert(rc == 0);
+  // Lost against the owner or another thief
+  return atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+//////////////// End Chase-Lev Deque /////////
+//////////////////////////////////////////////
+//////////////////////////////////////////////
 
-  pthread_cond_signal(&q->cv);
 
-  return true;
+
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+//////////////// Inbox ///////////////////////
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+
+// Tasks submitted from outside the worker (e.g., the RIC reactors), in
+// FIFO order. Bounded MPMC queue (D. Vyukov), so the owner and the thieves
+// pop lock free
+
+// Same as the initial capacity of the old mutex protected queues
+#define INBOX_CAP 32768
+
+typedef struct{
+  atomic_size_t seq;
+  task_t t;
+} cell_t;
+
+typedef struct{
+  cell_t* buf;
+  _Alignas(64) atomic_size_t enq;
+  _Alignas(64) atomic_size_t deq;
+} inbox_t;
+
+static
+void init_inbox(inbox_t* q)
+{
+  assert(q != NULL);
+  q->buf = calloc(INBOX_CAP, sizeof(cell_t));
+  assert(q->buf != NULL && "Memory exhausted");
+  for(size_t i = 0; i < INBOX_CAP; ++i)
+    atomic_init(&q->buf[i].seq, i);
+  atomic_init(&q->enq, 0);
+  atomic_init(&q->deq, 0);
 }
 
 static
-void push_not_q(not_q_t* q, task_t t)
+void free_inbox(inbox_t* q)
 {
   assert(q != NULL);
-  assert(q->done == 0 || q->done ==1);
-  assert(t.func != NULL);
-  //assert(t.args != NULL);
+  free(q->buf);
+}
+
+static inline
+size_t size_inbox(inbox_t* q)
+{
+  size_t const e = atomic_load_explicit(&q->enq, memory_order_relaxed);
+  size_t const d = atomic_load_explicit(&q->deq, memory_order_relaxed);
+  return e > d ? e - d : 0;
+}
+
+static
+bool try_push_inbox(inbox_t* q, task_t t)
+{
+  size_t pos = atomic_load_explicit(&q->enq, memory_order_relaxed);
+  for(;;){
+    cell_t* c = &q->buf[pos & (INBOX_CAP - 1)];
+    size_t const seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+    intptr_t const dif = (intptr_t)seq - (intptr_t)pos;
+    if(dif == 0){
+      if(atomic_compare_exchange_weak_explicit(&q->enq, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)){
+        c->t = t;
+        atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+        return true;
+      }
+    } else if(dif < 0){
+      // Full
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->enq, memory_order_relaxed);
+    }
+  }
+}
+
+static
+bool try_pop_inbox(inbox_t* q, task_t* out)
+{
+  size_t pos = atomic_load_explicit(&q->deq, memory_order_relaxed);
+  for(;;){
+    cell_t* c = &q->buf[pos & (INBOX_CAP - 1)];
+    size_t const seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+    intptr_t const dif = (intptr_t)seq - (intptr_t)(pos + 1);
+    if(dif == 0){
+      if(atomic_compare_exchange_weak_explicit(&q->deq, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)){
+        *out = c->t;
+        atomic_store_explicit(&c->seq, pos + INBOX_CAP, memory_order_release);
+        return true;
+      }
+    } else if(dif < 0){
+      // Empty
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->deq, memory_order_relaxed);
+    }
+  }
+}
+
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+//////////////// End Inbox ///////////////////
+//////////////////////////////////////////////
+//////////////////////////////////////////////
 
-  int rc = pthread_mutex_lock(&q->mtx);
-  assert(rc == 0);
 
-  seq_ring_push_back(&q->r, (void*)&t, sizeof(task_t));
 
-  pthread_mutex_unlock(&q->mtx);
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+//////////////// Worker //////////////////////
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+
+enum { WORKER_RUNNING = 0, WORKER_PARKED = 1 };
 
-  pthread_cond_signal(&q->cv);
+typedef struct{
+  // Tasks submitted by the worker itself
+  cl_deque_t dq;
+  // Tasks submitted by other threads
+  inbox_t in;
+  // Futex word
+  _Alignas(64) atomic_uint state;
+} worker_t;
+
+// Worker running in this thread, if any
+static _Thread_local struct{
+  task_manager_t* man;
+  uint32_t idx;
+} cur_worker;
+
+static inline
+long futex(atomic_uint* addr, int op, unsigned val)
+{
+  return syscall(SYS_futex, (unsigned*)addr, op, val, NULL, NULL, 0);
 }
 
 static
-ret_try_t try_pop_not_q(not_q_t* q)
+void init_worker(worker_t* w)
 {
-  assert(q != NULL);
+  assert(w != NULL);
+  init_cl_deque(&w->dq);
+  init_inbox(&w->in);
+  atomic_init(&w->state, WORKER_RUNNING);
+}
 
-  ret_try_t  ret = {.success = false}; 
+static
+void run_strand(void* arg);
 
-  int rc = pthread_mutex_trylock(&q->mtx);
-  assert(rc == 0 || rc == EBUSY);
+// Called after the workers joined
+static
+void free_worker(worker_t* w, void (*clean)(void*))
+{
+  assert(w != NULL);
 
-  if(rc == EBUSY)
-    return ret;
+  // The strands own their tasks, and release them on their own
+  task_t t = {0};
+  while(pop_cl_deque(&w->dq, &t) == true || try_pop_inbox(&w->in, &t) == true){
+    if(clean != NULL && t.func != run_strand)
+      clean(&t);
+  }
 
-  assert(q->done == 0 || q->done ==1);
+  free_cl_deque(&w->dq);
+  free_inbox(&w->in);
+}
 
-  size_t sz = seq_ring_size(&q->r); 
-  if(sz == 0){
-    rc = pthread_mutex_unlock(&q->mtx);
-    assert(rc == 0);
+static inline
+size_t load_worker(worker_t* w)
+{
+  return size_cl_deque(&w->dq) + size_inbox(&w->in);
+}
 
-    return ret;
-  }
+static
+bool try_pop_worker(worker_t* w, task_t* out)
+{
+  return pop_cl_deque(&w->dq, out) || try_pop_inbox(&w->in, out);
+}
 
-  ret.len = sz < 4096 ? sz : 4096;
-  for(int i = 0; i < ret.len; ++i){
-  void* it = seq_ring_at(&q->r, i);
-    memcpy(&ret.t[i], it, sizeof(task_t)); 
-  }
+static
+bool try_steal_worker(worker_t* w, task_t* out)
+{
+  return steal_cl_deque(&w->dq, out) || try_pop_inbox(&w->in, out);
+}
 
-//   void* it = seq_ring_front(&q->r);
-//    assert(it != seq_ring_end(&q->r));
-//    memcpy(&ret.t, it, sizeof(task_t)); 
+// True if w was parked
+static
+bool wake_worker(worker_t* w)
+{
+  unsigned exp = WORKER_PARKED;
+  if(atomic_load_explicit(&w->state, memory_order_relaxed) != WORKER_PARKED
+      || atomic_compare_exchange_strong(&w->state, &exp, WORKER_RUNNING) == false)
+    return false;
 
-  seq_ring_erase(&q->r, seq_ring_front(&q->r), seq_ring_at(&q->r, ret.len) );
+  futex(&w->state, FUTEX_WAKE_PRIVATE, 1);
+  return true;
+}
+
+// Wake up the owner of the new task or, if it is busy, any parked worker
+static
+void notify_task_manager(task_manager_t* man, uint32_t idx)
+{
+  worker_t* w_arr = (worker_t*)man->q_arr;
 
+  // Pairs with the fence in park_worker. Either the submitter sees the
+  // parked worker, or the worker sees the new task
+  atomic_thread_fence(memory_order_seq_cst);
+  if(atomic_load_explicit(&man->parked, memory_order_relaxed) == 0)
+    return;
 
-//  seq_ring_move(&q->r, seq_ring_front(&q->r), seq_ring_at(&q->r, ret.len), ret.t);
+  if(wake_worker(&w_arr[idx]) == true)
+    return;
 
-  assert(sz == ret.len + seq_ring_size(&q->r)); 
+  for(uint32_t i = 1; i < man->len_thr; ++i){
+    if(wake_worker(&w_arr[(idx + i) % man->len_thr]) == true)
+      return;
+  }
+}
 
-  rc = pthread_mutex_unlock(&q->mtx);
+static
+void push_overflow(task_manager_t* man, task_t t)
+{
+  int rc = pthread_mutex_lock(&man->overflow_mtx);
+  assert(rc == 0);
+  seq_ring_push_back(man->overflow, (uint8_t*)&t, sizeof(task_t));
+  atomic_fetch_add_explicit(&man->len_overflow, 1, memory_order_relaxed);
+  rc = pthread_mutex_unlock(&man->overflow_mtx);
   assert(rc == 0);
-  ret.success = true; 
+}
+
+static
+bool try_pop_overflow(task_manager_t* man, task_t* out)
+{
+  if(atomic_load_explicit(&man->len_overflow, memory_order_relaxed) == 0)
+    return false;
 
-  return ret;
+  int rc = pthread_mutex_lock(&man->overflow_mtx);
+  assert(rc == 0);
+  seq_ring_t* r = man->overflow;
+  bool const ans = seq_ring_size(r) > 0;
+  if(ans){
+    *out = *(task_t*)seq_ring_front(r);
+    seq_ring_erase(r, seq_ring_front(r), seq_ring_at(r, 1));
+    atomic_fetch_sub_explicit(&man->len_overflow, 1, memory_order_relaxed);
+  }
+  rc = pthread_mutex_unlock(&man->overflow_mtx);
+  assert(rc == 0);
+  return ans;
 }
 
+// FIFO. Any thread
 static
-bool pop_not_q(not_q_t* q, ret_try_t* out)
+void push_inbox_task_manager(task_manager_t* man, uint32_t idx, task_t t)
 {
-  assert(q != NULL);
-  assert(out != NULL);
+  worker_t* w_arr = (worker_t*)man->q_arr;
+
+  // Full. Try the rest
+  uint32_t i = 0;
+  for(; i < man->len_thr; ++i){
+    if(try_push_inbox(&w_arr[(idx + i) % man->len_thr].in, t) == true)
+      break;
+  }
 
-  pthread_mutex_lock(&q->mtx);
-  assert(q->done == 0 || q->done ==1);
+  // All of them are full. Never wait for room, as a worker waiting on
+  // the inboxes of the others may be the one that should drain them
+  if(i == man->len_thr){
+    if(cur_worker.man == man){
+      push_cl_deque(&w_arr[cur_worker.idx].dq, t);
+      idx = cur_worker.idx;
+    } else {
+      push_overflow(man, t);
+    }
+  }
 
-  while(seq_ring_size(&q->r) == 0 && q->done == 0)
-    pthread_cond_wait(&q->cv , &q->mtx);
+  notify_task_manager(man, idx);
+}
 
-  if(q->done == 1){
-    int rc = pthread_mutex_unlock(&q->mtx);
-    assert(rc == 0);
-    return false;
+static
+bool steal_task_manager(task_manager_t* man, uint32_t idx, task_t* out)
+{
+  worker_t* w_arr = (worker_t*)man->q_arr;
+  for(uint32_t i = 1; i < man->len_thr; ++i){
+    if(try_steal_worker(&w_arr[(idx + i) % man->len_thr], out) == true)
+      return true;
   }
+  return false;
+}
 
-  const size_t sz =  seq_ring_size(&q->r);
+static
+bool any_task_manager(task_manager_t* man)
+{
+  if(atomic_load_explicit(&man->len_overflow, memory_order_relaxed) > 0)
+    return true;
 
-  out->len = sz < 4096 ? sz : 4096; 
-  for(int i =0; i < out->len; ++i){
-     void* it = seq_ring_at(&q->r, i);
-    assert(it != seq_ring_end(&q->r));
-    memcpy(&out->t[i], it, sizeof(task_t)); 
+  worker_t* w_arr = (worker_t*)man->q_arr;
+  for(uint32_t i = 0; i < man->len_thr; ++i){
+    if(load_worker(&w_arr[i]) > 0)
+      return true;
   }
+  return false;
+}
 
-//   void* it = seq_ring_at(&q->r, 0);
-//    assert(it != seq_ring_end(&q->r));
-//    memcpy(&out->t, it, sizeof(task_t)); 
+static
+void park_worker(task_manager_t* man, worker_t* w)
+{
+  atomic_store(&w->state, WORKER_PARKED);
+  atomic_fetch_add(&man->parked, 1);
+  atomic_thread_fence(memory_order_seq_cst);
 
-  seq_ring_erase(&q->r, seq_ring_front(&q->r), seq_ring_at(&q->r, out->len));
+  // Last look, as a task may have been pushed before the parked count was visible
+  if(any_task_manager(man) == true || atomic_load(&man->stop) == true){
+    atomic_store(&w->state, WORKER_RUNNING);
+  } else {
+    while(atomic_load(&w->state) == WORKER_PARKED)
+      futex(&w->state, FUTEX_WAIT_PRIVATE, WORKER_PARKED);
+  }
+
+  atomic_fetch_sub(&man->parked, 1);
+}
+
+static inline
+void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+//////////////// End Worker //////////////////
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+
+
+
+
+//////////////////////////////////////////////
+//////////////////////////////////////////////
+//////////////// Strand //////////////////////
+//////////////////////////////////////////////
+//////////////////////////////////////////////
 
-//  seq_ring_move(&q->r, seq_ring_front(&q->r), seq_ring_at(&q->r, out->len), out->t);
+// Serial executor of the tasks with the same key. At most one run_strand
+// task per strand is queued or running, so its tasks never overlap and run
+// in submission order, regardless of the worker (or thief) that runs it.
+// A strand only lives while it has tasks. The one that drains it frees it,
+// so the keys of closed associations do not pile up
 
+// Tasks run before yielding the worker to the rest of the queue
+#define STRAND_QUOTA 64
 
-  int rc = pthread_mutex_unlock(&q->mtx);
+// A home queue with more pending tasks than twice the least loaded one
+// plus this slack is considered overloaded
+#define OVERLOAD_SLACK 64
+
+typedef struct{
+  pthread_mutex_t mtx;
+  seq_ring_t q; // task_t
+  bool scheduled;
+  uint32_t home;
+  uint64_t key;
+  task_manager_t* man;
+} strand_t;
+
+static
+int cmp_key_strand(void const* a, void const* b)
+{
+  uint64_t const x = *(uint64_t const*)a;
+  uint64_t const y = *(uint64_t const*)b;
+  if(x < y)
+    return 1;
+  if(x > y)
+    return -1;
+  return 0;
+}
+
+static
+void free_strand(strand_t* s, void (*clean)(void*))
+{
+  int rc = pthread_mutex_destroy(&s->mtx);
   assert(rc == 0);
+  seq_ring_free(&s->q, clean);
+  free(s);
+}
 
-  return true;
+static
+void free_key_strand(void* key, void* value)
+{
+  (void)key;
+  strand_t* s = (strand_t*)value;
+  free_strand(s, s->man->clean);
 }
 
+// man->strand_mtx held
 static
-void done_not_q(not_q_t* q)
+strand_t* get_strand(task_manager_t* man, uint64_t key)
 {
-  assert(q != NULL);
+  assoc_ht_open_t* ht = (assoc_ht_open_t*)man->strands;
 
-  int rc = pthread_mutex_lock(&q->mtx);
+  void* it = assoc_ht_open_find(ht, &key);
+  if(it != assoc_ht_open_end(ht))
+    return assoc_ht_open_value(ht, it);
+
+  strand_t* s = calloc(1, sizeof(strand_t));
+  assert(s != NULL && "Memory exhausted");
+  int rc = pthread_mutex_init(&s->mtx, NULL);
   assert(rc == 0);
-  
-  q->done = 1;
+  seq_ring_init_cap(&s->q, sizeof(task_t), 16);
+  // Fibonacci hashing spreads consecutive keys (e.g., assoc ids)
+  s->home = ((key * 11400714819323198485llu) >> 32) % man->len_thr;
+  s->key = key;
+  s->man = man;
+  assoc_ht_open_insert(ht, &key, sizeof(key), s);
+  return s;
+}
 
-  rc = pthread_mutex_unlock(&q->mtx);
+// The submitters look the strand up and push into it under
+// man->strand_mtx, so once it is out of the table nobody else can reach it
+static
+bool release_idle_strand(strand_t* s)
+{
+  task_manager_t* man = s->man;
+
+  int rc = pthread_mutex_lock(&man->strand_mtx);
+  assert(rc == 0);
+  rc = pthread_mutex_lock(&s->mtx);
   assert(rc == 0);
 
-  rc = pthread_cond_signal(&q->cv);
+  bool const idle = seq_ring_size(&s->q) == 0;
+  if(idle){
+    s->scheduled = false;
+    strand_t* tmp = assoc_ht_open_extract(man->strands, &s->key);
+    assert(tmp == s);
+  }
+
+  rc = pthread_mutex_unlock(&s->mtx);
   assert(rc == 0);
+  rc = pthread_mutex_unlock(&man->strand_mtx);
+  assert(rc == 0);
+
+  if(idle)
+    free_strand(s, NULL);
+
+  return idle;
+}
+
+// Move the strand away from its home queue only if it is overloaded,
+// so that a key normally stays on the same worker
+static
+void schedule_strand(task_manager_t* man, strand_t* s)
+{
+  worker_t* w_arr = (worker_t*)man->q_arr;
+
+  size_t const home_load = load_worker(&w_arr[s->home]);
+  if(home_load > OVERLOAD_SLACK){
+    uint32_t min_idx = s->home;
+    size_t min_load = home_load;
+    for(uint32_t i = 0; i < man->len_thr; ++i){
+      size_t const l = load_worker(&w_arr[i]);
+      if(l < min_load){
+        min_load = l;
+        min_idx = i;
+      }
+    }
+    if(home_load > 2*min_load + OVERLOAD_SLACK)
+      s->home = min_idx;
+  }
+
+  task_t t = {.args = s, .func = run_strand};
+  push_inbox_task_manager(man, s->home, t);
+}
+
+static
+void run_strand(void* arg)
+{
+  assert(arg != NULL);
+  strand_t* s = (strand_t*)arg;
+
+  for(int i = 0; i < STRAND_QUOTA; ++i){
+    int rc = pthread_mutex_lock(&s->mtx);
+    assert(rc == 0);
+
+    if(seq_ring_size(&s->q) == 0){
+      rc = pthread_mutex_unlock(&s->mtx);
+      assert(rc == 0);
+      // A task may have been pushed meanwhile, and then the strand goes on
+      if(release_idle_strand(s) == true)
+        return;
+      continue;
+    }
+
+    task_t t = *(task_t*)seq_ring_front(&s->q);
+    seq_ring_erase(&s->q, seq_ring_front(&s->q), seq_ring_at(&s->q, 1));
+
+    rc = pthread_mutex_unlock(&s->mtx);
+    assert(rc == 0);
+
+    t.func(t.args);
+  }
+
+  // Quota exhausted. Go to the back of the queue, still scheduled
+  schedule_strand(s->man, s);
 }
 
 //////////////////////////////////////////////
 //////////////////////////////////////////////
-//////////////// End Notification Queue //////////
+//////////////// End Strand //////////////////
 //////////////////////////////////////////////
 //////////////////////////////////////////////
-
-
-
 //////////////////////////////////////////////
 //////////////////////////////////////////////
 /////////// Task Manager /////////////////////
@@ -489,68 +954,123 @@ void* worker_thread(void* arg)
   assert(arg != NULL);
 
   task_thread_args_t* args = (task_thread_args_t*)arg; 
-  int const idx = args->idx;
+  uint32_t const idx = args->idx;
   task_manager_t* man = args->man;
+  free(args);
 
-  uint32_t const len = man->len_thr;
-  int const num_it = 3*(man->len_thr + idx); 
-
-  not_q_t* q_arr = (not_q_t*)man->q_arr;
-  ret_try_t ret = {.success = false}; 
-  for(;;){
-    for(int i = idx; i < num_it; ++i){
-      ret = try_pop_not_q(&q_arr[i%len]);
-      if(ret.success == true){
-        break;
-      } 
+  cur_worker.man = man;
+  cur_worker.idx = idx;
+
+  worker_t* w = &((worker_t*)man->q_arr)[idx];
+  uint32_t idle = 0;
+  while(atomic_load_explicit(&man->stop, memory_order_relaxed) == false){
+    task_t t = {0};
+    if(try_pop_worker(w, &t) == true
+        || steal_task_manager(man, idx, &t) == true
+        || try_pop_overflow(man, &t) == true){
+      t.func(t.args);
+      idle = 0;
+      continue;
     }
 
-    if(ret.success == false && pop_not_q(&q_arr[idx], &ret) == false)
-      break;
-    
-    for(int i =0; i < ret.len; ++i )
-      ret.t[i].func(ret.t[i].args); 
+    // Spin, then yield the CPU, then sleep until a task arrives
+    idle += 1;
+    if(idle <= man->conf.spin){
+      cpu_relax();
+    } else if(idle <= man->conf.spin + man->conf.yield){
+      sched_yield();
+    } else {
+      park_worker(man, w);
+      idle = 0;
+    }
   }
 
-  free(args);
   return NULL;
 }
 
+static
+void pin_worker(pthread_t t, int cpu)
+{
+  assert(cpu > -1 && cpu < CPU_SETSIZE);
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  int const rc = pthread_setaffinity_np(t, sizeof(set), &set);
+  if(rc != 0)
+    printf("[TASK MANAGER]: Worker not pinned to CPU %d: %s \n", cpu, strerror(rc));
+}
+
 void init_task_manager(task_manager_t* man, uint32_t num_threads)
+{
+  task_man_conf_t const conf = {.spin = TASK_MAN_SPIN_DEFAULT, 
+                                .yield = TASK_MAN_YIELD_DEFAULT};
+  init_conf_task_manager(man, num_threads, conf);
+}
+
+void init_conf_task_manager(task_manager_t* man, uint32_t num_threads, task_man_conf_t conf)
 {
   assert(man != NULL);
-  assert(num_threads > 0 && num_threads < 33 && "Do you have zero or more than 32 processors??");
+  assert(num_threads > 0 && num_threads <= TASK_MAN_MAX_THREADS);
 
-  man->q_arr = calloc(num_threads, sizeof(not_q_t));
+  man->conf = conf;
+  // Not valid after init
+  man->conf.cpus = NULL;
+  atomic_init(&man->parked, 0);
+  atomic_init(&man->stop, false);
+
+  man->q_arr = calloc(num_threads, sizeof(worker_t));
   assert(man->q_arr != NULL && "Memory exhausted");
    
-  not_q_t* q_arr = (not_q_t*)man->q_arr;
+  worker_t* w_arr = (worker_t*)man->q_arr;
 
   for(uint32_t i = 0; i < num_threads; ++i){
-    init_not_q(&q_arr[i]);   
+    init_worker(&w_arr[i]);   
   }
 
   man->t_arr = calloc(num_threads, sizeof(pthread_t));
   assert(man->t_arr != NULL && "Memory exhausted" );
   man->len_thr = num_threads;
 
+  man->index = 0;
+
+  man->overflow = calloc(1, sizeof(seq_ring_t));
+  assert(man->overflow != NULL && "Memory exhausted");
+  seq_ring_init_cap(man->overflow, sizeof(task_t), 16);
+  atomic_init(&man->len_overflow, 0);
+
+  int rc = pthread_mutex_init(&man->overflow_mtx, NULL);
+  assert(rc == 0);
+
+  man->strands = calloc(1, sizeof(assoc_ht_open_t));
+  assert(man->strands != NULL && "Memory exhausted");
+  assoc_ht_open_init(man->strands, sizeof(uint64_t), cmp_key_strand, free_key_strand);
+
+  rc = pthread_mutex_init(&man->strand_mtx, NULL);
+  assert(rc == 0);
+
   for(uint32_t i = 0; i < num_threads; ++i){
     task_thread_args_t* args = malloc(sizeof(task_thread_args_t) ); 
+    assert(args != NULL && "Memory exhausted");
     args->idx = i;
     args->man = man;
 
-    int rc = pthread_create(&man->t_arr[i], NULL, worker_thread, args);
+    rc = pthread_create(&man->t_arr[i], NULL, worker_thread, args);
     assert(rc == 0);
-  }
 
-  man->index = 0;
+    if(conf.len_cpus > 0)
+      pin_worker(man->t_arr[i], conf.cpus[i % conf.len_cpus]);
+  }
 }
 
 void free_task_manager(task_manager_t* man, void (*clean)(void*))
 {
-  not_q_t* q_arr = (not_q_t*)man->q_arr;
+  atomic_store(&man->stop, true);
+
+  worker_t* w_arr = (worker_t*)man->q_arr;
   for(uint32_t i = 0; i < man->len_thr; ++i){
-    done_not_q(&q_arr[i]);
+    wake_worker(&w_arr[i]);
   }
 
   for(uint32_t i = 0; i < man->len_thr; ++i){
@@ -558,9 +1078,28 @@ void free_task_manager(task_manager_t* man, void (*clean)(void*))
   }
 
   for(uint32_t i = 0; i < man->len_thr; ++i){
-    free_not_q(&q_arr[i], clean); 
+    free_worker(&w_arr[i], clean); 
   }
 
+  task_t t = {0};
+  while(try_pop_overflow(man, &t) == true){
+    if(clean != NULL && t.func != run_strand)
+      clean(&t);
+  }
+  seq_ring_free(man->overflow, NULL);
+  free(man->overflow);
+
+  int rc = pthread_mutex_destroy(&man->overflow_mtx);
+  assert(rc == 0);
+
+  // Pending keyed tasks
+  man->clean = clean;
+  assoc_ht_open_free(man->strands);
+  free(man->strands);
+
+  rc = pthread_mutex_destroy(&man->strand_mtx);
+  assert(rc == 0);
+
   free(man->q_arr);
 
   free(man->t_arr);
@@ -573,18 +1112,47 @@ void async_task_manager(task_manager_t* man, task_t t)
   assert(t.func != NULL);
   //assert(t.args != NULL);
 
-  uint64_t const index = man->index++;
-//  atomic_fetch_add_explicit(&man->index, 1, memory_order_relaxed);
-
-  not_q_t* q_arr = (not_q_t*)man->q_arr;
-  for(uint32_t i = 0; i < man->len_thr; ++i){
-    if(try_push_not_q(&q_arr[(i+index) % man->len_thr], t)){
-      return;
-    }
+  // Submitted from a task. Stays in the worker, unless stolen
+  if(cur_worker.man == man){
+    push_cl_deque(&((worker_t*)man->q_arr)[cur_worker.idx].dq, t);
+    notify_task_manager(man, cur_worker.idx);
+    return;
   }
 
-  push_not_q(&q_arr[index%man->len_thr], t);
+  uint64_t const index = atomic_fetch_add_explicit(&man->index, 1, memory_order_relaxed);
+  push_inbox_task_manager(man, index % man->len_thr, t);
 }
 
-#undef DEFAULT_ELM 
+void async_key_task_manager(task_manager_t* man, uint64_t key, task_t t)
+{
+  assert(man != NULL);
+  assert(man->len_thr > 0);
+  assert(t.func != NULL);
+
+  int rc = pthread_mutex_lock(&man->strand_mtx);
+  assert(rc == 0);
+
+  strand_t* s = get_strand(man, key);
+
+  rc = pthread_mutex_lock(&s->mtx);
+  assert(rc == 0);
+
+  seq_ring_push_back(&s->q, (uint8_t*)&t, sizeof(task_t));
+  bool const idle = s->scheduled == false;
+  s->scheduled = true;
+
+  rc = pthread_mutex_unlock(&s->mtx);
+  assert(rc == 0);
+
+  rc = pthread_mutex_unlock(&man->strand_mtx);
+  assert(rc == 0);
+
+  // Otherwise, the running/queued run_strand will reach it
+  if(idle)
+    schedule_strand(man, s);
+}
 
+#undef STRAND_QUOTA
+#undef OVERLOAD_SLACK
+#undef INBOX_CAP
+#undef CL_DEQUE_INIT_CAP
@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include <pthread.h>
 #include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef struct{
@@ -34,18 +35,55 @@ typedef struct{
   void (*func)(void* args);
 } task_t;
 
+// Idle rounds over the queues before yielding the CPU
+#define TASK_MAN_SPIN_DEFAULT 128
+// Idle rounds, yielding the CPU, before parking the worker
+#define TASK_MAN_YIELD_DEFAULT 16
+
+#define TASK_MAN_MAX_THREADS 1024
+
+typedef struct{
+  uint32_t spin;
+  uint32_t yield;
+  // Worker i is pinned to cpus[i % len_cpus]. Not pinned if len_cpus == 0.
+  // Only read during init
+  int const* cpus;
+  size_t len_cpus;
+} task_man_conf_t;
+
 typedef struct{
   pthread_t* t_arr;
   size_t len_thr;
   atomic_uint_fast64_t index;
+  // One Chase-Lev deque plus one inbox per worker
   void* q_arr;
+
+  task_man_conf_t conf;
+  atomic_uint parked;
+  atomic_bool stop;
+
+  // Tasks from non worker threads that found all the inboxes full
+  void* overflow;
+  pthread_mutex_t overflow_mtx;
+  atomic_size_t len_overflow;
+
+  // key -> strand, for the keyed tasks
+  void* strands;
+  pthread_mutex_t strand_mtx;
+  void (*clean)(void* args);
 } task_manager_t;
 
 void init_task_manager(task_manager_t* man, uint32_t num_threads);
 
+void init_conf_task_manager(task_manager_t* man, uint32_t num_threads, task_man_conf_t conf);
+
 void free_task_manager(task_manager_t* man, void (*clean)(void* args) );
 
 void async_task_manager(task_manager_t* man, task_t t);
 
+// Tasks with the same key run one after the other, in submission order.
+// A key sticks to the same worker unless that worker gets overloaded
+void async_key_task_manager(task_manager_t* man, uint64_t key, task_t t);
+
 #endif
 
@@ -0,0 +1,629 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "task_manager.h"
+#include "../assoc_container/assoc_ht_open_address.h"
+
+static
+int64_t now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+// False if *val did not reach target within ms
+static
+bool wait_until(atomic_size_t* val, size_t target, int64_t ms)
+{
+  int64_t const end = now_ms() + ms;
+  while(atomic_load(val) != target){
+    if(now_ms() > end)
+      return false;
+    usleep(100);
+  }
+  return true;
+}
+
+static
+size_t num_strands(task_manager_t* man)
+{
+  int rc = pthread_mutex_lock(&man->strand_mtx);
+  assert(rc == 0);
+  size_t const sz = assoc_ht_open_size(man->strands);
+  rc = pthread_mutex_unlock(&man->strand_mtx);
+  assert(rc == 0);
+  return sz;
+}
+
+// The drained strands are freed once their last task returns
+static
+void wait_no_strands(task_manager_t* man)
+{
+  int64_t const end = now_ms() + 5000;
+  while(num_strands(man) != 0){
+    assert(now_ms() < end && "Drained strand not freed");
+    usleep(100);
+  }
+}
+
+//////////////////////////////
+// Keyed tasks
+//////////////////////////////
+
+#define NUM_KEYS 8
+#define NUM_PRODUCERS 4
+#define NUM_KEY_TASKS 2000
+
+typedef struct{
+  // Tasks of the same key never overlap
+  atomic_int running;
+  // Next sequence number expected from every producer
+  uint32_t next[NUM_PRODUCERS];
+  atomic_size_t done;
+} key_state_t;
+
+typedef struct{
+  key_state_t* ks;
+  uint32_t prod;
+  uint32_t seq;
+} key_task_t;
+
+static
+void run_key_task(void* arg)
+{
+  key_task_t* kt = (key_task_t*)arg;
+  key_state_t* ks = kt->ks;
+
+  int const running = atomic_fetch_add(&ks->running, 1);
+  assert(running == 0 && "Tasks of the same key overlapped");
+
+  assert(ks->next[kt->prod] == kt->seq && "Tasks of the same key out of order");
+  ks->next[kt->prod] += 1;
+
+  atomic_fetch_sub(&ks->running, 1);
+  atomic_fetch_add(&ks->done, 1);
+  free(kt);
+}
+
+static
+void submit_key_task(task_manager_t* man, key_state_t* ks, uint64_t key, uint32_t prod, uint32_t seq)
+{
+  key_task_t* kt = malloc(sizeof(key_task_t));
+  assert(kt != NULL);
+  *kt = (key_task_t){.ks = ks, .prod = prod, .seq = seq};
+  task_t const t = {.args = kt, .func = run_key_task};
+  async_key_task_manager(man, key, t);
+}
+
+typedef struct{
+  task_manager_t* man;
+  key_state_t* ks;
+  uint32_t prod;
+} producer_t;
+
+static
+void* producer(void* arg)
+{
+  producer_t* p = (producer_t*)arg;
+  unsigned seed = p->prod + 1;
+
+  for(uint32_t seq = 0; seq < NUM_KEY_TASKS; ++seq){
+    for(uint64_t k = 0; k < NUM_KEYS; ++k)
+      submit_key_task(p->man, &p->ks[k], k, p->prod, seq);
+
+    // Let some strands drain, so that they are freed and created again
+    if(rand_r(&seed) % 64 == 0)
+      usleep(rand_r(&seed) % 500);
+  }
+  return NULL;
+}
+
+// Interleaved keys from several threads run in submission order per key,
+// one at a time, and a drained strand is freed and then created again
+static
+void test_key_fifo(void)
+{
+  task_manager_t man = {0};
+  init_task_manager(&man, 4);
+
+  key_state_t ks[NUM_KEYS] = {0};
+
+  pthread_t t[NUM_PRODUCERS];
+  producer_t p[NUM_PRODUCERS];
+  for(uint32_t i = 0; i < NUM_PRODUCERS; ++i){
+    p[i] = (producer_t){.man = &man, .ks = ks, .prod = i};
+    int const rc = pthread_create(&t[i], NULL, producer, &p[i]);
+    assert(rc == 0);
+  }
+  for(uint32_t i = 0; i < NUM_PRODUCERS; ++i){
+    int const rc = pthread_join(t[i], NULL);
+    assert(rc == 0);
+  }
+
+  for(size_t k = 0; k < NUM_KEYS; ++k){
+    bool const ok = wait_until(&ks[k].done, NUM_PRODUCERS*NUM_KEY_TASKS, 30000);
+    assert(ok && "Keyed tasks lost");
+  }
+  wait_no_strands(&man);
+
+  // Same keys again, on new strands
+  for(uint32_t seq = NUM_KEY_TASKS; seq < 2*NUM_KEY_TASKS; ++seq){
+    for(uint64_t k = 0; k < NUM_KEYS; ++k)
+      submit_key_task(&man, &ks[k], k, 0, seq);
+  }
+  for(size_t k = 0; k < NUM_KEYS; ++k){
+    bool const ok = wait_until(&ks[k].done, (NUM_PRODUCERS + 1)*NUM_KEY_TASKS, 30000);
+    assert(ok && "Keyed tasks lost");
+  }
+  wait_no_strands(&man);
+
+  free_task_manager(&man, NULL);
+}
+
+typedef struct{
+  atomic_bool open;
+  atomic_size_t started;
+  atomic_size_t done;
+  // Written by wait_gate_who, before started is incremented
+  pthread_t who;
+} gate_t;
+
+static
+void wait_gate(void* arg)
+{
+  gate_t* g = (gate_t*)arg;
+  atomic_fetch_add(&g->started, 1);
+  while(atomic_load(&g->open) == false)
+    usleep(100);
+  atomic_fetch_add(&g->done, 1);
+}
+
+static
+void wait_gate_who(void* arg)
+{
+  gate_t* g = (gate_t*)arg;
+  g->who = pthread_self();
+  wait_gate(arg);
+}
+
+// Same Fibonacci hashing as the task manager
+static
+uint32_t home_worker(uint64_t key, uint32_t len_thr)
+{
+  return ((key * 11400714819323198485llu) >> 32) % len_thr;
+}
+
+static
+uint64_t next_key_home(uint64_t key, uint32_t home, uint32_t len_thr)
+{
+  while(home_worker(key, len_thr) != home)
+    key += 1;
+  return key;
+}
+
+#define NUM_HOT_TASKS 300
+// Overloaded (i.e., more than 64 queued), but none of them is moved away
+// by the same rule, as then they would also block the idle worker
+#define NUM_FILLERS 65
+
+// The home worker of a hot key is stuck and its queue keeps growing. When
+// its quota runs out, the hot strand moves to the idle worker instead of
+// queueing behind tasks that will not finish soon
+static
+void test_key_rebalance(void)
+{
+  task_manager_t man = {0};
+  init_task_manager(&man, 2);
+
+  gate_t stuck = {0};
+  gate_t first = {0};
+
+  // One worker blocked. The other one may have stolen the task
+  uint64_t key = 1;
+  async_key_task_manager(&man, key, (task_t){.args = &stuck, .func = wait_gate_who});
+  bool ok = wait_until(&stuck.started, 1, 5000);
+  assert(ok);
+  uint32_t const busy = pthread_equal(stuck.who, man.t_arr[0]) ? 0 : 1;
+
+  // The hot key, at home in the blocked worker, is stolen by the other one.
+  // Its first task keeps it there until the blocked worker is overloaded
+  uint64_t const hot = next_key_home(key + 1, busy, 2);
+  key_state_t ks = {0};
+  async_key_task_manager(&man, hot, (task_t){.args = &first, .func = wait_gate});
+  for(uint32_t seq = 0; seq < NUM_HOT_TASKS; ++seq)
+    submit_key_task(&man, &ks, hot, 0, seq);
+  ok = wait_until(&first.started, 1, 5000);
+  assert(ok);
+
+  // Whoever runs them stays blocked. Without the move, the idle worker
+  // would steal one of them before the hot strand, queued behind them
+  key = hot;
+  for(size_t i = 0; i < NUM_FILLERS; ++i){
+    key = next_key_home(key + 1, busy, 2);
+    async_key_task_manager(&man, key, (task_t){.args = &stuck, .func = wait_gate});
+  }
+
+  atomic_store(&first.open, true);
+  ok = wait_until(&ks.done, NUM_HOT_TASKS, 10000);
+  assert(ok && "Hot key not moved away from its overloaded worker");
+
+  atomic_store(&stuck.open, true);
+  ok = wait_until(&stuck.done, 1 + NUM_FILLERS, 10000);
+  assert(ok);
+  wait_no_strands(&man);
+
+  free_task_manager(&man, NULL);
+}
+
+//////////////////////////////
+// Work stealing
+//////////////////////////////
+
+#define NUM_STEAL_ROUNDS 20
+#define NUM_SUBTASKS 2000
+
+typedef struct{
+  task_manager_t* man;
+  atomic_uint hits[NUM_SUBTASKS];
+  // Workers that ran a subtask, as a bitmask
+  atomic_uint_fast64_t thieves;
+  atomic_size_t done;
+  atomic_size_t root_done;
+} steal_state_t;
+
+typedef struct{
+  steal_state_t* st;
+  uint32_t idx;
+} subtask_t;
+
+static
+uint32_t worker_idx(task_manager_t* man)
+{
+  for(uint32_t i = 0; i < man->len_thr; ++i){
+    if(pthread_equal(man->t_arr[i], pthread_self()))
+      return i;
+  }
+  assert(0 != 0 && "Task not run by a worker");
+  return 0;
+}
+
+static
+void run_subtask(void* arg)
+{
+  subtask_t* sub = (subtask_t*)arg;
+  steal_state_t* st = sub->st;
+
+  // Some work, so that the thieves overlap
+  volatile uint32_t x = 0;
+  for(uint32_t i = 0; i < 1000; ++i)
+    x += i;
+
+  atomic_fetch_add(&st->hits[sub->idx], 1);
+  atomic_fetch_or(&st->thieves, 1llu << worker_idx(st->man));
+  atomic_fetch_add(&st->done, 1);
+  free(sub);
+}
+
+// Pushes the subtasks into its own deque, and does not return until they
+// finished. Hence, only the thieves can run them
+static
+void run_root(void* arg)
+{
+  steal_state_t* st = (steal_state_t*)arg;
+
+  for(uint32_t i = 0; i < NUM_SUBTASKS; ++i){
+    subtask_t* sub = malloc(sizeof(subtask_t));
+    assert(sub != NULL);
+    *sub = (subtask_t){.st = st, .idx = i};
+    async_task_manager(st->man, (task_t){.args = sub, .func = run_subtask});
+  }
+
+  bool const ok = wait_until(&st->done, NUM_SUBTASKS, 10000);
+  assert(ok && "Subtasks not stolen");
+
+  uint64_t const owner = 1llu << worker_idx(st->man);
+  assert((atomic_load(&st->thieves) & owner) == 0);
+  atomic_fetch_add(&st->root_done, 1);
+}
+
+typedef struct{
+  task_manager_t* man;
+  atomic_bool stop;
+  atomic_size_t submitted;
+  atomic_size_t done;
+} noise_t;
+
+static
+void run_noise(void* arg)
+{
+  noise_t* n = (noise_t*)arg;
+  atomic_fetch_add(&n->done, 1);
+}
+
+// Tasks into the inboxes, while the thieves fight over the same deque
+static
+void* noise_producer(void* arg)
+{
+  noise_t* n = (noise_t*)arg;
+  while(atomic_load(&n->stop) == false){
+    atomic_fetch_add(&n->submitted, 1);
+    async_task_manager(n->man, (task_t){.args = n, .func = run_noise});
+    usleep(10);
+  }
+  return NULL;
+}
+
+// Every task pushed into one deque runs exactly once, although several
+// thieves and the inbox producers compete for it
+static
+void test_steal_contention(void)
+{
+  task_manager_t man = {0};
+  init_task_manager(&man, 4);
+
+  noise_t noise = {.man = &man};
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, noise_producer, &noise);
+  assert(rc == 0);
+
+  uint64_t thieves = 0;
+  for(int r = 0; r < NUM_STEAL_ROUNDS; ++r){
+    steal_state_t* st = calloc(1, sizeof(steal_state_t));
+    assert(st != NULL);
+    st->man = &man;
+
+    async_task_manager(&man, (task_t){.args = st, .func = run_root});
+    bool const ok = wait_until(&st->root_done, 1, 20000);
+    assert(ok);
+
+    for(uint32_t i = 0; i < NUM_SUBTASKS; ++i)
+      assert(atomic_load(&st->hits[i]) == 1 && "Subtask lost or run twice");
+
+    thieves |= atomic_load(&st->thieves);
+    free(st);
+  }
+  // More than one thief took from the same deque
+  assert(__builtin_popcountll(thieves) > 1);
+
+  atomic_store(&noise.stop, true);
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+  bool const ok = wait_until(&noise.done, atomic_load(&noise.submitted), 10000);
+  assert(ok && "Inbox tasks lost");
+
+  free_task_manager(&man, NULL);
+}
+
+//////////////////////////////
+// Parking
+//////////////////////////////
+
+#define NUM_PARK_ROUNDS 20000
+
+static
+bool wait_parked(task_manager_t* man, int64_t ms)
+{
+  int64_t const end = now_ms() + ms;
+  while(atomic_load(&man->parked) != man->len_thr){
+    if(now_ms() > end)
+      return false;
+    usleep(100);
+  }
+  return true;
+}
+
+static
+void run_count(void* arg)
+{
+  atomic_fetch_add((atomic_size_t*)arg, 1);
+}
+
+typedef struct{
+  atomic_size_t done;
+  task_manager_t* man;
+} chain_t;
+
+// Submits from a worker, right before it parks
+static
+void run_count_chain(void* arg)
+{
+  chain_t* c = (chain_t*)arg;
+  atomic_fetch_add(&c->done, 1);
+  async_task_manager(c->man, (task_t){.args = &c->done, .func = run_count});
+}
+
+// Workers park without spinning, so every submission races with a worker
+// going to sleep. No task may be left behind with all the workers parked
+static
+void test_no_lost_wakeup(void)
+{
+  task_manager_t man = {0};
+  task_man_conf_t const conf = {.spin = 0, .yield = 0};
+  init_conf_task_manager(&man, 2, conf);
+
+  unsigned seed = 42;
+  chain_t c = {.man = &man};
+  size_t expected = 0;
+  for(int r = 0; r < NUM_PARK_ROUNDS; ++r){
+    // Fully parked, or somewhere on its way to park
+    if(r % 64 == 0){
+      bool const ok = wait_parked(&man, 5000);
+      assert(ok && "Idle workers not parked");
+    } else {
+      for(volatile uint32_t i = rand_r(&seed) % 4096; i > 0; --i)
+        ;
+    }
+
+    if(r % 2 == 0){
+      async_task_manager(&man, (task_t){.args = &c.done, .func = run_count});
+      expected += 1;
+    } else {
+      async_task_manager(&man, (task_t){.args = &c, .func = run_count_chain});
+      expected += 2;
+    }
+
+    // Without sleeping, to submit again as soon as the worker goes idle
+    int64_t const end = now_ms() + 2000;
+    while(atomic_load(&c.done) != expected)
+      assert(now_ms() < end && "Lost wakeup");
+  }
+
+  free_task_manager(&man, NULL);
+}
+
+// Parked workers do not burn CPU
+static
+void test_idle_cpu(void)
+{
+  task_manager_t man = {0};
+  init_task_manager(&man, 4);
+
+  atomic_size_t done = 0;
+  async_task_manager(&man, (task_t){.args = &done, .func = run_count});
+  bool ok = wait_until(&done, 1, 5000);
+  assert(ok);
+
+  // Spin plus yield rounds, and then parked
+  ok = wait_parked(&man, 5000);
+  assert(ok && "Idle workers not parked");
+
+  struct timespec start, stop;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+  usleep(200*1000);
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &stop);
+
+  int64_t const cpu_us = (stop.tv_sec - start.tv_sec)*1000000 + (stop.tv_nsec - start.tv_nsec)/1000;
+  assert(cpu_us < 20*1000 && "Idle workers burning CPU");
+  assert(atomic_load(&man.parked) == man.len_thr);
+
+  free_task_manager(&man, NULL);
+}
+
+//////////////////////////////
+// Shutdown
+//////////////////////////////
+
+// More than the inboxes of two workers hold, so some of them overflow
+#define NUM_QUEUED 70000
+#define NUM_QUEUED_KEYS 4
+#define NUM_QUEUED_KEY_TASKS 1000
+
+static atomic_size_t executed;
+static atomic_size_t cleaned;
+
+static
+void run_queued(void* arg)
+{
+  atomic_fetch_add(&executed, 1);
+  free(arg);
+}
+
+static
+void clean_queued(void* arg)
+{
+  task_t* t = (task_t*)arg;
+  assert(t->func == run_queued);
+  atomic_fetch_add(&cleaned, 1);
+  free(t->args);
+}
+
+static
+void* free_man_thread(void* arg)
+{
+  free_task_manager((task_manager_t*)arg, clean_queued);
+  return NULL;
+}
+
+// Stopped with tasks in the deques, inboxes, overflow and strands. Each
+// one either runs or is handed to clean, once
+static
+void test_shutdown_queued(void)
+{
+  task_manager_t man = {0};
+  init_task_manager(&man, 2);
+
+  gate_t g = {0};
+  for(int i = 0; i < 2; ++i)
+    async_task_manager(&man, (task_t){.args = &g, .func = wait_gate});
+  bool ok = wait_until(&g.started, 2, 5000);
+  assert(ok);
+
+  size_t submitted = 0;
+  for(size_t i = 0; i < NUM_QUEUED; ++i){
+    int* arg = malloc(sizeof(int));
+    assert(arg != NULL);
+    async_task_manager(&man, (task_t){.args = arg, .func = run_queued});
+    submitted += 1;
+  }
+  for(size_t i = 0; i < NUM_QUEUED_KEY_TASKS; ++i){
+    for(uint64_t k = 0; k < NUM_QUEUED_KEYS; ++k){
+      int* arg = malloc(sizeof(int));
+      assert(arg != NULL);
+      async_key_task_manager(&man, k, (task_t){.args = arg, .func = run_queued});
+      submitted += 1;
+    }
+  }
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, free_man_thread, &man);
+  assert(rc == 0);
+
+  int64_t const end = now_ms() + 5000;
+  while(atomic_load(&man.stop) == false){
+    assert(now_ms() < end);
+    usleep(100);
+  }
+  atomic_store(&g.open, true);
+
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  assert(atomic_load(&g.done) == 2);
+  assert(atomic_load(&executed) + atomic_load(&cleaned) == submitted && "Queued task lost");
+}
+
+int main()
+{
+  test_steal_contention();
+  test_no_lost_wakeup();
+  test_idle_cpu();
+  test_shutdown_queued();
+
+  test_key_fifo();
+  test_key_rebalance();
+
+  printf("Task manager test succeeded\n");
+  return EXIT_SUCCESS;
+}
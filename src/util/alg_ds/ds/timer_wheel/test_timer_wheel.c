@@ -0,0 +1,182 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timer_wheel.h"
+
+#define NUM_TIMERS 1024
+
+typedef struct{
+  int id;
+  uint64_t expiry;
+  uint64_t interval;
+  bool active;
+} ref_timer_t;
+
+static
+ref_timer_t ref[NUM_TIMERS];
+
+static
+int find_ref(int id)
+{
+  for(int i = 0; i < NUM_TIMERS; ++i)
+    if(ref[i].active == true && ref[i].id == id)
+      return i;
+  return -1;
+}
+
+static
+void test_one_shot(void)
+{
+  timer_wheel_t tw = {0};
+  init_timer_wheel(&tw, 1000);
+
+  int const id = arm_timer_wheel(&tw, 1000, 3000, 0);
+  assert(id > 0);
+  assert(size_timer_wheel(&tw) == 1);
+
+  // The cascade may wake us up before the expiry, but never after
+  assert(next_tick_timer_wheel(&tw) <= 4000);
+
+  int out[8] = {0};
+  advance_timer_wheel(&tw, 3999);
+  assert(pop_expired_timer_wheel(&tw, 3999, 8, out) == 0);
+
+  advance_timer_wheel(&tw, 4000);
+  assert(pop_expired_timer_wheel(&tw, 4000, 8, out) == 1);
+  assert(out[0] == id);
+  assert(size_timer_wheel(&tw) == 0);
+  assert(next_tick_timer_wheel(&tw) == UINT64_MAX);
+
+  // Stale id
+  assert(cancel_timer_wheel(&tw, id) == false);
+
+  free_timer_wheel(&tw);
+}
+
+static
+void test_cancel_and_periodic(void)
+{
+  timer_wheel_t tw = {0};
+  init_timer_wheel(&tw, 0);
+
+  int const a = arm_timer_wheel(&tw, 0, 100, 100);
+  int const b = arm_timer_wheel(&tw, 0, 100, 0);
+  assert(cancel_timer_wheel(&tw, b) == true);
+  assert(cancel_timer_wheel(&tw, b) == false);
+
+  int out[8] = {0};
+  for(uint64_t t = 100; t <= 1000; t += 100){
+    advance_timer_wheel(&tw, t);
+    assert(pop_expired_timer_wheel(&tw, t, 8, out) == 1);
+    assert(out[0] == a);
+  }
+
+  assert(cancel_timer_wheel(&tw, a) == true);
+  assert(size_timer_wheel(&tw) == 0);
+
+  free_timer_wheel(&tw);
+}
+
+// Compare against a brute force list with random arms, cancels and steps
+static
+void test_random(void)
+{
+  srand(42);
+
+  timer_wheel_t tw = {0};
+  uint64_t now = 12345;
+  init_timer_wheel(&tw, now);
+
+  for(int iter = 0; iter < 50000; ++iter){
+    int const op = rand() % 10;
+    if(op < 4){
+      int i = rand() % NUM_TIMERS;
+      if(ref[i].active == false){
+        uint64_t const initial = (rand() % 4) == 0 ? 1 + (uint64_t)rand() % 300000 : 1 + (uint64_t)rand() % 5000;
+        uint64_t const interval = (rand() % 2) == 0 ? 0 : 1 + (uint64_t)rand() % 3000;
+        ref[i].id = arm_timer_wheel(&tw, now, initial, interval);
+        ref[i].expiry = now + initial;
+        ref[i].interval = interval;
+        ref[i].active = true;
+      }
+    } else if(op < 6){
+      int i = rand() % NUM_TIMERS;
+      if(ref[i].active == true){
+        assert(cancel_timer_wheel(&tw, ref[i].id) == true);
+        ref[i].active = false;
+      }
+    } else {
+      uint64_t const next = next_tick_timer_wheel(&tw);
+      now += 1 + rand() % 700;
+
+      for(int i = 0; i < NUM_TIMERS; ++i){
+        if(ref[i].active == true && ref[i].expiry <= now)
+          assert(next <= ref[i].expiry);
+      }
+
+      advance_timer_wheel(&tw, now);
+      int out[NUM_TIMERS];
+      size_t const sz = pop_expired_timer_wheel(&tw, now, NUM_TIMERS, out);
+
+      size_t expected = 0;
+      for(int i = 0; i < NUM_TIMERS; ++i)
+        expected += ref[i].active == true && ref[i].expiry <= now;
+      assert(sz == expected);
+
+      for(size_t j = 0; j < sz; ++j){
+        int const i = find_ref(out[j]);
+        assert(i > -1);
+        assert(ref[i].expiry <= now);
+        if(ref[i].interval > 0)
+          ref[i].expiry = now + ref[i].interval;
+        else
+          ref[i].active = false;
+      }
+    }
+
+    size_t active = 0;
+    for(int i = 0; i < NUM_TIMERS; ++i)
+      active += ref[i].active;
+    assert(active == size_timer_wheel(&tw));
+  }
+
+  free_timer_wheel(&tw);
+}
+
+int main()
+{
+  test_one_shot();
+  test_cancel_and_periodic();
+  test_random();
+
+  printf("Timer wheel test passed\n");
+  return 0;
+}
+
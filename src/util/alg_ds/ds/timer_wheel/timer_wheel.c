@@ -0,0 +1,364 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "timer_wheel.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Timer id = generation << TW_IDX_BITS | (index + 1)
+#define TW_IDX_BITS 20
+#define TW_GEN_MASK 0x7FF
+#define TW_NIL UINT32_MAX
+#define TW_LVL_READY TW_LEVELS
+#define TW_LVL_FREE 0xFF
+#define TW_MASK (TW_SLOTS - 1)
+
+static inline
+uint64_t rotr_64(uint64_t x, uint32_t n)
+{
+  n &= 63;
+  if(n == 0)
+    return x;
+  return (x >> n) | (x << (64 - n));
+}
+
+static
+void enlarge_nodes(timer_wheel_t* tw)
+{
+  assert(tw != NULL);
+  assert(tw->free_head == TW_NIL);
+
+  uint32_t const new_cap = tw->cap == 0 ? 64 : 2*tw->cap;
+  assert(new_cap < (1u << TW_IDX_BITS) && "Too many timers armed");
+
+  tw_node_t* tmp = realloc(tw->nodes, new_cap * sizeof(tw_node_t));
+  assert(tmp != NULL && "Memory exhausted");
+  tw->nodes = tmp;
+
+  for(uint32_t i = tw->cap; i < new_cap; ++i){
+    tw_node_t* n = &tw->nodes[i];
+    memset(n, 0, sizeof(tw_node_t));
+    n->lvl = TW_LVL_FREE;
+    n->next = i + 1 == new_cap ? TW_NIL : i + 1;
+  }
+  tw->free_head = tw->cap;
+  tw->cap = new_cap;
+}
+
+static
+uint32_t alloc_node(timer_wheel_t* tw)
+{
+  if(tw->free_head == TW_NIL)
+    enlarge_nodes(tw);
+
+  uint32_t const idx = tw->free_head;
+  tw->free_head = tw->nodes[idx].next;
+  return idx;
+}
+
+static
+void release_node(timer_wheel_t* tw, uint32_t idx)
+{
+  tw_node_t* n = &tw->nodes[idx];
+  n->gen = (n->gen + 1) & TW_GEN_MASK;
+  n->lvl = TW_LVL_FREE;
+  n->prev = TW_NIL;
+  n->next = tw->free_head;
+  tw->free_head = idx;
+}
+
+static inline
+int node_id(timer_wheel_t const* tw, uint32_t idx)
+{
+  return (int)(((uint32_t)tw->nodes[idx].gen << TW_IDX_BITS) | (idx + 1));
+}
+
+static
+void link_slot(timer_wheel_t* tw, uint32_t idx)
+{
+  tw_node_t* n = &tw->nodes[idx];
+
+  uint64_t exp = n->expiry < tw->cur ? tw->cur : n->expiry;
+  uint64_t const delta = exp - tw->cur;
+
+  uint8_t lvl = 0;
+  while(lvl < TW_LEVELS - 1 && delta >= (1ull << (TW_LVL_BITS * (lvl + 1))))
+    ++lvl;
+
+  // Beyond the wheel horizon. Park it in the furthest slot, the cascade
+  // will reinsert it with its real expiry
+  uint64_t const horizon = 1ull << (TW_LVL_BITS * TW_LEVELS);
+  if(delta >= horizon)
+    exp = tw->cur + horizon - 1;
+
+  uint8_t const slot = (exp >> (TW_LVL_BITS * lvl)) & TW_MASK;
+
+  n->lvl = lvl;
+  n->slot = slot;
+  n->prev = TW_NIL;
+  n->next = tw->slot[lvl][slot];
+  if(n->next != TW_NIL)
+    tw->nodes[n->next].prev = idx;
+  tw->slot[lvl][slot] = idx;
+  tw->occupied[lvl] |= 1ull << slot;
+}
+
+static
+void link_ready(timer_wheel_t* tw, uint32_t idx)
+{
+  tw_node_t* n = &tw->nodes[idx];
+  n->lvl = TW_LVL_READY;
+  n->next = TW_NIL;
+  n->prev = tw->ready_tail;
+  if(tw->ready_tail != TW_NIL)
+    tw->nodes[tw->ready_tail].next = idx;
+  else
+    tw->ready_head = idx;
+  tw->ready_tail = idx;
+  tw->ready += 1;
+}
+
+static
+void unlink_node(timer_wheel_t* tw, uint32_t idx)
+{
+  tw_node_t* n = &tw->nodes[idx];
+  assert(n->lvl != TW_LVL_FREE);
+
+  if(n->next != TW_NIL)
+    tw->nodes[n->next].prev = n->prev;
+
+  if(n->lvl == TW_LVL_READY){
+    if(n->prev != TW_NIL)
+      tw->nodes[n->prev].next = n->next;
+    else
+      tw->ready_head = n->next;
+    if(n->next == TW_NIL)
+      tw->ready_tail = n->prev;
+    tw->ready -= 1;
+  } else {
+    if(n->prev != TW_NIL)
+      tw->nodes[n->prev].next = n->next;
+    else
+      tw->slot[n->lvl][n->slot] = n->next;
+    if(tw->slot[n->lvl][n->slot] == TW_NIL)
+      tw->occupied[n->lvl] &= ~(1ull << n->slot);
+  }
+  n->prev = TW_NIL;
+  n->next = TW_NIL;
+}
+
+static
+uint32_t detach_slot(timer_wheel_t* tw, uint8_t lvl, uint8_t slot)
+{
+  uint32_t const head = tw->slot[lvl][slot];
+  tw->slot[lvl][slot] = TW_NIL;
+  tw->occupied[lvl] &= ~(1ull << slot);
+  return head;
+}
+
+static
+void cascade(timer_wheel_t* tw, uint8_t lvl, uint8_t slot)
+{
+  uint32_t idx = detach_slot(tw, lvl, slot);
+  while(idx != TW_NIL){
+    uint32_t const next = tw->nodes[idx].next;
+    link_slot(tw, idx);
+    idx = next;
+  }
+}
+
+static
+void expire_slot(timer_wheel_t* tw, uint8_t slot)
+{
+  uint32_t idx = detach_slot(tw, 0, slot);
+  while(idx != TW_NIL){
+    uint32_t const next = tw->nodes[idx].next;
+    link_ready(tw, idx);
+    idx = next;
+  }
+}
+
+void init_timer_wheel(timer_wheel_t* tw, uint64_t now)
+{
+  assert(tw != NULL);
+
+  memset(tw, 0, sizeof(timer_wheel_t));
+  for(int i = 0; i < TW_LEVELS; ++i)
+    for(int j = 0; j < TW_SLOTS; ++j)
+      tw->slot[i][j] = TW_NIL;
+
+  tw->free_head = TW_NIL;
+  tw->ready_head = TW_NIL;
+  tw->ready_tail = TW_NIL;
+  tw->cur = now;
+}
+
+void free_timer_wheel(timer_wheel_t* tw)
+{
+  assert(tw != NULL);
+  free(tw->nodes);
+  memset(tw, 0, sizeof(timer_wheel_t));
+}
+
+int arm_timer_wheel(timer_wheel_t* tw, uint64_t now, uint64_t initial, uint64_t interval)
+{
+  assert(tw != NULL);
+
+  // Nothing in the wheel, no need to walk the empty ticks
+  if(tw->armed == tw->ready && tw->cur < now)
+    tw->cur = now;
+
+  uint32_t const idx = alloc_node(tw);
+  tw_node_t* n = &tw->nodes[idx];
+  n->expiry = now + initial;
+  n->interval = interval;
+  link_slot(tw, idx);
+
+  tw->armed += 1;
+  return node_id(tw, idx);
+}
+
+bool cancel_timer_wheel(timer_wheel_t* tw, int id)
+{
+  assert(tw != NULL);
+  if(id <= 0)
+    return false;
+
+  uint32_t const idx = ((uint32_t)id & ((1u << TW_IDX_BITS) - 1)) - 1;
+  uint16_t const gen = ((uint32_t)id >> TW_IDX_BITS) & TW_GEN_MASK;
+  if(idx >= tw->cap)
+    return false;
+
+  tw_node_t* n = &tw->nodes[idx];
+  if(n->lvl == TW_LVL_FREE || n->gen != gen)
+    return false;
+
+  unlink_node(tw, idx);
+  release_node(tw, idx);
+  tw->armed -= 1;
+  return true;
+}
+
+void advance_timer_wheel(timer_wheel_t* tw, uint64_t now)
+{
+  assert(tw != NULL);
+
+  while(tw->cur <= now){
+    // Empty wheel. Jump directly to now
+    if(tw->armed == tw->ready){
+      tw->cur = now + 1;
+      break;
+    }
+
+    uint8_t const idx = tw->cur & TW_MASK;
+    if(idx == 0){
+      for(uint8_t lvl = 1; lvl < TW_LEVELS; ++lvl){
+        uint8_t const slot = (tw->cur >> (TW_LVL_BITS * lvl)) & TW_MASK;
+        cascade(tw, lvl, slot);
+        if(slot != 0)
+          break;
+      }
+    }
+
+    // Empty first level. Jump to the next cascade
+    if(tw->occupied[0] == 0){
+      uint64_t const next = (tw->cur | TW_MASK) + 1;
+      tw->cur = next <= now ? next : now + 1;
+      continue;
+    }
+
+    expire_slot(tw, idx);
+    tw->cur += 1;
+  }
+}
+
+size_t pop_expired_timer_wheel(timer_wheel_t* tw, uint64_t now, size_t len, int out[len])
+{
+  assert(tw != NULL);
+  assert(out != NULL || len == 0);
+
+  size_t i = 0;
+  while(i < len && tw->ready_head != TW_NIL){
+    uint32_t const idx = tw->ready_head;
+    out[i++] = node_id(tw, idx);
+
+    unlink_node(tw, idx);
+    tw_node_t* n = &tw->nodes[idx];
+    if(n->interval > 0){
+      n->expiry = now + n->interval;
+      link_slot(tw, idx);
+    } else {
+      release_node(tw, idx);
+      tw->armed -= 1;
+    }
+  }
+  return i;
+}
+
+uint64_t next_tick_timer_wheel(timer_wheel_t const* tw)
+{
+  assert(tw != NULL);
+
+  if(tw->ready > 0)
+    return 0;
+
+  uint64_t next = UINT64_MAX;
+  if(tw->armed == 0)
+    return next;
+
+  uint64_t const r = rotr_64(tw->occupied[0], tw->cur & TW_MASK);
+  if(r != 0)
+    next = tw->cur + __builtin_ctzll(r);
+
+  for(uint8_t lvl = 1; lvl < TW_LEVELS; ++lvl){
+    if(tw->occupied[lvl] == 0)
+      continue;
+
+    uint32_t const shift = TW_LVL_BITS * lvl;
+    uint64_t const base = tw->cur >> shift;
+    uint64_t r_lvl = rotr_64(tw->occupied[lvl], base & TW_MASK);
+
+    // The current slot is cascaded when processing cur only if cur is
+    // aligned, otherwise it holds the timers of the next round
+    bool const aligned = (tw->cur & ((1ull << shift) - 1)) == 0;
+    if(aligned == false)
+      r_lvl &= ~1ull;
+
+    uint64_t const off = r_lvl != 0 ? (uint64_t)__builtin_ctzll(r_lvl) : TW_SLOTS;
+    uint64_t const cand = (base + off) << shift;
+    if(cand < next)
+      next = cand;
+  }
+
+  return next;
+}
+
+size_t size_timer_wheel(timer_wheel_t const* tw)
+{
+  assert(tw != NULL);
+  return tw->armed;
+}
+
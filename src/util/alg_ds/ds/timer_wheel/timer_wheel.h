@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2022 Mikel Irazabal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef HIERARCHICAL_TIMER_WHEEL_MIR_H
+#define HIERARCHICAL_TIMER_WHEEL_MIR_H
+
+// Hierarchical timing wheel (Varghese & Lauck). Time is measured in ticks
+// and the caller decides what a tick is (e.g., 1 ms of CLOCK_MONOTONIC).
+// Arm and cancel are O(1). Advancing the wheel cascades the timers of the
+// upper levels into the lower ones when the lower level wraps around.
+// Not thread-safe, the caller has to serialize the accesses.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TW_LVL_BITS 6
+#define TW_SLOTS (1 << TW_LVL_BITS)
+#define TW_LEVELS 4
+
+typedef struct{
+  uint32_t prev;
+  uint32_t next;
+  uint64_t expiry;
+  uint64_t interval;
+  uint16_t gen;
+  uint8_t lvl;
+  uint8_t slot;
+} tw_node_t;
+
+typedef struct{
+  tw_node_t* nodes;
+  uint32_t cap;
+  uint32_t free_head;
+
+  uint32_t slot[TW_LEVELS][TW_SLOTS];
+  uint64_t occupied[TW_LEVELS];
+
+  // Expired timers not yet popped
+  uint32_t ready_head;
+  uint32_t ready_tail;
+  size_t ready;
+
+  // Next tick to process
+  uint64_t cur;
+  size_t armed;
+} timer_wheel_t;
+
+void init_timer_wheel(timer_wheel_t* tw, uint64_t now);
+
+void free_timer_wheel(timer_wheel_t* tw);
+
+// Returns a positive timer id. An interval of 0 ticks means one-shot timer
+int arm_timer_wheel(timer_wheel_t* tw, uint64_t now, uint64_t initial, uint64_t interval);
+
+// Returns false if the id was not armed (i.e., already fired or cancelled)
+bool cancel_timer_wheel(timer_wheel_t* tw, int id);
+
+// Moves the timers that expired up to now (included) into the ready list
+void advance_timer_wheel(timer_wheel_t* tw, uint64_t now);
+
+// Pops up to len expired timer ids. Periodic timers are re-armed
+size_t pop_expired_timer_wheel(timer_wheel_t* tw, uint64_t now, size_t len, int out[len]);
+
+// Tick at which the wheel needs to be advanced next, UINT64_MAX if nothing armed.
+// It can be earlier than the real expiry if a cascade is needed
+uint64_t next_tick_timer_wheel(timer_wheel_t const* tw);
+
+size_t size_timer_wheel(timer_wheel_t const* tw);
+
+#endif
+
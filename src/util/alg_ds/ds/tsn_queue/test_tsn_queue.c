@@ -33,73 +33,127 @@ SOFTWARE.
 
 #include "tsn_queue.h"
 
+#define NUM_PROD 4
+#define NUM_VAL 8192 
+#define CAP 64
+#define BATCH 32 
 
 typedef struct
 {
-  bool has_value;
-  uint8_t val[1024];
+  uint32_t prod;
   uint32_t n;
 } val_t;
 
 static
-pthread_t t;
+void* producer_thread(void* arg)
+{
+  tsnq_t* q = (tsnq_t*)arg;
+
+  static _Atomic uint32_t id = 0;
+  uint32_t const prod = id++;
+
+  for(uint32_t i = 0; i < NUM_VAL; ++i){
+    val_t v = {.prod = prod, .n = i};
+    bool const pushed = push_tsnq(q, &v, sizeof(val_t) );
+    assert(pushed == true);
+    // Never above the capacity
+    assert(size_tsnq(q) <= CAP);
+  }
+
+  return NULL;
+}
 
 static
-void* dereference(void* it)
+void test_bulk_bounded(void)
 {
-  if(it == NULL)
-    return NULL;
+  tsnq_t q = {0};
+  init_cap_tsnq(&q, sizeof(val_t), CAP);
+
+  pthread_t p[NUM_PROD];
+  for(size_t i = 0; i < NUM_PROD; ++i){
+    int rc = pthread_create(&p[i], NULL, producer_thread, &q);
+    assert(rc == 0);
+  }
+
+  // FIFO per producer
+  uint32_t next[NUM_PROD] = {0};
+  size_t total = 0;
+  val_t out[BATCH] = {0};
+  while(total < NUM_PROD*NUM_VAL){
+    size_t const n = pop_tsnq_n(&q, out, BATCH, -1);
+    assert(n > 0 && n <= BATCH);
+    for(size_t i = 0; i < n; ++i){
+      assert(out[i].n == next[out[i].prod]);
+      next[out[i].prod] += 1;
+    }
+    total += n;
+  }
+
+  for(size_t i = 0; i < NUM_PROD; ++i)
+    pthread_join(p[i], NULL);
+
+  // Nothing left, the timeout expires
+  assert(pop_tsnq_n(&q, out, BATCH, 0) == 0);
+  assert(pop_tsnq_n(&q, out, BATCH, 10) == 0);
+  assert(q.stopped == false);
 
-  val_t* v = malloc(sizeof(val_t)); 
-  memcpy(v,it,sizeof(val_t));
-  return v;
+  // No consumer to acknowledge the stop
+  q.stopped = true;
+  free_tsnq(&q, NULL);
 }
 
 static
-void* worker_thread(void* arg)
+void test_try_push(void)
 {
-  tsq_t* q = (tsq_t*)arg;
-  while(true){
-   val_t* v = wait_and_pop_tsq(q, dereference); 
-    if(v == NULL) break;
+  tsnq_t q = {0};
+  init_cap_tsnq(&q, sizeof(val_t), 2);
 
-    assert(v != NULL);
-    free(v);
-  } 
+  val_t v = {0};
+  assert(try_push_tsnq(&q, &v, sizeof(v)) == true);
+  assert(try_push_tsnq(&q, &v, sizeof(v)) == true);
+  assert(try_push_tsnq(&q, &v, sizeof(v)) == false);
+  assert(size_tsnq(&q) == 2);
 
-  q->stopped = true;
+  val_t out[4] = {0};
+  assert(pop_tsnq_n(&q, out, 4, 0) == 2);
+  assert(try_push_tsnq(&q, &v, sizeof(v)) == true);
 
-  return NULL;
+  q.stopped = true;
+  free_tsnq(&q, NULL);
 }
 
 static
-void free_value(void* it)
+void* blocked_consumer(void* arg)
 {
-  assert(it != NULL);
-  val_t* v = *(val_t**)it; 
-  free(v);
+  tsnq_t* q = (tsnq_t*)arg;
+  val_t out[BATCH] = {0};
+  size_t const n = pop_tsnq_n(q, out, BATCH, -1);
+  assert(n == 0);
+  return NULL;
 }
 
-int main()
+static
+void test_stop(void)
 {
-  tsq_t q = {0};
-  init_tsq(&q, sizeof(val_t));
+  tsnq_t q = {0};
+  init_tsnq(&q, sizeof(val_t));
 
-  int rc = pthread_create(&t, NULL, worker_thread, &q);
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, blocked_consumer, &q);
   assert(rc == 0);
 
-  int n = 0;
-  for(size_t i = 0; i < 8192; ++i){
-    val_t v = {0};
-    v.n = n;
-    push_tsq(&q, &v, sizeof(val_t) );
-    ++n;
-  }
-
-
-  free_tsq(&q, free_value );
+  usleep(10000);
+  // Waits until the blocked consumer acknowledges the stop
+  free_tsnq(&q, NULL);
   pthread_join(t, NULL);
+}
+
+int main()
+{
+  test_bulk_bounded();
+  test_try_push();
+  test_stop();
 
+  printf("Success\n");
   return 0;
 }
-
@@ -23,22 +23,33 @@ SOFTWARE.
 */
 
 #include <assert.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "../lock_guard/lock_guard.h"
 #include "tsn_queue.h"
 
 void init_tsnq(tsnq_t* q, size_t elm_sz)
+{
+  init_cap_tsnq(q, elm_sz, 0);
+}
+
+void init_cap_tsnq(tsnq_t* q, size_t elm_sz, size_t cap)
 {
   assert(q != NULL);
   assert(elm_sz > 0);
 
   seq_init(&q->r, elm_sz);
+  q->cap = cap;
 
   const pthread_condattr_t* cond_attr = NULL;
   int rc = pthread_cond_init(&q->cv, cond_attr);
   assert(rc == 0);
 
+  rc = pthread_cond_init(&q->not_full, cond_attr);
+  assert(rc == 0);
+
   pthread_mutexattr_t *mtx_attr = NULL;
 #ifdef DEBUG
   *mtx_attr = PTHREAD_MUTEX_ERRORCHECK;
@@ -60,6 +71,7 @@ void free_tsnq(tsnq_t* q, void (*f)(void*) )
  {
   lock_guard(&q->mtx);
   pthread_cond_signal(&q->cv);
+  pthread_cond_broadcast(&q->not_full);
  }
 
   while(q->stopped == false)
@@ -70,16 +82,70 @@ void free_tsnq(tsnq_t* q, void (*f)(void*) )
   int rc = pthread_cond_destroy(&q->cv);
   assert(rc == 0); 
 
+  rc = pthread_cond_destroy(&q->not_full);
+  assert(rc == 0); 
+
   rc = pthread_mutex_destroy(&q->mtx);
   assert(rc == 0); 
 }
 
-void push_tsnq(tsnq_t* q, void* val, size_t sz)
+static
+bool full(tsnq_t* q)
+{
+  return q->cap > 0 && seq_size(&q->r) >= q->cap;
+}
+
+// The elements erased from the front made room for the producers
+static
+void erased(tsnq_t* q)
+{
+  if(q->cap > 0)
+    pthread_cond_broadcast(&q->not_full);
+}
+
+static
+void deadline_ms(struct timespec* deadline, int64_t timeout_ms)
+{
+  // pthread_cond_timedwait measures against the CLOCK_REALTIME
+  int rc = clock_gettime(CLOCK_REALTIME, deadline);
+  assert(rc == 0);
+  deadline->tv_sec += timeout_ms / 1000;
+  deadline->tv_nsec += (timeout_ms % 1000) * 1000000;
+  if(deadline->tv_nsec >= 1000000000){
+    deadline->tv_sec += 1;
+    deadline->tv_nsec -= 1000000000;
+  }
+}
+
+bool push_tsnq(tsnq_t* q, void* val, size_t sz)
+{
+  assert(q != NULL);
+
+  lock_guard(&q->mtx);
+
+  while(full(q) && q->stop_token == false)
+    pthread_cond_wait(&q->not_full, &q->mtx);
+
+  if(full(q))
+    return false;
+
+  seq_push_back(&q->r, val, sz);
+  pthread_cond_signal(&q->cv);
+  return true;
+}
+
+bool try_push_tsnq(tsnq_t* q, void* val, size_t sz)
 {
+  assert(q != NULL);
+
   lock_guard(&q->mtx);
 
+  if(full(q))
+    return false;
+
   seq_push_back(&q->r, val, sz);
   pthread_cond_signal(&q->cv);
+  return true;
 }
 
 void* wait_and_pop_tsnq(tsnq_t* q, void* (*f)(void*) )
@@ -109,73 +175,58 @@ void* wait_and_pop_tsnq(tsnq_t* q, void* (*f)(void*) )
   void* next = seq_next(&q->r, it);
    
   seq_erase(&q->r, it, next);
+  erased(q);
 
   pthread_mutex_unlock(&q->mtx);
 
   return elm;
 }
 
-void* pop_tsnq_10(tsnq_t* q, void* (*f)(void*) )
+size_t pop_tsnq_n(tsnq_t* q, void* out, size_t max, int64_t timeout_ms)
 {
   assert(q != NULL);
+  assert(out != NULL);
+  assert(max > 0);
+
+  struct timespec deadline = {0};
+  if(timeout_ms > 0)
+    deadline_ms(&deadline, timeout_ms);
 
   pthread_mutex_lock(&q->mtx);
 
-  if(q->stop_token == true){
-    pthread_mutex_unlock(&q->mtx);
-    q->stopped = true;
-    return NULL;
+  int rc = 0;
+  while((seq_size(&q->r) == 0) && rc == 0 && q->stop_token == false && timeout_ms != 0) {
+    if(timeout_ms < 0)
+      rc = pthread_cond_wait(&q->cv, &q->mtx);
+    else
+      rc = pthread_cond_timedwait(&q->cv, &q->mtx, &deadline);
   }
 
-  assert(seq_size(&q->r) >= 10);
-
-  void* it = seq_ring_front(&q->r);
-
-  void* elm = NULL;
-  
-  assert(it != seq_end(&q->r));
-  void* next = it;
-  for(int i = 0; i < 10; ++i){
-    elm = f(next);  
-    next = seq_next(&q->r, next);
-  } 
-  seq_erase(&q->r, it, next);
-
-  pthread_mutex_unlock(&q->mtx);
-
-  return elm;
-}
-
-void* pop_tsnq_100(tsnq_t* q, void* (*f)(void*) )
-{
-  assert(q != NULL);
-
-  pthread_mutex_lock(&q->mtx);
-
   if(q->stop_token == true){
     pthread_mutex_unlock(&q->mtx);
     q->stopped = true;
-    return NULL;
+    return 0;
   }
 
-  assert(seq_size(&q->r) >= 100);
+  size_t const sz = seq_size(&q->r);
+  size_t const n = sz < max ? sz : max;
+  size_t const elm_sz = q->r.elt_size;
 
   void* it = seq_ring_front(&q->r);
-
-  void* elm = NULL;
-
-  assert(it != seq_end(&q->r));
   void* next = it;
-  for(int i = 0; i < 100; ++i){
-    elm = f(next);  
+  for(size_t i = 0; i < n; ++i){
+    memcpy((uint8_t*)out + i*elm_sz, next, elm_sz);
     next = seq_next(&q->r, next);
   }
 
-  seq_erase(&q->r, it, next);
+  if(n > 0){
+    seq_erase(&q->r, it, next);
+    erased(q);
+  }
 
   pthread_mutex_unlock(&q->mtx);
 
-  return elm;
+  return n;
 }
 
 size_t size_tsnq(tsnq_t* q)
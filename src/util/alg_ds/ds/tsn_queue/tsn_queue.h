@@ -34,6 +34,7 @@ SOFTWARE.
 
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <pthread.h>
 
 #include "../seq_container/seq_generic.h"
@@ -41,22 +42,33 @@ SOFTWARE.
 typedef struct{
   pthread_mutex_t mtx;
   pthread_cond_t cv;
+  pthread_cond_t not_full;
   seq_ring_t r;
+  // 0 -> unbounded
+  size_t cap;
   atomic_bool stop_token;
   atomic_bool stopped;
 } tsnq_t;
 
 void init_tsnq(tsnq_t* q, size_t elm_sz);
 
+// At most cap elements. push_tsnq blocks while full 
+void init_cap_tsnq(tsnq_t* q, size_t elm_sz, size_t cap);
+
 void free_tsnq(tsnq_t* q, void (*f)(void*) ) ;
 
-void push_tsnq(tsnq_t* q, void* val, size_t size);
+// false if the queue was stopped while waiting for room. val is not pushed
+bool push_tsnq(tsnq_t* q, void* val, size_t size);
 
-void* wait_and_pop_tsnq(tsnq_t* q, void* (*f)(void*) );
+// false if full. val is not pushed
+bool try_push_tsnq(tsnq_t* q, void* val, size_t size);
 
-void* pop_tsnq_10(tsnq_t* q, void* (*f)(void*) );
+void* wait_and_pop_tsnq(tsnq_t* q, void* (*f)(void*) );
 
-void* pop_tsnq_100(tsnq_t* q, void* (*f)(void*) );
+// Moves up to max elements into out under one lock acquisition.
+// Waits timeout_ms for the first one (< 0 forever, 0 not at all).
+// Returns the number of elements moved, 0 after the timeout or if stopped
+size_t pop_tsnq_n(tsnq_t* q, void* out, size_t max, int64_t timeout_ms);
 
 size_t size_tsnq(tsnq_t* q);
 
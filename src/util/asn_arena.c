@@ -0,0 +1,327 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+#include "asn_arena.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Only virtual memory is reserved. Pages are backed on first touch
+#define SLOT_SZ ((size_t)8*1024*1024)
+#define NUM_SLOTS 256
+#define REGION_SZ (NUM_SLOTS*SLOT_SZ)
+
+// The block size is stored in front of the data, that keeps malloc alignment
+#define BLK_ALIGN 16
+#define HDR_SZ 16
+
+// When the outermost scope ends, pages touched beyond this are given back
+#define KEEP_SZ ((size_t)1024*1024)
+
+typedef struct{
+  uint8_t* base;
+  size_t off;
+  // Highest off since the last trim
+  size_t high;
+  uint32_t depth;
+  // No slot left when the thread asked for one
+  bool no_slot;
+
+  asn_arena_stats_t st;
+} tarena_t;
+
+static struct{
+  pthread_mutex_t mtx;
+
+  // Written once at init
+  _Atomic(uint8_t*) region;
+
+  // Protected by mtx
+  size_t next_slot;
+  size_t len_free;
+  uint32_t free_slot[NUM_SLOTS];
+
+  atomic_bool disabled;
+} arena = {.mtx = PTHREAD_MUTEX_INITIALIZER};
+
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+static pthread_key_t tarena_key;
+
+static _Thread_local tarena_t tarena;
+
+static inline
+size_t align_up(size_t sz)
+{
+  return (sz + BLK_ALIGN - 1) & ~((size_t)BLK_ALIGN - 1);
+}
+
+static inline
+bool owns(void const* ptr)
+{
+  uint8_t const* region = atomic_load_explicit(&arena.region, memory_order_acquire);
+  return region != NULL && (uint8_t const*)ptr >= region && (uint8_t const*)ptr < region + REGION_SZ;
+}
+
+static inline
+size_t blk_sz(void const* ptr)
+{
+  size_t sz;
+  memcpy(&sz, (uint8_t const*)ptr - HDR_SZ, sizeof(sz));
+  return sz;
+}
+
+static
+void free_tarena(void* arg)
+{
+  tarena_t* t = (tarena_t*)arg;
+  if(t->base == NULL)
+    return;
+
+  int rc = madvise(t->base, SLOT_SZ, MADV_DONTNEED);
+  assert(rc == 0);
+
+  uint8_t* region = atomic_load_explicit(&arena.region, memory_order_acquire);
+
+  rc = pthread_mutex_lock(&arena.mtx);
+  assert(rc == 0);
+  arena.free_slot[arena.len_free++] = (t->base - region) / SLOT_SZ;
+  rc = pthread_mutex_unlock(&arena.mtx);
+  assert(rc == 0);
+
+  t->base = NULL;
+}
+
+static
+void init_arena(void)
+{
+  void* p = mmap(NULL, REGION_SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  assert(p != MAP_FAILED && "Could not reserve the asn arena region");
+
+  int rc = pthread_key_create(&tarena_key, free_tarena);
+  assert(rc == 0);
+
+  atomic_store_explicit(&arena.region, p, memory_order_release);
+}
+
+// false if every slot is taken. The thread then uses the heap for good
+static
+bool acquire_slot(tarena_t* t)
+{
+  if(t->base != NULL)
+    return true;
+  if(t->no_slot == true)
+    return false;
+
+  int rc = pthread_once(&arena_once, init_arena);
+  assert(rc == 0);
+
+  rc = pthread_mutex_lock(&arena.mtx);
+  assert(rc == 0);
+
+  int64_t slot = -1;
+  if(arena.len_free > 0)
+    slot = arena.free_slot[--arena.len_free];
+  else if(arena.next_slot < NUM_SLOTS)
+    slot = arena.next_slot++;
+
+  rc = pthread_mutex_unlock(&arena.mtx);
+  assert(rc == 0);
+
+  if(slot == -1){
+    t->no_slot = true;
+    return false;
+  }
+
+  t->base = atomic_load_explicit(&arena.region, memory_order_acquire) + slot*SLOT_SZ;
+  t->off = 0;
+  t->high = 0;
+
+  // The destructor gives the slot back when the thread exits
+  rc = pthread_setspecific(tarena_key, t);
+  assert(rc == 0);
+  return true;
+}
+
+// NULL if the slot is exhausted
+static
+void* bump(tarena_t* t, size_t size)
+{
+  size_t const sz = HDR_SZ + align_up(size);
+  if(sz < size || sz > SLOT_SZ - t->off)
+    return NULL;
+
+  uint8_t* p = t->base + t->off + HDR_SZ;
+  memcpy(p - HDR_SZ, &size, sizeof(size));
+  t->off += sz;
+  if(t->off > t->high)
+    t->high = t->off;
+
+  t->st.arena += 1;
+  return p;
+}
+
+static inline
+void count_heap(tarena_t* t)
+{
+  t->st.heap += 1;
+  if(t->depth > 0)
+    t->st.spill += 1;
+}
+
+asn_arena_mark_t begin_asn_arena(void)
+{
+  tarena_t* t = &tarena;
+  asn_arena_mark_t m = {.off = t->off, .spill = t->st.spill};
+
+  if(atomic_load_explicit(&arena.disabled, memory_order_relaxed) == true)
+    return m;
+  if(acquire_slot(t) == false)
+    return m;
+
+  m.off = t->off;
+  m.active = true;
+  t->depth += 1;
+  return m;
+}
+
+bool must_free_asn_arena(asn_arena_mark_t m)
+{
+  return m.active == false || tarena.st.spill != m.spill;
+}
+
+void end_asn_arena(asn_arena_mark_t m)
+{
+  if(m.active == false)
+    return;
+
+  tarena_t* t = &tarena;
+  assert(t->depth > 0 && "Unbalanced asn arena scopes");
+  assert(m.off <= t->off);
+
+  t->depth -= 1;
+  t->off = m.off;
+
+  if(t->depth == 0 && t->high > KEEP_SZ){
+    // An unusually large message. Do not pin its pages
+    int const rc = madvise(t->base + KEEP_SZ, t->high - KEEP_SZ, MADV_DONTNEED);
+    assert(rc == 0);
+    t->high = KEEP_SZ;
+  }
+}
+
+void enable_asn_arena(bool enable)
+{
+  atomic_store_explicit(&arena.disabled, !enable, memory_order_relaxed);
+}
+
+asn_arena_stats_t stats_asn_arena(void)
+{
+  return tarena.st;
+}
+
+void reset_stats_asn_arena(void)
+{
+  // spill is part of the open marks
+  uint64_t const spill = tarena.st.spill;
+  memset(&tarena.st, 0, sizeof(tarena.st));
+  tarena.st.spill = spill;
+}
+
+void* malloc_asn_arena(size_t size)
+{
+  tarena_t* t = &tarena;
+  if(t->depth > 0){
+    void* p = bump(t, size);
+    if(p != NULL)
+      return p;
+  }
+  count_heap(t);
+  return malloc(size);
+}
+
+void* calloc_asn_arena(size_t nmemb, size_t size)
+{
+  tarena_t* t = &tarena;
+  if(t->depth > 0){
+    size_t total;
+    if(__builtin_mul_overflow(nmemb, size, &total))
+      return NULL;
+
+    // The slot is reused after every scope, thus not zeroed
+    void* p = bump(t, total);
+    if(p != NULL)
+      return memset(p, 0, total);
+  }
+
+  count_heap(t);
+  return calloc(nmemb, size);
+}
+
+void* realloc_asn_arena(void* ptr, size_t size)
+{
+  if(ptr == NULL)
+    return malloc_asn_arena(size);
+
+  tarena_t* t = &tarena;
+  if(owns(ptr) == false){
+    t->st.heap += 1;
+    return realloc(ptr, size);
+  }
+
+  size_t const old = blk_sz(ptr);
+  uint8_t* const end = (uint8_t*)ptr + align_up(old);
+
+  // Last block of the slot. Grow or shrink in place
+  if(t->depth > 0 && end == t->base + t->off){
+    size_t const start = (uint8_t*)ptr - t->base;
+    size_t const sz = align_up(size);
+    if(sz >= size && sz <= SLOT_SZ - start){
+      memcpy((uint8_t*)ptr - HDR_SZ, &size, sizeof(size));
+      t->off = start + sz;
+      if(t->off > t->high)
+        t->high = t->off;
+      return ptr;
+    }
+  }
+
+  void* p = malloc_asn_arena(size);
+  if(p != NULL)
+    memcpy(p, ptr, old < size ? old : size);
+  return p;
+}
+
+void free_asn_arena(void* ptr)
+{
+  if(ptr == NULL)
+    return;
+
+  if(owns(ptr) == true){
+    tarena.st.skip_free += 1;
+    return;
+  }
+  free(ptr);
+}
+
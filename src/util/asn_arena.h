@@ -0,0 +1,91 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef ASN_ARENA_H
+#define ASN_ARENA_H
+
+/*
+ * Bump allocator behind the asn1c CALLOC/MALLOC/REALLOC/FREEMEM hooks.
+ *
+ * Decoding one E2AP or E2SM message builds a tree of hundreds of small
+ * asn1c nodes that only live until the tree is converted into the native
+ * structures. Within a scope, the hooks carve these nodes from a per thread
+ * slot of one reserved virtual region, and end_asn_arena() releases all of
+ * them at once. Outside a scope, or when the slot runs out, the hooks fall
+ * back to the heap. Since the region is contiguous, FREEMEM tells both
+ * apart and ignores the arena blocks, so asn1c code needs no changes.
+ *
+ *  asn_arena_mark_t const m = begin_asn_arena();
+ *  // decode, convert
+ *  if(must_free_asn_arena(m))
+ *    ASN_STRUCT_FREE(asn_DEF_X, pdu);
+ *  end_asn_arena(m);
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct{
+  size_t off;
+  uint64_t spill;
+  bool active;
+} asn_arena_mark_t;
+
+typedef struct{
+  // Served by the arena
+  uint64_t arena;
+  // Served by the heap, in or out of a scope
+  uint64_t heap;
+  // Heap allocations within a scope i.e., slot exhausted or not available
+  uint64_t spill;
+  // FREEMEM calls ignored since the block belongs to the arena
+  uint64_t skip_free;
+} asn_arena_stats_t;
+
+// Scopes nest. Every begin must be matched by an end in the same thread
+asn_arena_mark_t begin_asn_arena(void);
+
+// True if the structures allocated since m may hold heap blocks, and thus,
+// must be freed as usual before end_asn_arena(m)
+bool must_free_asn_arena(asn_arena_mark_t m);
+
+// Invalidates every arena block allocated since m
+void end_asn_arena(asn_arena_mark_t m);
+
+// Process wide. Scopes begun while disabled use the heap. Enabled by default
+void enable_asn_arena(bool enable);
+
+// Counters of the calling thread
+asn_arena_stats_t stats_asn_arena(void);
+
+void reset_stats_asn_arena(void);
+
+// asn1c hooks. See asn_internal.h
+void* calloc_asn_arena(size_t nmemb, size_t size);
+
+void* malloc_asn_arena(size_t size);
+
+void* realloc_asn_arena(void* ptr, size_t size);
+
+void free_asn_arena(void* ptr);
+
+#endif
@@ -21,6 +21,7 @@
 
 
 #include "byte_array.h"
+#include "byte_array_pool.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -37,7 +38,10 @@ byte_array_t copy_byte_array(byte_array_t src)
 
 void free_byte_array(byte_array_t ba)
 {
-  free(ba.buf);
+  if(owns_byte_array_pool(ba.buf))
+    free_byte_array_pool(ba.buf);
+  else
+    free(ba.buf);
 }
 
 bool eq_byte_array(const byte_array_t* m0, const byte_array_t* m1)
@@ -0,0 +1,387 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+#include "byte_array_pool.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 256 B, 512 B, ..., 32 KiB
+#define MIN_CLASS_SHIFT 8
+#define NUM_CLASSES 8
+
+// Only virtual memory is reserved. Pages are backed on first touch
+#define SLAB_SZ ((size_t)1024*1024)
+#define NUM_SLABS 1024
+#define REGION_SZ (NUM_SLABS*SLAB_SZ)
+
+// Per thread and class
+#define TCACHE_BYTES (256*1024)
+#define TCACHE_MAX_LEN 64
+
+// Beyond this, the pages of the large buffers given back to the depot are
+// returned to the kernel (except the first one, that holds the list link)
+#define DEPOT_MAX_BYTES (4*1024*1024)
+#define MADVISE_MIN_SZ (8*1024)
+
+#define STATS_PERIOD 64
+
+_Static_assert(((size_t)1 << (MIN_CLASS_SHIFT + NUM_CLASSES - 1)) == BYTE_ARRAY_POOL_MAX_SZ, "Last class must be the max size");
+_Static_assert(NUM_CLASSES < UINT8_MAX, "Class stored in a uint8_t");
+
+typedef struct blk_s{
+  struct blk_s* next;
+} blk_t;
+
+typedef struct{
+  blk_t* head;
+  size_t len;
+} blk_list_t;
+
+typedef struct{
+  blk_list_t cls[NUM_CLASSES];
+
+  uint64_t hit;
+  uint64_t miss;
+  uint64_t fallback;
+  uint64_t trim;
+  uint32_t ops;
+
+  bool registered;
+} tcache_t;
+
+static struct{
+  pthread_mutex_t mtx;
+
+  // Written once at init
+  _Atomic(uint8_t*) region;
+  size_t page_sz;
+
+  // Protected by mtx
+  size_t next_slab;
+  blk_list_t depot[NUM_CLASSES];
+  uint8_t* bump[NUM_CLASSES];
+  uint8_t* bump_end[NUM_CLASSES];
+
+  // Written before any block of the slab is handed out
+  uint8_t slab_class[NUM_SLABS];
+
+  _Atomic uint64_t hit;
+  _Atomic uint64_t miss;
+  _Atomic uint64_t fallback;
+  _Atomic uint64_t trim;
+} pool = {.mtx = PTHREAD_MUTEX_INITIALIZER};
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t tcache_key;
+
+static _Thread_local tcache_t tcache;
+
+static inline
+size_t class_sz(int c)
+{
+  return (size_t)1 << (MIN_CLASS_SHIFT + c);
+}
+
+static inline
+int class_idx(size_t len)
+{
+  assert(len > 0 && len <= BYTE_ARRAY_POOL_MAX_SZ);
+  if(len <= class_sz(0))
+    return 0;
+
+  // ceil(log2(len))
+  int const bits = 64 - __builtin_clzll(len - 1);
+  return bits - MIN_CLASS_SHIFT;
+}
+
+static inline
+int class_of(uint8_t const* buf)
+{
+  uint8_t* region = atomic_load_explicit(&pool.region, memory_order_acquire);
+  size_t const slab = (size_t)(buf - region) / SLAB_SZ;
+  return pool.slab_class[slab];
+}
+
+static inline
+size_t tcache_cap(int c)
+{
+  size_t const n = TCACHE_BYTES / class_sz(c);
+  return n < TCACHE_MAX_LEN ? n : TCACHE_MAX_LEN;
+}
+
+static inline
+void push_blk(blk_list_t* l, blk_t* b)
+{
+  b->next = l->head;
+  l->head = b;
+  l->len += 1;
+}
+
+static inline
+blk_t* pop_blk(blk_list_t* l)
+{
+  blk_t* b = l->head;
+  if(b != NULL){
+    l->head = b->next;
+    l->len -= 1;
+  }
+  return b;
+}
+
+static
+void publish_stats(tcache_t* t)
+{
+  atomic_fetch_add_explicit(&pool.hit, t->hit, memory_order_relaxed);
+  atomic_fetch_add_explicit(&pool.miss, t->miss, memory_order_relaxed);
+  atomic_fetch_add_explicit(&pool.fallback, t->fallback, memory_order_relaxed);
+  atomic_fetch_add_explicit(&pool.trim, t->trim, memory_order_relaxed);
+  t->hit = 0;
+  t->miss = 0;
+  t->fallback = 0;
+  t->trim = 0;
+}
+
+static inline
+void count_op(tcache_t* t)
+{
+  t->ops += 1;
+  if(t->ops % STATS_PERIOD == 0)
+    publish_stats(t);
+}
+
+// Move n blocks of class c from the thread cache to the depot
+static
+void drain_tcache(tcache_t* t, int c, size_t n)
+{
+  assert(n <= t->cls[c].len);
+
+  size_t const sz = class_sz(c);
+
+  int rc = pthread_mutex_lock(&pool.mtx);
+  assert(rc == 0);
+
+  for(size_t i = 0; i < n; ++i){
+    blk_t* b = pop_blk(&t->cls[c]);
+    if(sz >= MADVISE_MIN_SZ && pool.depot[c].len * sz >= DEPOT_MAX_BYTES){
+      rc = madvise((uint8_t*)b + pool.page_sz, sz - pool.page_sz, MADV_DONTNEED);
+      assert(rc == 0);
+    }
+    push_blk(&pool.depot[c], b);
+  }
+
+  rc = pthread_mutex_unlock(&pool.mtx);
+  assert(rc == 0);
+}
+
+static
+void free_tcache(void* arg)
+{
+  tcache_t* t = (tcache_t*)arg;
+  for(int c = 0; c < NUM_CLASSES; ++c)
+    drain_tcache(t, c, t->cls[c].len);
+
+  publish_stats(t);
+  t->registered = false;
+}
+
+static
+void init_pool(void)
+{
+  void* p = mmap(NULL, REGION_SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  assert(p != MAP_FAILED && "Could not reserve the byte array pool region");
+
+  long const page_sz = sysconf(_SC_PAGESIZE);
+  assert(page_sz > 0 && (size_t)page_sz < MADVISE_MIN_SZ);
+  pool.page_sz = page_sz;
+
+  int rc = pthread_key_create(&tcache_key, free_tcache);
+  assert(rc == 0);
+
+  atomic_store_explicit(&pool.region, p, memory_order_release);
+}
+
+static
+tcache_t* get_tcache(void)
+{
+  if(tcache.registered == false){
+    // The destructor gives the cached blocks back when the thread exits
+    int const rc = pthread_setspecific(tcache_key, &tcache);
+    assert(rc == 0);
+    tcache.registered = true;
+  }
+  return &tcache;
+}
+
+// Called with the mutex locked. NULL if the region is exhausted
+static
+blk_t* carve_blk(int c)
+{
+  size_t const sz = class_sz(c);
+
+  if(pool.bump[c] == pool.bump_end[c]){
+    if(pool.next_slab == NUM_SLABS)
+      return NULL;
+
+    uint8_t* region = atomic_load_explicit(&pool.region, memory_order_relaxed);
+    pool.slab_class[pool.next_slab] = c;
+    pool.bump[c] = region + pool.next_slab * SLAB_SZ;
+    pool.bump_end[c] = pool.bump[c] + SLAB_SZ;
+    pool.next_slab += 1;
+  }
+
+  blk_t* b = (blk_t*)pool.bump[c];
+  pool.bump[c] += sz;
+  return b;
+}
+
+// Thread cache empty. Bring half a cache from the depot, or carve a new block
+static
+blk_t* refill_tcache(tcache_t* t, int c)
+{
+  blk_t* b = NULL;
+
+  int rc = pthread_mutex_lock(&pool.mtx);
+  assert(rc == 0);
+
+  if(pool.depot[c].len > 0){
+    size_t const half = tcache_cap(c) / 2;
+    size_t const n = half < pool.depot[c].len ? half : pool.depot[c].len;
+    for(size_t i = 0; i < n; ++i)
+      push_blk(&t->cls[c], pop_blk(&pool.depot[c]));
+
+    b = pop_blk(&t->cls[c]);
+    t->hit += 1;
+  } else {
+    b = carve_blk(c);
+    if(b != NULL)
+      t->miss += 1;
+  }
+
+  rc = pthread_mutex_unlock(&pool.mtx);
+  assert(rc == 0);
+
+  return b;
+}
+
+byte_array_t alloc_byte_array_pool(size_t len)
+{
+  assert(len > 0);
+
+  int rc = pthread_once(&pool_once, init_pool);
+  assert(rc == 0);
+
+  tcache_t* t = get_tcache();
+  byte_array_t ba = {.len = len};
+
+  if(len <= BYTE_ARRAY_POOL_MAX_SZ){
+    int const c = class_idx(len);
+    blk_t* b = pop_blk(&t->cls[c]);
+    if(b != NULL)
+      t->hit += 1;
+    else
+      b = refill_tcache(t, c);
+    ba.buf = (uint8_t*)b;
+  }
+
+  if(ba.buf == NULL){
+    ba.buf = malloc(len);
+    assert(ba.buf != NULL && "Memory exhausted");
+    t->fallback += 1;
+  }
+
+  count_op(t);
+  return ba;
+}
+
+byte_array_t trim_byte_array_pool(byte_array_t ba)
+{
+  assert(ba.buf != NULL);
+  assert(ba.len > 0);
+
+  if(owns_byte_array_pool(ba.buf) == false)
+    return ba;
+
+  // Copying is worth it only if it at least quarters the footprint
+  int const c = class_of(ba.buf);
+  if(class_idx(ba.len) + 2 > c)
+    return ba;
+
+  byte_array_t dst = alloc_byte_array_pool(ba.len);
+  memcpy(dst.buf, ba.buf, ba.len);
+  free_byte_array_pool(ba.buf);
+
+  get_tcache()->trim += 1;
+  return dst;
+}
+
+bool owns_byte_array_pool(uint8_t const* buf)
+{
+  uint8_t const* region = atomic_load_explicit(&pool.region, memory_order_acquire);
+  return region != NULL && buf >= region && buf < region + REGION_SZ;
+}
+
+void free_byte_array_pool(uint8_t* buf)
+{
+  assert(owns_byte_array_pool(buf) == true);
+
+  int const c = class_of(buf);
+  assert(((size_t)(buf - atomic_load_explicit(&pool.region, memory_order_relaxed)) & (class_sz(c) - 1)) == 0 && "Not the start of a block");
+
+  tcache_t* t = get_tcache();
+  push_blk(&t->cls[c], (blk_t*)buf);
+
+  size_t const cap = tcache_cap(c);
+  if(t->cls[c].len > cap)
+    drain_tcache(t, c, t->cls[c].len - cap / 2);
+
+  count_op(t);
+}
+
+byte_array_pool_stats_t stats_byte_array_pool(void)
+{
+  int rc = pthread_once(&pool_once, init_pool);
+  assert(rc == 0);
+
+  publish_stats(get_tcache());
+
+  byte_array_pool_stats_t s = {
+    .hit = atomic_load_explicit(&pool.hit, memory_order_relaxed),
+    .miss = atomic_load_explicit(&pool.miss, memory_order_relaxed),
+    .fallback = atomic_load_explicit(&pool.fallback, memory_order_relaxed),
+    .trim = atomic_load_explicit(&pool.trim, memory_order_relaxed),
+  };
+
+  rc = pthread_mutex_lock(&pool.mtx);
+  assert(rc == 0);
+  s.reserved = pool.next_slab * SLAB_SZ;
+  rc = pthread_mutex_unlock(&pool.mtx);
+  assert(rc == 0);
+
+  return s;
+}
+
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef BYTE_ARRAY_POOL_H
+#define BYTE_ARRAY_POOL_H
+
+/*
+ * Size-classed buffer pool for the byte_array_t that flow through the
+ * endpoints (SCTP receive) and the E2AP encoders.
+ *
+ * Buffers are carved from one reserved virtual region, in power of two
+ * classes from 256 B to 32 KiB. Every thread keeps a small cache per class,
+ * and exchanges batches with a shared depot when the cache runs empty or
+ * full. Since the region is contiguous, free_byte_array() can tell pooled
+ * buffers from malloc'ed ones, so the consumers release both the same way.
+*/
+
+#include "byte_array.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BYTE_ARRAY_POOL_MAX_SZ (32*1024)
+
+typedef struct{
+  // Served from the thread cache or the depot
+  uint64_t hit;
+  // Carved from a fresh slab
+  uint64_t miss;
+  // Larger than the biggest class or region exhausted. Served by malloc
+  uint64_t fallback;
+  // Buffers moved to a smaller class by trim_byte_array_pool
+  uint64_t trim;
+  // Bytes of the region handed to slabs. High-water mark of the pool
+  size_t reserved;
+} byte_array_pool_stats_t;
+
+// Buffer with capacity for at least len bytes. ba.len == len
+byte_array_t alloc_byte_array_pool(size_t len);
+
+// Move ba.len bytes to a smaller class if the current one is oversized.
+// Otherwise, the buffer is handed back untouched
+byte_array_t trim_byte_array_pool(byte_array_t ba);
+
+bool owns_byte_array_pool(uint8_t const* buf);
+
+// buf must be owned by the pool
+void free_byte_array_pool(uint8_t* buf);
+
+// Thread counters are published in batches, so the last few
+// operations of every thread may not be reflected yet
+byte_array_pool_stats_t stats_byte_array_pool(void);
+
+#endif
@@ -130,6 +130,13 @@ void print_usage(const char* prog)
   printf("  -h         : print usage\n");
   printf("  -c         : path to the config file\n");
   printf("  -p         : path to the shared libs \n");
+  printf("    nearRT-RIC options (override the config file):\n");
+  printf("  -w         : number of worker threads \n");
+  printf("  -W         : CPUs of the worker threads, e.g. 2-5,8 \n");
+  printf("  -R         : CPUs of the event loop (reactor) threads, e.g. 0-1 \n");
+  printf("  -N         : NUMA node of the threads and their memory \n");
+  printf("    xApp options (override the config file):\n");
+  printf("  -x         : number of threads running the callbacks \n");
 }  
 
 int parse_args(int argc, char** argv, args_t* args)
@@ -298,6 +305,11 @@ void print_usage(void)
   printf("  -h         : print usage\n");
   printf("  -c         : path to the config file\n");
   printf("  -p         : path to the shared libs \n");
+  printf("    nearRT-RIC options (override the config file):\n");
+  printf("  -w         : number of worker threads \n");
+  printf("  -W         : CPUs of the worker threads, e.g. 2-5,8 \n");
+  printf("  -R         : CPUs of the event loop (reactor) threads, e.g. 0-1 \n");
+  printf("  -N         : NUMA node of the threads and their memory \n");
   printf(
       "\n");
   printf("Ex. -p /usr/local/lib/flexric/ -c /usr/local/etc/flexric/flexric.conf \n");
@@ -311,7 +323,7 @@ void parse_args(int argc, char* const* argv, fr_args_t* args)
   assert(args != NULL);
 
   int opt = '?';
-  const char *optstring = "hc:p:";
+  const char *optstring = "hc:p:w:W:R:N:x:";
   while((opt = getopt(argc, argv, optstring)) != -1) {
     switch(opt) {
       case 'h':{
@@ -349,6 +361,23 @@ void parse_args(int argc, char* const* argv, fr_args_t* args)
                  memset(args->libs_dir, '\0', FR_CONF_FILE_LEN);
                  strncpy(args->libs_dir, optarg, len);
 
+                 break;
+               }
+      case 'w':
+      case 'W':
+      case 'R':
+      case 'N':
+      case 'x':{
+                 char* dst = opt == 'w' ? args->ric_workers
+                           : opt == 'W' ? args->ric_worker_cpus
+                           : opt == 'R' ? args->ric_reactor_cpus
+                           : opt == 'N' ? args->ric_numa_node
+                           : args->xapp_workers;
+                 if(strlen(optarg) > FR_CONF_VAL_LEN - 1){
+                   printf("Error: -%c %s too long \n", opt, optarg);  
+                   exit(EXIT_FAILURE);
+                 }
+                 strncpy(dst, optarg, FR_CONF_VAL_LEN - 1);
                  break;
                }
       case '?':{
@@ -385,7 +414,7 @@ fr_args_t init_fr_args(int argc, char* argv[])
   load_default_val(&args);
   
   if(argc > 1){
-    assert(argc < 6 && "Only -h -c -p flags supported");
+    assert(argc < 16 && "Only -h -c -p -w -W -R -N -x flags supported");
     assert(argv != NULL);
     parse_args(argc, argv, &args);
   }
@@ -510,3 +539,339 @@ char* get_conf_db_name(fr_args_t const* args)
 
   return strdup(db_name);
 }
+
+size_t get_conf_rx_batch(fr_args_t const* args)
+{
+  char* line = NULL;
+  defer({free(line);});
+  size_t len = 0;
+  ssize_t read;
+
+  FILE * fp = fopen(args->conf_file, "r");
+
+  if (fp == NULL){
+    printf("%s not found. Did you forget to sudo make install?\n", args->conf_file);
+    exit(EXIT_FAILURE);
+  }
+
+  defer({fclose(fp); } );
+
+  size_t rx_batch = FR_RX_BATCH_DEFAULT;
+  while ((read = getline(&line, &len, fp)) != -1) {
+    const char* needle = "RX_BATCH =";
+    char* ans = strstr(line, needle);
+    if(ans != NULL){
+      ans += strlen(needle);
+      char* end = NULL;
+      long const val = strtol(ans, &end, 10);
+      if(end == ans || val < 1 || val > FR_RX_BATCH_MAX){
+        printf("RX_BATCH invalid. It should be in [1, %d]. Check the config file\n", FR_RX_BATCH_MAX);
+        exit(EXIT_FAILURE);
+      }
+      rx_batch = val;
+      break;
+    }
+  }
+
+  return rx_batch;
+}
+
+size_t get_conf_ric_reactors(fr_args_t const* args)
+{
+  char* line = NULL;
+  defer({free(line);});
+  size_t len = 0;
+  ssize_t read;
+
+  FILE * fp = fopen(args->conf_file, "r");
+
+  if (fp == NULL){
+    printf("%s not found. Did you forget to sudo make install?\n", args->conf_file);
+    exit(EXIT_FAILURE);
+  }
+
+  defer({fclose(fp); } );
+
+  size_t reactors = 0;
+  while ((read = getline(&line, &len, fp)) != -1) {
+    const char* needle = "RIC_REACTORS =";
+    char* ans = strstr(line, needle);
+    if(ans != NULL){
+      ans += strlen(needle);
+      char* end = NULL;
+      long const val = strtol(ans, &end, 10);
+      if(end == ans || val < 0 || val > FR_RIC_REACTORS_MAX){
+        printf("RIC_REACTORS invalid. It should be in [0, %d]. Check the config file\n", FR_RIC_REACTORS_MAX);
+        exit(EXIT_FAILURE);
+      }
+      reactors = val;
+      break;
+    }
+  }
+
+  return reactors;
+}
+
+// Command line override, or the value of the first "KEY = value" line
+// of the config file. Commented out lines are skipped
+static
+bool get_conf_val(fr_args_t const* args, char const* cli, const char* needle, char out[FR_CONF_VAL_LEN])
+{
+  if(cli[0] != '\0'){
+    strncpy(out, cli, FR_CONF_VAL_LEN);
+    return true;
+  }
+
+  char* line = NULL;
+  defer({free(line);});
+  size_t len = 0;
+  ssize_t read;
+
+  FILE * fp = fopen(args->conf_file, "r");
+
+  if (fp == NULL){
+    printf("%s not found. Did you forget to sudo make install?\n", args->conf_file);
+    exit(EXIT_FAILURE);
+  }
+
+  defer({fclose(fp); } );
+
+  while ((read = getline(&line, &len, fp)) != -1) {
+    char* ans = ltrim(line);
+    if(strncmp(ans, needle, strlen(needle)) != 0)
+      continue;
+
+    ans += strlen(needle);
+    ans = ltrim(ans);
+    // No value. Same as not present
+    if(*ans == '\0')
+      return false;
+
+    ans = rtrim(ans);
+    if(strlen(ans) > FR_CONF_VAL_LEN - 1){
+      printf("%s too long. Check the config file\n", needle);
+      exit(EXIT_FAILURE);
+    }
+    memset(out, '\0', FR_CONF_VAL_LEN);
+    memcpy(out, ans, strlen(ans));
+    return true;
+  }
+
+  return false;
+}
+
+fr_cpu_list_t parse_conf_cpu_list(const char* name, const char* val)
+{
+  bool set[FR_MAX_CPUS] = {0};
+
+  const char* it = val;
+  while(*it != '\0'){
+    char* end = NULL;
+    long const first = strtol(it, &end, 10);
+    long last = first;
+    if(end != it && *end == '-'){
+      it = end + 1;
+      last = strtol(it, &end, 10);
+    }
+
+    if(end == it || first < 0 || last < first || last >= FR_MAX_CPUS || (*end != ',' && *end != '\0')){
+      printf("%s = %s invalid. It should be a list of CPUs in [0, %d), e.g. 0-3,8 \n", name, val, FR_MAX_CPUS);
+      exit(EXIT_FAILURE);
+    }
+
+    for(long i = first; i <= last; ++i)
+      set[i] = true;
+
+    it = *end == ',' ? end + 1 : end;
+  }
+
+  fr_cpu_list_t l = {.len = 0};
+  for(int i = 0; i < FR_MAX_CPUS; ++i){
+    if(set[i] == true)
+      l.cpu[l.len++] = i;
+  }
+
+  return l;
+}
+
+uint32_t get_conf_ric_workers(fr_args_t const* args)
+{
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, args->ric_workers, "RIC_WORKERS =", val) == false)
+    return 0;
+
+  char* end = NULL;
+  long const n = strtol(val, &end, 10);
+  if(end == val || *end != '\0' || n < 1 || n > FR_RIC_WORKERS_MAX){
+    printf("RIC_WORKERS invalid. It should be in [1, %d]. Check the config file\n", FR_RIC_WORKERS_MAX);
+    exit(EXIT_FAILURE);
+  }
+
+  return n;
+}
+
+fr_cpu_list_t get_conf_ric_worker_cpus(fr_args_t const* args)
+{
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, args->ric_worker_cpus, "RIC_WORKER_CPUS =", val) == false)
+    return (fr_cpu_list_t){.len = 0};
+
+  return parse_conf_cpu_list("RIC_WORKER_CPUS", val);
+}
+
+fr_cpu_list_t get_conf_ric_reactor_cpus(fr_args_t const* args)
+{
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, args->ric_reactor_cpus, "RIC_REACTOR_CPUS =", val) == false)
+    return (fr_cpu_list_t){.len = 0};
+
+  return parse_conf_cpu_list("RIC_REACTOR_CPUS", val);
+}
+
+int get_conf_ric_numa_node(fr_args_t const* args)
+{
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, args->ric_numa_node, "RIC_NUMA_NODE =", val) == false)
+    return -1;
+
+  char* end = NULL;
+  long const n = strtol(val, &end, 10);
+  if(end == val || *end != '\0' || n < 0 || n > 1023){
+    printf("RIC_NUMA_NODE invalid. It should be in [0, 1023]. Check the config file\n");
+    exit(EXIT_FAILURE);
+  }
+
+  return n;
+}
+
+static
+size_t get_conf_num(fr_args_t const* args, const char* key, size_t def, size_t max)
+{
+  char needle[64] = {0};
+  snprintf(needle, sizeof(needle), "%s =", key);
+
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, "", needle, val) == false)
+    return def;
+
+  char* end = NULL;
+  long const n = strtol(val, &end, 10);
+  if(end == val || *end != '\0' || n < 1 || (size_t)n > max){
+    printf("%s invalid. It should be in [1, %zu]. Check the config file\n", key, max);
+    exit(EXIT_FAILURE);
+  }
+
+  return n;
+}
+
+size_t get_conf_e42_shm_ring(fr_args_t const* args)
+{
+  return get_conf_num(args, "E42_SHM_RING", 0, FR_E42_SHM_RING_MAX) * 1024;
+}
+
+size_t get_conf_e2_agent_reactors(fr_args_t const* args)
+{
+  return get_conf_num(args, "E2_AGENT_REACTORS", 0, FR_E2_AGENT_REACTORS_MAX);
+}
+
+fr_disp_conf_t get_conf_xapp_disp(fr_args_t const* args)
+{
+  fr_disp_conf_t c = {.overflow = FR_DISP_DROP_OLDEST, .workers = 1};
+  c.queue = get_conf_num(args, "XAPP_DISP_QUEUE", FR_XAPP_DISP_QUEUE_DEFAULT, FR_XAPP_DISP_QUEUE_MAX);
+
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, args->xapp_workers, "XAPP_WORKERS =", val) == true){
+    char* end = NULL;
+    long const n = strtol(val, &end, 10);
+    if(end == val || *end != '\0' || n < 1 || n > FR_XAPP_WORKERS_MAX){
+      printf("XAPP_WORKERS invalid. It should be in [1, %d]. Check the config file\n", FR_XAPP_WORKERS_MAX);
+      exit(EXIT_FAILURE);
+    }
+    c.workers = n;
+  }
+
+  memset(val, '\0', sizeof(val));
+  if(get_conf_val(args, "", "XAPP_DISP_OVERFLOW =", val) == false)
+    return c;
+
+  if(strcmp(val, "block") == 0){
+    c.overflow = FR_DISP_BLOCK;
+  } else if(strcmp(val, "drop_oldest") == 0){
+    c.overflow = FR_DISP_DROP_OLDEST;
+  } else if(strcmp(val, "keep_latest") == 0){
+    c.overflow = FR_DISP_KEEP_LATEST;
+  } else {
+    printf("XAPP_DISP_OVERFLOW %s invalid. It should be block, drop_oldest or keep_latest\n", val);
+    exit(EXIT_FAILURE);
+  }
+
+  return c;
+}
+
+fr_db_conf_t get_conf_xapp_db(fr_args_t const* args)
+{
+  fr_db_conf_t c = {0};
+  c.batch = get_conf_num(args, "XAPP_DB_BATCH", FR_XAPP_DB_BATCH_DEFAULT, FR_XAPP_DB_BATCH_MAX);
+  c.batch_ms = get_conf_num(args, "XAPP_DB_BATCH_MS", FR_XAPP_DB_BATCH_MS_DEFAULT, FR_XAPP_DB_BATCH_MS_MAX);
+  c.queue = get_conf_num(args, "XAPP_DB_QUEUE", FR_XAPP_DB_QUEUE_DEFAULT, FR_XAPP_DB_QUEUE_MAX);
+  return c;
+}
+
+static
+fr_sink_overflow_e parse_sink_overflow(const char* sink, const char* val)
+{
+  if(strcmp(val, "block") == 0)
+    return FR_SINK_BLOCK;
+  if(strcmp(val, "drop_oldest") == 0)
+    return FR_SINK_DROP_OLDEST;
+  if(strcmp(val, "sample") == 0)
+    return FR_SINK_SAMPLE;
+
+  printf("RIC_SINKS: overflow policy %s of %s invalid. It should be block, drop_oldest or sample\n", val, sink);
+  exit(EXIT_FAILURE);
+}
+
+fr_sink_list_t get_conf_ric_sinks(fr_args_t const* args)
+{
+  fr_sink_list_t l = {.len = 0};
+  l.queue = get_conf_num(args, "RIC_SINK_QUEUE", FR_RIC_SINK_QUEUE_DEFAULT, FR_RIC_SINK_QUEUE_MAX);
+  l.sample = get_conf_num(args, "RIC_SINK_SAMPLE", FR_RIC_SINK_SAMPLE_DEFAULT, UINT32_MAX);
+
+  char val[FR_CONF_VAL_LEN] = {0};
+  if(get_conf_val(args, "", "RIC_SINKS =", val) == false)
+    strcpy(val, FR_RIC_SINKS_DEFAULT);
+
+  if(strcmp(val, "none") == 0)
+    return l;
+
+  char* save = NULL;
+  for(char* tok = strtok_r(val, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)){
+    tok = ltrim(tok);
+    char* policy = strchr(tok, ':');
+    if(policy != NULL){
+      *policy++ = '\0';
+      policy = ltrim(policy);
+      if(*policy != '\0')
+        policy = rtrim(policy);
+    }
+
+    if(*tok == '\0' || strlen(tok) > FR_RIC_SINK_NAME_LEN - 1 || l.len == FR_RIC_SINKS_MAX){
+      printf("RIC_SINKS invalid. Up to %d comma separated sinks expected. Check the config file\n", FR_RIC_SINKS_MAX);
+      exit(EXIT_FAILURE);
+    }
+    tok = rtrim(tok);
+
+    for(size_t i = 0; i < l.len; ++i){
+      if(strcmp(l.sink[i].name, tok) == 0){
+        printf("RIC_SINKS invalid. Sink %s listed twice. Check the config file\n", tok);
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    fr_sink_t* dst = &l.sink[l.len++];
+    strcpy(dst->name, tok);
+    dst->overflow = policy != NULL ? parse_sink_overflow(tok, policy) : FR_SINK_DROP_OLDEST;
+  }
+
+  return l;
+}
@@ -1,9 +1,96 @@
 #ifndef FLEXRIC_CONFIGURATION_FILE_H
 #define FLEXRIC_CONFIGURATION_FILE_H
 
+#include <stddef.h>
 #include <stdint.h>
 #define FR_CONF_FILE_LEN 128
 
+// Max. number of SCTP messages drained from a socket per reactor wake up
+#define FR_RX_BATCH_DEFAULT 32
+#define FR_RX_BATCH_MAX 256
+
+// Max. number of nearRT-RIC reactor threads serving peeled off associations
+#define FR_RIC_REACTORS_MAX 64
+
+// Max. number of E2 agent event loops shared by the nearRT-RIC associations
+#define FR_E2_AGENT_REACTORS_MAX 16
+
+#define FR_RIC_WORKERS_MAX 1024
+
+#define FR_MAX_CPUS 1024
+
+#define FR_CONF_VAL_LEN 256
+
+// nearRT-RIC pub/sub listeners, each one behind its own queue and thread
+#define FR_RIC_SINKS_MAX 8
+#define FR_RIC_SINK_NAME_LEN 32
+#define FR_RIC_SINKS_DEFAULT "stdout,redis,influx"
+#define FR_RIC_SINK_QUEUE_DEFAULT 1024
+#define FR_RIC_SINK_QUEUE_MAX (1024*1024)
+#define FR_RIC_SINK_SAMPLE_DEFAULT 8
+
+// E42_SHM_RING in KiB
+#define FR_E42_SHM_RING_MAX (1024*1024)
+
+// xApp indications waiting for the callback, per report subscription
+#define FR_XAPP_DISP_QUEUE_DEFAULT 1024
+#define FR_XAPP_DISP_QUEUE_MAX (1024*1024)
+#define FR_XAPP_WORKERS_MAX 64
+
+// xApp DB indications per transaction, and ms a transaction stays open
+#define FR_XAPP_DB_BATCH_DEFAULT 64
+#define FR_XAPP_DB_BATCH_MAX (1024*1024)
+#define FR_XAPP_DB_BATCH_MS_DEFAULT 100
+#define FR_XAPP_DB_BATCH_MS_MAX (60*1000)
+#define FR_XAPP_DB_QUEUE_DEFAULT 4096
+#define FR_XAPP_DB_QUEUE_MAX (1024*1024)
+
+// Sorted, without duplicates
+typedef struct{
+  int cpu[FR_MAX_CPUS];
+  size_t len;
+} fr_cpu_list_t;
+
+typedef enum{
+  FR_SINK_BLOCK,
+  FR_SINK_DROP_OLDEST,
+  FR_SINK_SAMPLE,
+} fr_sink_overflow_e;
+
+typedef struct{
+  char name[FR_RIC_SINK_NAME_LEN];
+  fr_sink_overflow_e overflow;
+} fr_sink_t;
+
+typedef struct{
+  fr_sink_t sink[FR_RIC_SINKS_MAX];
+  size_t len;
+  // Indications queued per sink
+  size_t queue;
+  // FR_SINK_SAMPLE keeps 1 out of sample indications over half the queue
+  uint32_t sample;
+} fr_sink_list_t;
+
+typedef enum{
+  FR_DISP_BLOCK,
+  FR_DISP_DROP_OLDEST,
+  FR_DISP_KEEP_LATEST,
+} fr_disp_overflow_e;
+
+typedef struct{
+  size_t queue;
+  fr_disp_overflow_e overflow;
+  // Threads running the callbacks
+  size_t workers;
+} fr_disp_conf_t;
+
+typedef struct{
+  size_t batch;
+  size_t batch_ms;
+  // Indications waiting for the writer
+  size_t queue;
+} fr_db_conf_t;
+
 typedef struct {
   // Option 1: directly pass IP argument
   const char* server_ip;
@@ -12,6 +99,16 @@ typedef struct {
   // Option 2: read from file
   char conf_file[FR_CONF_FILE_LEN];
   char libs_dir[FR_CONF_FILE_LEN];
+
+  // Command line overrides of the [NEAR-RIC] thread placement.
+  // Empty if not passed, and then read from the config file
+  char ric_workers[FR_CONF_VAL_LEN];
+  char ric_worker_cpus[FR_CONF_VAL_LEN];
+  char ric_reactor_cpus[FR_CONF_VAL_LEN];
+  char ric_numa_node[FR_CONF_VAL_LEN];
+
+  // Command line override of the [XAPP] callback threads
+  char xapp_workers[FR_CONF_VAL_LEN];
 } fr_args_t;
 
 fr_args_t init_fr_args(int argc, char* argv[]);
@@ -22,4 +119,54 @@ char* get_conf_db_dir(fr_args_t const*);
 
 char* get_conf_db_name(fr_args_t const*);
 
+// RX_BATCH = n. FR_RX_BATCH_DEFAULT if not present
+size_t get_conf_rx_batch(fr_args_t const*);
+
+// RIC_REACTORS = n. 0 (i.e., all the associations share the
+// listening socket and its reactor) if not present
+size_t get_conf_ric_reactors(fr_args_t const*);
+
+// RIC_WORKERS = n or -w n. Task manager threads. 0 if not
+// present (i.e., the build default, NUM_THREADS_RIC)
+uint32_t get_conf_ric_workers(fr_args_t const*);
+
+// RIC_WORKER_CPUS = 2-5,8 or -W 2-5,8. Empty if not present
+fr_cpu_list_t get_conf_ric_worker_cpus(fr_args_t const*);
+
+// RIC_REACTOR_CPUS = 0-1 or -R 0-1. CPUs of the RIC, reactor and
+// iApp event loops. Empty if not present
+fr_cpu_list_t get_conf_ric_reactor_cpus(fr_args_t const*);
+
+// RIC_NUMA_NODE = n or -N n. -1 if not present
+int get_conf_ric_numa_node(fr_args_t const*);
+
+// RIC_SINKS = stdout:block,influx:sample. Overflow policy block, drop_oldest
+// (default) or sample per sink. FR_RIC_SINKS_DEFAULT if not present or empty,
+// and no sink if none. RIC_SINK_QUEUE = n and RIC_SINK_SAMPLE = n apply to all
+// of them. The names are not checked, but must be unique
+fr_sink_list_t get_conf_ric_sinks(fr_args_t const*);
+
+// E42_SHM_RING = n. KiB per direction of the shared memory channel between
+// the iApp and a co-located xApp. In bytes, or 0 (i.e., E42 over SCTP only)
+// if not present. The iApp sizes the rings, and the xApp only asks for them
+size_t get_conf_e42_shm_ring(fr_args_t const*);
+
+// XAPP_DISP_QUEUE = n and XAPP_DISP_OVERFLOW = block, drop_oldest (default)
+// or keep_latest. FR_XAPP_DISP_QUEUE_DEFAULT if not present. XAPP_WORKERS = n
+// or -x n callback threads, 1 if not present
+fr_disp_conf_t get_conf_xapp_disp(fr_args_t const*);
+
+// XAPP_DB_BATCH = n and XAPP_DB_BATCH_MS = n. The xApp DB commits once per
+// n indications or n ms. XAPP_DB_QUEUE = n indications wait at most for
+// the writer. FR_XAPP_DB_*_DEFAULT if not present
+fr_db_conf_t get_conf_xapp_db(fr_args_t const*);
+
+// E2_AGENT_REACTORS = n. Event loops of the E2 agent, each one serving the
+// associations of several nearRT-RICs. 0 (i.e., one thread per nearRT-RIC)
+// if not present
+size_t get_conf_e2_agent_reactors(fr_args_t const*);
+
+// CPU list, e.g., 0-3,8,10-11. Exits if invalid, naming the option
+fr_cpu_list_t parse_conf_cpu_list(const char* name, const char* val);
+
 #endif
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include "thread_affinity.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// From <linux/mempolicy.h>. libnuma is not needed for just this
+#define MPOL_PREFERRED 1
+
+void pin_thread_cpus(pthread_t t, size_t len, int const cpus[len])
+{
+  if(len == 0)
+    return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for(size_t i = 0; i < len; ++i){
+    assert(cpus[i] > -1 && cpus[i] < CPU_SETSIZE);
+    CPU_SET(cpus[i], &set);
+  }
+
+  int const rc = pthread_setaffinity_np(t, sizeof(set), &set);
+  if(rc != 0)
+    printf("[UTIL]: Thread not pinned: %s \n", strerror(rc));
+}
+
+fr_cpu_list_t cpus_numa_node(int node)
+{
+  assert(node > -1);
+
+  fr_cpu_list_t l = {.len = 0};
+
+  char path[128] = {0};
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+  FILE* fp = fopen(path, "r");
+  if(fp == NULL){
+    printf("[UTIL]: NUMA node %d not found \n", node);
+    return l;
+  }
+
+  char buf[FR_CONF_VAL_LEN] = {0};
+  char* line = fgets(buf, sizeof(buf), fp);
+  fclose(fp);
+  if(line == NULL)
+    return l;
+
+  buf[strcspn(buf, "\n")] = '\0';
+  // Memory only nodes have no CPUs
+  if(buf[0] == '\0')
+    return l;
+
+  return parse_conf_cpu_list(path, buf);
+}
+
+void prefer_numa_node(int node)
+{
+  assert(node > -1 && node < 1024);
+
+  size_t const bits = 8*sizeof(unsigned long);
+  unsigned long mask[1024 / (8*sizeof(unsigned long)) + 1] = {0};
+  mask[node / bits] = 1UL << (node % bits);
+
+  // The kernel reads maxnode - 1 bits
+  long const rc = syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, 1024 + 1);
+  if(rc != 0)
+    printf("[UTIL]: NUMA node %d not preferred: %s \n", node, strerror(errno));
+}
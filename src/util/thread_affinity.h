@@ -0,0 +1,41 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include "conf_file.h"
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Restrict t to the CPUs. No-op if len == 0
+void pin_thread_cpus(pthread_t t, size_t len, int const cpus[len]);
+
+// CPUs of the NUMA node, read from sysfs. Empty if unknown
+fr_cpu_list_t cpus_numa_node(int node);
+
+// The calling thread, and the threads it creates afterwards,
+// allocate memory from node while it has free pages
+void prefer_numa_node(int node);
+
+#endif
+
@@ -30,6 +30,7 @@
 typedef enum
 {
   NETWORK_EVENT,
+  SHM_EVENT,
   INDICATION_EVENT,
   PENDING_EVENT,
   UNKNOWN_EVENT,
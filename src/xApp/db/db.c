@@ -30,114 +30,71 @@
 
 typedef struct{
   global_e2_node_id_t id;
-  sm_ag_if_rd_t rd;
+  ind_shared_xapp_t* ind;
 } e2_node_ag_if_t;
 
-static
-e2_node_ag_if_t static_e2_node_ag_if; 
-
-static
-e2_node_ag_if_t static_e2_node_ag_if_10[10]; 
-
-static
-e2_node_ag_if_t static_e2_node_ag_if_100[100]; 
-
-
-
-static
-void* create_val(void* it)
-{
-  if(it == NULL)
-    return NULL;
-
-  memcpy(&static_e2_node_ag_if, it, sizeof(e2_node_ag_if_t));
-
-  return &static_e2_node_ag_if;
-}
-
-static 
-int val_10 = 0;
-
-static
-void* create_val_10(void* it)
-{
-  if(it == NULL)
-    return NULL;
-
-  memcpy(&static_e2_node_ag_if_10[val_10], it, sizeof(e2_node_ag_if_t));
-
-  ++val_10;
-  assert(val_10 < 11);
-  return &static_e2_node_ag_if_10;
-}
-
-static 
-int val_100 = 0;
-
-static
-void* create_val_100(void* it)
-{
-  if(it == NULL)
-    return NULL;
-
-  memcpy(&static_e2_node_ag_if_100[val_100], it, sizeof(e2_node_ag_if_t));
-
-  ++val_100;
-  assert(val_100 < 101);
-  return &static_e2_node_ag_if_100;
-}
-
-
 static
 void* worker_thread(void* arg)
 {
   db_xapp_t* db = (db_xapp_t*)arg;
 
-  int counter=0;
+  e2_node_ag_if_t* data = calloc(db->conf.batch, sizeof(e2_node_ag_if_t));
+  assert(data != NULL && "Memory exhausted");
+
+  // Indications in the open transaction, and when the first one arrived
+  size_t pending = 0;
+  int64_t first = 0;
 
   while(true){
-    e2_node_ag_if_t* data = NULL; 
-    size_t sz = size_tsnq(&db->q);
-    //printf("Current size of the db = %ld \n", sz);
-    if(sz > 100){
-      sz = 100;
-      val_100 = 0;
-      data = pop_tsnq_100(&db->q, create_val_100); 
-    } else if(sz > 10){
-      sz = 10;
-      val_10 = 0;
-      data = pop_tsnq_10(&db->q, create_val_10); 
-    } else{
-      sz = 1;
-      data = wait_and_pop_tsnq(&db->q, create_val);
+    // Do not keep the open transaction beyond batch_ms if idle
+    int64_t left_ms = -1;
+    if(pending > 0){
+      left_ms = db->conf.batch_ms - (time_now_us() - first) / 1000;
+      left_ms = left_ms < 0 ? 0 : left_ms;
+    }
+
+    size_t const sz = pop_n_mpscq(&db->q, data, db->conf.batch - pending, left_ms);
+    if(sz == 0 && stopped_mpscq(&db->q) == true)
+      break;
+
+    if(sz == 0){
+      commit_db_gen(&db->handler);
+      pending = 0;
+      continue;
     }
 
-    if(data == NULL)
-        break;
+    if(pending == 0)
+      first = time_now_us();
 
     for(size_t i = 0; i < sz; ++i){
-      write_db_gen(db->handler, &data[i].id, &data[i].rd);
+      write_db_gen(&db->handler, &data[i].id, &data[i].ind->rd);
       free_global_e2_node_id(&data[i].id);
+      release_ind_shared_xapp(data[i].ind);
+    }
 
-      assert(data[i].rd.type == INDICATION_MSG_AGENT_IF_ANS_V0);
-      free_sm_ag_if_rd_ind(&data[i].rd.ind);
+    pending += sz;
+    if(pending >= db->conf.batch || time_now_us() - first >= db->conf.batch_ms * 1000){
+      commit_db_gen(&db->handler);
+      pending = 0;
     }
-    counter++;
-    //printf("*******Counter of data: %d\n", counter);
   }
-  db->q.stopped = true;
 
+  free(data);
   return NULL;
 }
 
-void init_db_xapp(db_xapp_t* db, char const* db_filename)
+void init_db_xapp(db_xapp_t* db, char const* db_filename, db_conf_xapp_t conf)
 {
   assert(db != NULL);
   assert(db_filename != NULL);
+  assert(conf.batch > 0);
+  assert(conf.batch_ms > 0);
+  assert(conf.queue > 0);
 
+  db->conf = conf;
   init_db_gen(&db->handler, db_filename);
 
-  init_tsnq(&db->q, sizeof(e2_node_ag_if_t));
+  init_mpscq(&db->q, sizeof(e2_node_ag_if_t), conf.queue);
 
   int rc = pthread_create(&db->p, NULL, worker_thread, db);
   assert(rc == 0);
@@ -150,9 +107,7 @@ void free_e2_node_ag_if_wrapper(void* it)
 
   e2_node_ag_if_t* d = (e2_node_ag_if_t*)it;
   free_global_e2_node_id(&d->id);
-
-  assert(d->rd.type == INDICATION_MSG_AGENT_IF_ANS_V0);
-  free_sm_ag_if_rd_ind(&d->rd.ind);
+  release_ind_shared_xapp(d->ind);
 }
 
 
@@ -160,21 +115,25 @@ void close_db_xapp(db_xapp_t* db)
 {
   assert(db != NULL);
   
-  free_tsnq(&db->q, free_e2_node_ag_if_wrapper);
+  // The indications not yet written are lost
+  stop_mpscq(&db->q);
   pthread_join(db->p, NULL);
-  close_db_gen(db->handler);  
+  free_mpscq(&db->q, free_e2_node_ag_if_wrapper);
+  close_db_gen(&db->handler);
 }
 
-void write_db_xapp(db_xapp_t* db, global_e2_node_id_t const* id, sm_ag_if_rd_t const* rd)
+void write_db_xapp(db_xapp_t* db, global_e2_node_id_t const* id, ind_shared_xapp_t* ind)
 {
   assert(db != NULL);
-  assert(rd != NULL);
+  assert(ind != NULL);
   assert(id != NULL);
-  assert(rd->type == INDICATION_MSG_AGENT_IF_ANS_V0);
+  assert(ind->rd.type == INDICATION_MSG_AGENT_IF_ANS_V0);
 
-  e2_node_ag_if_t d = { .rd = cp_sm_ag_if_rd(rd) ,
+  // Not copied. Shared with the callback dispatcher
+  e2_node_ag_if_t d = { .ind = acquire_ind_shared_xapp(ind) ,
                         .id = cp_global_e2_node_id(id) };
 
-  push_tsnq(&db->q, &d, sizeof(d) );
+  if(push_mpscq(&db->q, &d) == false)
+    free_e2_node_ag_if_wrapper(&d);
 }
 
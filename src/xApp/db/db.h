@@ -24,31 +24,45 @@
 
 #include "../../lib/e2ap/e2ap_global_node_id_wrapper.h"
 #include "../../sm/agent_if/read/sm_ag_if_rd.h"
-#include "../../util/alg_ds/ds/tsn_queue/tsn_queue.h"
+#include "../ind_shared_xapp.h"
+#include "../../util/alg_ds/ds/mpsc_queue/mpsc_queue.h"
 
 #include <pthread.h>
 
 #ifdef SQLITE3_XAPP
-  #include "sqlite3/sqlite3.h"
+  #include "sqlite3/sqlite3_wrapper.h"
 #endif
 
+// The indications are committed in batches, i.e., one transaction per
+// batch indications or per batch_ms, whatever happens first. At most queue
+// indications wait for the writer, write_db_xapp waits if full
+typedef struct{
+  size_t batch;
+  int64_t batch_ms;
+  size_t queue;
+} db_conf_xapp_t;
+
 typedef struct{
 
 #ifdef SQLITE3_XAPP
-  sqlite3* handler;
+  db_sqlite3_t handler;
 #else
   static_assert(0!=0, "Unknown DB selected for the xApp"); 
 #endif
 
+  db_conf_xapp_t conf;
+
   pthread_t p;
-  tsnq_t q;
+  // Producer: E42 thread. Consumer: the writer thread
+  mpscq_t q;
 } db_xapp_t;
 
-void init_db_xapp(db_xapp_t* db, char const* db_filename);
+void init_db_xapp(db_xapp_t* db, char const* db_filename, db_conf_xapp_t conf);
 
 void close_db_xapp(db_xapp_t* db);
 
-void write_db_xapp(db_xapp_t* db, global_e2_node_id_t const* id, sm_ag_if_rd_t const* rd);
+// Takes a reference of ind, released once written
+void write_db_xapp(db_xapp_t* db, global_e2_node_id_t const* id, ind_shared_xapp_t* ind);
 
 #endif
 
@@ -29,17 +29,21 @@
 
 
 #define init_db_gen(T,U) _Generic ((T), \
-                                    sqlite3*:  init_db_sqlite3, \
+                                    db_sqlite3_t*:  init_db_sqlite3, \
                                     default:   init_db_sqlite3) (T,U)
 
 #define close_db_gen(T) _Generic ((T),\
-                                    sqlite3*: close_db_sqlite3, \
+                                    db_sqlite3_t*: close_db_sqlite3, \
                                     default:  close_db_sqlite3) (T)
 
 
 #define write_db_gen(T,U,V) _Generic ((T),\
-                                    sqlite3*:   write_db_sqlite3, \
+                                    db_sqlite3_t*:   write_db_sqlite3, \
                                     default:    write_db_sqlite3) (T,U,V)
 
+#define commit_db_gen(T) _Generic ((T),\
+                                    db_sqlite3_t*: commit_db_sqlite3, \
+                                    default:  commit_db_sqlite3) (T)
+
 #endif
 
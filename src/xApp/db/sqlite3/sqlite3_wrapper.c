@@ -21,6 +21,9 @@
 
 #include "sqlite3_wrapper.h"
 #include "../../../util/time_now_us.h"
+#include "../../../util/alg_ds/ds/lock_guard/lock_guard.h"
+#include "../../../sm/rc_sm/ie/ir/ran_param_struct.h"
+#include "../../../sm/rc_sm/ie/ir/ran_param_list.h"
 
 #include <assert.h>
 #include <stddef.h>
@@ -268,1183 +271,1223 @@ static void create_gtp_table(sqlite3* db)
 
   create_table(db, sql_gtp);
 }
-void create_kpm_table(sqlite3* db)
+
+// Columns of ue_id_e2sm_t. Only the ones of its type are not NULL
+#define UE_ID_COLS_SQLITE3 \
+      "ue_id_type INT CHECK(ue_id_type >= 0 AND ue_id_type < 7)," \
+      "amf_ue_ngap_id INT," \
+      "mme_ue_s1ap_id INT," \
+      "gnb_cu_ue_f1ap INT," \
+      "gnb_cu_cp_ue_e1ap INT," \
+      "ng_enb_cu_ue_w1ap_id INT," \
+      "enb_ue_x2ap_id INT," \
+      "ran_ue_id INT"
+
+// Columns of cell_global_id_t
+#define CELL_COLS_SQLITE3 \
+      "cell_rat INT CHECK(cell_rat == NULL OR (cell_rat >= 0 AND cell_rat < 2))," \
+      "cell_mcc INT," \
+      "cell_mnc INT," \
+      "cell_mnc_digit_len INT," \
+      "cell_id INT"
+
+static void create_kpm_table(sqlite3* db)
 {
   assert(db != NULL);
 
-  char* sql_kpm_measRecord =
-      "DROP TABLE IF EXISTS KPM_MeasRecord;"
-      "CREATE TABLE KPM_MeasRecord(tstamp INT,"
+  // Measurement name dictionary. One row per name, or id, ever received
+  char* sql_kpm_meas_type =
+      "DROP TABLE IF EXISTS KPM_MeasType;"
+      "CREATE TABLE KPM_MeasType(id INTEGER PRIMARY KEY,"
+      "name TEXT,"
+      "meas_id INT CHECK(meas_id == NULL OR (meas_id >= 0 AND meas_id < 65536))"
+      ");";
+  create_table(db, sql_kpm_meas_type);
+
+  char* sql_kpm_ind =
+      "DROP TABLE IF EXISTS KPM_Ind;"
+      "CREATE TABLE KPM_Ind(id INTEGER PRIMARY KEY,"
+      "tstamp INT CHECK(tstamp > 0),"
       "ngran_node INT CHECK(ngran_node >= 0 AND ngran_node < 9),"
       "mcc INT,"
       "mnc INT,"
       "mnc_digit_len INT,"
       "nb_id INT,"
       "cu_du_id TEXT,"
+      "format INT CHECK(format >= 1 AND format < 4),"
+      "collectStartTime INT,"
+      "gran_period_ms INT"
+      ");";
+  create_table(db, sql_kpm_ind);
+
+  // UEs of the format 3 indications
+  char* sql_kpm_ue =
+      "DROP TABLE IF EXISTS KPM_UE;"
+      "CREATE TABLE KPM_UE(id INTEGER PRIMARY KEY,"
+      "ind INT REFERENCES KPM_Ind(id),"
+      UE_ID_COLS_SQLITE3
+      ");";
+  create_table(db, sql_kpm_ue);
+
+  // One row per value. ue is NULL in the formats 1 and 2. period is the
+  // index in the measData list, and idx the index of the record
+  char* sql_kpm_meas_record =
+      "DROP TABLE IF EXISTS KPM_MeasRecord;"
+      "CREATE TABLE KPM_MeasRecord(ind INT REFERENCES KPM_Ind(id),"
+      "ue INT REFERENCES KPM_UE(id),"
+      "period INT CHECK(period >= 0 AND period < 65536),"
+      "idx INT CHECK(idx >= 0 AND idx < 65536),"
+      "meas INT REFERENCES KPM_MeasType(id),"
       "incompleteFlag INT,"
-      "val REAL CHECK(val >=0 AND val < 4294967296 )"
+      "int_val INT CHECK(int_val == NULL OR (int_val >= 0 AND int_val < 4294967296)),"
+      "real_val REAL"
       ");";
-  create_table(db, sql_kpm_measRecord);
+  create_table(db, sql_kpm_meas_record);
+}
 
-  // ToDo: PRIMARY KEY UNIQUE
-  char* sql_kpm_labelInfo =
-      "DROP TABLE IF EXISTS KPM_LabelInfo;"
-      "CREATE TABLE KPM_LabelInfo(tstamp INT CHECK(tstamp > 0),"
+static void create_rc_table(sqlite3* db)
+{
+  assert(db != NULL);
+
+  char* sql_rc_ind =
+      "DROP TABLE IF EXISTS RC_Ind;"
+      "CREATE TABLE RC_Ind(id INTEGER PRIMARY KEY,"
+      "tstamp INT CHECK(tstamp > 0),"
       "ngran_node INT CHECK(ngran_node >= 0 AND ngran_node < 9),"
       "mcc INT,"
       "mnc INT,"
       "mnc_digit_len INT,"
       "nb_id INT,"
       "cu_du_id TEXT,"
-      "MeasType TEXT,"
-      "noLabel INT CHECK(noLabel >=0 AND noLabel < 4294967296 ),"
-      "plmnID TEXT,"
-      "sST TEXT,"
-      "sD TEXT,"
-      "fiveQI  INT CHECK(fiveQI  >= 0 AND fiveQI  < 4294967296 ) ,"
-      "qFI INT  CHECK(qFI >= 0 AND qFI < 4294967296 ),"
-      "qCI INT  CHECK(qCI >= 0 AND qCI < 4294967296 ),"
-      "qCImax INT  CHECK(qCImax >= 0 AND qCImax < 4294967296 ),"
-      "qCImin INT  CHECK(qCImin >= 0 AND qCImin < 4294967296 ),"
-      "aRPmax INT  CHECK(aRPmax >= 0 AND aRPmax < 4294967296 ),"
-      "aRPmin INT  CHECK(aRPmin >= 0 AND aRPmin < 4294967296 ),"
-      "bitrateRange INT  CHECK(bitrateRange >= 0 AND bitrateRange <4294967296 ),"
-      "layerMU_MIMO INT  CHECK(layerMU_MIMO >= 0 AND layerMU_MIMO <4294967296),"
-      "sUM INT CHECK(sUM >= 0 AND sUM <4294967296),"
-      "distBinX INT CHECK(distBinX >= 0 AND distBinX <4294967296),"
-      "distBinY INT CHECK(distBinY >= 0 AND distBinY <4294967296),"
-      "distBinZ INT CHECK(distBinZ >= 0 AND distBinZ <4294967296),"
-      "preLabelOverride INT CHECK(preLabelOverride >= 0 AND preLabelOverride <4294967296),"
-      "startEndInd INT CHECK(startEndInd >= 0 AND startEndInd <4294967296),"
-      "min INT CHECK(min >= 0 AND min <4294967296),"
-      "max INT CHECK(max >= 0 AND max <4294967296),"
-      "avg INT CHECK(avg >= 0 AND avg < 4294967296)"
+      "ric_id INT,"
+      "hdr_format INT CHECK(hdr_format >= 1 AND hdr_format < 4),"
+      "msg_format INT CHECK(msg_format >= 1 AND msg_format < 7),"
+      "ev_trigger_id INT,"
+      "ric_style_type INT,"
+      "ins_ind_id INT"
       ");";
-  create_table(db, sql_kpm_labelInfo);
+  create_table(db, sql_rc_ind);
+
+  // UEs of the header (hdr = 1) and of the message formats 2 and 4
+  char* sql_rc_ue =
+      "DROP TABLE IF EXISTS RC_UE;"
+      "CREATE TABLE RC_UE(id INTEGER PRIMARY KEY,"
+      "ind INT REFERENCES RC_Ind(id),"
+      "hdr INT CHECK(hdr == 0 OR hdr == 1),"
+      UE_ID_COLS_SQLITE3 ","
+      "ue_ctx_info BLOB,"
+      CELL_COLS_SQLITE3
+      ");";
+  create_table(db, sql_rc_ue);
+
+  // Cells of the message formats 3 and 4
+  char* sql_rc_cell =
+      "DROP TABLE IF EXISTS RC_Cell;"
+      "CREATE TABLE RC_Cell(ind INT REFERENCES RC_Ind(id),"
+      CELL_COLS_SQLITE3 ","
+      "cell_ctx_info BLOB,"
+      "cell_del INT CHECK(cell_del == NULL OR cell_del == 0 OR cell_del == 1)"
+      ");";
+  create_table(db, sql_rc_cell);
+
+  // RAN parameters of the message formats 1, 2 and 5, as a tree. The
+  // members of a STRUCTURE, and the items of a LIST (lst_idx), point to
+  // their parent row
+  char* sql_rc_ran_param =
+      "DROP TABLE IF EXISTS RC_RanParam;"
+      "CREATE TABLE RC_RanParam(id INTEGER PRIMARY KEY,"
+      "ind INT REFERENCES RC_Ind(id),"
+      "ue INT REFERENCES RC_UE(id),"
+      "parent INT REFERENCES RC_RanParam(id),"
+      "lst_idx INT,"
+      "ran_param_id INT CHECK(ran_param_id >= 0 AND ran_param_id < 4294967296),"
+      "val_type INT CHECK(val_type >= 0 AND val_type < 4),"
+      "type INT CHECK(type == NULL OR (type >= 0 AND type < 6)),"
+      "int_val INT,"
+      "real_val REAL,"
+      "str_val BLOB"
+      ");";
+  create_table(db, sql_rc_ran_param);
 }
 
-// static
-// void insert_db(sqlite3* db, char const* sql)
-// {
-//   assert(db != NULL);
-//   assert(sql != NULL);
-
-//   char* err_msg = NULL;
-//   int rc = sqlite3_exec(db, sql, 0, 0, &err_msg);
-//   assert(rc == SQLITE_OK && "Error while inserting into the DB. Check the err_msg string for further info");
-// }
+// Pages in the WAL that wake up the checkpoint thread. SQLite default
+#define WAL_CKPT_PAGES 1000
+
+static
+char const* table_name[END_TABLE_SQLITE3] = {
+  [MAC_UE_SQLITE3] = "MAC_UE",
+  [RLC_BEARER_SQLITE3] = "RLC_bearer",
+  [PDCP_BEARER_SQLITE3] = "PDCP_bearer",
+  [SLICE_SQLITE3] = "SLICE",
+  [UE_SLICE_SQLITE3] = "UE_SLICE",
+  [GTP_NGUT_SQLITE3] = "GTP_NGUT",
+  [KPM_MEAS_TYPE_SQLITE3] = "KPM_MeasType",
+  [KPM_IND_SQLITE3] = "KPM_Ind",
+  [KPM_UE_SQLITE3] = "KPM_UE",
+  [KPM_MEAS_RECORD_SQLITE3] = "KPM_MeasRecord",
+  [RC_IND_SQLITE3] = "RC_Ind",
+  [RC_UE_SQLITE3] = "RC_UE",
+  [RC_CELL_SQLITE3] = "RC_Cell",
+  [RC_RAN_PARAM_SQLITE3] = "RC_RanParam",
+};
+
+static
+sqlite3_stmt* prepare_stmt(sqlite3* db, char const* sql)
+{
+  sqlite3_stmt* stmt = NULL;
+  int const rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL);
+  assert(rc == SQLITE_OK && "Error while preparing a statement. Check sqlite3_errmsg for further info");
+  return stmt;
+}
 
-static int insert_db(sqlite3* db, char const* sql)
+// INSERT INTO table VALUES(?, ..., ?), with as many parameters as columns
+static
+sqlite3_stmt* prepare_insert(sqlite3* db, char const* table)
 {
-  // Ensure the database connection and SQL statement are not NULL
-  if (db == NULL) {
-    fprintf(stderr, "Database connection is NULL\n");
-    return;
-  }
-  if (sql == NULL) {
-    fprintf(stderr, "SQL statement is NULL\n");
-    return;
+  char sql[512] = {0};
+  int n = snprintf(sql, sizeof(sql), "SELECT * FROM %s;", table);
+  assert(n < (int)sizeof(sql));
+
+  sqlite3_stmt* sel = prepare_stmt(db, sql);
+  int const cols = sqlite3_column_count(sel);
+  sqlite3_finalize(sel);
+  assert(cols > 0);
+
+  n = snprintf(sql, sizeof(sql), "INSERT INTO %s VALUES(", table);
+  for(int i = 0; i < cols; ++i){
+    assert(n + 3 < (int)sizeof(sql) && "Too many columns");
+    sql[n++] = '?';
+    sql[n++] = i + 1 < cols ? ',' : ')';
   }
+  sql[n] = '\0';
 
-  char* err_msg = NULL;
-  int rc = sqlite3_exec(db, sql, 0, 0, &err_msg);
-  if (rc != SQLITE_OK) {
-    // Print the error message to stderr
-    fprintf(stderr, "Error while inserting into the DB: %s\n", err_msg);
-    // Free the error message memory allocated by sqlite3_exec
-    sqlite3_free(err_msg);
-    return;
-  }
-  // Successfully inserted into the DB
-  return SQLITE_OK;
+  return prepare_stmt(db, sql);
 }
 
-static int to_sql_string_mac_ue(global_e2_node_id_t const* id,
-                                mac_ue_stats_impl_t* stats,
-                                int64_t tstamp,
-                                char* out,
-                                size_t out_len)
-{
-  assert(stats != NULL);
-  assert(out != NULL);
-  const size_t max = 1024;
-  assert(out_len >= max);
+// Parameters of the row being inserted
+typedef struct{
+  sqlite3_stmt* stmt;
+  int pos;
+} row_sqlite3_t;
 
-  char* c_null = NULL;
-  char c_cu_du_id[26];
-  if (id->cu_du_id) {
-    int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  }
+static
+void bind_int(row_sqlite3_t* r, int64_t val)
+{
+  int const rc = sqlite3_bind_int64(r->stmt, ++r->pos, val);
+  assert(rc == SQLITE_OK);
+}
 
-  int rc = snprintf(out,
-                    max,
-                    "INSERT INTO MAC_UE VALUES("
-                    "%ld," // tstamp
-                    "%d," // ngran_node
-                    "%d," // mcc
-                    "%d," // mnc
-                    "%d," // mnc_digit_len
-                    "%d," // nb_id
-                    "'%s'," // cu_du_id
-                    "%d," // frame
-                    "%d," // slot
-                    "%lu," // dl_aggr_tbs
-                    "%lu," // ul_aggr_tbs
-                    "%lu," // dl_aggr_bytes_sdus
-                    "%lu," // ul_aggr_bytes_sdus
-                    "%lu," // dl_curr_tbs
-                    "%lu," // ul_curr_tbs
-                    "%lu," // dl_sched_rb
-                    "%lu," // ul_sched_rb
-                    "%g," // pusch_snr
-                    "%g," //  pucch_snr
-                    "%u," // rnti
-                    "%u," // dl_aggr_prb
-                    "%u," //  ul_aggr_prb
-                    "%u," //  dl_aggr_sdus
-                    "%u," //  ul_aggr_sdus
-                    "%u," // dl_aggr_retx_prb
-                    "%u," // ul_aggr_retx_prb
-                    "%u," // wb_cqi
-                    "%u," // dl_mcs1
-                    "%u," // ul_mcs1
-                    "%u," // dl_mcs2
-                    "%u," // ul_mcs2
-                    "%d," // phr
-                    "%u," // bsr
-                    "%f," // dl_bler
-                    "%f," // ul_bler
-                    "%d," // dl_num_harq
-                    "%u," // dl_harq[0]
-                    "%u," // dl_harq[1]
-                    "%u," // dl_harq[2]
-                    "%u," // dl_harq[3]
-                    "%u," // dlsch_errors
-                    "%d," // ul_num_harq
-                    "%u," // ul_harq[0]
-                    "%u," // ul_harq[1]
-                    "%u," // ul_harq[2]
-                    "%u," // ul_harq[3]
-                    "%u," // ulsch_errors
-                    "%d," // pcmax
-                    "%f," // raw_rssi
-                    "%u," // cqi
-                    "%ld" // rsrp
-                    ");",
-                    tstamp,
-                    id->type,
-                    id->plmn.mcc,
-                    id->plmn.mnc,
-                    id->plmn.mnc_digit_len,
-                    id->nb_id.nb_id,
-                    id->cu_du_id ? c_cu_du_id : c_null,
-                    stats->frame,
-                    stats->slot,
-                    stats->dl_aggr_tbs,
-                    stats->ul_aggr_tbs,
-                    stats->dl_aggr_bytes_sdus,
-                    stats->ul_aggr_bytes_sdus,
-                    stats->dl_curr_tbs,
-                    stats->ul_curr_tbs,
-                    stats->dl_sched_rb,
-                    stats->ul_sched_rb,
-                    stats->pusch_snr,
-                    stats->pucch_snr,
-                    stats->rnti,
-                    stats->dl_aggr_prb,
-                    stats->ul_aggr_prb,
-                    stats->dl_aggr_sdus,
-                    stats->ul_aggr_sdus,
-                    stats->dl_aggr_retx_prb,
-                    stats->ul_aggr_retx_prb,
-                    stats->wb_cqi,
-                    stats->dl_mcs1,
-                    stats->ul_mcs1,
-                    stats->dl_mcs2,
-                    stats->ul_mcs2,
-                    stats->phr,
-                    stats->bsr,
-                    stats->dl_bler,
-                    stats->ul_bler,
-                    stats->dl_num_harq,
-                    stats->dl_harq[0],
-                    stats->dl_harq[1],
-                    stats->dl_harq[2],
-                    stats->dl_harq[3],
-                    stats->dl_harq[4],
-                    stats->ul_num_harq,
-                    stats->ul_harq[0],
-                    stats->ul_harq[1],
-                    stats->ul_harq[2],
-                    stats->ul_harq[3],
-                    stats->ul_harq[4],
-                    stats->pcmax,
-                    stats->raw_rssi,
-                    stats->cqi,
-                    stats->rsrp);
-  assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  return rc;
+static
+void bind_real(row_sqlite3_t* r, double val)
+{
+  int const rc = sqlite3_bind_double(r->stmt, ++r->pos, val);
+  assert(rc == SQLITE_OK);
 }
 
-static int to_sql_string_rlc_rb(global_e2_node_id_t const* id,
-                                rlc_radio_bearer_stats_t* rlc,
-                                int64_t tstamp,
-                                char* out,
-                                size_t out_len)
+// SQL NULL if str is NULL
+static
+void bind_text(row_sqlite3_t* r, char const* str, size_t len)
 {
-  assert(rlc != NULL);
-  assert(out != NULL);
-  const size_t max = 1024;
-  assert(out_len >= max);
+  int const rc = str == NULL ? sqlite3_bind_null(r->stmt, ++r->pos)
+                             : sqlite3_bind_text(r->stmt, ++r->pos, str, len, SQLITE_TRANSIENT);
+  assert(rc == SQLITE_OK);
+}
 
-  char* c_null = NULL;
-  char c_cu_du_id[26];
-  if (id->cu_du_id) {
-    int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  }
+static
+void bind_null(row_sqlite3_t* r)
+{
+  int const rc = sqlite3_bind_null(r->stmt, ++r->pos);
+  assert(rc == SQLITE_OK);
+}
 
-  int const rc = snprintf(out,
-                          max,
-                          "INSERT INTO RLC_bearer VALUES("
-                          "%ld," // tstamp
-                          "%d," // ngran_node
-                          "%d," // mcc
-                          "%d," // mnc
-                          "%d," // mnc_digit_len
-                          "%d," // nb_id
-                          "'%s'," // cu_du_id
-                          "%u," // rlc->txpdu_pkts
-                          "%u," // rlc->txpdu_bytes
-                          "%u," // rlc->txpdu_wt_ms
-                          "%u," // rlc->txpdu_dd_pkts
-                          "%u," // rlc->txpdu_dd_bytes
-                          "%u," // rlc->txpdu_retx_pkts
-                          "%u," // rlc->txpdu_retx_bytes
-                          "%u," // rlc->txpdu_segmented
-                          "%u," // rlc->txpdu_status_pkts
-                          "%u," // rlc->txpdu_status_bytes
-                          "%u," // rlc->txbuf_occ_bytes
-                          "%u," // rlc->txbuf_occ_pkts
-                          "%u," // rlc->rxpdu_pkts
-                          "%u," // rlc->rxpdu_bytes
-                          "%u," // rlc->rxpdu_dup_pkts
-                          "%u," // rlc->rxpdu_dup_bytes
-                          "%u," // rlc->rxpdu_dd_pkts
-                          "%u," // rlc->rxpdu_dd_bytes
-                          "%u," // rlc->rxpdu_ow_pkts
-                          "%u," // rlc->rxpdu_ow_bytes
-                          "%u," // rlc->rxpdu_status_pkts
-                          "%u," // rlc->rxpdu_status_bytes
-                          "%u," // rlc->rxbuf_occ_bytes
-                          "%u," // rlc->rxbuf_occ_pkts
-                          "%u," // rlc->txsdu_pkts
-                          "%lu," // rlc->txsdu_bytes
-                          "%.2f," // rlc->txsdu_avg_time_to_tx
-                          "%u," // rlc->txsdu_wt_us
-                          "%u," // rlc->rxsdu_pkts
-                          "%lu," // rlc->rxsdu_bytes
-                          "%u," // rlc->rxsdu_dd_pkts
-                          "%u," // rlc->rxsdu_dd_bytes
-                          "%u," // rlc->rnti
-                          "%u," // rlc->mode
-                          "%u" // rlc->rbid
-                          ");",
-                          tstamp,
-                          id->type,
-                          id->plmn.mcc,
-                          id->plmn.mnc,
-                          id->plmn.mnc_digit_len,
-                          id->nb_id.nb_id,
-                          id->cu_du_id ? c_cu_du_id : c_null,
-                          rlc->txpdu_pkts,
-                          rlc->txpdu_bytes,
-                          rlc->txpdu_wt_ms,
-                          rlc->txpdu_dd_pkts,
-                          rlc->txpdu_dd_bytes,
-                          rlc->txpdu_retx_pkts,
-                          rlc->txpdu_retx_bytes,
-                          rlc->txpdu_segmented,
-                          rlc->txpdu_status_pkts,
-                          rlc->txpdu_status_bytes,
-                          rlc->txbuf_occ_bytes,
-                          rlc->txbuf_occ_pkts,
-                          rlc->rxpdu_pkts,
-                          rlc->rxpdu_bytes,
-                          rlc->rxpdu_dup_pkts,
-                          rlc->rxpdu_dup_bytes,
-                          rlc->rxpdu_dd_pkts,
-                          rlc->rxpdu_dd_bytes,
-                          rlc->rxpdu_ow_pkts,
-                          rlc->rxpdu_ow_bytes,
-                          rlc->rxpdu_status_pkts,
-                          rlc->rxpdu_status_bytes,
-                          rlc->rxbuf_occ_bytes,
-                          rlc->rxbuf_occ_pkts,
-                          rlc->txsdu_pkts,
-                          rlc->txsdu_bytes,
-                          rlc->txsdu_avg_time_to_tx,
-                          rlc->txsdu_wt_us,
-                          rlc->rxsdu_pkts,
-                          rlc->rxsdu_bytes,
-                          rlc->rxsdu_dd_pkts,
-                          rlc->rxsdu_dd_bytes,
-                          rlc->rnti,
-                          rlc->mode,
-                          rlc->rbid);
-  assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  return rc;
+// SQL NULL if buf is NULL
+static
+void bind_blob(row_sqlite3_t* r, uint8_t const* buf, size_t len)
+{
+  int const rc = buf == NULL ? sqlite3_bind_null(r->stmt, ++r->pos)
+                             : sqlite3_bind_blob(r->stmt, ++r->pos, buf, len, SQLITE_TRANSIENT);
+  assert(rc == SQLITE_OK);
 }
 
-static int to_sql_string_pdcp_rb(global_e2_node_id_t const* id,
-                                 pdcp_radio_bearer_stats_t* pdcp,
-                                 int64_t tstamp,
-                                 char* out,
-                                 size_t out_len)
+static
+row_sqlite3_t new_row(db_sqlite3_t* db, table_sqlite3_e t)
 {
-  assert(pdcp != NULL);
-  assert(out != NULL);
-  const size_t max = 512;
-  assert(out_len >= max);
+  return (row_sqlite3_t){.stmt = db->ins[t], .pos = 0};
+}
 
-  char* c_null = NULL;
-  char c_cu_du_id[26];
+// Columns tstamp to cu_du_id, shared by all the tables
+static
+void bind_node(row_sqlite3_t* r, global_e2_node_id_t const* id, int64_t tstamp)
+{
+  bind_int(r, tstamp);
+  bind_int(r, id->type);
+  bind_int(r, id->plmn.mcc);
+  bind_int(r, id->plmn.mnc);
+  bind_int(r, id->plmn.mnc_digit_len);
+  bind_int(r, id->nb_id.nb_id);
+
+  char c_cu_du_id[26] = {0};
   if (id->cu_du_id) {
-    int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
+    int const rc = snprintf(c_cu_du_id, sizeof(c_cu_du_id), "%lu", *id->cu_du_id);
+    assert(rc < (int)sizeof(c_cu_du_id));
   }
+  bind_text(r, id->cu_du_id ? c_cu_du_id : NULL, strlen(c_cu_du_id));
+}
+
+// Rowid of the inserted row, or 0 on error
+static
+int64_t insert_row(db_sqlite3_t* db, table_sqlite3_e t, row_sqlite3_t* r)
+{
+  assert(r->pos == sqlite3_bind_parameter_count(r->stmt) && "Columns and values mismatch");
+
+  int const rc = sqlite3_step(r->stmt);
+  if (rc != SQLITE_DONE)
+    fprintf(stderr, "Error while inserting into the %s DB table: %s\n", table_name[t], sqlite3_errmsg(db->db));
 
-  int rc = snprintf(out,
-                    out_len,
-                    "INSERT INTO PDCP_bearer VALUES("
-                    "%ld," // tstamp
-                    "%d," // ngran_node
-                    "%d," // mcc
-                    "%d," // mnc
-                    "%d," // mnc_digit_len
-                    "%d," // nb_id
-                    "'%s'," // cu_du_id
-                    "%u," // txpdu_pkts
-                    "%u," // txpdu_bytes
-                    "%u," // txpdu_sn
-                    "%u," // rxpdu_pkts
-                    "%u," // rxpdu_bytes
-                    "%u," // rxpdu_sn
-                    "%u," // rxpdu_oo_pkts
-                    "%u," // rxpdu_oo_bytes
-                    "%u," // rxpdu_dd_pkts
-                    "%u," // rxpdu_dd_bytes
-                    "%u," // rxpdu_ro_count
-                    "%u," // txsdu_pkts
-                    "%u," // txsdu_bytes
-                    "%u," // rxsdu_pkts
-                    "%u," // rxsdu_bytes
-                    "%u," // rnti
-                    "%u," // mode
-                    "%u" // rbid
-                    ");",
-                    tstamp,
-                    id->type,
-                    id->plmn.mcc,
-                    id->plmn.mnc,
-                    id->plmn.mnc_digit_len,
-                    id->nb_id.nb_id,
-                    id->cu_du_id ? c_cu_du_id : c_null,
-                    pdcp->txpdu_pkts,
-                    pdcp->txpdu_bytes,
-                    pdcp->txpdu_sn,
-                    pdcp->rxpdu_pkts,
-                    pdcp->rxpdu_bytes,
-                    pdcp->rxpdu_sn,
-                    pdcp->rxpdu_oo_pkts,
-                    pdcp->rxpdu_oo_bytes,
-                    pdcp->rxpdu_dd_pkts,
-                    pdcp->rxpdu_dd_bytes,
-                    pdcp->rxpdu_ro_count,
-                    pdcp->txsdu_pkts,
-                    pdcp->txsdu_bytes,
-                    pdcp->rxsdu_pkts,
-                    pdcp->rxsdu_bytes,
-                    pdcp->rnti,
-                    pdcp->mode,
-                    pdcp->rbid);
-  assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  return rc;
+  sqlite3_reset(r->stmt);
+  return rc == SQLITE_DONE ? sqlite3_last_insert_rowid(db->db) : 0;
 }
 
-static int to_sql_string_ue_slice_rb(global_e2_node_id_t const* id,
-                                     ue_slice_conf_t const* ues,
-                                     ue_slice_assoc_t const* u,
-                                     int64_t tstamp,
-                                     char* out,
-                                     size_t out_len)
+static
+void begin_tx(db_sqlite3_t* db)
 {
-  assert(ues != NULL);
-  assert(out != NULL);
-  const size_t max = 512;
-  assert(out_len >= max);
+  if (db->tx == true)
+    return;
 
-  char* c_null = NULL;
-  char c_cu_du_id[26];
-  if (id->cu_du_id) {
-    int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  }
+  int const rc = sqlite3_step(db->begin);
+  assert(rc == SQLITE_DONE && "Error while beginning a transaction");
+  sqlite3_reset(db->begin);
+  db->tx = true;
+}
+
+static void write_mac_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, mac_ind_data_t const* ind)
+{
+  assert(db != NULL);
+  assert(ind != NULL);
+
+  mac_ind_msg_t const* ind_msg_mac = &ind->msg;
 
-  int rc = 0;
-  if (u == NULL) {
-    rc = snprintf(out,
-                  out_len,
-                  "INSERT INTO UE_SLICE VALUES("
-                  "%ld," // tstamp
-                  "%d," // ngran_node
-                  "%d," // mcc
-                  "%d," // mnc
-                  "%d," // mnc_digit_len
-                  "%d," // nb_id
-                  "'%s'," // cu_du_id
-                  "%d," // dl->len_ue_slices
-                  "%d," // ues[i]->rnti
-                  "%d" // ues[i]->dl_id
-                  ");",
-                  tstamp,
-                  id->type,
-                  id->plmn.mcc,
-                  id->plmn.mnc,
-                  id->plmn.mnc_digit_len,
-                  id->nb_id.nb_id,
-                  id->cu_du_id ? c_cu_du_id : c_null,
-                  ues->len_ue_slice,
-                  -1,
-                  -1);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
-    return rc;
+  for (size_t i = 0; i < ind_msg_mac->len_ue_stats; ++i) {
+    mac_ue_stats_impl_t const* stats = &ind_msg_mac->ue_stats[i];
+    row_sqlite3_t r = new_row(db, MAC_UE_SQLITE3);
+    bind_node(&r, id, ind_msg_mac->tstamp);
+
+    bind_int(&r, stats->frame);
+    bind_int(&r, stats->slot);
+    bind_int(&r, stats->dl_aggr_tbs);
+    bind_int(&r, stats->ul_aggr_tbs);
+    bind_int(&r, stats->dl_aggr_bytes_sdus);
+    bind_int(&r, stats->ul_aggr_bytes_sdus);
+    bind_int(&r, stats->dl_curr_tbs);
+    bind_int(&r, stats->ul_curr_tbs);
+    bind_int(&r, stats->dl_sched_rb);
+    bind_int(&r, stats->ul_sched_rb);
+    bind_real(&r, stats->pusch_snr);
+    bind_real(&r, stats->pucch_snr);
+    bind_int(&r, stats->rnti);
+    bind_int(&r, stats->dl_aggr_prb);
+    bind_int(&r, stats->ul_aggr_prb);
+    bind_int(&r, stats->dl_aggr_sdus);
+    bind_int(&r, stats->ul_aggr_sdus);
+    bind_int(&r, stats->dl_aggr_retx_prb);
+    bind_int(&r, stats->ul_aggr_retx_prb);
+    bind_int(&r, stats->wb_cqi);
+    bind_int(&r, stats->dl_mcs1);
+    bind_int(&r, stats->ul_mcs1);
+    bind_int(&r, stats->dl_mcs2);
+    bind_int(&r, stats->ul_mcs2);
+    bind_int(&r, stats->phr);
+    bind_int(&r, stats->bsr);
+    bind_real(&r, stats->dl_bler);
+    bind_real(&r, stats->ul_bler);
+    bind_int(&r, stats->dl_num_harq);
+    bind_int(&r, stats->dl_harq[0]);
+    bind_int(&r, stats->dl_harq[1]);
+    bind_int(&r, stats->dl_harq[2]);
+    bind_int(&r, stats->dl_harq[3]);
+    bind_int(&r, stats->dl_harq[4]); // dlsch_errors
+    bind_int(&r, stats->ul_num_harq);
+    bind_int(&r, stats->ul_harq[0]);
+    bind_int(&r, stats->ul_harq[1]);
+    bind_int(&r, stats->ul_harq[2]);
+    bind_int(&r, stats->ul_harq[3]);
+    bind_int(&r, stats->ul_harq[4]); // ulsch_errors
+    bind_int(&r, stats->pcmax);
+    bind_real(&r, stats->raw_rssi);
+    bind_int(&r, stats->cqi);
+    bind_int(&r, stats->rsrp);
+
+    insert_row(db, MAC_UE_SQLITE3, &r);
   }
+}
+
+static void write_rlc_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, rlc_ind_data_t const* ind)
+{
+  assert(db != NULL);
+  assert(ind != NULL);
+
+  rlc_ind_msg_t const* ind_msg_rlc = &ind->msg;
 
-  rc = snprintf(out,
-                out_len,
-                "INSERT INTO UE_SLICE VALUES("
-                "%ld," // tstamp
-                "%d," // ngran_node
-                "%d," // mcc
-                "%d," // mnc
-                "%d," // mnc_digit_len
-                "%d," // nb_id
-                "'%s'," // cu_du_id
-                "%d," // dl->len_ue_slices
-                "%d," // ues[i]->rnti
-                "%d" // ues[i]->dl_id
-                ");",
-                tstamp,
-                id->type,
-                id->plmn.mcc,
-                id->plmn.mnc,
-                id->plmn.mnc_digit_len,
-                id->nb_id.nb_id,
-                id->cu_du_id ? c_cu_du_id : c_null,
-                ues->len_ue_slice,
-                u->rnti,
-                u->dl_id);
-  assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  return rc;
+  for (size_t i = 0; i < ind_msg_rlc->len; ++i) {
+    rlc_radio_bearer_stats_t const* rlc = &ind_msg_rlc->rb[i];
+    row_sqlite3_t r = new_row(db, RLC_BEARER_SQLITE3);
+    bind_node(&r, id, ind_msg_rlc->tstamp);
+
+    bind_int(&r, rlc->txpdu_pkts);
+    bind_int(&r, rlc->txpdu_bytes);
+    bind_int(&r, rlc->txpdu_wt_ms);
+    bind_int(&r, rlc->txpdu_dd_pkts);
+    bind_int(&r, rlc->txpdu_dd_bytes);
+    bind_int(&r, rlc->txpdu_retx_pkts);
+    bind_int(&r, rlc->txpdu_retx_bytes);
+    bind_int(&r, rlc->txpdu_segmented);
+    bind_int(&r, rlc->txpdu_status_pkts);
+    bind_int(&r, rlc->txpdu_status_bytes);
+    bind_int(&r, rlc->txbuf_occ_bytes);
+    bind_int(&r, rlc->txbuf_occ_pkts);
+    bind_int(&r, rlc->rxpdu_pkts);
+    bind_int(&r, rlc->rxpdu_bytes);
+    bind_int(&r, rlc->rxpdu_dup_pkts);
+    bind_int(&r, rlc->rxpdu_dup_bytes);
+    bind_int(&r, rlc->rxpdu_dd_pkts);
+    bind_int(&r, rlc->rxpdu_dd_bytes);
+    bind_int(&r, rlc->rxpdu_ow_pkts);
+    bind_int(&r, rlc->rxpdu_ow_bytes);
+    bind_int(&r, rlc->rxpdu_status_pkts);
+    bind_int(&r, rlc->rxpdu_status_bytes);
+    bind_int(&r, rlc->rxbuf_occ_bytes);
+    bind_int(&r, rlc->rxbuf_occ_pkts);
+    bind_int(&r, rlc->txsdu_pkts);
+    bind_int(&r, rlc->txsdu_bytes);
+    bind_real(&r, rlc->txsdu_avg_time_to_tx);
+    bind_int(&r, rlc->txsdu_wt_us);
+    bind_int(&r, rlc->rxsdu_pkts);
+    bind_int(&r, rlc->rxsdu_bytes);
+    bind_int(&r, rlc->rxsdu_dd_pkts);
+    bind_int(&r, rlc->rxsdu_dd_bytes);
+    bind_int(&r, rlc->rnti);
+    bind_int(&r, rlc->mode);
+    bind_int(&r, rlc->rbid);
+
+    insert_row(db, RLC_BEARER_SQLITE3, &r);
+  }
 }
 
-static int to_sql_string_slice_rb(global_e2_node_id_t const* id,
-                                  ul_dl_slice_conf_t const* slices,
-                                  fr_slice_t const* s,
-                                  int64_t tstamp,
-                                  char* out,
-                                  size_t out_len)
+static void write_pdcp_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, pdcp_ind_data_t const* ind)
 {
-  assert(slices != NULL);
-  assert(out != NULL);
-  const size_t max = 1024;
-  assert(out_len >= max);
+  assert(db != NULL);
+  assert(ind != NULL);
 
-  char* c_null = NULL;
-  char sched_name[50];
-  sched_name[0] = '\0';
-  strncat(sched_name, slices->sched_name, slices->len_sched_name);
+  pdcp_ind_msg_t const* ind_msg_pdcp = &ind->msg;
 
-  char c_cu_du_id[26];
-  if (id->cu_du_id) {
-    int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
+  for (size_t i = 0; i < ind_msg_pdcp->len; ++i) {
+    pdcp_radio_bearer_stats_t const* pdcp = &ind_msg_pdcp->rb[i];
+    row_sqlite3_t r = new_row(db, PDCP_BEARER_SQLITE3);
+    bind_node(&r, id, ind_msg_pdcp->tstamp);
+
+    bind_int(&r, pdcp->txpdu_pkts);
+    bind_int(&r, pdcp->txpdu_bytes);
+    bind_int(&r, pdcp->txpdu_sn);
+    bind_int(&r, pdcp->rxpdu_pkts);
+    bind_int(&r, pdcp->rxpdu_bytes);
+    bind_int(&r, pdcp->rxpdu_sn);
+    bind_int(&r, pdcp->rxpdu_oo_pkts);
+    bind_int(&r, pdcp->rxpdu_oo_bytes);
+    bind_int(&r, pdcp->rxpdu_dd_pkts);
+    bind_int(&r, pdcp->rxpdu_dd_bytes);
+    bind_int(&r, pdcp->rxpdu_ro_count);
+    bind_int(&r, pdcp->txsdu_pkts);
+    bind_int(&r, pdcp->txsdu_bytes);
+    bind_int(&r, pdcp->rxsdu_pkts);
+    bind_int(&r, pdcp->rxsdu_bytes);
+    bind_int(&r, pdcp->rnti);
+    bind_int(&r, pdcp->mode);
+    bind_int(&r, pdcp->rbid);
+
+    insert_row(db, PDCP_BEARER_SQLITE3, &r);
   }
+}
+
+// Columns len_slices to type_param2. The params type and conf select the
+// meaning of the type_param columns
+static void write_slice_row(db_sqlite3_t* db,
+                            global_e2_node_id_t const* id,
+                            int64_t tstamp,
+                            ul_dl_slice_conf_t const* slices,
+                            fr_slice_t const* s)
+{
+  row_sqlite3_t r = new_row(db, SLICE_SQLITE3);
+  bind_node(&r, id, tstamp);
 
-  int rc = 0;
   if (s == NULL) {
-    rc = snprintf(
-        out,
-        out_len,
-        "INSERT INTO SLICE VALUES("
-        "%ld," // tstamp
-        "%d," // ngran_node
-        "%d," // mcc
-        "%d," // mnc
-        "%d," // mnc_digit_len
-        "%d," // nb_id
-        "'%s'," // cu_du_id
-        "%d," // dl->len_slices
-        "'%s'," // dl->sched_name
-        "%u," // dl->slice[i].id
-        "'%s'," // dl->slice[i].label
-        "'%s'," // dl->slice[i]->params.type
-        "'%s'," // dl->slice[i]->params.u.nvs.conf
-        "'%s'," // dl->slice[i].sched
-        "%.2f," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u1.mbps_required/nvs.u.capacity.u.pct_reserved/edf.deadline
-        "%.2f," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u2.mbps_reference/edf.guaranteed_prbs
-        "%.2f" // dl->slice[i]->params.u.edf.max_replenish
-        ");",
-        tstamp,
-        id->type,
-        id->plmn.mcc,
-        id->plmn.mnc,
-        id->plmn.mnc_digit_len,
-        id->nb_id.nb_id,
-        id->cu_du_id ? c_cu_du_id : c_null,
-        0,
-        sched_name,
-        0,
-        c_null,
-        c_null,
-        c_null,
-        c_null,
-        0.00,
-        0.00,
-        0.00);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
-    return rc;
+    bind_int(&r, 0); // len_slices
+    bind_text(&r, slices->sched_name, slices->len_sched_name);
+    bind_int(&r, 0); // id
+    bind_text(&r, NULL, 0); // label
+    bind_text(&r, NULL, 0); // type
+    bind_text(&r, NULL, 0); // type_conf
+    bind_text(&r, NULL, 0); // sched
+    bind_real(&r, 0.0);
+    bind_real(&r, 0.0);
+    bind_real(&r, 0.0);
+    insert_row(db, SLICE_SQLITE3, &r);
+    return;
   }
 
-  char label[50];
-  label[0] = '\0';
-  strncat(label, s->label, s->len_label);
-  char params_type[10];
-  params_type[0] = '\0';
-  char params_type_conf[10];
-  params_type_conf[0] = '\0';
-  char sched[50];
-  sched[0] = '\0';
-  strncat(sched, s->sched, s->len_sched);
+  bind_int(&r, slices->len_slices);
+  bind_text(&r, NULL, 0); // sched_name
+  bind_int(&r, s->id);
+  bind_text(&r, s->label, s->len_label);
+
   if (s->params.type == SLICE_ALG_SM_V0_STATIC) {
-    strcat(params_type, "STATIC");
-    rc =
-        snprintf(out,
-                 out_len,
-                 "INSERT INTO SLICE VALUES("
-                 "%ld," // tstamp
-                 "%d," // ngran_node
-                 "%d," // mcc
-                 "%d," // mnc
-                 "%d," // mnc_digit_len
-                 "%d," // nb_id
-                 "'%s'," // cu_du_id
-                 "%d," // dl->len_slices
-                 "'%s'," // dl->sched_name
-                 "%u," // dl->slice[i].id
-                 "'%s'," // dl->slice[i].label
-                 "'%s'," // dl->slice[i]->params.type
-                 "'%s'," // dl->slice[i]->params.u.nvs.conf
-                 "'%s'," // dl->slice[i].sched
-                 "%d," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u1.mbps_required/nvs.u.capacity.u.pct_reserved/edf.deadline
-                 "%d," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u2.mbps_reference/edf.guaranteed_prbs
-                 "%.2f" // dl->slice[i]->params.u.edf.max_replenish
-                 ");",
-                 tstamp,
-                 id->type,
-                 id->plmn.mcc,
-                 id->plmn.mnc,
-                 id->plmn.mnc_digit_len,
-                 id->nb_id.nb_id,
-                 id->cu_du_id ? c_cu_du_id : c_null,
-                 slices->len_slices,
-                 c_null,
-                 s->id,
-                 label,
-                 params_type,
-                 c_null,
-                 sched,
-                 s->params.u.sta.pos_low,
-                 s->params.u.sta.pos_high,
-                 0.00);
-  } else if (s->params.type == SLICE_ALG_SM_V0_NVS) {
-    strcat(params_type, "NVS");
-    if (s->params.u.nvs.conf == SLICE_SM_NVS_V0_RATE) {
-      strcat(params_type_conf, "RATE");
-      rc = snprintf(
-          out,
-          out_len,
-          "INSERT INTO SLICE VALUES("
-          "%ld," // tstamp
-          "%d," // ngran_node
-          "%d," // mcc
-          "%d," // mnc
-          "%d," // mnc_digit_len
-          "%d," // nb_id
-          "'%s'," // cu_du_id
-          "%d," // dl->len_slices
-          "'%s'," // dl->sched_name
-          "%u," // dl->slice[i].id
-          "'%s'," // dl->slice[i].label
-          "'%s'," // dl->slice[i]->params.type
-          "'%s'," // dl->slice[i]->params.u.nvs.conf
-          "'%s'," // dl->slice[i].sched
-          "%.2f," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u1.mbps_required/nvs.u.capacity.u.pct_reserved/edf.deadline
-          "%.2f," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u2.mbps_reference/edf.guaranteed_prbs
-          "%.2f" // dl->slice[i]->params.u.edf.max_replenish
-          ");",
-          tstamp,
-          id->type,
-          id->plmn.mcc,
-          id->plmn.mnc,
-          id->plmn.mnc_digit_len,
-          id->nb_id.nb_id,
-          id->cu_du_id ? c_cu_du_id : c_null,
-          slices->len_slices,
-          c_null,
-          s->id,
-          label,
-          params_type,
-          params_type_conf,
-          sched,
-          s->params.u.nvs.u.rate.u1.mbps_required,
-          s->params.u.nvs.u.rate.u2.mbps_reference,
-          0.00);
-    } else if (s->params.u.nvs.conf == SLICE_SM_NVS_V0_CAPACITY) {
-      strcat(params_type_conf, "CAPACITY");
-      rc = snprintf(
-          out,
-          out_len,
-          "INSERT INTO SLICE VALUES("
-          "%ld," // tstamp
-          "%d," // ngran_node
-          "%d," // mcc
-          "%d," // mnc
-          "%d," // mnc_digit_len
-          "%d," // nb_id
-          "'%s'," // cu_du_id
-          "%d," // dl->len_slices
-          "'%s'," // dl->sched_name
-          "%u," // dl->slice[i].id
-          "'%s'," // dl->slice[i].label
-          "'%s'," // dl->slice[i]->params.type
-          "'%s'," // dl->slice[i]->params.u.nvs.conf
-          "'%s'," // dl->slice[i].sched
-          "%.2f," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u1.mbps_required/nvs.u.capacity.u.pct_reserved/edf.deadline
-          "%.2f," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u2.mbps_reference/edf.guaranteed_prbs
-          "%.2f" // dl->slice[i]->params.u.edf.max_replenish
-          ");",
-          tstamp,
-          id->type,
-          id->plmn.mcc,
-          id->plmn.mnc,
-          id->plmn.mnc_digit_len,
-          id->nb_id.nb_id,
-          id->cu_du_id ? c_cu_du_id : c_null,
-          slices->len_slices,
-          c_null,
-          s->id,
-          label,
-          params_type,
-          params_type_conf,
-          sched,
-          s->params.u.nvs.u.capacity.u.pct_reserved,
-          0.00,
-          0.00);
-    }
+    bind_text(&r, "STATIC", strlen("STATIC"));
+    bind_text(&r, NULL, 0);
+    bind_text(&r, s->sched, s->len_sched);
+    bind_int(&r, s->params.u.sta.pos_low);
+    bind_int(&r, s->params.u.sta.pos_high);
+    bind_real(&r, 0.0);
+  } else if (s->params.type == SLICE_ALG_SM_V0_NVS && s->params.u.nvs.conf == SLICE_SM_NVS_V0_RATE) {
+    bind_text(&r, "NVS", strlen("NVS"));
+    bind_text(&r, "RATE", strlen("RATE"));
+    bind_text(&r, s->sched, s->len_sched);
+    bind_real(&r, s->params.u.nvs.u.rate.u1.mbps_required);
+    bind_real(&r, s->params.u.nvs.u.rate.u2.mbps_reference);
+    bind_real(&r, 0.0);
+  } else if (s->params.type == SLICE_ALG_SM_V0_NVS && s->params.u.nvs.conf == SLICE_SM_NVS_V0_CAPACITY) {
+    bind_text(&r, "NVS", strlen("NVS"));
+    bind_text(&r, "CAPACITY", strlen("CAPACITY"));
+    bind_text(&r, s->sched, s->len_sched);
+    bind_real(&r, s->params.u.nvs.u.capacity.u.pct_reserved);
+    bind_real(&r, 0.0);
+    bind_real(&r, 0.0);
   } else if (s->params.type == SLICE_ALG_SM_V0_EDF) {
-    strcat(params_type, "EDF");
-    rc =
-        snprintf(out,
-                 out_len,
-                 "INSERT INTO SLICE VALUES("
-                 "%ld," // tstamp
-                 "%d," // ngran_node
-                 "%d," // mcc
-                 "%d," // mnc
-                 "%d," // mnc_digit_len
-                 "%d," // nb_id
-                 "'%s'," // cu_du_id
-                 "%d," // dl->len_slices
-                 "'%s'," // dl->sched_name
-                 "%u," // dl->slice[i].id
-                 "'%s'," // dl->slice[i].label
-                 "'%s'," // dl->slice[i]->params.type
-                 "'%s'," // dl->slice[i]->params.u.nvs.conf
-                 "'%s'," // dl->slice[i].sched
-                 "%d," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u1.mbps_required/nvs.u.capacity.u.pct_reserved/edf.deadline
-                 "%d," // dl->slice[i]->params.u.sta.pos_high/nvs.u.rate.u2.mbps_reference/edf.guaranteed_prbs
-                 "%d" // dl->slice[i]->params.u.edf.max_replenish
-                 ");",
-                 tstamp,
-                 id->type,
-                 id->plmn.mcc,
-                 id->plmn.mnc,
-                 id->plmn.mnc_digit_len,
-                 id->nb_id.nb_id,
-                 id->cu_du_id ? c_cu_du_id : c_null,
-                 slices->len_slices,
-                 c_null,
-                 s->id,
-                 label,
-                 params_type,
-                 c_null,
-                 sched,
-                 s->params.u.edf.deadline,
-                 s->params.u.edf.guaranteed_prbs,
-                 s->params.u.edf.max_replenish);
+    bind_text(&r, "EDF", strlen("EDF"));
+    bind_text(&r, NULL, 0);
+    bind_text(&r, s->sched, s->len_sched);
+    bind_int(&r, s->params.u.edf.deadline);
+    bind_int(&r, s->params.u.edf.guaranteed_prbs);
+    bind_int(&r, s->params.u.edf.max_replenish);
+  } else {
+    // Unknown algorithm. Nothing written
+    sqlite3_clear_bindings(r.stmt);
+    return;
   }
-  assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  return rc;
+
+  insert_row(db, SLICE_SQLITE3, &r);
 }
 
-static int to_sql_string_gtp_NGUT(global_e2_node_id_t const* id, gtp_ngu_t_stats_t* gtp, int64_t tstamp, char* out, size_t out_len)
+static void write_slice_conf_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, int64_t tstamp, slice_conf_t const* slice_conf)
 {
-  assert(gtp != NULL);
-  assert(out != NULL);
-  const size_t max = 1024;
-  assert(out_len >= max);
+  ul_dl_slice_conf_t const* dlslices = &slice_conf->dl;
+  if (dlslices->len_slices > 0) {
+    for (size_t i = 0; i < dlslices->len_slices; ++i) {
+      write_slice_row(db, id, tstamp, dlslices, &dlslices->slices[i]);
+    }
+  } else {
+    write_slice_row(db, id, tstamp, dlslices, NULL);
+  }
 
-  char* c_null = NULL;
-  char c_cu_du_id[26];
-  if (id->cu_du_id) {
-    int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-    assert(rc < (int)max && "Not enough space in the char array to write all the data");
+  // TODO: Process uplink slice stats
+}
+
+static void write_ue_slice_conf_stats(db_sqlite3_t* db,
+                                      global_e2_node_id_t const* id,
+                                      int64_t tstamp,
+                                      ue_slice_conf_t const* ue_slice_conf)
+{
+  // One row with rnti and dl_id -1 if there are no UEs
+  uint32_t const len = ue_slice_conf->len_ue_slice > 0 ? ue_slice_conf->len_ue_slice : 1;
+
+  for (uint32_t j = 0; j < len; ++j) {
+    ue_slice_assoc_t const* u = ue_slice_conf->len_ue_slice > 0 ? &ue_slice_conf->ues[j] : NULL;
+    row_sqlite3_t r = new_row(db, UE_SLICE_SQLITE3);
+    bind_node(&r, id, tstamp);
+
+    bind_int(&r, ue_slice_conf->len_ue_slice);
+    bind_int(&r, u != NULL ? u->rnti : -1);
+    bind_int(&r, u != NULL ? (int64_t)u->dl_id : -1);
+
+    insert_row(db, UE_SLICE_SQLITE3, &r);
   }
+}
+
+static void write_slice_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, slice_ind_data_t const* ind)
+{
+  assert(db != NULL);
+  assert(ind != NULL);
 
-  int const rc = snprintf(out,
-                          max,
-                          "INSERT INTO GTP_NGUT VALUES("
-                          "%ld," // tstamp
-                          "%d," // ngran_node
-                          "%d," // mcc
-                          "%d," // mnc
-                          "%d," // mnc_digit_len
-                          "%d," // nb_id
-                          "'%s'," // cu_du_id
-                          "%u," // teidgnb
-                          "%u," // rnti
-                          "%u," // qfi
-                          "%u," // teidupf
-                          "%u," // ue_context_has_mqr
-                          "%u," // ue_context_rrc_ue_id
-                          "%u," // ue_context_rnti_t
-                          "%ld," // ue_context_mqr_rsrp
-                          "%f," // ue_context_mqr_rsrq
-                          "%f" // ue_context_mqr_sinr
-                          ");",
-                          tstamp,
-                          id->type,
-                          id->plmn.mcc,
-                          id->plmn.mnc,
-                          id->plmn.mnc_digit_len,
-                          id->nb_id.nb_id,
-                          id->cu_du_id ? c_cu_du_id : c_null,
-                          gtp->teidgnb,
-                          gtp->rnti,
-                          gtp->qfi,
-                          gtp->teidupf,
-                          gtp->ue_context_has_mqr,
-                          gtp->ue_context_rrc_ue_id,
-                          gtp->ue_context_rnti_t,
-                          gtp->ue_context_mqr_rsrp,
-                          gtp->ue_context_mqr_rsrq,
-                          gtp->ue_context_mqr_sinr);
-  assert(rc < (int)max && "Not enough space in the char array to write all the data");
-  return rc;
+  slice_ind_msg_t const* ind_msg_slice = &ind->msg;
+
+  write_slice_conf_stats(db, id, ind_msg_slice->tstamp, &ind_msg_slice->slice_conf);
+  write_ue_slice_conf_stats(db, id, ind_msg_slice->tstamp, &ind_msg_slice->ue_slice_conf);
 }
 
-// static
-// void to_sql_string_kpm_measRecord(global_e2_node_id_t const* id,
-//                                  MeasDataItem_t* kpm_measData,
-//                                  MeasRecord_t* kpm_measRecord,
-//                                  uint32_t tstamp,
-//                                  char* out,
-//                                  size_t out_len)
-// {
-//   assert(kpm_measData != NULL);
-//   assert(out != NULL);
-//   const size_t max = 512;
-//   assert(out_len >= max);
-
-//   char* c_null = NULL;
-//   char c_cu_du_id[26];
-//   if (id->cu_du_id) {
-//     int rc = snprintf(c_cu_du_id, 26, "%lu", *id->cu_du_id);
-//     assert(rc < (int) max && "Not enough space in the char array to write all the data");
-//   }
-
-//   if (kpm_measRecord == NULL){
-//     int const rc = snprintf(out, max,
-//         "INSERT INTO KPM_MeasRecord VALUES("
-//         "%u,"// tstamp
-//         "%d," //ngran_node
-//         "%d," //mcc
-//         "%d," //mnc
-//         "%d," //mnc_digit_len
-//         "%d," //nb_id
-//         "'%s'," //cu_du_id
-//         "%p,"  //kpm_measData->incompleteFlag
-//         "NULL"  //kpm_measRecord->int_val
-//         ");"
-//         , tstamp
-//         , id->type
-//         , id->plmn.mcc
-//         , id->plmn.mnc
-//         , id->plmn.mnc_digit_len
-//         , id->nb_id
-//         , id->cu_du_id ? c_cu_du_id : c_null
-//         , (void *)kpm_measData->incompleteFlag
-//         // , granulPeriod
-//         );
-//     assert(rc < (int)max && "Not enough space in the char array to write all the data");
-//     return ;
-//   } else {
-//     if(kpm_measRecord->type == MeasRecord_int){
-//       int const rc = snprintf(out, max,
-//           "INSERT INTO KPM_MeasRecord VALUES("
-//           "%u,"// tstamp
-//           "%d," //ngran_node
-//           "%d," //mcc
-//           "%d," //mnc
-//           "%d," //mnc_digit_len
-//           "%d," //nb_id
-//           "'%s'," //cu_du_id
-//           "%p,"  //kpm_measData->incompleteFlag
-//           "%ld"  //kpm_measRecord->int_val
-//           ");"
-//           , tstamp
-//           , id->type
-//           , id->plmn.mcc
-//           , id->plmn.mnc
-//           , id->plmn.mnc_digit_len
-//           , id->nb_id
-//           , id->cu_du_id ? c_cu_du_id : c_null
-//           , (void *)kpm_measData->incompleteFlag
-//           , kpm_measRecord->int_val
-//           );
-//       assert(rc < (int)max && "Not enough space in the char array to write all the data");
-//       return;
-//     }else if (kpm_measRecord->type == MeasRecord_real){
-//       int const rc = snprintf(out, max,
-//           "INSERT INTO KPM_MeasRecord VALUES("
-//           "%u,"// tstamp
-//           "%d," //ngran_node
-//           "%d," //mcc
-//           "%d," //mnc
-//           "%d," //mnc_digit_len
-//           "%d," //nb_id
-//           "'%s'," //cu_du_id
-//           "%p,"  //kpm_measData->incompleteFlag
-//           "%f"  //kpm_measRecord->real_val
-//           ");"
-//           , tstamp
-//           , id->type
-//           , id->plmn.mcc
-//           , id->plmn.mnc
-//           , id->plmn.mnc_digit_len
-//           , id->nb_id
-//           , id->cu_du_id ? c_cu_du_id : c_null
-//           , (void *)kpm_measData->incompleteFlag
-//           , kpm_measRecord->real_val
-//           );
-//       assert(rc < (int)max && "Not enough space in the char array to write all the data");
-//       return;
-//     }else if (kpm_measRecord->type == MeasRecord_noval){
-//       int const rc = snprintf(out, max,
-//           "INSERT INTO KPM_MeasRecord VALUES("
-//           "%u,"// tstamp
-//           "%d," //ngran_node
-//           "%d," //mcc
-//           "%d," //mnc
-//           "%d," //mnc_digit_len
-//           "%d," //nb_id
-//           "'%s'," //cu_du_id
-//           "%p,"  //kpm_measData->incompleteFlag
-//           "-1"  //kpm_measRecord->noVal
-//           ");"
-//           , tstamp
-//           , id->type
-//           , id->plmn.mcc
-//           , id->plmn.mnc
-//           , id->plmn.mnc_digit_len
-//           , id->nb_id
-//           , id->cu_du_id ? c_cu_du_id : c_null
-//           , (void *)kpm_measData->incompleteFlag
-//           );
-//       assert(rc < (int)max && "Not enough space in the char array to write all the data");
-//       return;
-//     }
-//   }
-//   assert(0!=0 && "Bad input data. Nothing for SQL to be created");
-// }
-
-static void write_mac_stats(sqlite3* db, global_e2_node_id_t const* id, mac_ind_data_t const* ind)
+static void write_gtp_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, gtp_ind_data_t const* ind)
 {
   assert(db != NULL);
   assert(ind != NULL);
 
-  mac_ind_msg_t const* ind_msg_mac = &ind->msg;
+  gtp_ind_msg_t const* ind_msg_gtp = &ind->msg;
 
-  char buffer[2048] = {0};
-  int pos = 0;
+  for (size_t i = 0; i < ind_msg_gtp->len; ++i) {
+    gtp_ngu_t_stats_t const* gtp = &ind_msg_gtp->ngut[i];
+    row_sqlite3_t r = new_row(db, GTP_NGUT_SQLITE3);
+    bind_node(&r, id, ind_msg_gtp->tstamp);
+
+    bind_int(&r, gtp->teidgnb);
+    bind_int(&r, gtp->rnti);
+    bind_int(&r, gtp->qfi);
+    bind_int(&r, gtp->teidupf);
+    bind_int(&r, gtp->ue_context_has_mqr);
+    bind_int(&r, gtp->ue_context_rrc_ue_id);
+    bind_int(&r, gtp->ue_context_rnti_t);
+    bind_int(&r, gtp->ue_context_mqr_rsrp);
+    bind_real(&r, gtp->ue_context_mqr_rsrq);
+    bind_real(&r, gtp->ue_context_mqr_sinr);
+
+    insert_row(db, GTP_NGUT_SQLITE3, &r);
+  }
+}
 
-  // printf("****Before the database\n");
-  // printf("Before writing the database dl_aggr_tbs: %lu\n", ind_msg_mac->ue_stats[0].dl_aggr_tbs);
-  // printf("Before writing the database rsrp: %ld\n", ind_msg_mac->ue_stats[0].rsrp);
-  // printf("Before writing the database cqi: %d\n", ind_msg_mac->ue_stats[0].cqi);
-  // printf("Before writing the database pcmax: %d\n", ind_msg_mac->ue_stats[0].pcmax);
-  // printf("Before writing the database rssi: %.1f\n", ind_msg_mac->ue_stats[0].raw_rssi);
-  // printf("****Before the database\n");
+// Foreign key. SQL NULL if the referenced row was not inserted
+static
+void bind_rowid(row_sqlite3_t* r, int64_t rowid)
+{
+  if (rowid == 0)
+    bind_null(r);
+  else
+    bind_int(r, rowid);
+}
 
-  for (size_t i = 0; i < ind_msg_mac->len_ue_stats; ++i) {
-    pos += to_sql_string_mac_ue(id, &ind_msg_mac->ue_stats[i], ind_msg_mac->tstamp, buffer + pos, 2048 - pos);
+// Columns ue_id_type to ran_ue_id
+static
+void bind_ue_id(row_sqlite3_t* r, ue_id_e2sm_t const* ue)
+{
+  enum {AMF, MME, F1AP, E1AP, W1AP, X2AP, RAN_UE_ID, END_UE_ID_COL};
+  int64_t val[END_UE_ID_COL] = {0};
+  bool set[END_UE_ID_COL] = {0};
+
+  if (ue->type == GNB_UE_ID_E2SM) {
+    gnb_e2sm_t const* u = &ue->gnb;
+    val[AMF] = u->amf_ue_ngap_id, set[AMF] = true;
+    if (u->gnb_cu_ue_f1ap_lst_len > 0)
+      val[F1AP] = u->gnb_cu_ue_f1ap_lst[0], set[F1AP] = true;
+    if (u->gnb_cu_cp_ue_e1ap_lst_len > 0)
+      val[E1AP] = u->gnb_cu_cp_ue_e1ap_lst[0], set[E1AP] = true;
+    if (u->ran_ue_id != NULL)
+      val[RAN_UE_ID] = *u->ran_ue_id, set[RAN_UE_ID] = true;
+  } else if (ue->type == GNB_DU_UE_ID_E2SM) {
+    val[F1AP] = ue->gnb_du.gnb_cu_ue_f1ap, set[F1AP] = true;
+    if (ue->gnb_du.ran_ue_id != NULL)
+      val[RAN_UE_ID] = *ue->gnb_du.ran_ue_id, set[RAN_UE_ID] = true;
+  } else if (ue->type == GNB_CU_UP_UE_ID_E2SM) {
+    val[E1AP] = ue->gnb_cu_up.gnb_cu_cp_ue_e1ap, set[E1AP] = true;
+    if (ue->gnb_cu_up.ran_ue_id != NULL)
+      val[RAN_UE_ID] = *ue->gnb_cu_up.ran_ue_id, set[RAN_UE_ID] = true;
+  } else if (ue->type == NG_ENB_UE_ID_E2SM) {
+    val[AMF] = ue->ng_enb.amf_ue_ngap_id, set[AMF] = true;
+    if (ue->ng_enb.ng_enb_cu_ue_w1ap_id != NULL)
+      val[W1AP] = *ue->ng_enb.ng_enb_cu_ue_w1ap_id, set[W1AP] = true;
+  } else if (ue->type == NG_ENB_DU_UE_ID_E2SM) {
+    val[W1AP] = ue->ng_enb_du.ng_enb_cu_ue_w1ap_id, set[W1AP] = true;
+  } else if (ue->type == EN_GNB_UE_ID_E2SM) {
+    en_gnb_e2sm_t const* u = &ue->en_gnb;
+    val[X2AP] = u->enb_ue_x2ap_id, set[X2AP] = true;
+    if (u->gnb_cu_ue_f1ap_lst != NULL)
+      val[F1AP] = u->gnb_cu_ue_f1ap_lst[0], set[F1AP] = true;
+    if (u->gnb_cu_cp_ue_e1ap_lst_len > 0)
+      val[E1AP] = u->gnb_cu_cp_ue_e1ap_lst[0], set[E1AP] = true;
+    if (u->ran_ue_id != NULL)
+      val[RAN_UE_ID] = *u->ran_ue_id, set[RAN_UE_ID] = true;
+  } else if (ue->type == ENB_UE_ID_E2SM) {
+    val[MME] = ue->enb.mme_ue_s1ap_id, set[MME] = true;
+    if (ue->enb.enb_ue_x2ap_id != NULL)
+      val[X2AP] = *ue->enb.enb_ue_x2ap_id, set[X2AP] = true;
+  } else {
+    assert(0 != 0 && "Unknown UE ID type");
   }
 
-  // insert_db(db, buffer);
-  // printf("Successfully insert DB entries into MAC_UE table\n");
+  bind_int(r, ue->type);
+  for (size_t i = 0; i < END_UE_ID_COL; ++i) {
+    if (set[i])
+      bind_int(r, val[i]);
+    else
+      bind_null(r);
+  }
+}
 
-  int rc = insert_db(db, buffer);
-  if (rc != SQLITE_OK) {
-    // Handle error - error message already printed in the function
-    // Additional error handling if needed
-    printf("Failled to insert into the MAC_UE DB\n");
+// Columns cell_rat to cell_id. SQL NULL if c is NULL
+static
+void bind_cell(row_sqlite3_t* r, cell_global_id_t const* c)
+{
+  if (c == NULL) {
+    for (size_t i = 0; i < 5; ++i)
+      bind_null(r);
+    return;
   }
+
+  assert(c->type == NR_CGI_RAT_TYPE || c->type == EUTRA_CGI_RAT_TYPE);
+  e2sm_plmn_t const* plmn = c->type == NR_CGI_RAT_TYPE ? &c->nr_cgi.plmn_id : &c->eutra.plmn_id;
+
+  bind_int(r, c->type);
+  bind_int(r, plmn->mcc);
+  bind_int(r, plmn->mnc);
+  bind_int(r, plmn->mnc_digit_len);
+  bind_int(r, c->type == NR_CGI_RAT_TYPE ? (int64_t)c->nr_cgi.nr_cell_id : (int64_t)c->eutra.eutra_cell_id);
 }
 
-static void write_rlc_stats(sqlite3* db, global_e2_node_id_t const* id, rlc_ind_data_t const* ind)
+// Longest measurement name. E2SM-KPM 8.3.9
+#define KPM_MEAS_NAME_LEN_SQLITE3 150
+
+// Key of the KPM_MeasType dictionary. Zeroed, as it is compared with memcmp
+typedef struct{
+  uint32_t type;
+  uint32_t id;
+  uint32_t len;
+  char name[KPM_MEAS_NAME_LEN_SQLITE3];
+} kpm_meas_key_t;
+
+static
+int cmp_kpm_meas_key(void const* m0_v, void const* m1_v)
 {
-  assert(db != NULL);
-  assert(ind != NULL);
+  assert(m0_v != NULL);
+  assert(m1_v != NULL);
 
-  rlc_ind_msg_t const* ind_msg_rlc = &ind->msg;
+  int const c = memcmp(m0_v, m1_v, sizeof(kpm_meas_key_t));
+  if (c < 0) return 1;
+  if (c == 0) return 0;
+  return -1;
+}
 
-  char buffer[2048] = {0};
-  int pos = 0;
+static
+void free_kpm_meas_key(void* key, void* value)
+{
+  // The value is the rowid, not a pointer
+  (void)key;
+  (void)value;
+}
 
-  for (size_t i = 0; i < ind_msg_rlc->len; ++i) {
-    pos += to_sql_string_rlc_rb(id, &ind_msg_rlc->rb[i], ind_msg_rlc->tstamp, buffer + pos, 2048 - pos);
+// KPM_MeasType rowid of the measurement. Inserted the first time that it
+// is received, afterwards served from memory
+static
+int64_t kpm_meas_type_rowid(db_sqlite3_t* db, meas_type_t const* m)
+{
+  assert(m->type == NAME_MEAS_TYPE || m->type == ID_MEAS_TYPE);
+
+  kpm_meas_key_t key;
+  memset(&key, 0, sizeof(key));
+  key.type = m->type;
+  if (m->type == NAME_MEAS_TYPE) {
+    // Names longer than the standard (150) are truncated
+    key.len = m->name.len < sizeof(key.name) ? m->name.len : sizeof(key.name);
+    if (key.len > 0)
+      memcpy(key.name, m->name.buf, key.len);
+  } else {
+    key.id = m->id;
   }
 
-  // insert_db(db, buffer);
-  // printf("Successfully insert DB entry into RLC_bearer table\n");
+  void* it = assoc_rb_tree_find(&db->meas_type, &key);
+  if (it != assoc_rb_tree_end(&db->meas_type))
+    return (intptr_t)assoc_rb_tree_value(&db->meas_type, it);
+
+  row_sqlite3_t r = new_row(db, KPM_MEAS_TYPE_SQLITE3);
+  bind_null(&r); // id
+  bind_text(&r, m->type == NAME_MEAS_TYPE ? key.name : NULL, key.len);
+  if (m->type == ID_MEAS_TYPE)
+    bind_int(&r, m->id);
+  else
+    bind_null(&r);
+
+  int64_t const rowid = insert_row(db, KPM_MEAS_TYPE_SQLITE3, &r);
+  if (rowid != 0)
+    assoc_rb_tree_insert(&db->meas_type, &key, sizeof(key), (void*)(intptr_t)rowid);
 
-  int rc = insert_db(db, buffer);
-  if (rc != SQLITE_OK) {
-    // Handle error - error message already printed in the function
-    // Additional error handling if needed
-    printf("Failled to insert into the RLC_bearer DB\n");
+  return rowid;
+}
+
+// KPM_MeasRecord rows. The record j of every period is the measurement
+// meas[j], if j < len_meas
+static
+void write_kpm_meas_data(db_sqlite3_t* db,
+                         int64_t ind,
+                         int64_t ue,
+                         size_t len,
+                         meas_data_lst_t const* data,
+                         size_t len_meas,
+                         int64_t const* meas)
+{
+  for (size_t i = 0; i < len; ++i) {
+    meas_data_lst_t const* d = &data[i];
+
+    for (size_t j = 0; j < d->meas_record_len; ++j) {
+      meas_record_lst_t const* rec = &d->meas_record_lst[j];
+      row_sqlite3_t r = new_row(db, KPM_MEAS_RECORD_SQLITE3);
+
+      bind_rowid(&r, ind);
+      bind_rowid(&r, ue);
+      bind_int(&r, i);
+      bind_int(&r, j);
+      bind_rowid(&r, j < len_meas ? meas[j] : 0);
+      bind_int(&r, d->incomplete_flag != NULL);
+
+      if (rec->value == INTEGER_MEAS_VALUE)
+        bind_int(&r, rec->int_val);
+      else
+        bind_null(&r);
+
+      if (rec->value == REAL_MEAS_VALUE)
+        bind_real(&r, rec->real_val);
+      else
+        bind_null(&r);
+
+      insert_row(db, KPM_MEAS_RECORD_SQLITE3, &r);
+    }
   }
 }
 
-static void write_pdcp_stats(sqlite3* db, global_e2_node_id_t const* id, pdcp_ind_data_t const* ind)
+static
+void write_kpm_frm_1(db_sqlite3_t* db, int64_t ind, int64_t ue, kpm_ind_msg_format_1_t const* msg)
 {
-  assert(db != NULL);
-  assert(ind != NULL);
+  size_t const len = msg->meas_info_lst_len;
+  int64_t* meas = len > 0 ? calloc(len, sizeof(int64_t)) : NULL;
+  assert((len == 0 || meas != NULL) && "Memory exhausted");
 
-  pdcp_ind_msg_t const* ind_msg_pdcp = &ind->msg;
+  for (size_t j = 0; j < len; ++j)
+    meas[j] = kpm_meas_type_rowid(db, &msg->meas_info_lst[j].meas_type);
 
-  char buffer[2048] = {0};
-  int pos = 0;
+  write_kpm_meas_data(db, ind, ue, msg->meas_data_lst_len, msg->meas_data_lst, len, meas);
+  free(meas);
+}
 
-  for (size_t i = 0; i < ind_msg_pdcp->len; ++i) {
-    pos += to_sql_string_pdcp_rb(id, &ind_msg_pdcp->rb[i], ind_msg_pdcp->tstamp, buffer + pos, 2048 - pos);
-  }
+static
+void write_kpm_frm_2(db_sqlite3_t* db, int64_t ind, kpm_ind_msg_format_2_t const* msg)
+{
+  size_t const len = msg->meas_info_cond_ue_lst_len;
+  int64_t* meas = len > 0 ? calloc(len, sizeof(int64_t)) : NULL;
+  assert((len == 0 || meas != NULL) && "Memory exhausted");
 
-  // insert_db(db, buffer);
-  // printf("Successfully insert DB entry into PDCP_bearer table\n");
-  int rc = insert_db(db, buffer);
-  if (rc != SQLITE_OK) {
-    // Handle error - error message already printed in the function
-    // Additional error handling if needed
-    printf("Failled to insert into the PDCP_bearer DB\n");
-  }
+  for (size_t j = 0; j < len; ++j)
+    meas[j] = kpm_meas_type_rowid(db, &msg->meas_info_cond_ue_lst[j].meas_type);
+
+  write_kpm_meas_data(db, ind, 0, msg->meas_data_lst_len, msg->meas_data_lst, len, meas);
+  free(meas);
 }
 
-static void write_slice_conf_stats(sqlite3* db, global_e2_node_id_t const* id, int64_t tstamp, slice_conf_t const* slice_conf)
+static void write_kpm_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, kpm_ind_data_t const* ind)
 {
-  char buffer[4096] = {0};
-  int pos = 0;
+  assert(db != NULL);
+  assert(ind != NULL);
 
-  ul_dl_slice_conf_t const* dlslices = &slice_conf->dl;
-  if (dlslices->len_slices > 0) {
-    for (size_t i = 0; i < dlslices->len_slices; ++i) {
-      fr_slice_t const* s = &dlslices->slices[i];
-      pos += to_sql_string_slice_rb(id, dlslices, s, tstamp, buffer + pos, 4096 - pos);
-    }
+  kpm_ind_msg_t const* msg = &ind->msg;
+  assert(msg->type == FORMAT_1_INDICATION_MESSAGE || msg->type == FORMAT_2_INDICATION_MESSAGE
+         || msg->type == FORMAT_3_INDICATION_MESSAGE);
+
+  // The one of the first UE in the format 3
+  uint32_t const* gran_period_ms = NULL;
+  if (msg->type == FORMAT_1_INDICATION_MESSAGE)
+    gran_period_ms = msg->frm_1.gran_period_ms;
+  else if (msg->type == FORMAT_2_INDICATION_MESSAGE)
+    gran_period_ms = msg->frm_2.gran_period_ms;
+  else if (msg->frm_3.ue_meas_report_lst_len > 0)
+    gran_period_ms = msg->frm_3.meas_report_per_ue[0].ind_msg_format_1.gran_period_ms;
+
+  row_sqlite3_t r = new_row(db, KPM_IND_SQLITE3);
+  bind_null(&r); // id
+  bind_node(&r, id, time_now_us());
+  bind_int(&r, msg->type + 1);
+
+  if (ind->hdr.type == FORMAT_1_INDICATION_HEADER)
+    bind_int(&r, ind->hdr.kpm_ric_ind_hdr_format_1.collectStartTime);
+  else
+    bind_null(&r);
+
+  if (gran_period_ms != NULL)
+    bind_int(&r, *gran_period_ms);
+  else
+    bind_null(&r);
+
+  int64_t const ind_id = insert_row(db, KPM_IND_SQLITE3, &r);
+
+  if (msg->type == FORMAT_1_INDICATION_MESSAGE) {
+    write_kpm_frm_1(db, ind_id, 0, &msg->frm_1);
+  } else if (msg->type == FORMAT_2_INDICATION_MESSAGE) {
+    write_kpm_frm_2(db, ind_id, &msg->frm_2);
   } else {
-    pos += to_sql_string_slice_rb(id, dlslices, NULL, tstamp, buffer + pos, 4096 - pos);
+    for (size_t i = 0; i < msg->frm_3.ue_meas_report_lst_len; ++i) {
+      meas_report_per_ue_t const* ue = &msg->frm_3.meas_report_per_ue[i];
+
+      row_sqlite3_t r_ue = new_row(db, KPM_UE_SQLITE3);
+      bind_null(&r_ue); // id
+      bind_rowid(&r_ue, ind_id);
+      bind_ue_id(&r_ue, &ue->ue_meas_report_lst);
+      int64_t const ue_id = insert_row(db, KPM_UE_SQLITE3, &r_ue);
+
+      write_kpm_frm_1(db, ind_id, ue_id, &ue->ind_msg_format_1);
+    }
   }
+}
 
-  // TODO: Process uplink slice stats
+// RC_UE row. hdr if the UE is the one of the indication header
+static
+int64_t write_rc_ue(db_sqlite3_t* db,
+                    int64_t ind,
+                    bool hdr,
+                    ue_id_e2sm_t const* ue,
+                    byte_array_t const* ue_ctx_info,
+                    cell_global_id_t const* cell)
+{
+  row_sqlite3_t r = new_row(db, RC_UE_SQLITE3);
 
-  // insert_db(db, buffer);
-  // printf("Successfully insert DB entry into SLICE table\n");
+  bind_null(&r); // id
+  bind_rowid(&r, ind);
+  bind_int(&r, hdr);
+  bind_ue_id(&r, ue);
+  bind_blob(&r, ue_ctx_info != NULL ? ue_ctx_info->buf : NULL, ue_ctx_info != NULL ? ue_ctx_info->len : 0);
+  bind_cell(&r, cell);
 
-  int rc = insert_db(db, buffer);
-  if (rc != SQLITE_OK) {
-    // Handle error - error message already printed in the function
-    // Additional error handling if needed
-    printf("Failled to insert into the SLICE CONF table DB\n");
-  }
+  return insert_row(db, RC_UE_SQLITE3, &r);
 }
 
-static void write_ue_slice_conf_stats(sqlite3* db,
-                                      global_e2_node_id_t const* id,
-                                      int64_t tstamp,
-                                      ue_slice_conf_t const* ue_slice_conf)
+static
+void write_rc_cell(db_sqlite3_t* db, int64_t ind, cell_global_id_t const* cell, byte_array_t const* cell_ctx_info, bool const* cell_del)
 {
-  char buffer[4096] = {0};
-  int pos = 0;
+  row_sqlite3_t r = new_row(db, RC_CELL_SQLITE3);
+
+  bind_rowid(&r, ind);
+  bind_cell(&r, cell);
+  bind_blob(&r, cell_ctx_info != NULL ? cell_ctx_info->buf : NULL, cell_ctx_info != NULL ? cell_ctx_info->len : 0);
 
-  if (ue_slice_conf->len_ue_slice > 0) {
-    for (uint32_t j = 0; j < ue_slice_conf->len_ue_slice; ++j) {
-      ue_slice_assoc_t* u = &ue_slice_conf->ues[j];
-      pos += to_sql_string_ue_slice_rb(id, ue_slice_conf, u, tstamp, buffer + pos, 2048 - pos);
+  if (cell_del != NULL)
+    bind_int(&r, *cell_del);
+  else
+    bind_null(&r);
+
+  insert_row(db, RC_CELL_SQLITE3, &r);
+}
+
+// RC_RanParam rows of the sequence, and of the STRUCTURE and LIST members
+// below it. lst_idx is negative out of a LIST
+static
+void write_rc_ran_param(db_sqlite3_t* db,
+                        int64_t ind,
+                        int64_t ue,
+                        int64_t parent,
+                        int64_t lst_idx,
+                        size_t sz,
+                        seq_ran_param_t const* seq)
+{
+  for (size_t i = 0; i < sz; ++i) {
+    ran_param_val_type_t const* val = &seq[i].ran_param_val;
+    ran_parameter_value_t const* v = NULL;
+    if (val->type == ELEMENT_KEY_FLAG_TRUE_RAN_PARAMETER_VAL_TYPE)
+      v = val->flag_true;
+    else if (val->type == ELEMENT_KEY_FLAG_FALSE_RAN_PARAMETER_VAL_TYPE)
+      v = val->flag_false;
+
+    row_sqlite3_t r = new_row(db, RC_RAN_PARAM_SQLITE3);
+    bind_null(&r); // id
+    bind_rowid(&r, ind);
+    bind_rowid(&r, ue);
+    bind_rowid(&r, parent);
+
+    if (lst_idx < 0)
+      bind_null(&r);
+    else
+      bind_int(&r, lst_idx);
+
+    bind_int(&r, seq[i].ran_param_id);
+    bind_int(&r, val->type);
+
+    if (v == NULL) {
+      bind_null(&r); // type
+      bind_null(&r); // int_val
+      bind_null(&r); // real_val
+      bind_null(&r); // str_val
+    } else {
+      bind_int(&r, v->type);
+
+      if (v->type == BOOLEAN_RAN_PARAMETER_VALUE)
+        bind_int(&r, v->bool_ran);
+      else if (v->type == INTEGER_RAN_PARAMETER_VALUE)
+        bind_int(&r, v->int_ran);
+      else
+        bind_null(&r);
+
+      if (v->type == REAL_RAN_PARAMETER_VALUE)
+        bind_real(&r, v->real_ran);
+      else
+        bind_null(&r);
+
+      if (v->type == BIT_STRING_RAN_PARAMETER_VALUE)
+        bind_blob(&r, v->bit_str_ran.buf, v->bit_str_ran.len);
+      else if (v->type == OCTET_STRING_RAN_PARAMETER_VALUE)
+        bind_blob(&r, v->octet_str_ran.buf, v->octet_str_ran.len);
+      else if (v->type == PRINTABLESTRING_RAN_PARAMETER_VALUE)
+        bind_text(&r, (char const*)v->printable_str_ran.buf, v->printable_str_ran.len);
+      else
+        bind_null(&r);
     }
-  } else {
-    pos += to_sql_string_ue_slice_rb(id, ue_slice_conf, NULL, tstamp, buffer + pos, 2048 - pos);
-  }
 
-  // insert_db(db, buffer);
-  // printf("Successfully insert DB entry into UE_SLICE table\n");
+    int64_t const rowid = insert_row(db, RC_RAN_PARAM_SQLITE3, &r);
 
-  int rc = insert_db(db, buffer);
-  if (rc != SQLITE_OK) {
-    // Handle error - error message already printed in the function
-    // Additional error handling if needed
-    printf("Failled to insert into the UE_SLICE table DB\n");
+    if (val->type == STRUCTURE_RAN_PARAMETER_VAL_TYPE && val->strct != NULL) {
+      write_rc_ran_param(db, ind, ue, rowid, -1, val->strct->sz_ran_param_struct, val->strct->ran_param_struct);
+    } else if (val->type == LIST_RAN_PARAMETER_VAL_TYPE && val->lst != NULL) {
+      for (size_t j = 0; j < val->lst->sz_lst_ran_param; ++j) {
+        ran_param_struct_t const* s = &val->lst->lst_ran_param[j].ran_param_struct;
+        write_rc_ran_param(db, ind, ue, rowid, j, s->sz_ran_param_struct, s->ran_param_struct);
+      }
+    }
   }
 }
 
-static void write_slice_stats(sqlite3* db, global_e2_node_id_t const* id, slice_ind_data_t const* ind)
+static void write_rc_stats(db_sqlite3_t* db, global_e2_node_id_t const* id, rc_rd_ind_data_t const* rc)
 {
   assert(db != NULL);
-  assert(ind != NULL);
+  assert(rc != NULL);
+
+  e2sm_rc_ind_hdr_t const* hdr = &rc->ind.hdr;
+  e2sm_rc_ind_msg_t const* msg = &rc->ind.msg;
+  assert(hdr->format < END_E2SM_RC_IND_HDR);
+  assert(msg->format < END_E2SM_RC_IND_MSG);
+
+  row_sqlite3_t r = new_row(db, RC_IND_SQLITE3);
+  bind_null(&r); // id
+  bind_node(&r, id, time_now_us());
+  bind_int(&r, rc->ric_id);
+  bind_int(&r, hdr->format + 1);
+  bind_int(&r, msg->format + 1);
+
+  // The event trigger condition id, in the format 3
+  uint16_t const* ev_trigger_id = NULL;
+  if (hdr->format == FORMAT_1_E2SM_RC_IND_HDR)
+    ev_trigger_id = hdr->frmt_1.ev_trigger_id;
+  else if (hdr->format == FORMAT_3_E2SM_RC_IND_HDR)
+    ev_trigger_id = hdr->frmt_3.ev_trigger_cond;
+
+  if (ev_trigger_id != NULL)
+    bind_int(&r, *ev_trigger_id);
+  else
+    bind_null(&r);
+
+  if (hdr->format == FORMAT_2_E2SM_RC_IND_HDR) {
+    bind_int(&r, hdr->frmt_2.ric_style_type);
+    bind_int(&r, hdr->frmt_2.ins_ind_id);
+  } else {
+    bind_null(&r);
+    bind_null(&r);
+  }
 
-  slice_ind_msg_t const* ind_msg_slice = &ind->msg;
+  int64_t const ind_id = insert_row(db, RC_IND_SQLITE3, &r);
 
-  write_slice_conf_stats(db, id, ind_msg_slice->tstamp, &ind_msg_slice->slice_conf);
-  write_ue_slice_conf_stats(db, id, ind_msg_slice->tstamp, &ind_msg_slice->ue_slice_conf);
+  if (hdr->format == FORMAT_2_E2SM_RC_IND_HDR)
+    write_rc_ue(db, ind_id, true, &hdr->frmt_2.ue_id, NULL, NULL);
+  else if (hdr->format == FORMAT_3_E2SM_RC_IND_HDR && hdr->frmt_3.ue_id != NULL)
+    write_rc_ue(db, ind_id, true, hdr->frmt_3.ue_id, NULL, NULL);
+
+  if (msg->format == FORMAT_1_E2SM_RC_IND_MSG) {
+    write_rc_ran_param(db, ind_id, 0, 0, -1, msg->frmt_1.sz_seq_ran_param, msg->frmt_1.seq_ran_param);
+  } else if (msg->format == FORMAT_2_E2SM_RC_IND_MSG) {
+    for (size_t i = 0; i < msg->frmt_2.sz_seq_ue_id; ++i) {
+      seq_ue_id_t const* s = &msg->frmt_2.seq_ue_id[i];
+      int64_t const ue_id = write_rc_ue(db, ind_id, false, &s->ue_id, NULL, NULL);
+      write_rc_ran_param(db, ind_id, ue_id, 0, -1, s->sz_seq_ran_param, s->seq_ran_param);
+    }
+  } else if (msg->format == FORMAT_3_E2SM_RC_IND_MSG) {
+    for (size_t i = 0; i < msg->frmt_3.sz_seq_cell_info; ++i) {
+      seq_cell_info_t const* c = &msg->frmt_3.seq_cell_info[i];
+      write_rc_cell(db, ind_id, &c->cell_global_id, c->cell_ctx_info, c->cell_del);
+    }
+  } else if (msg->format == FORMAT_4_E2SM_RC_IND_MSG) {
+    for (size_t i = 0; i < msg->frmt_4.sz_seq_ue_info; ++i) {
+      seq_ue_info_t const* u = &msg->frmt_4.seq_ue_info[i];
+      write_rc_ue(db, ind_id, false, &u->ue_id, u->ue_ctx_info, &u->cell_global_id);
+    }
+    for (size_t i = 0; i < msg->frmt_4.sz_seq_cell_info_2; ++i) {
+      seq_cell_info_2_t const* c = &msg->frmt_4.seq_cell_info_2[i];
+      write_rc_cell(db, ind_id, &c->cell_global_id, c->cell_ctx_info, NULL);
+    }
+  } else if (msg->format == FORMAT_5_E2SM_RC_IND_MSG) {
+    write_rc_ran_param(db, ind_id, 0, 0, -1, msg->frmt_5.sz_seq_ran_param, msg->frmt_5.seq_ran_param);
+  }
+  // Format 6 (insert styles) only in RC_Ind
 }
 
-static void write_gtp_stats(sqlite3* db, global_e2_node_id_t const* id, gtp_ind_data_t const* ind)
+static
+int wal_hook(void* arg, sqlite3* handle, char const* name, int pages)
 {
-  assert(db != NULL);
-  assert(ind != NULL);
+  (void)handle;
+  (void)name;
+
+  // Called after every commit, so only wake up the checkpoint thread
+  if (pages >= WAL_CKPT_PAGES) {
+    db_sqlite3_t* db = (db_sqlite3_t*)arg;
+    lock_guard(&db->mtx);
+    db->wal_pages = pages;
+    pthread_cond_signal(&db->cv);
+  }
 
-  gtp_ind_msg_t const* ind_msg_gtp = &ind->msg;
+  return SQLITE_OK;
+}
 
-  char buffer[2048] = {0};
-  int pos = 0;
-  for (size_t i = 0; i < ind_msg_gtp->len; ++i) {
-    // printf("****Before the GTP database\n");
-    // printf("Before writing the GTP  database : %04x\n", ind_msg_gtp->ngut[i].teidgnb);
-    // printf("****Before the database\n");
-    pos += to_sql_string_gtp_NGUT(id, &ind_msg_gtp->ngut[i], ind_msg_gtp->tstamp, buffer + pos, 2048 - pos);
-  }
+// Copies the WAL back into the DB file out of the write path. PASSIVE
+// checkpoints never wait for, nor block, the writer
+static
+void* ckpt_thread(void* arg)
+{
+  db_sqlite3_t* db = (db_sqlite3_t*)arg;
+
+  sqlite3* handle = NULL;
+  int rc = sqlite3_open_v2(db->filename, &handle, SQLITE_OPEN_READWRITE, NULL);
+  assert(rc == SQLITE_OK && "Error while opening the DB for the WAL checkpoints");
 
-  // insert_db(db, buffer);
-  // printf("Successfully insert DB entry into GTP_NGUT table\n");
+  while (true) {
+    {
+      lock_guard(&db->mtx);
+      while (db->wal_pages < WAL_CKPT_PAGES && db->stop == false)
+        pthread_cond_wait(&db->cv, &db->mtx);
 
-  int rc = insert_db(db, buffer);
-  if (rc != SQLITE_OK) {
-    // Handle error - error message already printed in the function
-    // Additional error handling if needed
-    printf("Failled to insert into the GTP_NGUT DB\n");
+      if (db->stop == true)
+        break;
+
+      db->wal_pages = 0;
+    }
+
+    int log = 0;
+    int ckpt = 0;
+    rc = sqlite3_wal_checkpoint_v2(handle, NULL, SQLITE_CHECKPOINT_PASSIVE, &log, &ckpt);
+    if (rc != SQLITE_OK && rc != SQLITE_BUSY)
+      fprintf(stderr, "Error while checkpointing the WAL: %s\n", sqlite3_errmsg(handle));
   }
+
+  rc = sqlite3_close(handle);
+  assert(rc == SQLITE_OK);
+  return NULL;
 }
 
-// void write_kpm_stats(sqlite3* db, global_e2_node_id_t const* id, kpm_ric_indication_t const* ind)
-// {
-//   // TODO: Add granulPeriod into database
-//   // TODO: Add MeasInfo and LabelInfo into database
-
-//   assert(db != NULL);
-//   assert(ind != NULL);
-
-//   kpm_ind_msg_t const* ind_msg_kpm = &ind->msg;
-//   char buffer[512] = {0};
-
-//   for(size_t i = 0; i < ind_msg_kpm->MeasData_len; i++){
-//     MeasDataItem_t* curMeasData = &ind_msg_kpm->MeasData[i];
-//     if (curMeasData->measRecord_len > 0){
-//       for (size_t j = 0; j < curMeasData->measRecord_len; j++){
-//         MeasRecord_t* curMeasRecord = &curMeasData->measRecord[j];
-//         memset(buffer, 0, sizeof(buffer));
-//         to_sql_string_kpm_measRecord(id, curMeasData, curMeasRecord, ind->hdr.collectStartTime,
-//                                      buffer, 512);
-//         insert_db(db, buffer);
-//       }
-//     } else {
-//       memset(buffer, 0, sizeof(buffer));
-//       to_sql_string_kpm_measRecord(id, curMeasData, NULL, ind->hdr.collectStartTime,
-//                                    buffer, 512);
-//       insert_db(db, buffer);
-//     }
-//   }
-// }
-
-void init_db_sqlite3(sqlite3** db, char const* db_filename)
+void init_db_sqlite3(db_sqlite3_t* db, char const* db_filename)
 {
   assert(db != NULL);
   assert(db_filename != NULL);
 
-  int const rc = sqlite3_open(db_filename, db);
+  memset(db, 0, sizeof(*db));
+
+  int const rc = sqlite3_open(db_filename, &db->db);
   assert(rc != SQLITE_CANTOPEN && "SQLITE3 cannot open the directory. Does it already exist?");
   assert(rc == SQLITE_OK && "Error while creating the DB at /tmp/db_xapp");
 
   // Optimizations. Write Ahead Logging
   char* err_msg = NULL;
-  int const rc_2 = sqlite3_exec(*db, "pragma journal_mode=wal", 0, 0, &err_msg);
+  int const rc_2 = sqlite3_exec(db->db, "pragma journal_mode=wal", 0, 0, &err_msg);
   assert(rc_2 == SQLITE_OK && "Error while setting the wal mode in sqlite3");
 
-  int const rc_3 = sqlite3_exec(*db, "pragma synchronous=normal", 0, 0, &err_msg);
+  int const rc_3 = sqlite3_exec(db->db, "pragma synchronous=normal", 0, 0, &err_msg);
   assert(rc_3 == SQLITE_OK && "Error while setting the syncronous mode to normal");
 
   //////
   // MAC
   //////
-  create_mac_ue_table(*db);
+  create_mac_ue_table(db->db);
 
   //////
   // RLC
   //////
-  create_rlc_bearer_table(*db);
+  create_rlc_bearer_table(db->db);
 
   //////
   // PDCP
   //////
-  create_pdcp_bearer_table(*db);
+  create_pdcp_bearer_table(db->db);
 
   //////
   // SLICE
   //////
-  create_slice_table(*db);
-  create_ue_slice_table(*db);
+  create_slice_table(db->db);
+  create_ue_slice_table(db->db);
 
   ////
   // GTP
   ////
-  create_gtp_table(*db);
+  create_gtp_table(db->db);
+
+  ////
   // KPM
   ////
-  create_kpm_table(*db);
+  create_kpm_table(db->db);
+  assoc_rb_tree_init(&db->meas_type, sizeof(kpm_meas_key_t), cmp_kpm_meas_key, free_kpm_meas_key);
+
+  ////
+  // RC
+  ////
+  create_rc_table(db->db);
+
+  for (size_t i = 0; i < END_TABLE_SQLITE3; ++i)
+    db->ins[i] = prepare_insert(db->db, table_name[i]);
+
+  db->begin = prepare_stmt(db->db, "BEGIN;");
+  db->commit = prepare_stmt(db->db, "COMMIT;");
+
+  // Replaces the automatic checkpoints, which run in the writer
+  db->filename = strdup(db_filename);
+  assert(db->filename != NULL && "Memory exhausted");
+
+  int rc_4 = pthread_mutex_init(&db->mtx, NULL);
+  assert(rc_4 == 0);
+  rc_4 = pthread_cond_init(&db->cv, NULL);
+  assert(rc_4 == 0);
+
+  sqlite3_wal_hook(db->db, wal_hook, db);
+
+  rc_4 = pthread_create(&db->ckpt, NULL, ckpt_thread, db);
+  assert(rc_4 == 0);
 }
 
-void close_db_sqlite3(sqlite3* db)
+void close_db_sqlite3(db_sqlite3_t* db)
 {
   assert(db != NULL);
-  int const rc = sqlite3_close(db);
+
+  commit_db_sqlite3(db);
+
+  {
+    lock_guard(&db->mtx);
+    db->stop = true;
+    pthread_cond_signal(&db->cv);
+  }
+  int rc = pthread_join(db->ckpt, NULL);
+  assert(rc == 0);
+
+  pthread_cond_destroy(&db->cv);
+  pthread_mutex_destroy(&db->mtx);
+  free(db->filename);
+
+  assoc_rb_tree_free(&db->meas_type);
+
+  for (size_t i = 0; i < END_TABLE_SQLITE3; ++i)
+    sqlite3_finalize(db->ins[i]);
+  sqlite3_finalize(db->begin);
+  sqlite3_finalize(db->commit);
+
+  rc = sqlite3_close(db->db);
   assert(rc == SQLITE_OK && "Error while closing the DB");
 }
 
-static int kpm_acc = 0;
-static int rc_acc = 0;
+void commit_db_sqlite3(db_sqlite3_t* db)
+{
+  assert(db != NULL);
+
+  if (db->tx == false)
+    return;
+
+  int const rc = sqlite3_step(db->commit);
+  if (rc != SQLITE_DONE)
+    fprintf(stderr, "Error while committing into the DB: %s\n", sqlite3_errmsg(db->db));
+  sqlite3_reset(db->commit);
+
+  // A failed COMMIT may leave the transaction open
+  db->tx = sqlite3_get_autocommit(db->db) == 0;
+}
 
-void write_db_sqlite3(sqlite3* db, global_e2_node_id_t const* id, sm_ag_if_rd_t const* ag_rd)
+void write_db_sqlite3(db_sqlite3_t* db, global_e2_node_id_t const* id, sm_ag_if_rd_t const* ag_rd)
 {
   assert(db != NULL);
   assert(ag_rd != NULL);
@@ -1454,6 +1497,8 @@ void write_db_sqlite3(sqlite3* db, global_e2_node_id_t const* id, sm_ag_if_rd_t
   assert(rd->type == MAC_STATS_V0 || rd->type == RLC_STATS_V0 || rd->type == PDCP_STATS_V0 || rd->type == SLICE_STATS_V0
          || rd->type == KPM_STATS_V3_0 || rd->type == GTP_STATS_V0 || rd->type == RAN_CTRL_STATS_V1_03);
 
+  begin_tx(db);
+
   if (rd->type == MAC_STATS_V0) {
     write_mac_stats(db, id, &rd->mac);
   } else if (rd->type == RLC_STATS_V0) {
@@ -1465,17 +1510,9 @@ void write_db_sqlite3(sqlite3* db, global_e2_node_id_t const* id, sm_ag_if_rd_t
   } else if (rd->type == GTP_STATS_V0) {
     write_gtp_stats(db, id, &rd->gtp);
   } else if (rd->type == KPM_STATS_V3_0) {
-    kpm_acc++;
-    if (kpm_acc > 2048) {
-      printf("KPM sqlite not implemented\n");
-      kpm_acc = 0;
-    }
+    write_kpm_stats(db, id, &rd->kpm.ind);
   } else if (rd->type == RAN_CTRL_STATS_V1_03) {
-    rc_acc++;
-    if (rc_acc > 2048) {
-      printf("RAN Control sqlite not implemented\n");
-      rc_acc = 0;
-    }
+    write_rc_stats(db, id, &rd->rc);
   } else {
     assert(0 != 0 && "Unknown statistics type received ");
   }
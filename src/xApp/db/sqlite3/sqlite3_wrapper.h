@@ -25,14 +25,65 @@
 
 #include "../../../sm/agent_if/read/sm_ag_if_rd.h"
 #include "../../../lib/e2ap/e2ap_global_node_id_wrapper.h" 
+#include "../../../util/alg_ds/ds/assoc_container/assoc_rb_tree.h"
 
 #include "sqlite3.h"
 
-void init_db_sqlite3(sqlite3** db, char const* db_filename);
+#include <pthread.h>
+#include <stdbool.h>
 
-void close_db_sqlite3(sqlite3* db);
+// Tables with a prepared INSERT
+typedef enum{
+  MAC_UE_SQLITE3,
+  RLC_BEARER_SQLITE3,
+  PDCP_BEARER_SQLITE3,
+  SLICE_SQLITE3,
+  UE_SLICE_SQLITE3,
+  GTP_NGUT_SQLITE3,
+  KPM_MEAS_TYPE_SQLITE3,
+  KPM_IND_SQLITE3,
+  KPM_UE_SQLITE3,
+  KPM_MEAS_RECORD_SQLITE3,
+  RC_IND_SQLITE3,
+  RC_UE_SQLITE3,
+  RC_CELL_SQLITE3,
+  RC_RAN_PARAM_SQLITE3,
 
-void write_db_sqlite3(sqlite3* db, global_e2_node_id_t const* id, sm_ag_if_rd_t const* rd);
+  END_TABLE_SQLITE3
+} table_sqlite3_e;
+
+typedef struct{
+  sqlite3* db;
+
+  // One row per execution, with bound parameters
+  sqlite3_stmt* ins[END_TABLE_SQLITE3];
+  sqlite3_stmt* begin;
+  sqlite3_stmt* commit;
+  // A transaction is open
+  bool tx;
+
+  // KPM_MeasType rowid, by measurement name or id
+  assoc_rb_tree_t meas_type;
+
+  // The WAL is checkpointed in its own thread and connection
+  char* filename;
+  pthread_t ckpt;
+  pthread_mutex_t mtx;
+  pthread_cond_t cv;
+  int wal_pages;
+  bool stop;
+} db_sqlite3_t;
+
+void init_db_sqlite3(db_sqlite3_t* db, char const* db_filename);
+
+// Commits the open transaction, if any
+void close_db_sqlite3(db_sqlite3_t* db);
+
+// Within the open transaction, or a new one if none is open. Visible to
+// the readers after commit_db_sqlite3
+void write_db_sqlite3(db_sqlite3_t* db, global_e2_node_id_t const* id, sm_ag_if_rd_t const* rd);
+
+void commit_db_sqlite3(db_sqlite3_t* db);
 
 #endif
 
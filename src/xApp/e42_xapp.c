@@ -68,6 +68,14 @@ bool net_pkt(const e42_xapp_t* xapp, int fd)
   return fd == xapp->ep.base.fd;
 }
 
+static inline
+bool shm_pkt(const e42_xapp_t* xapp, int fd)
+{
+  assert(xapp != NULL);
+  assert(fd > 0);
+  return xapp->ep.shm != NULL && fd == xapp->ep.shm->rx_fd;
+}
+
 static inline
 bool pend_event(e42_xapp_t* xapp, int fd, pending_event_t** p_ev)
 {
@@ -97,6 +105,8 @@ async_event_xapp_t find_event_type(e42_xapp_t* xapp, int fd)
   async_event_xapp_t e = {.type = UNKNOWN_EVENT };
   if (net_pkt(xapp, fd) == true){
     e.type = NETWORK_EVENT;
+  } else if (shm_pkt(xapp, fd) == true){
+    e.type = SHM_EVENT;
 //  } else if (ind_event(xapp, fd, &e.i_ev) == true) {
 //    e.type = INDICATION_EVENT;
 
@@ -170,6 +180,20 @@ sm_io_ag_ran_t init_io_ag_ran(void)
 }
 
 
+static disp_conf_xapp_t disp_conf_xapp(fr_args_t const* args)
+{
+  fr_disp_conf_t const c = get_conf_xapp_disp(args);
+
+  disp_conf_xapp_t conf = {.cap = c.queue, .overflow = DISP_OVERFLOW_DROP_OLDEST, .workers = c.workers};
+  if (c.overflow == FR_DISP_BLOCK)
+    conf.overflow = DISP_OVERFLOW_BLOCK;
+  else if (c.overflow == FR_DISP_KEEP_LATEST)
+    conf.overflow = DISP_OVERFLOW_KEEP_LATEST;
+
+  printf("[xApp]: Up to %zu indications queued per subscription, %zu callback threads \n", conf.cap, conf.workers);
+  return conf;
+}
+
 e42_xapp_t* init_e42_xapp(fr_args_t const* args)
 {
   assert(args != NULL);
@@ -210,7 +234,7 @@ e42_xapp_t* init_e42_xapp(fr_args_t const* args)
 
   init_act_proc(&xapp->act_proc);
 
-  init_msg_dispatcher(&xapp->msg_disp);
+  init_msg_dispatcher(&xapp->msg_disp, disp_conf_xapp(args));
 
   char* dir = get_conf_db_dir(args);
   assert(strlen(dir) < 128 && "String too large");
@@ -233,7 +257,10 @@ e42_xapp_t* init_e42_xapp(fr_args_t const* args)
 
   printf("[xApp]: DB filename = %s \n ", filename );
 
-  init_db_xapp(&xapp->db, filename);
+  fr_db_conf_t const db_conf = get_conf_xapp_db(args);
+  init_db_xapp(&xapp->db, filename, (db_conf_xapp_t){.batch = db_conf.batch, .batch_ms = db_conf.batch_ms, .queue = db_conf.queue});
+
+  xapp->shm = get_conf_e42_shm_ring(args) > 0;
 
   free(dir);
   free(db_name);
@@ -318,6 +345,23 @@ void send_setup_request(e42_xapp_t* xapp)
 // }
 
 
+static
+void handle_msg_xapp(e42_xapp_t* xapp, byte_array_t ba)
+{
+  e2ap_msg_t msg = e2ap_msg_dec_xapp(&xapp->ap, ba);
+  defer( { e2ap_msg_free_xapp(&xapp->ap, &msg);} );
+
+  e2ap_msg_t ans = e2ap_msg_handle_xapp(xapp, &msg);
+  defer( { e2ap_msg_free_xapp(&xapp->ap, &ans);} );
+
+  if(ans.type != NONE_E2_MSG_TYPE){
+    byte_array_t ba_ans = e2ap_msg_enc_xapp(&xapp->ap, &ans); 
+    defer ({free_byte_array(ba_ans); } );
+
+    e2ap_send_bytes_xapp(&xapp->ep, ba_ans);
+  }
+}
+
 static
 void e2_event_loop_xapp(e42_xapp_t* xapp)
 {
@@ -340,17 +384,13 @@ void e2_event_loop_xapp(e42_xapp_t* xapp)
       byte_array_t ba = e2ap_recv_msg_xapp(&xapp->ep);
       defer( {free_byte_array(ba);} );
 
-      e2ap_msg_t msg = e2ap_msg_dec_xapp(&xapp->ap, ba);
-      defer( { e2ap_msg_free_xapp(&xapp->ap, &msg);} );
-
-      e2ap_msg_t ans = e2ap_msg_handle_xapp(xapp, &msg);
-      defer( { e2ap_msg_free_xapp(&xapp->ap, &ans);} );
-
-      if(ans.type != NONE_E2_MSG_TYPE){
-        byte_array_t ba_ans = e2ap_msg_enc_xapp(&xapp->ap, &ans); 
-        defer ({free_byte_array(ba_ans); } );
-
-        e2ap_send_bytes_xapp(&xapp->ep, ba_ans);
+      handle_msg_xapp(xapp, ba);
+    } else if(e.type == SHM_EVENT){
+      byte_array_t ba[32];
+      size_t const len = e2ap_recv_shm_msgs_xapp(&xapp->ep, sizeof(ba)/sizeof(ba[0]), ba);
+      for(size_t i = 0; i < len; ++i){
+        handle_msg_xapp(xapp, ba[i]);
+        free_byte_array(ba[i]);
       }
     } else if(e.type == PENDING_EVENT){
         if (*e.p_ev == E42_RIC_SUBSCRIPTION_REQUEST_PENDING_EVENT) {
@@ -498,6 +538,9 @@ sm_ans_xapp_t report_sm_sync_xapp(e42_xapp_t* xapp, global_e2_node_id_t* id, uin
   // Generate and registry the ric_req_id
   ric_gen_id_t ric_id = generate_ric_gen_id(xapp, RIC_SUBSCRIPTION_PROCEDURE_ACTIVE , rf_id, id, cb);
 
+  // Queue for its indications
+  add_sub_msg_dispatcher(&xapp->msg_disp, ric_id.ric_req_id);
+
   // Send message 
   send_subscription_request(xapp, id, ric_id, data);
 
@@ -552,6 +595,8 @@ void rm_report_sm_sync_xapp(e42_xapp_t* xapp, int ric_req_id)
 
   // Remove the active procedure  
   rm_act_proc(&xapp->act_proc, ric_req_id ); 
+
+  rm_sub_msg_dispatcher(&xapp->msg_disp, ric_req_id);
 }
 
 static
@@ -618,6 +663,20 @@ size_t not_dispatch_msg(e42_xapp_t* xapp)
 {
   assert(xapp != NULL);
 
-  return size_msg_dispatcher(&xapp->msg_disp );
+  return stats_msg_dispatcher(&xapp->msg_disp).depth;
+}
+
+bool dispatch_stats_xapp(e42_xapp_t* xapp, int handle, disp_stats_xapp_t* st)
+{
+  assert(xapp != NULL);
+  assert(st != NULL);
+
+  if (handle < 0) {
+    *st = stats_msg_dispatcher(&xapp->msg_disp);
+    return true;
+  }
+
+  assert(handle < 1 << 16);
+  return stats_sub_msg_dispatcher(&xapp->msg_disp, handle, st);
 }
 
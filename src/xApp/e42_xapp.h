@@ -95,6 +95,9 @@ typedef struct e42_xapp_s
   // DB handler
   db_xapp_t db;
 
+  // Ask the iApp for a shared memory channel after the E42 Setup
+  bool shm;
+
   pthread_mutex_t conn_mtx;
   atomic_bool connected;
   atomic_bool stopped;
@@ -114,6 +117,9 @@ e2_node_arr_xapp_t e2_nodes_xapp(e42_xapp_t* xapp);
 
 size_t not_dispatch_msg(e42_xapp_t* xapp);
 
+// handle of a report subscription, or -1 for all of them
+bool dispatch_stats_xapp(e42_xapp_t* xapp, int handle, disp_stats_xapp_t* st);
+
 // We wait for the message to come back and avoid asyncronous programming
 sm_ans_xapp_t report_sm_sync_xapp(e42_xapp_t* xapp, global_e2_node_id_t* id, uint16_t ran_func_id, void* data, sm_cb cb);
 
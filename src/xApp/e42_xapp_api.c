@@ -199,6 +199,15 @@ void rm_report_sm_xapp_api(int const handle)
   rm_report_sm_sync_xapp(xapp, handle);
 }
 
+bool dispatch_stats_xapp_api(int handle, disp_stats_xapp_t* st)
+{
+  assert(xapp != NULL);
+  assert(st != NULL);
+  assert(handle > -2);
+
+  return dispatch_stats_xapp(xapp, handle, st);
+}
+
 sm_ans_xapp_t control_sm_xapp_api(global_e2_node_id_t* id, uint32_t ran_func_id, void* wr)
 {
   assert(xapp != NULL);
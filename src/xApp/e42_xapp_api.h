@@ -30,6 +30,7 @@ extern "C" {
 #include <stdint.h>
 
 #include "e2_node_arr_xapp.h"
+#include "msg_dispatcher_xapp.h"
 #include "../sm/agent_if/write/sm_ag_if_wr.h"
 #include "../sm/agent_if/read/sm_ag_if_rd.h"
 #include "../util/conf_file.h"
@@ -70,6 +71,11 @@ sm_ans_xapp_t report_sm_xapp_api(global_e2_node_id_t* id, uint32_t rf_id, void*
 // Remove the handle previously returned
 void rm_report_sm_xapp_api(int const handle);
 
+// Indications queued, dropped and delivered, and the latency histograms
+// of the handle, or of all the report subscriptions if handle is -1.
+// False if the handle is unknown
+bool dispatch_stats_xapp_api(int handle, disp_stats_xapp_t* st);
+
 // Send control message
 // return void but sm_ag_if_ans_ctrl_t should be returned. Add it in the future if needed
 sm_ans_xapp_t control_sm_xapp_api(global_e2_node_id_t* id, uint32_t rf_id, void* wr);
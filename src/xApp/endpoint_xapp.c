@@ -77,6 +77,7 @@ void e2ap_init_ep_xapp(e2ap_ep_xapp_t* ep, const char* addr, int port)
   assert(strlen(addr) < 16);
   assert(port > 0 && port < 65535);
   init_sctp_conn_client(ep, addr, port);
+  ep->shm = NULL;
 }
 
 byte_array_t e2ap_recv_msg_xapp(e2ap_ep_xapp_t* ep)
@@ -97,6 +98,9 @@ void e2ap_send_bytes_xapp(e2ap_ep_xapp_t* ep, byte_array_t ba)
   assert(ep != NULL);
   assert(ba.buf && ba.len > 0);
 
+  if(ep->shm != NULL && send_shm_chan(ep->shm, ba) == true)
+    return;
+
   sctp_msg_t msg = { .ba = ba,
                       .info.addr = ep->to,
                       .info.sri = ep->sri
@@ -112,4 +116,30 @@ void e2ap_free_ep_xapp(e2ap_ep_xapp_t* ep)
   assert(ep != NULL);
 
   e2ap_ep_free(&ep->base);
+
+  if(ep->shm != NULL)
+    free_shm_chan(ep->shm);
+}
+
+bool e2ap_attach_shm_xapp(e2ap_ep_xapp_t* ep, uint16_t xapp_id)
+{
+  assert(ep != NULL);
+  assert(ep->shm == NULL);
+
+  // The iApp checks it against the association of xapp_id
+  struct sockaddr_in local = {0};
+  socklen_t len = sizeof(local);
+  int const rc = getsockname(ep->base.fd, (struct sockaddr*)&local, &len);
+  assert(rc == 0);
+
+  ep->shm = connect_shm_chan(ep->base.port, xapp_id, local.sin_port);
+  return ep->shm != NULL;
+}
+
+size_t e2ap_recv_shm_msgs_xapp(e2ap_ep_xapp_t* ep, size_t max, byte_array_t ba[max])
+{
+  assert(ep != NULL);
+  assert(ep->shm != NULL);
+
+  return recv_shm_chan(ep->shm, max, ba);
 }
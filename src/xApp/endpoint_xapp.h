@@ -25,6 +25,7 @@
 #define ENDPOINT_XAPP
 
 #include "lib/ep/e2ap_ep.h"   // for e2ap_ep_t
+#include "lib/ep/shm_chan.h"  // for shm_chan_t
 #include "util/byte_array.h"  // for byte_array_t
 
 typedef struct e2ap_xapp_xapp
@@ -35,6 +36,10 @@ typedef struct e2ap_xapp_xapp
   struct sockaddr_in to; 
   struct sctp_sndrcvinfo sri;
   int msg_flags;
+
+  // Shared memory channel with the iApp, if co-located. NULL otherwise.
+  // Set before the xApp is connected, and read by the senders after that
+  shm_chan_t* shm;
 } e2ap_ep_xapp_t;
 
 void e2ap_init_ep_xapp(e2ap_ep_xapp_t* ep, const char* addr, int port);
@@ -45,5 +50,11 @@ byte_array_t e2ap_recv_msg_xapp(e2ap_ep_xapp_t* ep);
 
 void e2ap_send_bytes_xapp(e2ap_ep_xapp_t* ep, byte_array_t ba);
 
+// After the E42 Setup. False if the iApp is not on this host or does not offer it
+bool e2ap_attach_shm_xapp(e2ap_ep_xapp_t* ep, uint16_t xapp_id);
+
+// Drain up to max messages of the shared memory channel
+size_t e2ap_recv_shm_msgs_xapp(e2ap_ep_xapp_t* ep, size_t max, byte_array_t ba[max]);
+
 #endif
 
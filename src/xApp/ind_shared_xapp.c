@@ -0,0 +1,62 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include "ind_shared_xapp.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+ind_shared_xapp_t* init_ind_shared_xapp(sm_ag_if_rd_t rd)
+{
+  assert(rd.type == INDICATION_MSG_AGENT_IF_ANS_V0);
+
+  ind_shared_xapp_t* s = malloc(sizeof(ind_shared_xapp_t));
+  assert(s != NULL && "Memory exhausted");
+
+  s->rd = rd;
+  atomic_init(&s->refs, 1);
+  return s;
+}
+
+ind_shared_xapp_t* acquire_ind_shared_xapp(ind_shared_xapp_t* s)
+{
+  assert(s != NULL);
+
+  // The caller already holds a reference, so it cannot reach zero
+  size_t const prev = atomic_fetch_add_explicit(&s->refs, 1, memory_order_relaxed);
+  assert(prev > 0);
+  (void)prev;
+  return s;
+}
+
+void release_ind_shared_xapp(ind_shared_xapp_t* s)
+{
+  assert(s != NULL);
+
+  // acq_rel: the reads of every other consumer happen before the free
+  size_t const prev = atomic_fetch_sub_explicit(&s->refs, 1, memory_order_acq_rel);
+  assert(prev > 0);
+  if(prev > 1)
+    return;
+
+  free_sm_ag_if_rd(&s->rd);
+  free(s);
+}
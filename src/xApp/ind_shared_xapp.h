@@ -0,0 +1,48 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#ifndef INDICATION_SHARED_XAPP_H
+#define INDICATION_SHARED_XAPP_H
+
+// Decoded indication shared by its consumers in the xApp, i.e., the DB
+// writer and the callback dispatcher, instead of one copy per consumer.
+// It is immutable once created, so the consumers read it concurrently
+// without locking. The last release frees it
+
+#include "../sm/agent_if/read/sm_ag_if_rd.h"
+
+#include <stdatomic.h>
+
+typedef struct{
+  // Read only
+  sm_ag_if_rd_t rd;
+  atomic_size_t refs;
+} ind_shared_xapp_t;
+
+// Takes ownership of rd. The caller holds the only reference
+ind_shared_xapp_t* init_ind_shared_xapp(sm_ag_if_rd_t rd);
+
+// One more reference. Returns s
+ind_shared_xapp_t* acquire_ind_shared_xapp(ind_shared_xapp_t* s);
+
+void release_ind_shared_xapp(ind_shared_xapp_t* s);
+
+#endif
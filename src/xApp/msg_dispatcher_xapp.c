@@ -1,80 +1,481 @@
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
-#include "../util/alg_ds/alg/defer.h"
+#include "../util/alg_ds/ds/lock_guard/lock_guard.h"
+#include "../util/time_now_us.h"
 
 #include "msg_dispatcher_xapp.h"
 
+// Indications taken from the queues per lock acquisition
+#define DISP_BATCH 32
 
+// Initial capacity of the queue of a subscription. It grows up to conf.cap
+#define DISP_SUB_INIT_CAP 16
+
+typedef struct{
+  // Ring, grown on demand
+  msg_dispatch_t* buf;
+  size_t head;
+  size_t len;
+  size_t cap;
+
+  // rm_sub_msg_dispatcher called. Freed once drained
+  bool gone;
+
+  disp_stats_xapp_t st;
+} disp_sub_t;
+
+static
+int cmp_ric_req_id(void const* m0_v, void const* m1_v)
+{
+  assert(m0_v != NULL);
+  assert(m1_v != NULL);
+
+  uint16_t const m0 = *(uint16_t const*)m0_v;
+  uint16_t const m1 = *(uint16_t const*)m1_v;
+
+  if(m0 < m1) return 1;
+  if(m0 == m1) return 0;
+  return -1;
+}
 
 static
-msg_dispatch_t static_msg; 
+void free_sub(void* key, void* value)
+{
+  (void)key;
+  disp_sub_t* s = (disp_sub_t*)value;
+
+  for(size_t i = 0; i < s->len; ++i)
+    release_ind_shared_xapp(s->buf[(s->head + i) % s->cap].ind);
 
+  free(s->buf);
+  free(s);
+}
+
+// Called with the mutex locked
 static
-void* create_val(void* it)
+disp_sub_t* find_sub(disp_worker_xapp_t* w, uint16_t ric_req_id)
 {
-  if(it == NULL)
+  void* it = assoc_rb_tree_find(&w->subs, &ric_req_id);
+  if(it == assoc_rb_tree_end(&w->subs))
     return NULL;
 
- // msg_dispatch_t* msg = calloc(1, sizeof( msg_dispatch_t )); 
-//  assert(msg != NULL && "Memory exhausted");
+  return assoc_rb_tree_value(&w->subs, it);
+}
+
+// Called with the mutex locked
+static
+void erase_sub(disp_worker_xapp_t* w, uint16_t ric_req_id)
+{
+  disp_sub_t* s = assoc_rb_tree_extract(&w->subs, &ric_req_id);
+  assert(s != NULL);
+  free_sub(NULL, s);
+}
+
+static
+void push_back_sub(disp_sub_t* s, msg_dispatch_t const* msg, size_t max)
+{
+  if(s->len == s->cap){
+    assert(s->cap < max);
+    size_t const cap = 2*s->cap < DISP_SUB_INIT_CAP ? DISP_SUB_INIT_CAP : (2*s->cap > max ? max : 2*s->cap);
+
+    msg_dispatch_t* buf = malloc(cap * sizeof(msg_dispatch_t));
+    assert(buf != NULL && "Memory exhausted");
+    for(size_t i = 0; i < s->len; ++i)
+      buf[i] = s->buf[(s->head + i) % s->cap];
+
+    free(s->buf);
+    s->buf = buf;
+    s->head = 0;
+    s->cap = cap;
+  }
+
+  s->buf[(s->head + s->len) % s->cap] = *msg;
+  s->len += 1;
+}
+
+static
+msg_dispatch_t pop_front_sub(disp_sub_t* s)
+{
+  assert(s->len > 0);
+  msg_dispatch_t const msg = s->buf[s->head];
+  s->head = (s->head + 1) % s->cap;
+  s->len -= 1;
+  return msg;
+}
+
+static
+msg_dispatch_t pop_back_sub(disp_sub_t* s)
+{
+  assert(s->len > 0);
+  s->len -= 1;
+  return s->buf[(s->head + s->len) % s->cap];
+}
+
+// Called with the mutex locked
+static
+void push_order(disp_worker_xapp_t* w, uint16_t ric_req_id)
+{
+  if(w->len == w->cap){
+    size_t const cap = w->cap == 0 ? 64 : 2*w->cap;
+
+    uint16_t* order = malloc(cap * sizeof(uint16_t));
+    assert(order != NULL && "Memory exhausted");
+    for(size_t i = 0; i < w->len; ++i)
+      order[i] = w->order[(w->head + i) % w->cap];
+
+    free(w->order);
+    w->order = order;
+    w->head = 0;
+    w->cap = cap;
+  }
+
+  w->order[(w->head + w->len) % w->cap] = ric_req_id;
+  w->len += 1;
+}
+
+// Called with the mutex locked
+static
+uint16_t pop_order(disp_worker_xapp_t* w)
+{
+  assert(w->len > 0);
+  uint16_t const ric_req_id = w->order[w->head];
+  w->head = (w->head + 1) % w->cap;
+  w->len -= 1;
+  return ric_req_id;
+}
+
+static
+size_t hist_bucket(int64_t us)
+{
+  if(us < 1)
+    return 0;
 
-  memcpy(&static_msg, it, sizeof(msg_dispatch_t ) );
-  
-  return &static_msg;
+  size_t const b = 64 - __builtin_clzll((uint64_t)us);
+  return b < DISP_HIST_LEN ? b : DISP_HIST_LEN - 1;
 }
 
+static
+void add_done(disp_stats_xapp_t* st, size_t wait_b, size_t cb_b)
+{
+  st->done += 1;
+  st->wait_us[wait_b] += 1;
+  st->cb_us[cb_b] += 1;
+}
 
 static
 void* worker_thread(void* arg)
 {
-  tsnq_t* q = (tsnq_t*)arg;
+  disp_worker_xapp_t* w = (disp_worker_xapp_t*)arg;
+
+  msg_dispatch_t batch[DISP_BATCH];
+  size_t wait_b[DISP_BATCH];
+  size_t cb_b[DISP_BATCH];
 
   while(true){
-    msg_dispatch_t* msg = wait_and_pop_tsnq(q,  create_val);
-    if(msg == NULL)
+    size_t n = 0;
+
+    int rc = pthread_mutex_lock(&w->mtx);
+    assert(rc == 0);
+
+    while(w->len == 0 && w->stop == false)
+      pthread_cond_wait(&w->not_empty, &w->mtx);
+
+    // The queued indications are discarded by free_msg_dispatcher
+    if(w->stop == true){
+      rc = pthread_mutex_unlock(&w->mtx);
+      assert(rc == 0);
       break;
+    }
+
+    // One entry in the order per queued indication, as the overflow
+    // policies replace the indications they drop
+    while(w->len > 0 && n < DISP_BATCH){
+      uint16_t const ric_req_id = pop_order(w);
+      disp_sub_t* s = find_sub(w, ric_req_id);
+      assert(s != NULL && s->len > 0);
+
+      batch[n++] = pop_front_sub(s);
+      s->st.depth = s->len;
+      if(s->gone == true && s->len == 0)
+        erase_sub(w, ric_req_id);
+    }
+    w->st.depth = w->len;
 
-    msg->sm_cb(&msg->rd);
-    free_sm_ag_if_rd(&msg->rd);
+    pthread_cond_broadcast(&w->not_full);
+    rc = pthread_mutex_unlock(&w->mtx);
+    assert(rc == 0);
+
+    for(size_t i = 0; i < n; ++i){
+      int64_t const start = time_now_us();
+      batch[i].sm_cb(&batch[i].ind->rd);
+      int64_t const stop = time_now_us();
+      release_ind_shared_xapp(batch[i].ind);
+
+      wait_b[i] = hist_bucket(start - batch[i].tstamp);
+      cb_b[i] = hist_bucket(stop - start);
+    }
+
+    lock_guard(&w->mtx);
+    for(size_t i = 0; i < n; ++i){
+      add_done(&w->st, wait_b[i], cb_b[i]);
+      disp_sub_t* s = find_sub(w, batch[i].ric_req_id);
+      if(s != NULL)
+        add_done(&s->st, wait_b[i], cb_b[i]);
+    }
   }
-  q->stopped = true;
 
   return NULL;
 }
 
+static
+void init_worker(disp_worker_xapp_t* w, disp_conf_xapp_t conf)
+{
+  memset(w, 0, sizeof(*w));
+  w->conf = conf;
+
+  assoc_rb_tree_init(&w->subs, sizeof(uint16_t), cmp_ric_req_id, free_sub);
+
+  int rc = pthread_mutex_init(&w->mtx, NULL);
+  assert(rc == 0);
+  rc = pthread_cond_init(&w->not_empty, NULL);
+  assert(rc == 0);
+  rc = pthread_cond_init(&w->not_full, NULL);
+  assert(rc == 0);
+
+  rc = pthread_create(&w->p, NULL, worker_thread, w);
+  assert(rc == 0);
+}
+
+static
+void free_worker(disp_worker_xapp_t* w)
+{
+  int rc = pthread_mutex_lock(&w->mtx);
+  assert(rc == 0);
+  w->stop = true;
+  pthread_cond_broadcast(&w->not_empty);
+  // Blocked senders, if any, give up
+  pthread_cond_broadcast(&w->not_full);
+  rc = pthread_mutex_unlock(&w->mtx);
+  assert(rc == 0);
+
+  rc = pthread_join(w->p, NULL);
+  assert(rc == 0);
+
+  assoc_rb_tree_free(&w->subs);
+  free(w->order);
 
-void init_msg_dispatcher( msg_dispatcher_xapp_t* d)
+  pthread_cond_destroy(&w->not_full);
+  pthread_cond_destroy(&w->not_empty);
+  pthread_mutex_destroy(&w->mtx);
+}
+
+static
+void send_worker(disp_worker_xapp_t* w, msg_dispatch_t* msg)
 {
-  assert(d != NULL);
+  // Freed out of the critical section
+  msg_dispatch_t dropped = {0};
+  bool drop = false;
 
-  init_tsnq(&d->q, sizeof(msg_dispatch_t));
-  int rc = pthread_create(&d->p, NULL, worker_thread, &d->q);
+  int rc = pthread_mutex_lock(&w->mtx);
   assert(rc == 0);
+
+  size_t const cap = w->conf.cap;
+  disp_sub_t* s = find_sub(w, msg->ric_req_id);
+  // Unknown or removed subscription, e.g., an indication that was on its
+  // way while unsubscribing. Not delivered
+  if(s != NULL && s->gone == true)
+    s = NULL;
+  // The overflow policies that drop keep the count, and the order, as it is
+  bool new_entry = true;
+
+  if(w->stop == true || s == NULL){
+    drop = true;
+  } else if(s->len == cap && w->conf.overflow == DISP_OVERFLOW_BLOCK){
+    while(s != NULL && s->len == cap && w->stop == false){
+      pthread_cond_wait(&w->not_full, &w->mtx);
+      // Removed meanwhile. The worker frees it once drained, and its
+      // indications are not delivered anymore
+      s = find_sub(w, msg->ric_req_id);
+      if(s != NULL && s->gone == true)
+        s = NULL;
+    }
+    drop = w->stop == true || s == NULL;
+  } else if(s->len == cap && w->conf.overflow == DISP_OVERFLOW_DROP_OLDEST){
+    dropped = pop_front_sub(s);
+    new_entry = false;
+  } else if(s->len == cap){
+    assert(w->conf.overflow == DISP_OVERFLOW_KEEP_LATEST);
+    dropped = pop_back_sub(s);
+    new_entry = false;
+  }
+
+  if(drop == true){
+    dropped = *msg;
+  } else {
+    push_back_sub(s, msg, cap);
+    if(new_entry == true)
+      push_order(w, msg->ric_req_id);
+    s->st.enq += 1;
+    w->st.enq += 1;
+    pthread_cond_signal(&w->not_empty);
+  }
+
+  bool const has_dropped = drop == true || new_entry == false;
+  if(has_dropped == true)
+    w->st.drop += 1;
+
+  if(s != NULL){
+    if(has_dropped == true)
+      s->st.drop += 1;
+    s->st.depth = s->len;
+    if(s->len > s->st.max_depth)
+      s->st.max_depth = s->len;
+  }
+  w->st.depth = w->len;
+  if(w->len > w->st.max_depth)
+    w->st.max_depth = w->len;
+
+  rc = pthread_mutex_unlock(&w->mtx);
+  assert(rc == 0);
+
+  if(has_dropped == true)
+    release_ind_shared_xapp(dropped.ind);
+}
+
+static
+void add_sub_worker(disp_worker_xapp_t* w, uint16_t ric_req_id)
+{
+  lock_guard(&w->mtx);
+
+  disp_sub_t* s = find_sub(w, ric_req_id);
+  if(s == NULL){
+    s = calloc(1, sizeof(disp_sub_t));
+    assert(s != NULL && "Memory exhausted");
+    assoc_rb_tree_insert(&w->subs, &ric_req_id, sizeof(ric_req_id), s);
+    return;
+  }
+
+  // Same ric_req_id as a removed one that is still draining. Its queued
+  // indications go first, but they do not count for the new one
+  assert(s->gone == true && "Subscription added twice");
+  s->gone = false;
+  s->st = (disp_stats_xapp_t){.depth = s->len, .max_depth = s->len};
+}
+
+static
+void rm_sub_worker(disp_worker_xapp_t* w, uint16_t ric_req_id)
+{
+  lock_guard(&w->mtx);
+
+  disp_sub_t* s = find_sub(w, ric_req_id);
+  if(s == NULL)
+    return;
+
+  if(s->len == 0)
+    erase_sub(w, ric_req_id);
+  else
+    s->gone = true;
+}
+
+static
+void add_stats(disp_stats_xapp_t* dst, disp_stats_xapp_t const* src)
+{
+  dst->enq += src->enq;
+  dst->done += src->done;
+  dst->drop += src->drop;
+  dst->depth += src->depth;
+  if(src->max_depth > dst->max_depth)
+    dst->max_depth = src->max_depth;
+
+  for(size_t i = 0; i < DISP_HIST_LEN; ++i){
+    dst->wait_us[i] += src->wait_us[i];
+    dst->cb_us[i] += src->cb_us[i];
+  }
+}
+
+// A subscription always goes to the same worker, so its callbacks run in order
+static
+disp_worker_xapp_t* worker_sub(msg_dispatcher_xapp_t* d, uint16_t ric_req_id)
+{
+  return &d->w[ric_req_id % d->len];
+}
+
+void init_msg_dispatcher( msg_dispatcher_xapp_t* d, disp_conf_xapp_t conf)
+{
+  assert(d != NULL);
+  assert(conf.cap > 0);
+  assert(conf.overflow < DISP_OVERFLOW_END);
+  assert(conf.workers > 0);
+
+  d->conf = conf;
+  d->len = conf.workers;
+  d->w = calloc(d->len, sizeof(disp_worker_xapp_t));
+  assert(d->w != NULL && "Memory exhausted");
+
+  for(size_t i = 0; i < d->len; ++i)
+    init_worker(&d->w[i], conf);
 }
 
 void free_msg_dispatcher(msg_dispatcher_xapp_t* d)
 {
   assert(d != NULL);
 
-  free_tsnq(&d->q, NULL);
-  int rc = pthread_join(d->p, NULL);
-  assert(rc == 0);
+  for(size_t i = 0; i < d->len; ++i)
+    free_worker(&d->w[i]);
+
+  free(d->w);
 }
 
 void send_msg_dispatcher( msg_dispatcher_xapp_t* d, msg_dispatch_t* msg )
 {
   assert(d != NULL);
   assert(msg != NULL);
+  assert(msg->sm_cb != NULL);
+  assert(msg->ind != NULL);
 
-  push_tsnq(&d->q, msg, sizeof(msg_dispatch_t));
+  msg->tstamp = time_now_us();
+  send_worker(worker_sub(d, msg->ric_req_id), msg);
 }
 
-size_t size_msg_dispatcher(msg_dispatcher_xapp_t* d)
+void add_sub_msg_dispatcher(msg_dispatcher_xapp_t* d, uint16_t ric_req_id)
 {
   assert(d != NULL);
+  add_sub_worker(worker_sub(d, ric_req_id), ric_req_id);
+}
 
-  return size_tsnq(&d->q);
+void rm_sub_msg_dispatcher(msg_dispatcher_xapp_t* d, uint16_t ric_req_id)
+{
+  assert(d != NULL);
+  rm_sub_worker(worker_sub(d, ric_req_id), ric_req_id);
 }
 
+disp_stats_xapp_t stats_msg_dispatcher(msg_dispatcher_xapp_t* d)
+{
+  assert(d != NULL);
+
+  disp_stats_xapp_t st = {0};
+  for(size_t i = 0; i < d->len; ++i){
+    disp_worker_xapp_t* w = &d->w[i];
+    lock_guard(&w->mtx);
+    add_stats(&st, &w->st);
+  }
+
+  return st;
+}
+
+bool stats_sub_msg_dispatcher(msg_dispatcher_xapp_t* d, uint16_t ric_req_id, disp_stats_xapp_t* st)
+{
+  assert(d != NULL);
+  assert(st != NULL);
+
+  disp_worker_xapp_t* w = worker_sub(d, ric_req_id);
+  lock_guard(&w->mtx);
+  disp_sub_t const* s = find_sub(w, ric_req_id);
+  if(s == NULL || s->gone == true)
+    return false;
+
+  *st = s->st;
+  return true;
+}
@@ -24,30 +24,128 @@
 #ifndef MESSAGE_DISPATCHER_XAPP_H
 #define MESSAGE_DISPATCHER_XAPP_H 
 
+/*
+ * Hands the indications over to the xApp callbacks in worker threads.
+ *
+ * Every report subscription owns a bounded queue, so a slow callback
+ * no longer makes the xApp memory grow without limit. The policy on
+ * overflow applies to all the subscriptions.
+ *
+ * A pool of workers runs the callbacks. A subscription is pinned to one
+ * worker, so its indications are delivered in arrival order, while the
+ * callbacks of subscriptions on different workers run concurrently.
+*/
 
-#include "../util/alg_ds/ds/tsn_queue/tsn_queue.h"
+#include "../util/alg_ds/ds/assoc_container/assoc_rb_tree.h"
 #include "../sm/agent_if/read/sm_ag_if_rd.h"
+#include "ind_shared_xapp.h"
 
 #include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// What send_msg_dispatcher does when the queue of the subscription is full
+typedef enum{
+  // Wait for room. Stalls the E42 event loop, i.e., backpressure up to
+  // the iApp. The callbacks must not wait for the E42 loop, e.g., by
+  // calling control_sm_xapp_api(), as it would never make room
+  DISP_OVERFLOW_BLOCK,
+  // Discard the oldest queued indication of the subscription
+  DISP_OVERFLOW_DROP_OLDEST,
+  // Overwrite the newest queued indication of the subscription. For a
+  // per UE subscription, the queue keeps the latest state of the UE
+  DISP_OVERFLOW_KEEP_LATEST,
 
+  DISP_OVERFLOW_END,
+} disp_overflow_e;
 
 typedef struct{
-  pthread_t p;
-  tsnq_t q;
-} msg_dispatcher_xapp_t;
+  // Indications queued per subscription
+  size_t cap;
+  disp_overflow_e overflow;
+  // Threads running the callbacks
+  size_t workers;
+} disp_conf_xapp_t;
+
+// Bucket i counts the latencies in [2^(i-1), 2^i) us. Bucket 0 counts
+// the ones below 1 us and the last one is open ended
+#define DISP_HIST_LEN 24
 
 typedef struct{
-  sm_ag_if_rd_t rd; 
+  uint64_t enq;
+  uint64_t done;
+  uint64_t drop;
+  size_t depth;
+  size_t max_depth;
+  // Time from send_msg_dispatcher to the callback
+  uint64_t wait_us[DISP_HIST_LEN];
+  // Time spent in the callback
+  uint64_t cb_us[DISP_HIST_LEN];
+} disp_stats_xapp_t;
+
+typedef struct{
+  // One reference, released once the callback returns
+  ind_shared_xapp_t* ind;
   void (*sm_cb)(sm_ag_if_rd_t const*);
+  // Subscription, i.e., the handle returned by report_sm_xapp_api
+  uint16_t ric_req_id;
+  // Set by send_msg_dispatcher
+  int64_t tstamp;
 } msg_dispatch_t ;
 
-void init_msg_dispatcher( msg_dispatcher_xapp_t* d);
+typedef struct{
+  disp_conf_xapp_t conf;
+
+  pthread_t p;
+  pthread_mutex_t mtx;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+
+  // key: ric_req_id | value: queue of the subscription
+  assoc_rb_tree_t subs;
 
+  // ric_req_id per queued indication, in arrival order
+  uint16_t* order;
+  size_t head;
+  size_t len;
+  size_t cap;
+
+  bool stop;
+
+  // All the subscriptions of the worker
+  disp_stats_xapp_t st;
+} disp_worker_xapp_t;
+
+typedef struct{
+  disp_conf_xapp_t conf;
+
+  // Worker of a subscription: ric_req_id % len
+  disp_worker_xapp_t* w;
+  size_t len;
+} msg_dispatcher_xapp_t;
+
+void init_msg_dispatcher( msg_dispatcher_xapp_t* d, disp_conf_xapp_t conf);
+
+// The queued indications are discarded
 void free_msg_dispatcher( msg_dispatcher_xapp_t* d);
 
+// Takes over the msg->ind reference, even if dropped. The indications of
+// unknown or removed subscriptions are dropped
 void send_msg_dispatcher( msg_dispatcher_xapp_t* d, msg_dispatch_t* msg );
 
-size_t size_msg_dispatcher(msg_dispatcher_xapp_t* d);
+// Before the subscription request is sent, so that its first indication
+// finds the queue
+void add_sub_msg_dispatcher(msg_dispatcher_xapp_t* d, uint16_t ric_req_id);
 
-#endif
+// The queued indications of the subscription are still delivered
+void rm_sub_msg_dispatcher(msg_dispatcher_xapp_t* d, uint16_t ric_req_id);
 
+// All the subscriptions, including the removed ones. max_depth is the
+// largest among the workers, not the one of the whole pool
+disp_stats_xapp_t stats_msg_dispatcher(msg_dispatcher_xapp_t* d);
+
+// False if the subscription is unknown or removed
+bool stats_sub_msg_dispatcher(msg_dispatcher_xapp_t* d, uint16_t ric_req_id, disp_stats_xapp_t* st);
+
+#endif
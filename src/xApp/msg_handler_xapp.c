@@ -34,6 +34,7 @@
 
 #include "msg_generator_xapp.h"
 #include "e2ap_xapp.h"
+#include "ind_shared_xapp.h"
 
 #include "lib/e2ap/e2ap_msg_free_wrapper.h"
 #include "lib/pending_events.h"
@@ -249,26 +250,31 @@ sm_ind_data_t ind_sm_payload(ric_indication_t const* src)
 
   sm_ind_data_t ind_data = ind_sm_payload(src);
 
-  msg_dispatch_t msg_disp = {.rd.type = INDICATION_MSG_AGENT_IF_ANS_V0 };
-  msg_disp.rd.ind = sm->proc.on_indication(sm, &ind_data);
-  assert(msg_disp.rd.ind.type == MAC_STATS_V0 || msg_disp.rd.ind.type == RLC_STATS_V0 
-      || msg_disp.rd.ind.type == PDCP_STATS_V0 || msg_disp.rd.ind.type == SLICE_STATS_V0 
-      || msg_disp.rd.ind.type == KPM_STATS_V3_0 || msg_disp.rd.ind.type == GTP_STATS_V0
-      || msg_disp.rd.ind.type == RAN_CTRL_STATS_V1_03);
+  sm_ag_if_rd_t rd = {.type = INDICATION_MSG_AGENT_IF_ANS_V0 };
+  rd.ind = sm->proc.on_indication(sm, &ind_data);
+  assert(rd.ind.type == MAC_STATS_V0 || rd.ind.type == RLC_STATS_V0 
+      || rd.ind.type == PDCP_STATS_V0 || rd.ind.type == SLICE_STATS_V0 
+      || rd.ind.type == KPM_STATS_V3_0 || rd.ind.type == GTP_STATS_V0
+      || rd.ind.type == RAN_CTRL_STATS_V1_03);
   
   act_proc_ans_t ans = find_act_proc(&xapp->act_proc, src->ric_id.ric_req_id);
 
   if(ans.ok == false){
     printf("%s \n", ans.error); 
     printf("ric_req_id = %d not in the registry. Spuriosly can happen.\n",  src->ric_id.ric_req_id);
-    free_sm_ag_if_rd(&msg_disp.rd);
+    free_sm_ag_if_rd(&rd);
   } else {
-   
+    // One decoded copy, read by the DB writer and the callback
+    ind_shared_xapp_t* ind = init_ind_shared_xapp(rd);
+
    // Write to SQL DB
-   write_db_xapp(&xapp->db, &ans.val.e2_node, &msg_disp.rd);
+   write_db_xapp(&xapp->db, &ans.val.e2_node, ind);
 
     // Write to the callback. Should I send the E2 Node info to the cb??
+    // It takes over the reference of init_ind_shared_xapp
+    msg_dispatch_t msg_disp = {.ind = ind};
     msg_disp.sm_cb = ans.val.sm_cb;
+    msg_disp.ric_req_id = src->ric_id.ric_req_id;
     send_msg_dispatcher(&xapp->msg_disp, &msg_disp );
  }
 
@@ -377,6 +383,16 @@ e2ap_msg_t e2ap_handle_e42_setup_response_xapp(e42_xapp_t* xapp, const e2ap_msg_
   pending_event_xapp_t ev = {.ev = E42_SETUP_REQUEST_PENDING_EVENT };
   rm_pending_event_xapp(xapp, &ev);
 
+  // Before connected is set, so that every message after the setup goes through it
+  if(xapp->shm == true){
+    if(e2ap_attach_shm_xapp(&xapp->ep, xapp->id) == true){
+      add_fd_asio_xapp(&xapp->io, xapp->ep.shm->rx_fd);
+      printf("[xApp]: E42 through shared memory \n");
+    } else {
+      printf("[xApp]: Shared memory not offered by the nearRT-RIC. E42 through SCTP \n");
+    }
+  }
+
   // Set the connected flag 
   xapp->connected = true;
 
@@ -238,6 +238,21 @@ sm_io_ag_ran_t init_sm_io_ag_ran(void)
 }
 
 
+// Waits until the RIC sees len E2 Nodes, up to 5 s
+static
+void wait_e2_nodes(size_t len)
+{
+  for (int i = 0; i < 50; ++i) {
+    e2_nodes_api_t nodes = e2_nodes_near_ric_api();
+    size_t const cur = nodes.len;
+    free_e2_nodes_api(&nodes);
+    if (cur == len)
+      return;
+    usleep(100000);
+  }
+  assert(0 != 0 && "Unexpected number of E2 Nodes");
+}
+
 int main(int argc, char *argv[])
 {
   // Init the Agent
@@ -326,6 +341,16 @@ int main(int argc, char *argv[])
 
   sleep(1);
 
+  // Remove the RIC from the Agent, and add it back
+  char* ric_ip = get_near_ric_ip(&args);
+  assert(remove_ric_agent_api(ric_ip) == true);
+  wait_e2_nodes(0);
+  assert(remove_ric_agent_api(ric_ip) == false);
+
+  init_agent_api( mcc, mnc, mnc_digit_len, nb_id, cu_du_id, ran_type, io, &args);
+  wait_e2_nodes(1);
+  free(ric_ip);
+
   // Stop the Agent
   stop_agent_api();
 
@@ -0,0 +1,315 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Indication cache shared by the agents of several nearRT-RICs. The first
+// agent of a tick reads the RAN while the rest wait and share its result,
+// a late agent reads on its own, the waiters of a tick replaced meanwhile
+// are woken up, and the entries of deleted subscriptions are pruned
+
+#include "../../src/agent/ind_cache_agent.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static atomic_int ran_reads;
+
+typedef struct{
+  uint64_t tick;
+  // Blocks the read until set. NULL does not block
+  atomic_bool* open;
+  atomic_bool entered;
+} read_arg_t;
+
+static
+exp_ind_data_t read_ran(void const* arg)
+{
+  read_arg_t* ra = (read_arg_t*)arg;
+  atomic_fetch_add(&ran_reads, 1);
+  atomic_store(&ra->entered, true);
+  while(ra->open != NULL && atomic_load(ra->open) == false)
+    usleep(100);
+
+  exp_ind_data_t exp = {.has_value = true};
+  exp.data.len_msg = sizeof(ra->tick);
+  exp.data.ind_msg = malloc(sizeof(ra->tick));
+  assert(exp.data.ind_msg != NULL);
+  memcpy(exp.data.ind_msg, &ra->tick, sizeof(ra->tick));
+  return exp;
+}
+
+static
+exp_ind_data_t read_nothing(void const* arg)
+{
+  (void)arg;
+  atomic_fetch_add(&ran_reads, 1);
+  return (exp_ind_data_t){.has_value = false};
+}
+
+static
+uint64_t tick_of(ind_shared_agent_t const* ind)
+{
+  assert(ind != NULL && ind->data.len_msg == sizeof(uint64_t));
+  uint64_t tick = 0;
+  memcpy(&tick, ind->data.ind_msg, sizeof(tick));
+  return tick;
+}
+
+typedef struct{
+  ind_cache_agent_t* c;
+  ind_cache_key_t const* k;
+  uint64_t due;
+  read_arg_t ra;
+  ind_shared_agent_t* ind;
+  atomic_bool done;
+  pthread_t t;
+} agent_t;
+
+static
+void* agent_thread(void* arg)
+{
+  agent_t* a = (agent_t*)arg;
+  a->ind = get_ind_cache_agent(a->c, a->k, a->due, read_ran, &a->ra);
+  atomic_store(&a->done, true);
+  return NULL;
+}
+
+static
+void start_agent(agent_t* a, ind_cache_agent_t* c, ind_cache_key_t const* k, uint64_t due, atomic_bool* open)
+{
+  *a = (agent_t){.c = c, .k = k, .due = due, .ra = {.tick = due, .open = open}};
+  int const rc = pthread_create(&a->t, NULL, agent_thread, a);
+  assert(rc == 0);
+}
+
+static
+void join_agent(agent_t* a)
+{
+  int const rc = pthread_join(a->t, NULL);
+  assert(rc == 0);
+}
+
+static
+void wait_flag(atomic_bool const* f)
+{
+  for(int i = 0; i < 10000 && atomic_load(f) == false; ++i)
+    usleep(100);
+  assert(atomic_load(f) == true);
+}
+
+static
+uint8_t ad_kpm[] = {1, 2, 3, 4};
+
+#define AGENTS 8
+
+static
+void test_first_reader_and_waiters(void)
+{
+  ind_cache_agent_t c;
+  init_ind_cache_agent(&c);
+  ind_cache_key_t const k = {.ran_func_id = 2, .period_ms = 10, .ad = {.len = sizeof(ad_kpm), .buf = ad_kpm}};
+  atomic_store(&ran_reads, 0);
+
+  atomic_bool open = false;
+  agent_t a[AGENTS];
+  start_agent(&a[0], &c, &k, 10, &open);
+  wait_flag(&a[0].ra.entered);
+
+  // They find the read in flight and wait for it
+  for(size_t i = 1; i < AGENTS; ++i)
+    start_agent(&a[i], &c, &k, 10, &open);
+  usleep(20000);
+  for(size_t i = 0; i < AGENTS; ++i)
+    assert(atomic_load(&a[i].done) == false);
+
+  atomic_store(&open, true);
+  for(size_t i = 0; i < AGENTS; ++i)
+    join_agent(&a[i]);
+
+  assert(atomic_load(&ran_reads) == 1);
+  for(size_t i = 0; i < AGENTS; ++i){
+    assert(a[i].ind == a[0].ind);
+    assert(a[i].ra.entered == (i == 0));
+  }
+  assert(tick_of(a[0].ind) == 10);
+  // Plus the one of the cache
+  assert(atomic_load(&a[0].ind->refs) == AGENTS + 1);
+
+  // Same tick, afterwards. Served from the cache
+  ind_shared_agent_t* again = get_ind_cache_agent(&c, &k, 10, read_nothing, NULL);
+  assert(again == a[0].ind);
+  release_ind_shared_agent(again);
+  for(size_t i = 0; i < AGENTS; ++i)
+    release_ind_shared_agent(a[i].ind);
+
+  // Nothing to report is shared too
+  assert(get_ind_cache_agent(&c, &k, 20, read_nothing, NULL) == NULL);
+  assert(get_ind_cache_agent(&c, &k, 20, read_ran, NULL) == NULL);
+  assert(atomic_load(&ran_reads) == 2);
+
+  // Another action definition is another entry
+  uint8_t ad_other[] = {1, 2, 3, 5};
+  ind_cache_key_t const k2 = {.ran_func_id = 2, .period_ms = 10, .ad = {.len = sizeof(ad_other), .buf = ad_other}};
+  read_arg_t ra = {.tick = 20};
+  ind_shared_agent_t* ind = get_ind_cache_agent(&c, &k2, 20, read_ran, &ra);
+  assert(tick_of(ind) == 20 && atomic_load(&ran_reads) == 3);
+  assert(seq_arr_size(&c.arr) == 2);
+  release_ind_shared_agent(ind);
+
+  free_ind_cache_agent(&c);
+}
+
+static
+void test_late_agent(void)
+{
+  ind_cache_agent_t c;
+  init_ind_cache_agent(&c);
+  ind_cache_key_t const k = {.ran_func_id = 3, .period_ms = 5};
+  atomic_store(&ran_reads, 0);
+
+  read_arg_t ra10 = {.tick = 10};
+  read_arg_t ra15 = {.tick = 15};
+  ind_shared_agent_t* i10 = get_ind_cache_agent(&c, &k, 10, read_ran, &ra10);
+  ind_shared_agent_t* i15 = get_ind_cache_agent(&c, &k, 15, read_ran, &ra15);
+  assert(tick_of(i10) == 10 && tick_of(i15) == 15);
+
+  // The tick 10 was replaced. The late agent reads on its own, and the
+  // cache keeps the tick 15
+  read_arg_t late = {.tick = 10};
+  ind_shared_agent_t* own = get_ind_cache_agent(&c, &k, 10, read_ran, &late);
+  assert(own != i10 && tick_of(own) == 10);
+  assert(atomic_load(&own->refs) == 1);
+  assert(atomic_load(&ran_reads) == 3);
+
+  ind_shared_agent_t* cached = get_ind_cache_agent(&c, &k, 15, read_nothing, NULL);
+  assert(cached == i15 && atomic_load(&ran_reads) == 3);
+
+  release_ind_shared_agent(own);
+  release_ind_shared_agent(cached);
+  release_ind_shared_agent(i15);
+  release_ind_shared_agent(i10);
+  free_ind_cache_agent(&c);
+}
+
+static
+void test_tick_replaced_while_reading(void)
+{
+  ind_cache_agent_t c;
+  init_ind_cache_agent(&c);
+  ind_cache_key_t const k = {.ran_func_id = 4, .period_ms = 10};
+  atomic_store(&ran_reads, 0);
+
+  atomic_bool open_30 = false;
+  atomic_bool open_40 = false;
+
+  agent_t first;
+  start_agent(&first, &c, &k, 30, &open_30);
+  wait_flag(&first.ra.entered);
+
+  agent_t waiter;
+  start_agent(&waiter, &c, &k, 30, NULL);
+  usleep(20000);
+  assert(atomic_load(&waiter.done) == false);
+
+  // A faster agent takes the entry over for the next tick
+  agent_t next;
+  start_agent(&next, &c, &k, 40, &open_40);
+  wait_flag(&next.ra.entered);
+
+  // The waiter of tick 30 must not wait for the read of tick 40
+  atomic_store(&open_30, true);
+  join_agent(&first);
+  wait_flag(&waiter.done);
+  assert(atomic_load(&next.done) == false);
+  assert(waiter.ra.entered == true);
+  assert(tick_of(waiter.ind) == 30 && waiter.ind != first.ind);
+
+  atomic_store(&open_40, true);
+  join_agent(&next);
+  join_agent(&waiter);
+  assert(atomic_load(&ran_reads) == 3);
+
+  // The result of tick 30 was not cached over the one of tick 40
+  ind_shared_agent_t* cached = get_ind_cache_agent(&c, &k, 40, read_nothing, NULL);
+  assert(cached == next.ind && tick_of(cached) == 40);
+
+  release_ind_shared_agent(cached);
+  release_ind_shared_agent(first.ind);
+  release_ind_shared_agent(waiter.ind);
+  release_ind_shared_agent(next.ind);
+  free_ind_cache_agent(&c);
+}
+
+static
+void test_prune(void)
+{
+  ind_cache_agent_t c;
+  init_ind_cache_agent(&c);
+  ind_cache_key_t const gone = {.ran_func_id = 5, .period_ms = 10};
+  ind_cache_key_t const slow = {.ran_func_id = 6, .period_ms = 10};
+  ind_cache_key_t const fresh = {.ran_func_id = 7, .period_ms = 10};
+  ind_cache_key_t const newer = {.ran_func_id = 8, .period_ms = 1};
+
+  read_arg_t ra = {.tick = 10};
+  release_ind_shared_agent(get_ind_cache_agent(&c, &gone, 10, read_ran, &ra));
+
+  // Still reading an old tick. Never pruned in flight
+  atomic_bool open = false;
+  agent_t a;
+  start_agent(&a, &c, &slow, 10, &open);
+  wait_flag(&a.ra.entered);
+
+  // Two periods behind is kept
+  ra.tick = 30;
+  release_ind_shared_agent(get_ind_cache_agent(&c, &fresh, 30, read_ran, &ra));
+  assert(seq_arr_size(&c.arr) == 3);
+
+  // More than two periods behind goes away with the next new entry
+  ra.tick = 31;
+  release_ind_shared_agent(get_ind_cache_agent(&c, &newer, 31, read_ran, &ra));
+  assert(seq_arr_size(&c.arr) == 3);
+
+  ind_shared_agent_t* none = get_ind_cache_agent(&c, &gone, 10, read_nothing, NULL);
+  assert(none == NULL && seq_arr_size(&c.arr) == 4);
+
+  atomic_store(&open, true);
+  join_agent(&a);
+  assert(tick_of(a.ind) == 10);
+  release_ind_shared_agent(a.ind);
+
+  free_ind_cache_agent(&c);
+}
+
+int main()
+{
+  test_first_reader_and_waiters();
+  test_late_agent();
+  test_tick_replaced_while_reading();
+  test_prune();
+
+  printf("Indication cache agent test succeeded\n");
+  return EXIT_SUCCESS;
+}
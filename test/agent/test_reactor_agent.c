@@ -0,0 +1,179 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Event loop shared by several agents. Every agent with events is served,
+// and once rm_reactor_agent() returns the removed agent is marked as
+// stopped and never polled again, even while its fds keep firing. The
+// agents are bare ones, e2_poll_agent() just drains their pipe
+
+#include "../../src/agent/e2_agent.h"
+#include "../../src/agent/reactor_agent.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NUM_AGENTS 3
+
+typedef struct{
+  e2_agent_t* ag;
+  atomic_size_t polls;
+  atomic_size_t bytes;
+} peer_t;
+
+static peer_t peers[NUM_AGENTS];
+
+static
+peer_t* find_peer(e2_agent_t* ag)
+{
+  for (size_t i = 0; i < NUM_AGENTS; ++i) {
+    if (peers[i].ag == ag)
+      return &peers[i];
+  }
+  assert(0 != 0 && "Unknown agent");
+  return NULL;
+}
+
+// The real one serves the agent's fds. Here, only the pipe is written
+size_t e2_poll_agent(e2_agent_t* ag, size_t budget)
+{
+  peer_t* p = find_peer(ag);
+
+  char buf[16];
+  size_t const len = budget < sizeof(buf) ? budget : sizeof(buf);
+  ssize_t const rc = read(ag->io.pipe.r, buf, len);
+  assert(rc > 0);
+
+  atomic_fetch_add(&p->polls, 1);
+  atomic_fetch_add(&p->bytes, rc);
+  return rc;
+}
+
+static
+void write_pipe(peer_t* p, size_t len)
+{
+  for (size_t i = 0; i < len; ++i) {
+    char const c = 'x';
+    ssize_t const rc = write(p->ag->io.pipe.w, &c, 1);
+    assert(rc == 1);
+  }
+}
+
+// Waits until the reactor read every byte written to the agent
+static
+void wait_served(peer_t* p, size_t bytes)
+{
+  for (int i = 0; i < 5000 && atomic_load(&p->bytes) < bytes; ++i)
+    usleep(1000);
+  assert(atomic_load(&p->bytes) == bytes);
+}
+
+static
+atomic_bool stop_writer;
+
+static
+void* writer(void* arg)
+{
+  peer_t* p = (peer_t*)arg;
+  while (atomic_load(&stop_writer) == false) {
+    write_pipe(p, 1);
+    usleep(100);
+  }
+  return NULL;
+}
+
+static
+void test_reactor(void)
+{
+  reactor_agent_t r = {0};
+  init_reactor_agent(&r);
+
+  for (size_t i = 0; i < NUM_AGENTS; ++i) {
+    peers[i].ag = calloc(1, sizeof(e2_agent_t));
+    assert(peers[i].ag != NULL && "Memory exhausted");
+    init_asio_agent(&peers[i].ag->io);
+    atomic_init(&peers[i].polls, 0);
+    atomic_init(&peers[i].bytes, 0);
+    add_reactor_agent(&r, peers[i].ag);
+  }
+  assert(size_reactor_agent(&r) == NUM_AGENTS);
+
+  // Every agent with events is served, more than a budget per agent included
+  for (size_t i = 0; i < NUM_AGENTS; ++i)
+    write_pipe(&peers[i], 64);
+  for (size_t i = 0; i < NUM_AGENTS; ++i)
+    wait_served(&peers[i], 64);
+
+  // An idle removed agent is not polled anymore
+  rm_reactor_agent(&r, peers[0].ag);
+  assert(peers[0].ag->agent_stopped == true);
+  assert(size_reactor_agent(&r) == NUM_AGENTS - 1);
+
+  write_pipe(&peers[0], 8);
+  write_pipe(&peers[1], 8);
+  wait_served(&peers[1], 64 + 8);
+  assert(atomic_load(&peers[0].bytes) == 64);
+
+  // Nor a removed agent whose fds keep firing
+  atomic_init(&stop_writer, false);
+  pthread_t thrd;
+  int rc = pthread_create(&thrd, NULL, writer, &peers[2]);
+  assert(rc == 0);
+  usleep(20000);
+
+  rm_reactor_agent(&r, peers[2].ag);
+  assert(peers[2].ag->agent_stopped == true);
+  size_t const polls = atomic_load(&peers[2].polls);
+  assert(polls > 0);
+  usleep(20000);
+  assert(atomic_load(&peers[2].polls) == polls);
+
+  atomic_store(&stop_writer, true);
+  rc = pthread_join(thrd, NULL);
+  assert(rc == 0);
+
+  // The remaining agent is still served
+  write_pipe(&peers[1], 8);
+  wait_served(&peers[1], 64 + 8 + 8);
+  assert(size_reactor_agent(&r) == 1);
+
+  rm_reactor_agent(&r, peers[1].ag);
+  assert(size_reactor_agent(&r) == 0);
+
+  free_reactor_agent(&r);
+
+  for (size_t i = 0; i < NUM_AGENTS; ++i) {
+    free_asio_agent(&peers[i].ag->io);
+    free(peers[i].ag);
+  }
+}
+
+int main()
+{
+  test_reactor();
+
+  printf("Reactor agent test succeeded\n");
+  return EXIT_SUCCESS;
+}
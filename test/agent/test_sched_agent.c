@@ -0,0 +1,231 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Periodic indication scheduler with 1, 5 and 10 ms groups, driven by the
+// agent epoll loop. The due times must stay on the multiples of the period,
+// the groups must be served in the same wake ups, every missed period must
+// be accounted as an overrun, and the timer must follow the groups removed
+
+#include "../../src/agent/asio_agent.h"
+#include "../../src/agent/sched_agent.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SERVED 4096
+
+typedef struct{
+  int id;
+  int64_t period_ms;
+  uint64_t due;
+  // Wake up that served it
+  uint64_t tick;
+} served_t;
+
+typedef struct{
+  served_t s[MAX_SERVED];
+  size_t len;
+  uint64_t tick;
+} log_t;
+
+static
+void on_due(int id, int64_t period_ms, uint64_t due, void* arg)
+{
+  log_t* log = (log_t*)arg;
+  assert(log->len < MAX_SERVED);
+  log->s[log->len++] = (served_t){.id = id, .period_ms = period_ms, .due = due, .tick = log->tick};
+}
+
+static
+uint64_t now_ms(void)
+{
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static
+bool armed(sched_agent_t const* s)
+{
+  struct itimerspec cur = {0};
+  int const rc = timerfd_gettime(s->tfd, &cur);
+  assert(rc == 0);
+  return cur.it_value.tv_sec != 0 || cur.it_value.tv_nsec != 0;
+}
+
+// Serves the wake ups for ms. late_ms is slept before serving the wake up
+// number late_at, as a busy reactor would
+static
+void run(asio_agent_t* io, sched_agent_t* s, log_t* log, uint64_t ms, uint64_t late_at, useconds_t late_ms)
+{
+  uint64_t const stop = now_ms() + ms;
+  while(now_ms() < stop){
+    int const fd = event_asio_agent(io, 100);
+    assert(fd != -1 && "The scheduler did not wake up the reactor");
+    if(tick_fd_sched_agent(s, fd) == false)
+      continue;
+
+    if(log->tick == late_at)
+      usleep(late_ms * 1000);
+
+    tick_sched_agent(s, on_due, log);
+    log->tick += 1;
+  }
+}
+
+static
+bool served_in(log_t const* log, uint64_t tick, int id)
+{
+  for(size_t i = 0; i < log->len; ++i){
+    if(log->s[i].tick == tick && log->s[i].id == id)
+      return true;
+  }
+  return false;
+}
+
+// Periods skipped between the consecutive services of id
+static
+uint64_t check_id(log_t const* log, int id, int64_t period_ms)
+{
+  uint64_t skipped = 0;
+  uint64_t last = 0;
+  size_t n = 0;
+  for(size_t i = 0; i < log->len; ++i){
+    served_t const* it = &log->s[i];
+    if(it->id != id)
+      continue;
+
+    assert(it->period_ms == period_ms);
+    assert(it->due % period_ms == 0 && "Due time not aligned to the period");
+    if(n > 0){
+      assert(it->due > last);
+      assert((it->due - last) % period_ms == 0);
+      skipped += (it->due - last) / period_ms - 1;
+    }
+    last = it->due;
+    ++n;
+  }
+  assert(n > 0);
+  return skipped;
+}
+
+static
+void test_groups(void)
+{
+  asio_agent_t io = {0};
+  init_asio_agent(&io);
+  sched_agent_t s = {0};
+  init_sched_agent(&s, &io);
+  assert(armed(&s) == false);
+
+  int const a = add_sched_agent(&s, 1);
+  int const b = add_sched_agent(&s, 5);
+  int const c = add_sched_agent(&s, 10);
+  int const d = add_sched_agent(&s, 10);
+  assert(a > 0 && b > a && c > b && d > c);
+  assert(seq_arr_size(&s.grp) == 3);
+  assert(armed(&s) == true);
+
+  log_t* log = calloc(1, sizeof(log_t));
+  assert(log != NULL);
+
+  // The 20th wake up comes 25 ms late
+  run(&io, &s, log, 200, 20, 25);
+
+  // Overruns are counted once per group, not per subscription
+  uint64_t const skipped_a = check_id(log, a, 1);
+  uint64_t const skipped_b = check_id(log, b, 5);
+  uint64_t const skipped_c = check_id(log, c, 10);
+  assert(check_id(log, d, 10) == skipped_c);
+
+  sched_stats_agent_t const st = stats_sched_agent(&s);
+  assert(st.ticks == log->tick);
+  assert(st.fired == log->len);
+  assert(st.overruns == skipped_a + skipped_b + skipped_c);
+  assert(skipped_a >= 20 && skipped_b >= 4 && skipped_c >= 1);
+  assert(st.max_late_ms >= 20);
+
+  // The 10 ms group is due on the multiples of 5 and 1 ms too, so they
+  // are served in the same wake up, and the longer periods never wake up
+  // the reactor on their own
+  for(size_t i = 0; i < log->len; ++i){
+    served_t const* it = &log->s[i];
+    if(it->id == c){
+      assert(served_in(log, it->tick, a) == true);
+      assert(served_in(log, it->tick, b) == true);
+      assert(served_in(log, it->tick, d) == true);
+    } else if(it->id == b){
+      assert(served_in(log, it->tick, a) == true);
+    }
+  }
+
+  // The 1 ms group goes away, and the timer follows the 5 ms one
+  rm_sched_agent(&s, a);
+  assert(seq_arr_size(&s.grp) == 2);
+  assert(s.tfd_due % 5 == 0);
+  log->len = 0;
+  run(&io, &s, log, 50, UINT64_MAX, 0);
+  for(size_t i = 0; i < log->len; ++i)
+    assert(log->s[i].id != a);
+  check_id(log, b, 5);
+
+  rm_sched_agent(&s, b);
+  assert(s.tfd_due % 10 == 0);
+
+  // Not the last one of its group
+  rm_sched_agent(&s, c);
+  assert(seq_arr_size(&s.grp) == 1);
+  assert(armed(&s) == true);
+
+  // The last one disarms the timer. No wake up follows
+  rm_sched_agent(&s, d);
+  assert(seq_arr_size(&s.grp) == 0);
+  assert(s.tfd_due == UINT64_MAX);
+  assert(armed(&s) == false);
+  assert(event_asio_agent(&io, 30) == -1);
+
+  // Armed again by the next subscription
+  int const e = add_sched_agent(&s, 2);
+  assert(armed(&s) == true);
+  log->len = 0;
+  run(&io, &s, log, 20, UINT64_MAX, 0);
+  check_id(log, e, 2);
+  rm_sched_agent(&s, e);
+  assert(armed(&s) == false);
+
+  free(log);
+  free_sched_agent(&s, &io);
+  close(io.pipe.r);
+  close(io.pipe.w);
+  close(io.efd);
+}
+
+int main()
+{
+  test_groups();
+
+  printf("Scheduler agent test succeeded\n");
+  return EXIT_SUCCESS;
+}
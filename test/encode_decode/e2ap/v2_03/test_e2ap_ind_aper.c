@@ -0,0 +1,244 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// peek_ric_indication_aper() against the asn1c encoder and decoder. Every
+// buffer it accepts must decode into a RIC INDICATION with the same ids
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <E2AP-PDU.h>
+#include <InitiatingMessage.h>
+#include <ProtocolIE-Field.h>
+#include <ProcedureCode.h>
+
+#include "../src/lib/e2ap/e2ap_ind_aper.h"
+#include "../src/lib/e2ap/e2ap_msg_enc_generic_wrapper.h"
+#include "../src/lib/e2ap/e2ap_msg_dec_generic_wrapper.h"
+#include "../src/lib/e2ap/e2ap_msg_free_wrapper.h"
+
+static
+byte_array_t fill_ba(size_t len, uint8_t val)
+{
+  byte_array_t ba = {.len = len};
+  ba.buf = malloc(len);
+  assert(ba.buf != NULL && "Memory exhausted");
+  memset(ba.buf, val, len);
+  return ba;
+}
+
+static
+ric_indication_t gen_ind(ric_gen_id_t ric_id, uint16_t const* sn, bool cpid, size_t msg_len)
+{
+  ric_indication_t ind = {.ric_id = ric_id,
+                          .action_id = 19,
+                          .type = RIC_IND_REPORT,
+                          .hdr = fill_ba(25, 'h'),
+                          .msg = fill_ba(msg_len, 'm')};
+  if (sn != NULL) {
+    ind.sn = malloc(sizeof(uint16_t));
+    assert(ind.sn != NULL && "Memory exhausted");
+    *ind.sn = *sn;
+  }
+  if (cpid == true) {
+    ind.call_process_id = malloc(sizeof(byte_array_t));
+    assert(ind.call_process_id != NULL && "Memory exhausted");
+    *ind.call_process_id = fill_ba(7, 'c');
+  }
+  return ind;
+}
+
+// The ids as read by the asn1c decoder. false if it rejects the buffer, or
+// if it is not a RIC INDICATION with both ids
+static
+bool full_dec_ids(byte_array_t ba, ric_gen_id_t* out)
+{
+  E2AP_PDU_t* pdu = NULL;
+  asn_dec_rval_t const rval = asn_decode_e2ap_v2_03(NULL, ATS_ALIGNED_BASIC_PER, &asn_DEF_E2AP_PDU_e2ap_v2_03, (void**)&pdu, ba.buf, ba.len);
+
+  bool req_id = false;
+  bool ran_func = false;
+  if (rval.code == RC_OK
+      && pdu->present == E2AP_PDU_PR_initiatingMessage
+      && pdu->choice.initiatingMessage->procedureCode == ProcedureCode_id_RICindication
+      && pdu->choice.initiatingMessage->value.present == InitiatingMessage__value_PR_RICindication) {
+    RICindication_t const* ind = &pdu->choice.initiatingMessage->value.choice.RICindication;
+    for (int i = 0; i < ind->protocolIEs.list.count; ++i) {
+      RICindication_IEs_t const* ie = ind->protocolIEs.list.array[i];
+      if (ie->value.present == RICindication_IEs__value_PR_RICrequestID) {
+        out->ric_req_id = ie->value.choice.RICrequestID.ricRequestorID;
+        out->ric_inst_id = ie->value.choice.RICrequestID.ricInstanceID;
+        req_id = true;
+      } else if (ie->value.present == RICindication_IEs__value_PR_RANfunctionID) {
+        out->ran_func_id = ie->value.choice.RANfunctionID;
+        ran_func = true;
+      }
+    }
+  }
+
+  ASN_STRUCT_FREE(asn_DEF_E2AP_PDU_e2ap_v2_03, pdu);
+  return req_id && ran_func;
+}
+
+// Either rejected, or the same ids as the full decoder
+static
+void check_peek(byte_array_t ba)
+{
+  ric_gen_id_t peek = {0};
+  if (peek_ric_indication_aper(ba, &peek) == false)
+    return;
+
+  ric_gen_id_t full = {0};
+  assert(full_dec_ids(ba, &full) == true && "Accepted a buffer that the decoder rejects");
+  assert(peek.ric_req_id == full.ric_req_id);
+  assert(peek.ric_inst_id == full.ric_inst_id);
+  assert(peek.ran_func_id == full.ran_func_id);
+}
+
+static
+void test_round_trip(void)
+{
+  uint16_t const req[] = {0, 1, 65535};
+  uint16_t const inst[] = {0, 65535};
+  uint16_t const ran_func[] = {0, 4095};
+  uint16_t const sn[] = {0, 65535};
+  // The last one spreads the RIC INDICATION over several APER fragments
+  size_t const msg_len[] = {26, 300, 20000};
+
+  for (size_t r = 0; r < sizeof(req) / sizeof(req[0]); ++r)
+    for (size_t i = 0; i < sizeof(inst) / sizeof(inst[0]); ++i)
+      for (size_t f = 0; f < sizeof(ran_func) / sizeof(ran_func[0]); ++f)
+        for (int s = -1; s < 2; ++s)
+          for (int c = 0; c < 2; ++c)
+            for (size_t m = 0; m < sizeof(msg_len) / sizeof(msg_len[0]); ++m) {
+              ric_gen_id_t const ric_id = {.ric_req_id = req[r], .ric_inst_id = inst[i], .ran_func_id = ran_func[f]};
+              ric_indication_t ind = gen_ind(ric_id, s < 0 ? NULL : &sn[s], c == 1, msg_len[m]);
+
+              byte_array_t ba = e2ap_enc_indication_asn(&ind);
+
+              ric_gen_id_t peek = {0};
+              assert(peek_ric_indication_aper(ba, &peek) == true);
+              assert(eq_ric_gen_id(&peek, &ric_id) == true);
+              check_peek(ba);
+
+              // The full decoder, as the RIC runs it when the peek fails
+              E2AP_PDU_t* pdu = NULL;
+              asn_dec_rval_t const rval = asn_decode_e2ap_v2_03(NULL, ATS_ALIGNED_BASIC_PER, &asn_DEF_E2AP_PDU_e2ap_v2_03, (void**)&pdu, ba.buf, ba.len);
+              assert(rval.code == RC_OK);
+              e2ap_msg_t msg = e2ap_dec_indication(pdu);
+              ASN_STRUCT_FREE(asn_DEF_E2AP_PDU_e2ap_v2_03, pdu);
+              assert(msg.type == RIC_INDICATION);
+              assert(eq_ric_indication(&ind, &msg.u_msgs.ric_ind) == true);
+
+              e2ap_free_indication(&msg.u_msgs.ric_ind);
+              e2ap_free_indication(&ind);
+              free_byte_array(ba);
+            }
+}
+
+static
+void test_truncated(void)
+{
+  size_t const msg_len[] = {26, 20000};
+  for (size_t m = 0; m < sizeof(msg_len) / sizeof(msg_len[0]); ++m) {
+    ric_gen_id_t const ric_id = {.ric_req_id = 7, .ric_inst_id = 8, .ran_func_id = 9};
+    uint16_t const sn = 3;
+    ric_indication_t ind = gen_ind(ric_id, &sn, true, msg_len[m]);
+    byte_array_t ba = e2ap_enc_indication_asn(&ind);
+
+    ric_gen_id_t peek = {0};
+    for (size_t len = 0; len < ba.len; ++len) {
+      byte_array_t tmp = {.buf = ba.buf, .len = len};
+      assert(peek_ric_indication_aper(tmp, &peek) == false);
+    }
+
+    e2ap_free_indication(&ind);
+    free_byte_array(ba);
+  }
+}
+
+static
+void test_garbage(void)
+{
+  srand(42);
+
+  // Random bytes, half of them behind a RIC INDICATION head
+  uint8_t buf[96] = {0};
+  for (int n = 0; n < 100000; ++n) {
+    size_t const len = rand() % sizeof(buf);
+    for (size_t i = 0; i < len; ++i)
+      buf[i] = rand();
+    if (n % 2 == 0 && len > 2) {
+      buf[0] = 0x00;
+      buf[1] = 0x05;
+    }
+    check_peek((byte_array_t){.buf = buf, .len = len});
+  }
+
+  // Every byte of a valid RIC INDICATION flipped to other values
+  ric_gen_id_t const ric_id = {.ric_req_id = 1021, .ric_inst_id = 3, .ran_func_id = 2};
+  uint16_t const sn = 5;
+  ric_indication_t ind = gen_ind(ric_id, &sn, true, 26);
+  byte_array_t ba = e2ap_enc_indication_asn(&ind);
+  uint8_t const vals[] = {0x00, 0x01, 0x05, 0x1D, 0x40, 0x7F, 0x80, 0xC0, 0xFF};
+  for (size_t pos = 0; pos < ba.len; ++pos) {
+    uint8_t const orig = ba.buf[pos];
+    for (size_t v = 0; v < sizeof(vals) / sizeof(vals[0]); ++v) {
+      ba.buf[pos] = vals[v];
+      check_peek(ba);
+      ba.buf[pos] = orig ^ (1 << (v % 8));
+      check_peek(ba);
+    }
+    ba.buf[pos] = orig;
+  }
+
+  // A few random bytes overwritten at once
+  uint8_t* cp = malloc(ba.len);
+  assert(cp != NULL && "Memory exhausted");
+  for (int n = 0; n < 20000; ++n) {
+    memcpy(cp, ba.buf, ba.len);
+    for (int k = 0; k < 1 + n % 3; ++k)
+      cp[rand() % ba.len] = rand();
+    check_peek((byte_array_t){.buf = cp, .len = ba.len});
+  }
+  free(cp);
+
+  // Not a RIC INDICATION
+  byte_array_t other = ba;
+  other.buf[1] = 0x04;
+  ric_gen_id_t peek = {0};
+  assert(peek_ric_indication_aper(other, &peek) == false);
+
+  e2ap_free_indication(&ind);
+  free_byte_array(ba);
+}
+
+int main()
+{
+  test_round_trip();
+  test_truncated();
+  test_garbage();
+
+  printf("Peek RIC INDICATION APER tests succeeded\n");
+  return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// io_uring backend of the nearRT-RIC event loop, over AF_UNIX datagram
+// socketpairs instead of SCTP sockets: multishot receives in arrival
+// order, more messages than provided buffers, polls, and completions of a
+// removed fd that must not reach the fd that reuses its number
+
+#include "../../src/lib/ep/sctp_uring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MAX_FDS 8
+#define MAX_MSGS 64
+
+typedef struct{
+  int rd;
+  int wr;
+} pair_t;
+
+static
+pair_t open_pair(void)
+{
+  int sv[2] = {0};
+  int rc = socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sv);
+  assert(rc == 0);
+  rc = fcntl(sv[1], F_SETFL, O_NONBLOCK);
+  assert(rc == 0);
+  return (pair_t){.rd = sv[0], .wr = sv[1]};
+}
+
+static
+void close_pair(pair_t p)
+{
+  close(p.rd);
+  close(p.wr);
+}
+
+// False if the socket buffer is full
+static
+bool send_seq(int fd, uint32_t seq)
+{
+  uint8_t buf[100];
+  memset(buf, seq, sizeof(buf));
+  memcpy(buf, &seq, sizeof(seq));
+  ssize_t const rc = write(fd, buf, sizeof(buf));
+  assert(rc == sizeof(buf) || errno == EAGAIN);
+  return rc == sizeof(buf);
+}
+
+static
+uint32_t check_seq(sctp_msg_t* msg)
+{
+  assert(msg->type == SCTP_MSG_PAYLOAD);
+  assert(msg->ba.len == 100);
+  uint32_t seq = 0;
+  memcpy(&seq, msg->ba.buf, sizeof(seq));
+  for(size_t i = sizeof(seq); i < msg->ba.len; ++i)
+    assert(msg->ba.buf[i] == (uint8_t)seq);
+  free_sctp_msg(msg);
+  return seq;
+}
+
+static
+bool reported(sctp_uring_t* u, int fd, int timeout_ms)
+{
+  int ready[MAX_FDS] = {0};
+  int const n = wait_sctp_uring(u, timeout_ms, MAX_FDS, ready);
+  for(int i = 0; i < n; ++i){
+    if(ready[i] == fd)
+      return true;
+  }
+  return false;
+}
+
+// Takes what arrived, checking the order. Returns the next expected seq
+static
+uint32_t take_seq(sctp_uring_t* u, int fd, uint32_t next)
+{
+  sctp_msg_t msg[MAX_MSGS];
+  size_t n = 0;
+  while((n = take_msgs_sctp_uring(u, fd, MAX_MSGS, msg)) > 0){
+    for(size_t i = 0; i < n; ++i){
+      uint32_t const seq = check_seq(&msg[i]);
+      assert(seq == next && "Messages out of order");
+      next += 1;
+    }
+  }
+  return next;
+}
+
+// Several times the provided buffers. The receive ends when they run out,
+// and it is submitted again once they return
+static
+void test_recv_order(sctp_uring_t* u)
+{
+  pair_t p = open_pair();
+  add_recv_sctp_uring(u, p.rd);
+
+  uint32_t sent = 0;
+  uint32_t next = 0;
+  while(next < 1000){
+    while(sent < 1000 && send_seq(p.wr, sent) == true)
+      sent += 1;
+
+    bool const ok = reported(u, p.rd, 1000);
+    assert(ok && "Messages not reported");
+    next = take_seq(u, p.rd, next);
+  }
+  assert(next == sent);
+
+  rm_fd_sctp_uring(u, p.rd);
+  close_pair(p);
+}
+
+static
+void test_poll(sctp_uring_t* u)
+{
+  int const efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  assert(efd > -1);
+  add_poll_sctp_uring(u, efd);
+
+  assert(reported(u, efd, 10) == false);
+
+  // Multishot. Every time it turns readable
+  for(int i = 0; i < 3; ++i){
+    uint64_t v = 1;
+    ssize_t rc = write(efd, &v, sizeof(v));
+    assert(rc == sizeof(v));
+    assert(reported(u, efd, 1000) == true);
+    rc = read(efd, &v, sizeof(v));
+    assert(rc == sizeof(v));
+  }
+
+  rm_fd_sctp_uring(u, efd);
+  close(efd);
+}
+
+// A message read for the removed fd is still in the completion queue when
+// the same fd number is added again, on the same slot. It must be ignored
+static
+void test_fd_reuse(sctp_uring_t* u)
+{
+  pair_t old = open_pair();
+  add_recv_sctp_uring(u, old.rd);
+  // Submitted, and nothing to read yet
+  assert(reported(u, old.rd, 10) == false);
+
+  bool ok = send_seq(old.wr, 666);
+  assert(ok);
+
+  rm_fd_sctp_uring(u, old.rd);
+  int const fd = old.rd;
+  close_pair(old);
+
+  pair_t p = open_pair();
+  assert(p.rd == fd && "fd number not reused");
+  add_recv_sctp_uring(u, p.rd);
+
+  ok = send_seq(p.wr, 0);
+  assert(ok);
+
+  // Give the completions of both a chance. Only the new one arrives
+  size_t num = 0;
+  for(int timeout_ms = 1000; reported(u, p.rd, timeout_ms) == true; timeout_ms = 50){
+    sctp_msg_t msg[MAX_MSGS];
+    size_t const n = take_msgs_sctp_uring(u, p.rd, MAX_MSGS, msg);
+    for(size_t i = 0; i < n; ++i)
+      assert(check_seq(&msg[i]) == 0 && "Message of the removed fd delivered");
+    num += n;
+  }
+  assert(num == 1);
+
+  rm_fd_sctp_uring(u, p.rd);
+  close_pair(p);
+}
+
+int main()
+{
+  sctp_uring_t* u = init_sctp_uring();
+  if(u == NULL){
+    printf("io_uring not supported by the kernel. Test skipped\n");
+    return EXIT_SUCCESS;
+  }
+
+  test_recv_order(u);
+  test_poll(u);
+  test_fd_reuse(u);
+
+  free_sctp_uring(u);
+
+  printf("SCTP io_uring test succeeded\n");
+  return EXIT_SUCCESS;
+}
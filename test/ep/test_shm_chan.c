@@ -0,0 +1,371 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Shared memory E42 channel between two threads: the eventfd wakeup,
+// senders waiting on a full ring, and the fallback to SCTP once the peer
+// stops draining or a message is larger than the ring. Messages carry a
+// sequence number, and the ring must hand them over in order
+
+#include "../../src/lib/ep/shm_chan.h"
+#include "../../src/util/byte_array_pool.h"
+
+#include <assert.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MSG_LEN 1000
+
+typedef struct{
+  shm_chan_t* iapp;
+  shm_chan_t* xapp;
+} chan_pair_t;
+
+typedef struct{
+  int port;
+  shm_chan_t* ch;
+} connect_arg_t;
+
+static
+int64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static
+bool valid_any(void* data, uint16_t xapp_id, uint16_t sctp_port)
+{
+  (void)data;
+  return xapp_id == 7 && sctp_port == 38472;
+}
+
+static
+void* connect_thread(void* arg)
+{
+  connect_arg_t* c = (connect_arg_t*)arg;
+  c->ch = connect_shm_chan(c->port, 7, 38472);
+  return NULL;
+}
+
+static
+chan_pair_t open_pair(size_t ring)
+{
+  // Abstract socket names are per network namespace. Avoid parallel runs
+  int const port = 40000 + getpid() % 20000;
+  int const lfd = listen_shm_chan(port);
+  assert(lfd > -1);
+
+  connect_arg_t arg = {.port = port};
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, connect_thread, &arg);
+  assert(rc == 0);
+
+  struct pollfd pfd = {.fd = lfd, .events = POLLIN};
+  rc = poll(&pfd, 1, 1000);
+  assert(rc == 1);
+
+  uint16_t xapp_id = 0;
+  chan_pair_t p = {.iapp = accept_shm_chan(lfd, ring, valid_any, NULL, &xapp_id)};
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+  close(lfd);
+
+  p.xapp = arg.ch;
+  assert(p.iapp != NULL && p.xapp != NULL);
+  assert(xapp_id == 7);
+  assert(p.iapp->cap == SHM_CHAN_RING_MIN);
+  return p;
+}
+
+static
+void close_pair(chan_pair_t* p)
+{
+  free_shm_chan(p->iapp);
+  free_shm_chan(p->xapp);
+}
+
+static
+bool readable(int fd, int ms)
+{
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  return poll(&pfd, 1, ms) == 1;
+}
+
+static
+bool send_seq(shm_chan_t* ch, uint32_t seq, size_t len)
+{
+  uint8_t buf[len];
+  memset(buf, seq, len);
+  memcpy(buf, &seq, sizeof(seq));
+  return send_shm_chan(ch, (byte_array_t){.len = len, .buf = buf});
+}
+
+static
+uint32_t check_seq(byte_array_t ba, size_t len)
+{
+  assert(ba.len == len);
+  uint32_t seq = 0;
+  memcpy(&seq, ba.buf, sizeof(seq));
+  for(size_t i = sizeof(seq); i < len; ++i)
+    assert(ba.buf[i] == (uint8_t)seq);
+  free_byte_array_pool(ba.buf);
+  return seq;
+}
+
+static
+void* wait_recv_one(void* arg)
+{
+  shm_chan_t* ch = (shm_chan_t*)arg;
+  // Blocks as the xApp event loop does
+  bool const rc = readable(ch->rx_fd, 1000);
+  assert(rc == true);
+
+  byte_array_t ba;
+  size_t const n = recv_shm_chan(ch, 1, &ba);
+  assert(n == 1);
+  assert(check_seq(ba, MSG_LEN) == 42);
+  return NULL;
+}
+
+static
+void test_wakeup(void)
+{
+  chan_pair_t p = open_pair(1);
+  assert(readable(p.xapp->rx_fd, 0) == false);
+
+  // A sleeping consumer is woken by the first message
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, wait_recv_one, p.xapp);
+  assert(rc == 0);
+  usleep(10000);
+  assert(send_seq(p.iapp, 42, MSG_LEN) == true);
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+  assert(readable(p.xapp->rx_fd, 0) == false);
+
+  // A consumer stopping after a full batch is woken again for the rest
+  for(uint32_t i = 0; i < 3; ++i)
+    assert(send_seq(p.iapp, i, MSG_LEN) == true);
+  for(uint32_t i = 0; i < 3; ++i){
+    assert(readable(p.xapp->rx_fd, 0) == true);
+    byte_array_t ba;
+    assert(recv_shm_chan(p.xapp, 1, &ba) == 1);
+    assert(check_seq(ba, MSG_LEN) == i);
+  }
+  assert(readable(p.xapp->rx_fd, 0) == false);
+
+  // Same in the other direction
+  assert(readable(p.iapp->rx_fd, 0) == false);
+  assert(send_seq(p.xapp, 5, MSG_LEN) == true);
+  assert(readable(p.iapp->rx_fd, 0) == true);
+  byte_array_t ba;
+  assert(recv_shm_chan(p.iapp, 1, &ba) == 1);
+  assert(check_seq(ba, MSG_LEN) == 5);
+
+  assert(p.iapp->waits == 0 && p.iapp->down == false);
+  close_pair(&p);
+}
+
+#define FULL_MSGS 4000
+
+static
+void* slow_consumer(void* arg)
+{
+  shm_chan_t* ch = (shm_chan_t*)arg;
+  // Let the producer fill the ring first
+  usleep(20000);
+
+  uint32_t next = 0;
+  while(next < FULL_MSGS){
+    bool const rc = readable(ch->rx_fd, 1000);
+    assert(rc == true);
+
+    byte_array_t ba[16];
+    size_t const n = recv_shm_chan(ch, 16, ba);
+    for(size_t i = 0; i < n; ++i)
+      assert(check_seq(ba[i], MSG_LEN) == next++);
+    if(next % 512 == 0)
+      usleep(1000);
+  }
+  return NULL;
+}
+
+static
+void test_full_ring(void)
+{
+  chan_pair_t p = open_pair(1);
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, slow_consumer, p.xapp);
+  assert(rc == 0);
+
+  // About 60 times the ring. The sender waits instead of overtaking
+  for(uint32_t i = 0; i < FULL_MSGS; ++i)
+    assert(send_seq(p.iapp, i, MSG_LEN) == true);
+
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  assert(p.iapp->waits > 0);
+  assert(p.iapp->down == false);
+  assert(readable(p.xapp->rx_fd, 0) == false);
+  close_pair(&p);
+}
+
+static
+void test_fallback_stuck_peer(void)
+{
+  chan_pair_t p = open_pair(1);
+  p.iapp->full_ms = 50;
+
+  uint32_t sent = 0;
+  while(send_seq(p.iapp, sent, MSG_LEN) == true)
+    ++sent;
+  assert(sent == SHM_CHAN_RING_MIN / (sizeof(uint32_t) + MSG_LEN));
+  assert(p.iapp->down == true);
+
+  // SCTP from now on, even once there is room again, without waiting
+  byte_array_t ba[8];
+  assert(recv_shm_chan(p.xapp, 8, ba) == 8);
+  for(uint32_t i = 0; i < 8; ++i)
+    assert(check_seq(ba[i], MSG_LEN) == i);
+
+  int64_t const start = now_us();
+  assert(send_seq(p.iapp, sent, 16) == false);
+  assert(now_us() - start < 50000);
+
+  // The ring still hands over what it got, in order
+  uint32_t next = 8;
+  size_t n = 0;
+  while((n = recv_shm_chan(p.xapp, 8, ba)) > 0){
+    for(size_t i = 0; i < n; ++i)
+      assert(check_seq(ba[i], MSG_LEN) == next++);
+  }
+  assert(next == sent);
+  close_pair(&p);
+}
+
+static
+void* drain_later(void* arg)
+{
+  shm_chan_t* ch = (shm_chan_t*)arg;
+  usleep(20000);
+  byte_array_t ba[4];
+  size_t const n = recv_shm_chan(ch, 4, ba);
+  assert(n == 2);
+  assert(check_seq(ba[0], MSG_LEN) == 0);
+  assert(check_seq(ba[1], MSG_LEN) == 1);
+  return NULL;
+}
+
+static
+void test_fallback_large_msg(void)
+{
+  chan_pair_t p = open_pair(1);
+  assert(send_seq(p.iapp, 0, MSG_LEN) == true);
+  assert(send_seq(p.iapp, 1, MSG_LEN) == true);
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, drain_later, p.xapp);
+  assert(rc == 0);
+
+  // Only after the peer got the previous messages
+  size_t const len = SHM_CHAN_RING_MIN;
+  uint8_t* buf = calloc(1, len);
+  assert(buf != NULL);
+  int64_t const start = now_us();
+  assert(send_shm_chan(p.iapp, (byte_array_t){.len = len, .buf = buf}) == false);
+  assert(now_us() - start >= 15000);
+  free(buf);
+
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  assert(p.iapp->down == true);
+  assert(send_seq(p.iapp, 2, MSG_LEN) == false);
+  assert(readable(p.xapp->rx_fd, 0) == false);
+  close_pair(&p);
+}
+
+typedef struct{
+  shm_chan_t* ch;
+  int64_t done_us;
+  bool sent;
+} pinned_send_t;
+
+static
+void* pinned_send(void* arg)
+{
+  pinned_send_t* ps = (pinned_send_t*)arg;
+  ps->sent = send_seq(ps->ch, 0, MSG_LEN);
+  ps->done_us = now_us();
+  release_shm_chan(ps->ch);
+  return NULL;
+}
+
+// As the iApp does: the sender pins the channel and waits for room out of
+// the lock that guards it. The owner frees it meanwhile, the sender gives
+// up at once, and its release frees the channel
+static
+void test_free_while_waiting(void)
+{
+  chan_pair_t p = open_pair(1);
+
+  // Full ring
+  uint32_t const fit = SHM_CHAN_RING_MIN / (sizeof(uint32_t) + MSG_LEN);
+  for(uint32_t i = 0; i < fit; ++i)
+    assert(send_seq(p.iapp, i, MSG_LEN) == true);
+  assert(p.iapp->waits == 0);
+
+  pinned_send_t ps = {.ch = acquire_shm_chan(p.iapp)};
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, pinned_send, &ps);
+  assert(rc == 0);
+
+  usleep(20000);
+  int64_t const start = now_us();
+  free_shm_chan(p.iapp);
+
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+  assert(ps.sent == false);
+  assert(ps.done_us - start < (int64_t)SHM_CHAN_FULL_MS * 1000 / 2 && "Sender kept waiting on a freed channel");
+
+  free_shm_chan(p.xapp);
+}
+
+int main()
+{
+  test_wakeup();
+  test_full_ring();
+  test_fallback_stuck_peer();
+  test_fallback_large_msg();
+  test_free_while_waiting();
+
+  printf("Shared memory channel test succeeded\n");
+  return EXIT_SUCCESS;
+}
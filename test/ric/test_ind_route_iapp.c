@@ -0,0 +1,203 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Indication routing table of the iApp, with more readers routing than
+// lock free reader slots (i.e., some of them take the mutex path) while
+// writers subscribe and unsubscribe. Two DUs that only differ in their DU ID
+// share the RAN function and RIC request IDs, and the indications of one of
+// them must never reach an xApp subscribed on the other
+
+#include "../../src/ric/iApp/ind_route_iapp.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_READERS 160
+#define NUM_WRITERS 4
+#define NUM_READS 1000
+
+#define RAN_FUNC_ID 2
+#define RIC_REQ_ID 7
+
+// xApp IDs subscribed on node A are in [XAPP_A, XAPP_B), and on node B
+// in [XAPP_B, XAPP_B + 1000)
+#define XAPP_A 1000
+#define XAPP_B 2000
+
+// Subscribed during the whole test
+#define STABLE_A XAPP_A
+#define STABLE_B XAPP_B
+
+static uint64_t du_id_a = 1;
+static uint64_t du_id_b = 2;
+
+static global_e2_node_id_t const node_a = {.type = ngran_gNB_DU,
+                                           .plmn = {.mcc = 208, .mnc = 95, .mnc_digit_len = 2},
+                                           .nb_id = {.nb_id = 3584},
+                                           .cu_du_id = &du_id_a};
+
+static global_e2_node_id_t const node_b = {.type = ngran_gNB_DU,
+                                           .plmn = {.mcc = 208, .mnc = 95, .mnc_digit_len = 2},
+                                           .nb_id = {.nb_id = 3584},
+                                           .cu_du_id = &du_id_b};
+
+typedef struct {
+  ind_route_iapp_t* r;
+  atomic_bool stop;
+  atomic_size_t readers_done;
+} shared_t;
+
+static void check_route(ind_route_iapp_t* r, global_e2_node_id_t const* node, uint32_t lo, uint32_t hi, uint32_t stable)
+{
+  uint32_t xapp_id[16] = {0};
+  size_t const num = find_ind_route_iapp(r, node, RAN_FUNC_ID, RIC_REQ_ID, 16, xapp_id);
+  assert(num > 0 && num <= 1 + NUM_WRITERS && "Subscription lost");
+
+  bool found = false;
+  for (size_t i = 0; i < num; ++i) {
+    assert(xapp_id[i] >= lo && xapp_id[i] < hi && "Indication routed to an xApp of another E2 node");
+    found |= xapp_id[i] == stable;
+  }
+  assert(found && "Stable subscription missing");
+}
+
+static void* reader(void* arg)
+{
+  shared_t* sh = (shared_t*)arg;
+
+  for (int i = 0; i < NUM_READS; ++i) {
+    check_route(sh->r, &node_a, XAPP_A, XAPP_B, STABLE_A);
+    check_route(sh->r, &node_b, XAPP_B, XAPP_B + 1000, STABLE_B);
+
+    // Nobody subscribed to it
+    uint32_t xapp_id[4];
+    size_t const num = find_ind_route_iapp(sh->r, &node_a, RAN_FUNC_ID, RIC_REQ_ID + 1, 4, xapp_id);
+    assert(num == 0);
+  }
+
+  atomic_fetch_add(&sh->readers_done, 1);
+  return NULL;
+}
+
+typedef struct {
+  shared_t* sh;
+  uint32_t idx;
+} writer_arg_t;
+
+static void* writer(void* arg)
+{
+  writer_arg_t* w = (writer_arg_t*)arg;
+  ind_route_iapp_t* r = w->sh->r;
+
+  uint32_t const id_a = XAPP_A + 1 + w->idx;
+  uint32_t const id_b = XAPP_B + 1 + w->idx;
+
+  uint32_t n = 0;
+  while (atomic_load(&w->sh->stop) == false) {
+    add_ind_route_iapp(r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, id_a);
+    add_ind_route_iapp(r, &node_b, RAN_FUNC_ID, RIC_REQ_ID, id_b);
+    // Other routes, so that the table grows and shrinks
+    add_ind_route_iapp(r, &node_b, RAN_FUNC_ID + 1 + w->idx, RIC_REQ_ID, id_b);
+
+    if (n % 2 == 0) {
+      bool ok = rm_ind_route_iapp(r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, id_a);
+      assert(ok);
+      ok = rm_ind_route_iapp(r, &node_b, RAN_FUNC_ID, RIC_REQ_ID, id_b);
+      assert(ok);
+      ok = rm_ind_route_iapp(r, &node_b, RAN_FUNC_ID + 1 + w->idx, RIC_REQ_ID, id_b);
+      assert(ok);
+    } else {
+      // As when the xApp disconnects
+      size_t const num = rm_xapp_ind_route_iapp(r, id_a) + rm_xapp_ind_route_iapp(r, id_b);
+      assert(num == 3);
+    }
+    n += 1;
+  }
+
+  return NULL;
+}
+
+static void run_readers(shared_t* sh)
+{
+  pthread_t t[NUM_READERS];
+  for (size_t i = 0; i < NUM_READERS; ++i) {
+    int const rc = pthread_create(&t[i], NULL, reader, sh);
+    assert(rc == 0);
+  }
+  for (size_t i = 0; i < NUM_READERS; ++i) {
+    int const rc = pthread_join(t[i], NULL);
+    assert(rc == 0);
+  }
+}
+
+int main()
+{
+  ind_route_iapp_t r = {0};
+  init_ind_route_iapp(&r);
+
+  add_ind_route_iapp(&r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, STABLE_A);
+  add_ind_route_iapp(&r, &node_b, RAN_FUNC_ID, RIC_REQ_ID, STABLE_B);
+
+  shared_t sh = {.r = &r};
+
+  pthread_t t[NUM_WRITERS];
+  writer_arg_t w[NUM_WRITERS];
+  for (uint32_t i = 0; i < NUM_WRITERS; ++i) {
+    w[i] = (writer_arg_t){.sh = &sh, .idx = i};
+    int const rc = pthread_create(&t[i], NULL, writer, &w[i]);
+    assert(rc == 0);
+  }
+
+  // Twice, so that the second round reuses the slots of exited readers
+  run_readers(&sh);
+  run_readers(&sh);
+  assert(atomic_load(&sh.readers_done) == 2 * NUM_READERS);
+
+  atomic_store(&sh.stop, true);
+  for (uint32_t i = 0; i < NUM_WRITERS; ++i) {
+    int const rc = pthread_join(t[i], NULL);
+    assert(rc == 0);
+  }
+
+  // Only the stable subscriptions are left
+  uint32_t xapp_id[16] = {0};
+  size_t num = find_ind_route_iapp(&r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, 16, xapp_id);
+  assert(num == 1 && xapp_id[0] == STABLE_A);
+  num = find_ind_route_iapp(&r, &node_b, RAN_FUNC_ID, RIC_REQ_ID, 16, xapp_id);
+  assert(num == 1 && xapp_id[0] == STABLE_B);
+
+  bool ok = rm_ind_route_iapp(&r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, STABLE_A);
+  assert(ok);
+  ok = rm_ind_route_iapp(&r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, STABLE_A);
+  assert(ok == false);
+  num = find_ind_route_iapp(&r, &node_a, RAN_FUNC_ID, RIC_REQ_ID, 16, xapp_id);
+  assert(num == 0);
+  num = find_ind_route_iapp(&r, &node_b, RAN_FUNC_ID, RIC_REQ_ID, 16, xapp_id);
+  assert(num == 1 && xapp_id[0] == STABLE_B);
+
+  free_ind_route_iapp(&r);
+
+  printf("Indication route test succeeded\n");
+  return EXIT_SUCCESS;
+}
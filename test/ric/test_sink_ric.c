@@ -0,0 +1,370 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Sinks of the RIC pub/sub listeners with a slow listener, i.e., one that
+// holds an indication until the test lets it go. Pushing to a full sink must
+// not block under the drop oldest and sample policies, the drop and depth
+// counters must match the policy exactly, and every indication shared by
+// several sinks must be freed once, after the last sink is done with it
+
+#include "../../src/ric/iApps/sink_ric.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CAP 8
+#define SAMPLE_RATE 4
+#define NUM_PUSH 100
+#define MAX_IND 1024
+
+// Times each indication was freed, by the ID carried in ric_id
+static atomic_uint freed[MAX_IND];
+
+typedef struct {
+  pthread_mutex_t mtx;
+  pthread_cond_t cv;
+  bool open;
+  size_t entered;
+  // IDs in delivery order
+  uint32_t ids[MAX_IND];
+  size_t len;
+} listener_t;
+
+static listener_t slow;
+static listener_t fast;
+
+static void init_listener(listener_t* l, bool open)
+{
+  memset(l, 0, sizeof(*l));
+  pthread_mutex_init(&l->mtx, NULL);
+  pthread_cond_init(&l->cv, NULL);
+  l->open = open;
+}
+
+static void free_listener(listener_t* l)
+{
+  pthread_cond_destroy(&l->cv);
+  pthread_mutex_destroy(&l->mtx);
+}
+
+static void deliver(listener_t* l, sm_ag_if_rd_ind_t const* d)
+{
+  uint32_t const id = d->rc.ric_id;
+  assert(id < MAX_IND);
+  assert(atomic_load(&freed[id]) == 0 && "Indication freed while a listener reads it");
+
+  pthread_mutex_lock(&l->mtx);
+  l->entered += 1;
+  pthread_cond_broadcast(&l->cv);
+  while (l->open == false)
+    pthread_cond_wait(&l->cv, &l->mtx);
+  l->ids[l->len++] = id;
+  pthread_mutex_unlock(&l->mtx);
+
+  assert(atomic_load(&freed[id]) == 0 && "Indication freed while a listener reads it");
+}
+
+static void slow_fp(sm_ag_if_rd_ind_t const* d)
+{
+  deliver(&slow, d);
+}
+
+static void fast_fp(sm_ag_if_rd_ind_t const* d)
+{
+  deliver(&fast, d);
+}
+
+static void open_listener(listener_t* l)
+{
+  pthread_mutex_lock(&l->mtx);
+  l->open = true;
+  pthread_cond_broadcast(&l->cv);
+  pthread_mutex_unlock(&l->mtx);
+}
+
+// The listener holds its first indication, so the queue is empty
+static void wait_entered(listener_t* l, size_t n)
+{
+  pthread_mutex_lock(&l->mtx);
+  while (l->entered < n)
+    pthread_cond_wait(&l->cv, &l->mtx);
+  pthread_mutex_unlock(&l->mtx);
+}
+
+static void free_ind(void* d)
+{
+  uint32_t const id = ((sm_ag_if_rd_ind_t*)d)->rc.ric_id;
+  assert(id < MAX_IND);
+  atomic_fetch_add(&freed[id], 1);
+}
+
+static sink_ind_ric_t* new_ind(uint32_t id, uint32_t refs)
+{
+  sm_ag_if_rd_ind_t d = {.type = RAN_CTRL_STATS_V1_03};
+  d.rc.ric_id = id;
+  return init_sink_ind_ric(d, free_ind, refs);
+}
+
+static void reset_freed(void)
+{
+  for (size_t i = 0; i < MAX_IND; ++i)
+    atomic_store(&freed[i], 0);
+}
+
+static void check_freed(uint32_t lo, uint32_t hi, uint32_t times)
+{
+  for (uint32_t i = lo; i < hi; ++i)
+    assert(atomic_load(&freed[i]) == times);
+}
+
+typedef struct {
+  sink_ric_t* s;
+  uint32_t first;
+  uint32_t num;
+  uint32_t refs;
+
+  pthread_mutex_t mtx;
+  pthread_cond_t cv;
+  bool done;
+} pusher_t;
+
+static void* push_loop(void* arg)
+{
+  pusher_t* p = (pusher_t*)arg;
+
+  for (uint32_t i = 0; i < p->num; ++i)
+    push_sink_ric(p->s, new_ind(p->first + i, p->refs));
+
+  pthread_mutex_lock(&p->mtx);
+  p->done = true;
+  pthread_cond_signal(&p->cv);
+  pthread_mutex_unlock(&p->mtx);
+  return NULL;
+}
+
+// Pushes [first, first + num) while the slow listener does not return.
+// Fails rather than hangs if push_sink_ric blocks
+static void push_no_block(sink_ric_t* s, uint32_t first, uint32_t num)
+{
+  pusher_t p = {.s = s, .first = first, .num = num, .refs = 1};
+  pthread_mutex_init(&p.mtx, NULL);
+  pthread_cond_init(&p.cv, NULL);
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, push_loop, &p);
+  assert(rc == 0);
+
+  struct timespec deadline = {0};
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += 5;
+
+  pthread_mutex_lock(&p.mtx);
+  rc = 0;
+  while (p.done == false && rc != ETIMEDOUT)
+    rc = pthread_cond_timedwait(&p.cv, &p.mtx, &deadline);
+  bool const done = p.done;
+  pthread_mutex_unlock(&p.mtx);
+  assert(done == true && "Ingest blocked by a slow listener");
+
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+  pthread_cond_destroy(&p.cv);
+  pthread_mutex_destroy(&p.mtx);
+}
+
+static void start_slow_sink(sink_ric_t* s, sink_overflow_e overflow)
+{
+  reset_freed();
+  init_listener(&slow, false);
+
+  sink_conf_ric_t conf = {.cap = CAP, .overflow = overflow, .sample_rate = SAMPLE_RATE};
+  strcpy(conf.subs.name, "slow");
+  conf.subs.fp = slow_fp;
+
+  init_sink_ric(s, conf);
+
+  // The listener holds ID 0 from now on
+  push_sink_ric(s, new_ind(0, 1));
+  wait_entered(&slow, 1);
+}
+
+static void test_drop_oldest(void)
+{
+  sink_ric_t s = {0};
+  start_slow_sink(&s, SINK_OVERFLOW_DROP_OLDEST);
+
+  push_no_block(&s, 1, NUM_PUSH);
+
+  // The newest CAP are queued, the older ones dropped and freed at once
+  uint32_t const first_kept = NUM_PUSH + 1 - CAP;
+  sink_stats_ric_t st = stats_sink_ric(&s);
+  assert(st.enq == NUM_PUSH + 1);
+  assert(st.drop == NUM_PUSH - CAP);
+  assert(st.depth == CAP);
+  assert(st.max_depth == CAP);
+  assert(st.done == 0);
+  check_freed(0, 1, 0);
+  check_freed(1, first_kept, 1);
+  check_freed(first_kept, NUM_PUSH + 1, 0);
+
+  open_listener(&slow);
+  st = free_sink_ric(&s);
+  assert(st.enq == NUM_PUSH + 1);
+  assert(st.drop == NUM_PUSH - CAP);
+  assert(st.done == CAP + 1);
+  assert(st.depth == 0);
+  assert(st.max_depth == CAP);
+  check_freed(0, NUM_PUSH + 1, 1);
+
+  assert(slow.len == CAP + 1);
+  assert(slow.ids[0] == 0);
+  for (size_t i = 1; i < slow.len; ++i)
+    assert(slow.ids[i] == first_kept + i - 1);
+
+  free_listener(&slow);
+}
+
+static void test_sample(void)
+{
+  sink_ric_t s = {0};
+  start_slow_sink(&s, SINK_OVERFLOW_SAMPLE);
+
+  push_no_block(&s, 1, NUM_PUSH);
+
+  // IDs 1 to CAP/2 fill half of the queue. From there, 1 out of SAMPLE_RATE
+  // is queued until full, i.e., IDs 8, 12, 16 and 20
+  uint32_t const expected[] = {0, 1, 2, 3, 4, 8, 12, 16, 20};
+  size_t const num_exp = sizeof(expected) / sizeof(expected[0]);
+  _Static_assert(CAP == 8 && SAMPLE_RATE == 4, "Update the expected IDs");
+
+  sink_stats_ric_t st = stats_sink_ric(&s);
+  assert(st.enq == num_exp);
+  assert(st.drop == NUM_PUSH + 1 - num_exp);
+  assert(st.depth == CAP);
+  assert(st.max_depth == CAP);
+  assert(st.done == 0);
+
+  size_t j = 0;
+  for (uint32_t id = 0; id <= NUM_PUSH; ++id) {
+    bool const queued = j < num_exp && expected[j] == id;
+    j += queued;
+    assert(atomic_load(&freed[id]) == (queued ? 0 : 1));
+  }
+
+  open_listener(&slow);
+  st = free_sink_ric(&s);
+  assert(st.enq == num_exp);
+  assert(st.drop == NUM_PUSH + 1 - num_exp);
+  assert(st.done == num_exp);
+  assert(st.depth == 0);
+  check_freed(0, NUM_PUSH + 1, 1);
+
+  assert(slow.len == num_exp);
+  for (size_t i = 0; i < num_exp; ++i)
+    assert(slow.ids[i] == expected[i]);
+
+  free_listener(&slow);
+}
+
+// One reference per sink, as publish_ind_msg. A fast sink delivers all of
+// them while the slow one drops most, and every indication is freed once,
+// by whichever sink releases it last
+static void test_shared_ind(void)
+{
+  reset_freed();
+  init_listener(&slow, false);
+  init_listener(&fast, true);
+
+  sink_conf_ric_t conf_slow = {.cap = CAP, .overflow = SINK_OVERFLOW_DROP_OLDEST};
+  strcpy(conf_slow.subs.name, "slow");
+  conf_slow.subs.fp = slow_fp;
+
+  sink_conf_ric_t conf_fast = {.cap = 2, .overflow = SINK_OVERFLOW_BLOCK};
+  strcpy(conf_fast.subs.name, "fast");
+  conf_fast.subs.fp = fast_fp;
+
+  sink_ric_t s[2] = {0};
+  init_sink_ric(&s[0], conf_slow);
+  init_sink_ric(&s[1], conf_fast);
+
+  // The slow listener holds ID 0 alone, not a batch
+  sink_ind_ric_t* first = new_ind(0, 2);
+  push_sink_ric(&s[0], first);
+  push_sink_ric(&s[1], first);
+  wait_entered(&slow, 1);
+
+  uint32_t const num = 4 * NUM_PUSH;
+  for (uint32_t id = 1; id < num; ++id) {
+    sink_ind_ric_t* ind = new_ind(id, 2);
+    push_sink_ric(&s[0], ind);
+    push_sink_ric(&s[1], ind);
+  }
+
+  // The fast sink is done with all of them. The slow one still holds
+  // the one its listener reads and the CAP queued
+  sink_stats_ric_t st_fast = free_sink_ric(&s[1]);
+  assert(st_fast.enq == num && st_fast.done == num && st_fast.drop == 0);
+  assert(fast.len == num);
+  for (uint32_t i = 0; i < num; ++i)
+    assert(fast.ids[i] == i);
+
+  sink_stats_ric_t st_slow = stats_sink_ric(&s[0]);
+  assert(st_slow.depth == CAP);
+  assert(st_slow.drop == num - CAP - 1);
+  size_t not_freed = 0;
+  for (uint32_t id = 0; id < num; ++id) {
+    uint32_t const n = atomic_load(&freed[id]);
+    assert(n <= 1);
+    not_freed += n == 0;
+  }
+  assert(not_freed == CAP + 1);
+
+  open_listener(&slow);
+  st_slow = free_sink_ric(&s[0]);
+  assert(st_slow.enq == num);
+  assert(st_slow.drop == num - CAP - 1);
+  assert(st_slow.done == CAP + 1);
+  assert(slow.len == CAP + 1);
+  assert(slow.ids[0] == 0);
+  for (size_t i = 1; i < slow.len; ++i)
+    assert(slow.ids[i] == num - CAP + i - 1);
+  check_freed(0, num, 1);
+
+  free_listener(&fast);
+  free_listener(&slow);
+}
+
+int main()
+{
+  test_drop_oldest();
+  test_sample();
+  test_shared_ind();
+
+  printf("Sink test succeeded\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Size-classed byte_array_t pool. A freed block is served again from the
+// thread cache, a full cache spills to the depot where other threads pick
+// the blocks up, an exiting thread gives its cache back, trim moves a
+// buffer to a smaller class, and the counters account every allocation
+
+#include "../../src/util/byte_array.h"
+#include "../../src/util/byte_array_pool.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_BLKS 300
+
+static
+byte_array_pool_stats_t delta(byte_array_pool_stats_t a, byte_array_pool_stats_t b)
+{
+  return (byte_array_pool_stats_t){.hit = b.hit - a.hit,
+                                   .miss = b.miss - a.miss,
+                                   .fallback = b.fallback - a.fallback,
+                                   .trim = b.trim - a.trim,
+                                   .reserved = b.reserved - a.reserved};
+}
+
+static
+void test_thread_cache(void)
+{
+  byte_array_pool_stats_t const s0 = stats_byte_array_pool();
+
+  // Fresh class. Carved from a new slab
+  byte_array_t ba = alloc_byte_array_pool(200);
+  assert(ba.len == 200);
+  assert(owns_byte_array_pool(ba.buf) == true);
+  memset(ba.buf, 0xAB, ba.len);
+  uint8_t* const buf = ba.buf;
+  free_byte_array(ba);
+
+  // Same class, served by the thread cache
+  ba = alloc_byte_array_pool(256);
+  assert(ba.buf == buf);
+  free_byte_array(ba);
+
+  // Beyond the biggest class
+  ba = alloc_byte_array_pool(BYTE_ARRAY_POOL_MAX_SZ + 1);
+  assert(owns_byte_array_pool(ba.buf) == false);
+  free_byte_array(ba);
+
+  byte_array_pool_stats_t const d = delta(s0, stats_byte_array_pool());
+  assert(d.miss == 1);
+  assert(d.hit == 1);
+  assert(d.fallback == 1);
+  assert(d.trim == 0);
+  assert(d.reserved > 0);
+}
+
+static
+void test_trim(void)
+{
+  byte_array_pool_stats_t const s0 = stats_byte_array_pool();
+
+  // Oversized by far. Moved to the 256 B class
+  byte_array_t ba = alloc_byte_array_pool(BYTE_ARRAY_POOL_MAX_SZ);
+  for (size_t i = 0; i < 100; ++i)
+    ba.buf[i] = i;
+  ba.len = 100;
+  uint8_t* const big = ba.buf;
+
+  ba = trim_byte_array_pool(ba);
+  assert(ba.buf != big);
+  assert(ba.len == 100);
+  assert(owns_byte_array_pool(ba.buf) == true);
+  for (size_t i = 0; i < 100; ++i)
+    assert(ba.buf[i] == i);
+
+  // The big block went back to the thread cache
+  byte_array_t again = alloc_byte_array_pool(BYTE_ARRAY_POOL_MAX_SZ);
+  assert(again.buf == big);
+  free_byte_array(again);
+
+  // Less than a quarter of the class. Not worth the copy
+  byte_array_t small = alloc_byte_array_pool(1024);
+  small.len = 600;
+  uint8_t* const small_buf = small.buf;
+  small = trim_byte_array_pool(small);
+  assert(small.buf == small_buf);
+  free_byte_array(small);
+
+  // Not owned by the pool. Handed back untouched
+  byte_array_t mal = {.len = 10, .buf = malloc(100)};
+  assert(mal.buf != NULL);
+  byte_array_t const mal_trim = trim_byte_array_pool(mal);
+  assert(mal_trim.buf == mal.buf);
+  free_byte_array(mal_trim);
+
+  free_byte_array(ba);
+
+  byte_array_pool_stats_t const d = delta(s0, stats_byte_array_pool());
+  assert(d.trim == 1);
+  // 32 KiB, 256 B (trim), 32 KiB again and 1 KiB
+  assert(d.hit + d.miss == 4);
+  assert(d.fallback == 0);
+}
+
+typedef struct{
+  size_t len;
+  uint8_t* buf[NUM_BLKS];
+} blks_t;
+
+static
+void* free_blks(void* arg)
+{
+  blks_t* b = (blks_t*)arg;
+  for (size_t i = 0; i < NUM_BLKS; ++i)
+    free_byte_array((byte_array_t){.len = b->len, .buf = b->buf[i]});
+  // Exits with a full cache, given back to the depot
+  return NULL;
+}
+
+static
+void* alloc_blks(void* arg)
+{
+  blks_t* b = (blks_t*)arg;
+  for (size_t i = 0; i < NUM_BLKS; ++i)
+    b->buf[i] = alloc_byte_array_pool(b->len).buf;
+  return NULL;
+}
+
+static
+int cmp_ptr(void const* a, void const* b)
+{
+  uintptr_t const x = (uintptr_t)*(uint8_t* const*)a;
+  uintptr_t const y = (uintptr_t)*(uint8_t* const*)b;
+  return (x > y) - (x < y);
+}
+
+// Blocks allocated by this thread, freed by another one and reused by a
+// third one. The 32 KiB class also gives the pages of the spare blocks back
+static
+void test_depot(size_t len)
+{
+  blks_t src = {.len = len};
+  for (size_t i = 0; i < NUM_BLKS; ++i) {
+    src.buf[i] = alloc_byte_array_pool(len).buf;
+    memset(src.buf[i], 0x5A, len);
+  }
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, free_blks, &src);
+  assert(rc == 0);
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  byte_array_pool_stats_t const s0 = stats_byte_array_pool();
+
+  blks_t dst = {.len = len};
+  rc = pthread_create(&t, NULL, alloc_blks, &dst);
+  assert(rc == 0);
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  // Every block came from the depot, the ones cached at thread exit included
+  byte_array_pool_stats_t const d = delta(s0, stats_byte_array_pool());
+  assert(d.hit == NUM_BLKS);
+  assert(d.miss == 0);
+  assert(d.fallback == 0);
+
+  qsort(src.buf, NUM_BLKS, sizeof(src.buf[0]), cmp_ptr);
+  qsort(dst.buf, NUM_BLKS, sizeof(dst.buf[0]), cmp_ptr);
+  assert(memcmp(src.buf, dst.buf, sizeof(src.buf)) == 0);
+
+  for (size_t i = 0; i < NUM_BLKS; ++i)
+    free_byte_array((byte_array_t){.len = len, .buf = dst.buf[i]});
+}
+
+#define NUM_THREADS 4
+#define NUM_OPS 20000
+
+static
+void* stress(void* arg)
+{
+  unsigned seed = (uintptr_t)arg;
+  byte_array_t live[16] = {0};
+
+  for (size_t i = 0; i < NUM_OPS; ++i) {
+    byte_array_t* ba = &live[rand_r(&seed) % 16];
+    if (ba->buf != NULL) {
+      assert(ba->buf[0] == (uint8_t)ba->len && ba->buf[ba->len - 1] == (uint8_t)ba->len);
+      free_byte_array(*ba);
+    }
+    *ba = alloc_byte_array_pool(1 + rand_r(&seed) % (BYTE_ARRAY_POOL_MAX_SZ + 1024));
+    ba->buf[0] = (uint8_t)ba->len;
+    ba->buf[ba->len - 1] = (uint8_t)ba->len;
+  }
+
+  for (size_t i = 0; i < 16; ++i)
+    free_byte_array(live[i]);
+  return NULL;
+}
+
+// Every allocation is counted once, whatever thread made it
+static
+void test_counters(void)
+{
+  byte_array_pool_stats_t const s0 = stats_byte_array_pool();
+
+  pthread_t t[NUM_THREADS];
+  for (size_t i = 0; i < NUM_THREADS; ++i) {
+    int const rc = pthread_create(&t[i], NULL, stress, (void*)(uintptr_t)(i + 1));
+    assert(rc == 0);
+  }
+  for (size_t i = 0; i < NUM_THREADS; ++i) {
+    int const rc = pthread_join(t[i], NULL);
+    assert(rc == 0);
+  }
+
+  byte_array_pool_stats_t const d = delta(s0, stats_byte_array_pool());
+  assert(d.hit + d.miss + d.fallback == NUM_THREADS * NUM_OPS);
+  assert(d.fallback > 0);
+  assert(d.trim == 0);
+}
+
+int main()
+{
+  test_thread_cache();
+  test_trim();
+  test_depot(1000);
+  test_depot(BYTE_ARRAY_POOL_MAX_SZ);
+  test_counters();
+
+  printf("Byte array pool test succeeded\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,431 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Rows per second that the xApp DB writes into the MAC_UE, the
+ * KPM_MeasRecord and the RC tables. One transaction per indication, i.e.,
+ * the writer before batching, versus the indications committed in batches.
+ */
+
+#include "../../src/xApp/db/sqlite3/sqlite3_wrapper.h"
+#include "../../src/util/time_now_us.h"
+#include "../../src/sm/rc_sm/ie/ir/ran_param_struct.h"
+#include "../../src/sm/rc_sm/ie/ir/ran_param_list.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NUM_IND 2048
+
+static
+char const db_filename[] = "/tmp/bench_db_sqlite3";
+
+static
+void rm_db(void)
+{
+  char const* suffix[] = {"", "-wal", "-shm"};
+  for(size_t i = 0; i < sizeof(suffix)/sizeof(suffix[0]); ++i){
+    char f[128] = {0};
+    snprintf(f, sizeof(f), "%s%s", db_filename, suffix[i]);
+    unlink(f);
+  }
+}
+
+// Values within the CHECK constraints of the table
+static
+void fill_ue(mac_ue_stats_impl_t* ue, uint32_t rnti)
+{
+  memset(ue, 0, sizeof(*ue));
+  ue->frame = 100;
+  ue->slot = 10;
+  ue->dl_aggr_tbs = 1 << 20;
+  ue->ul_aggr_tbs = 1 << 18;
+  ue->pusch_snr = 20.0;
+  ue->pucch_snr = 20.0;
+  ue->rnti = rnti;
+  ue->wb_cqi = 15;
+  ue->dl_mcs1 = 28;
+  ue->ul_mcs1 = 20;
+  ue->dl_num_harq = 4;
+  ue->ul_num_harq = 4;
+  ue->phr = 20;
+  ue->bsr = 1024;
+  ue->dl_bler = 0.1;
+  ue->ul_bler = 0.1;
+}
+
+static
+size_t count_rows(char const* table)
+{
+  sqlite3* db = NULL;
+  int rc = sqlite3_open(db_filename, &db);
+  assert(rc == SQLITE_OK);
+
+  char sql[256] = {0};
+  int const len = snprintf(sql, sizeof(sql), "SELECT count(*) FROM %s;", table);
+  assert(len > 0 && (size_t)len < sizeof(sql));
+
+  sqlite3_stmt* stmt = NULL;
+  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  assert(rc == SQLITE_OK);
+  rc = sqlite3_step(stmt);
+  assert(rc == SQLITE_ROW);
+  size_t const n = sqlite3_column_int64(stmt, 0);
+
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  return n;
+}
+
+static
+double rows_per_sec(size_t num_ues, size_t batch)
+{
+  mac_ue_stats_impl_t* ue = calloc(num_ues, sizeof(mac_ue_stats_impl_t));
+  assert(ue != NULL);
+  for(size_t i = 0; i < num_ues; ++i)
+    fill_ue(&ue[i], i + 1);
+
+  global_e2_node_id_t id = {.type = ngran_gNB, .plmn = {.mcc = 208, .mnc = 95, .mnc_digit_len = 2}};
+  id.nb_id.nb_id = 1;
+
+  sm_ag_if_rd_t rd = {.type = INDICATION_MSG_AGENT_IF_ANS_V0};
+  rd.ind.type = MAC_STATS_V0;
+  rd.ind.mac.msg.len_ue_stats = num_ues;
+  rd.ind.mac.msg.ue_stats = ue;
+
+  rm_db();
+  db_sqlite3_t db = {0};
+  init_db_sqlite3(&db, db_filename);
+
+  int64_t const t0 = time_now_us();
+  for(size_t i = 0; i < NUM_IND; ++i){
+    rd.ind.mac.msg.tstamp = time_now_us();
+    write_db_sqlite3(&db, &id, &rd);
+    if((i + 1) % batch == 0)
+      commit_db_sqlite3(&db);
+  }
+  commit_db_sqlite3(&db);
+  int64_t const us = time_now_us() - t0;
+
+  close_db_sqlite3(&db);
+  assert(count_rows("MAC_UE") == NUM_IND * num_ues && "Rows lost");
+  rm_db();
+  free(ue);
+
+  return (double)(NUM_IND * num_ues) * 1000000.0 / us;
+}
+
+static
+char const* meas_name[] = {"DRB.PdcpSduVolumeDL", "DRB.PdcpSduVolumeUL", "DRB.RlcSduDelayDl", "DRB.UEThpDl"};
+
+#define NUM_MEAS (sizeof(meas_name)/sizeof(meas_name[0]))
+
+// Format 3, one period of NUM_MEAS records per UE
+static
+double kpm_rows_per_sec(size_t num_ues, size_t batch)
+{
+  meas_info_format_1_lst_t info[NUM_MEAS] = {0};
+  meas_record_lst_t rec[NUM_MEAS] = {0};
+  for(size_t i = 0; i < NUM_MEAS; ++i){
+    info[i].meas_type.type = NAME_MEAS_TYPE;
+    info[i].meas_type.name.buf = (uint8_t*)meas_name[i];
+    info[i].meas_type.name.len = strlen(meas_name[i]);
+    rec[i].value = i % 2 == 0 ? INTEGER_MEAS_VALUE : REAL_MEAS_VALUE;
+    if(rec[i].value == INTEGER_MEAS_VALUE)
+      rec[i].int_val = 1000 * i;
+    else
+      rec[i].real_val = 0.5 * i;
+  }
+  meas_data_lst_t data = {.meas_record_len = NUM_MEAS, .meas_record_lst = rec};
+
+  meas_report_per_ue_t* ue = calloc(num_ues, sizeof(meas_report_per_ue_t));
+  assert(ue != NULL);
+  for(size_t i = 0; i < num_ues; ++i){
+    ue[i].ue_meas_report_lst.type = GNB_DU_UE_ID_E2SM;
+    ue[i].ue_meas_report_lst.gnb_du.gnb_cu_ue_f1ap = i;
+    ue[i].ind_msg_format_1.meas_data_lst_len = 1;
+    ue[i].ind_msg_format_1.meas_data_lst = &data;
+    ue[i].ind_msg_format_1.meas_info_lst_len = NUM_MEAS;
+    ue[i].ind_msg_format_1.meas_info_lst = info;
+  }
+
+  global_e2_node_id_t id = {.type = ngran_gNB_DU, .plmn = {.mcc = 208, .mnc = 95, .mnc_digit_len = 2}};
+  id.nb_id.nb_id = 1;
+
+  sm_ag_if_rd_t rd = {.type = INDICATION_MSG_AGENT_IF_ANS_V0};
+  rd.ind.type = KPM_STATS_V3_0;
+  rd.ind.kpm.ind.hdr.type = FORMAT_1_INDICATION_HEADER;
+  rd.ind.kpm.ind.msg.type = FORMAT_3_INDICATION_MESSAGE;
+  rd.ind.kpm.ind.msg.frm_3.ue_meas_report_lst_len = num_ues;
+  rd.ind.kpm.ind.msg.frm_3.meas_report_per_ue = ue;
+
+  rm_db();
+  db_sqlite3_t db = {0};
+  init_db_sqlite3(&db, db_filename);
+
+  int64_t const t0 = time_now_us();
+  for(size_t i = 0; i < NUM_IND; ++i){
+    rd.ind.kpm.ind.hdr.kpm_ric_ind_hdr_format_1.collectStartTime = time_now_us() / 1000000;
+    write_db_sqlite3(&db, &id, &rd);
+    if((i + 1) % batch == 0)
+      commit_db_sqlite3(&db);
+  }
+  commit_db_sqlite3(&db);
+  int64_t const us = time_now_us() - t0;
+
+  close_db_sqlite3(&db);
+  assert(count_rows("KPM_MeasRecord") == NUM_IND * num_ues * NUM_MEAS && "Rows lost");
+  assert(count_rows("KPM_UE") == NUM_IND * num_ues && "Rows lost");
+  assert(count_rows("KPM_MeasRecord WHERE ue IS NULL OR meas IS NULL") == 0 && "Records without UE or measurement");
+  assert(count_rows("KPM_MeasType") == NUM_MEAS && "Measurement names not deduplicated");
+  rm_db();
+  free(ue);
+
+  return (double)(NUM_IND * num_ues * NUM_MEAS) * 1000000.0 / us;
+}
+
+// RAN parameters of the RC formats 1, 2 and 5:
+// 1 INTEGER
+// 2 STRUCTURE
+//   21 REAL
+//   22 LIST of 2 STRUCTUREs
+//      221 PRINTABLESTRING
+#define NUM_RC_PARAM 6
+
+// Items of the LIST 22
+#define NUM_RC_LST 2
+
+static
+char rc_str[] = "rc_bench";
+
+static
+ran_parameter_value_t rc_int = {.type = INTEGER_RAN_PARAMETER_VALUE, .int_ran = 42};
+
+static
+ran_parameter_value_t rc_real = {.type = REAL_RAN_PARAMETER_VALUE, .real_ran = 0.5};
+
+static
+ran_parameter_value_t rc_printable = {.type = PRINTABLESTRING_RAN_PARAMETER_VALUE,
+                                      .printable_str_ran = {.len = sizeof(rc_str) - 1, .buf = (uint8_t*)rc_str}};
+
+static
+seq_ran_param_t rc_item_param = {.ran_param_id = 221,
+                                 .ran_param_val = {.type = ELEMENT_KEY_FLAG_FALSE_RAN_PARAMETER_VAL_TYPE, .flag_false = &rc_printable}};
+
+static
+lst_ran_param_t rc_lst_item[NUM_RC_LST] = {
+  {.ran_param_struct = {.sz_ran_param_struct = 1, .ran_param_struct = &rc_item_param}},
+  {.ran_param_struct = {.sz_ran_param_struct = 1, .ran_param_struct = &rc_item_param}},
+};
+
+static
+ran_param_list_t rc_lst = {.sz_lst_ran_param = NUM_RC_LST, .lst_ran_param = rc_lst_item};
+
+static
+seq_ran_param_t rc_member[2] = {
+  {.ran_param_id = 21, .ran_param_val = {.type = ELEMENT_KEY_FLAG_TRUE_RAN_PARAMETER_VAL_TYPE, .flag_true = &rc_real}},
+  {.ran_param_id = 22, .ran_param_val = {.type = LIST_RAN_PARAMETER_VAL_TYPE, .lst = &rc_lst}},
+};
+
+static
+ran_param_struct_t rc_strct = {.sz_ran_param_struct = 2, .ran_param_struct = rc_member};
+
+static
+seq_ran_param_t rc_param[2] = {
+  {.ran_param_id = 1, .ran_param_val = {.type = ELEMENT_KEY_FLAG_FALSE_RAN_PARAMETER_VAL_TYPE, .flag_false = &rc_int}},
+  {.ran_param_id = 2, .ran_param_val = {.type = STRUCTURE_RAN_PARAMETER_VAL_TYPE, .strct = &rc_strct}},
+};
+
+// Rows expected in the RC tables
+typedef struct{
+  size_t ind;
+  size_t ue;
+  size_t hdr_ue;
+  size_t cell;
+  size_t param;
+  size_t ue_param;
+} rc_rows_t;
+
+// The message formats 1 to 5 in turn, with num_ues UEs or cells in the
+// formats 2, 3 and 4
+static
+double rc_rows_per_sec(size_t num_ues, size_t batch)
+{
+  uint64_t ran_ue_id = 7;
+  uint16_t ev_trigger_id = 3;
+  bool cell_del = false;
+  uint8_t ctx[] = {0xCA, 0xFE};
+  byte_array_t ctx_info = {.len = sizeof(ctx), .buf = ctx};
+
+  ue_id_e2sm_t hdr_ue = {.type = GNB_DU_UE_ID_E2SM};
+  hdr_ue.gnb_du.gnb_cu_ue_f1ap = 1;
+  hdr_ue.gnb_du.ran_ue_id = &ran_ue_id;
+
+  cell_global_id_t cell = {.type = NR_CGI_RAT_TYPE};
+  cell.nr_cgi.plmn_id = (e2sm_plmn_t){.mcc = 208, .mnc = 95, .mnc_digit_len = 2};
+  cell.nr_cgi.nr_cell_id = 12345;
+
+  seq_ue_id_t* ue_param = calloc(num_ues, sizeof(seq_ue_id_t));
+  seq_cell_info_t* cell_info = calloc(num_ues, sizeof(seq_cell_info_t));
+  seq_ue_info_t* ue_info = calloc(num_ues, sizeof(seq_ue_info_t));
+  seq_cell_info_2_t* cell_info_2 = calloc(num_ues, sizeof(seq_cell_info_2_t));
+  assert(ue_param != NULL && cell_info != NULL && ue_info != NULL && cell_info_2 != NULL);
+
+  for(size_t i = 0; i < num_ues; ++i){
+    ue_id_e2sm_t ue = {.type = GNB_DU_UE_ID_E2SM};
+    ue.gnb_du.gnb_cu_ue_f1ap = i + 2;
+
+    ue_param[i] = (seq_ue_id_t){.ue_id = ue, .sz_seq_ran_param = 2, .seq_ran_param = rc_param};
+    cell_info[i] = (seq_cell_info_t){.cell_global_id = cell, .cell_ctx_info = &ctx_info, .cell_del = &cell_del};
+    ue_info[i] = (seq_ue_info_t){.ue_id = ue, .ue_ctx_info = &ctx_info, .cell_global_id = cell};
+    cell_info_2[i] = (seq_cell_info_2_t){.cell_global_id = cell, .cell_ctx_info = &ctx_info};
+  }
+
+  global_e2_node_id_t id = {.type = ngran_gNB, .plmn = {.mcc = 208, .mnc = 95, .mnc_digit_len = 2}};
+  id.nb_id.nb_id = 1;
+
+  sm_ag_if_rd_t rd = {.type = INDICATION_MSG_AGENT_IF_ANS_V0};
+  rd.ind.type = RAN_CTRL_STATS_V1_03;
+  rd.ind.rc.ric_id = 5;
+  e2sm_rc_ind_hdr_t* hdr = &rd.ind.rc.ind.hdr;
+  e2sm_rc_ind_msg_t* msg = &rd.ind.rc.ind.msg;
+
+  rc_rows_t exp = {0};
+
+  rm_db();
+  db_sqlite3_t db = {0};
+  init_db_sqlite3(&db, db_filename);
+
+  int64_t const t0 = time_now_us();
+  for(size_t i = 0; i < NUM_IND; ++i){
+    memset(hdr, 0, sizeof(*hdr));
+    memset(msg, 0, sizeof(*msg));
+    msg->format = FORMAT_1_E2SM_RC_IND_MSG + i % 5;
+
+    if(msg->format == FORMAT_1_E2SM_RC_IND_MSG){
+      hdr->format = FORMAT_1_E2SM_RC_IND_HDR;
+      hdr->frmt_1.ev_trigger_id = &ev_trigger_id;
+      msg->frmt_1 = (e2sm_rc_ind_msg_frmt_1_t){.sz_seq_ran_param = 2, .seq_ran_param = rc_param};
+      exp.param += NUM_RC_PARAM;
+    } else if(msg->format == FORMAT_2_E2SM_RC_IND_MSG){
+      hdr->format = FORMAT_2_E2SM_RC_IND_HDR;
+      hdr->frmt_2 = (e2sm_rc_ind_hdr_frmt_2_t){.ue_id = hdr_ue, .ric_style_type = 2, .ins_ind_id = 1};
+      msg->frmt_2 = (e2sm_rc_ind_msg_frmt_2_t){.sz_seq_ue_id = num_ues, .seq_ue_id = ue_param};
+      exp.hdr_ue += 1;
+      exp.ue += 1 + num_ues;
+      exp.param += NUM_RC_PARAM * num_ues;
+      exp.ue_param += NUM_RC_PARAM * num_ues;
+    } else if(msg->format == FORMAT_3_E2SM_RC_IND_MSG){
+      hdr->format = FORMAT_3_E2SM_RC_IND_HDR;
+      msg->frmt_3 = (e2sm_rc_ind_msg_frmt_3_t){.sz_seq_cell_info = num_ues, .seq_cell_info = cell_info};
+      exp.cell += num_ues;
+    } else if(msg->format == FORMAT_4_E2SM_RC_IND_MSG){
+      hdr->format = FORMAT_1_E2SM_RC_IND_HDR;
+      msg->frmt_4 = (e2sm_rc_ind_msg_frmt_4_t){.sz_seq_ue_info = num_ues, .seq_ue_info = ue_info,
+                                               .sz_seq_cell_info_2 = num_ues, .seq_cell_info_2 = cell_info_2};
+      exp.ue += num_ues;
+      exp.cell += num_ues;
+    } else {
+      hdr->format = FORMAT_3_E2SM_RC_IND_HDR;
+      hdr->frmt_3.ue_id = &hdr_ue;
+      msg->frmt_5 = (e2sm_rc_ind_msg_frmt_5_t){.sz_seq_ran_param = 2, .seq_ran_param = rc_param};
+      exp.hdr_ue += 1;
+      exp.ue += 1;
+      exp.param += NUM_RC_PARAM;
+    }
+    exp.ind += 1;
+
+    write_db_sqlite3(&db, &id, &rd);
+    if((i + 1) % batch == 0)
+      commit_db_sqlite3(&db);
+  }
+  commit_db_sqlite3(&db);
+  int64_t const us = time_now_us() - t0;
+
+  close_db_sqlite3(&db);
+  assert(count_rows("RC_Ind") == exp.ind && "Rows lost");
+  assert(count_rows("RC_UE") == exp.ue && "Rows lost");
+  assert(count_rows("RC_UE WHERE hdr == 1") == exp.hdr_ue && "Header UEs");
+  assert(count_rows("RC_Cell") == exp.cell && "Rows lost");
+  assert(count_rows("RC_RanParam") == exp.param && "Rows lost");
+  assert(count_rows("RC_RanParam WHERE ue IS NOT NULL") == exp.ue_param && "RAN parameters without their UE");
+  assert(count_rows("RC_RanParam p JOIN RC_UE u ON p.ue = u.id WHERE p.ind != u.ind OR u.hdr != 0") == 0 && "RAN parameters of another UE");
+  for(size_t f = 1; f < 6; ++f){
+    char where[64] = {0};
+    snprintf(where, sizeof(where), "RC_Ind WHERE msg_format == %zu", f);
+    assert(count_rows(where) == NUM_IND / 5 + (f <= NUM_IND % 5) && "Message format");
+  }
+
+  // Links of the tree. The sequence, i.e., 1 and 2, has no parent
+  size_t const num_seq = exp.param / NUM_RC_PARAM;
+  assert(count_rows("RC_RanParam WHERE parent IS NULL") == 2 * num_seq && "Parent links");
+  assert(count_rows("RC_RanParam WHERE parent IS NULL AND ran_param_id NOT IN (1, 2)") == 0 && "Parent links");
+  // Members of the STRUCTURE 2
+  assert(count_rows("RC_RanParam c JOIN RC_RanParam p ON c.parent = p.id "
+                    "WHERE p.ran_param_id == 2 AND p.val_type == 2 AND c.ran_param_id IN (21, 22) AND c.lst_idx IS NULL") == 2 * num_seq
+         && "STRUCTURE members");
+  // Items of the LIST 22
+  assert(count_rows("RC_RanParam c JOIN RC_RanParam p ON c.parent = p.id "
+                    "WHERE p.ran_param_id == 22 AND p.val_type == 3 AND c.ran_param_id == 221 AND c.lst_idx IN (0, 1)") == NUM_RC_LST * num_seq
+         && "LIST items");
+  assert(count_rows("RC_RanParam WHERE lst_idx == 1") == num_seq && "LIST index");
+  // A parent belongs to the same indication and UE
+  assert(count_rows("RC_RanParam c JOIN RC_RanParam p ON c.parent = p.id WHERE c.ind != p.ind OR c.ue IS NOT p.ue") == 0
+         && "Parent of another indication or UE");
+  assert(count_rows("RC_RanParam WHERE ran_param_id == 221 AND str_val == 'rc_bench'") == NUM_RC_LST * num_seq && "Values");
+
+  rm_db();
+  free(ue_param);
+  free(cell_info);
+  free(ue_info);
+  free(cell_info_2);
+
+  return (double)(exp.ind + exp.ue + exp.cell + exp.param) * 1000000.0 / us;
+}
+
+int main()
+{
+  size_t const ues[] = {2, 32};
+  size_t const batch[] = {1, 64};
+
+  for(size_t i = 0; i < sizeof(ues)/sizeof(ues[0]); ++i){
+    for(size_t j = 0; j < sizeof(batch)/sizeof(batch[0]); ++j){
+      printf("MAC UEs/ind %3zu indications/transaction %3zu rows/s %10.0f\n", ues[i], batch[j], rows_per_sec(ues[i], batch[j]));
+    }
+  }
+
+  for(size_t i = 0; i < sizeof(ues)/sizeof(ues[0]); ++i){
+    for(size_t j = 0; j < sizeof(batch)/sizeof(batch[0]); ++j){
+      printf("KPM UEs/ind %3zu indications/transaction %3zu rows/s %10.0f\n", ues[i], batch[j], kpm_rows_per_sec(ues[i], batch[j]));
+    }
+  }
+
+  for(size_t i = 0; i < sizeof(ues)/sizeof(ues[0]); ++i){
+    for(size_t j = 0; j < sizeof(batch)/sizeof(batch[0]); ++j){
+      printf("RC  UEs/ind %3zu indications/transaction %3zu rows/s %10.0f\n", ues[i], batch[j], rc_rows_per_sec(ues[i], batch[j]));
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,417 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+// Indication dispatcher of the xApp: the three overflow policies of a full
+// subscription queue, the indications of unknown and removed
+// subscriptions, the worker pool and the statistics. Every indication
+// reference handed to send_msg_dispatcher is released exactly once
+
+#include "../../src/xApp/msg_dispatcher_xapp.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SEQ 1024
+#define MAX_SUBS 16
+
+// rd first, so the callback finds the rest
+typedef struct{
+  ind_shared_xapp_t ind;
+  uint16_t sub;
+  uint32_t seq;
+  // The callback waits for the gate
+  bool block;
+} test_ind_t;
+
+static atomic_size_t released[MAX_SUBS][MAX_SEQ];
+
+// The dispatcher takes the indications over. Instead of the one from
+// ind_shared_xapp.c, that would pull all the SMs in
+void release_ind_shared_xapp(ind_shared_xapp_t* s)
+{
+  assert(s != NULL);
+  if(atomic_fetch_sub(&s->refs, 1) > 1)
+    return;
+
+  test_ind_t* t = (test_ind_t*)s;
+  size_t const prev = atomic_fetch_add(&released[t->sub][t->seq], 1);
+  assert(prev == 0 && "Indication released twice");
+  free(t);
+}
+
+static atomic_bool gate_open;
+static atomic_size_t gate_started;
+
+// Delivered sequence numbers per subscription, in callback order. A
+// subscription is served by one worker at a time
+static uint32_t delivered[MAX_SUBS][MAX_SEQ];
+static atomic_size_t len_delivered[MAX_SUBS];
+
+static atomic_int in_cb;
+static atomic_int max_in_cb;
+
+static
+void reset(void)
+{
+  memset(released, 0, sizeof(released));
+  memset(delivered, 0, sizeof(delivered));
+  memset(len_delivered, 0, sizeof(len_delivered));
+  atomic_store(&gate_open, false);
+  atomic_store(&gate_started, 0);
+  atomic_store(&in_cb, 0);
+  atomic_store(&max_in_cb, 0);
+}
+
+static
+void deliver(sm_ag_if_rd_t const* rd, useconds_t us)
+{
+  test_ind_t const* t = (test_ind_t const*)rd;
+
+  int const n = atomic_fetch_add(&in_cb, 1) + 1;
+  int m = atomic_load(&max_in_cb);
+  while(n > m && atomic_compare_exchange_weak(&max_in_cb, &m, n) == false)
+    ;
+
+  if(us > 0)
+    usleep(us);
+
+  if(t->block == true){
+    atomic_fetch_add(&gate_started, 1);
+    while(atomic_load(&gate_open) == false)
+      usleep(100);
+  }
+
+  size_t const idx = atomic_load(&len_delivered[t->sub]);
+  delivered[t->sub][idx] = t->seq;
+  atomic_fetch_sub(&in_cb, 1);
+  atomic_store(&len_delivered[t->sub], idx + 1);
+}
+
+static
+void cb(sm_ag_if_rd_t const* rd)
+{
+  deliver(rd, 0);
+}
+
+static
+void slow_cb(sm_ag_if_rd_t const* rd)
+{
+  deliver(rd, 1000);
+}
+
+static
+void send(msg_dispatcher_xapp_t* d, uint16_t sub, uint32_t seq, bool block, void (*f)(sm_ag_if_rd_t const*))
+{
+  assert(sub < MAX_SUBS && seq < MAX_SEQ);
+
+  test_ind_t* t = calloc(1, sizeof(test_ind_t));
+  assert(t != NULL);
+  t->ind.rd.type = INDICATION_MSG_AGENT_IF_ANS_V0;
+  atomic_init(&t->ind.refs, 1);
+  t->sub = sub;
+  t->seq = seq;
+  t->block = block;
+
+  msg_dispatch_t msg = {.ind = &t->ind, .sm_cb = f, .ric_req_id = sub};
+  send_msg_dispatcher(d, &msg);
+}
+
+static
+void wait_len(atomic_size_t* val, size_t target)
+{
+  for(int i = 0; atomic_load(val) != target; ++i){
+    assert(i < 100000 && "Indications not delivered");
+    usleep(100);
+  }
+}
+
+static
+disp_stats_xapp_t wait_done(msg_dispatcher_xapp_t* d, uint64_t done)
+{
+  for(int i = 0; i < 100000; ++i){
+    disp_stats_xapp_t const st = stats_msg_dispatcher(d);
+    if(st.done == done)
+      return st;
+    usleep(100);
+  }
+  assert(0 != 0 && "Callbacks not accounted");
+  return (disp_stats_xapp_t){0};
+}
+
+static
+uint64_t sum_hist(uint64_t const hist[DISP_HIST_LEN])
+{
+  uint64_t sum = 0;
+  for(size_t i = 0; i < DISP_HIST_LEN; ++i)
+    sum += hist[i];
+  return sum;
+}
+
+static
+void check_delivered(uint16_t sub, size_t len, uint32_t const seq[len])
+{
+  assert(atomic_load(&len_delivered[sub]) == len);
+  for(size_t i = 0; i < len; ++i)
+    assert(delivered[sub][i] == seq[i] && "Unexpected indication delivered");
+}
+
+static
+void check_released(uint16_t sub, uint32_t num)
+{
+  for(uint32_t i = 0; i < num; ++i)
+    assert(atomic_load(&released[sub][i]) == 1 && "Indication not released");
+}
+
+// The callback of seq 0 waits on the gate, while seq 1..10 arrive on a
+// queue of 4
+static
+void test_drop(disp_overflow_e overflow, size_t len, uint32_t const exp[len])
+{
+  reset();
+
+  msg_dispatcher_xapp_t d = {0};
+  init_msg_dispatcher(&d, (disp_conf_xapp_t){.cap = 4, .overflow = overflow, .workers = 1});
+  add_sub_msg_dispatcher(&d, 1);
+
+  send(&d, 1, 0, true, cb);
+  wait_len(&gate_started, 1);
+  for(uint32_t seq = 1; seq <= 10; ++seq)
+    send(&d, 1, seq, false, cb);
+
+  disp_stats_xapp_t st = stats_msg_dispatcher(&d);
+  assert(st.enq == 11 && st.drop == 6 && st.depth == 4 && st.max_depth == 4);
+
+  atomic_store(&gate_open, true);
+  wait_len(&len_delivered[1], len);
+  check_delivered(1, len, exp);
+
+  st = wait_done(&d, len);
+  assert(st.enq == 11 && st.drop == 6 && st.depth == 0 && st.max_depth == 4);
+  assert(sum_hist(st.wait_us) == len && sum_hist(st.cb_us) == len);
+
+  disp_stats_xapp_t sub = {0};
+  bool const ok = stats_sub_msg_dispatcher(&d, 1, &sub);
+  assert(ok);
+  assert(sub.enq == 11 && sub.done == len && sub.drop == 6 && sub.depth == 0 && sub.max_depth == 4);
+
+  free_msg_dispatcher(&d);
+  check_released(1, 11);
+}
+
+static
+void test_drop_oldest(void)
+{
+  uint32_t const exp[] = {0, 7, 8, 9, 10};
+  test_drop(DISP_OVERFLOW_DROP_OLDEST, 5, exp);
+}
+
+static
+void test_keep_latest(void)
+{
+  uint32_t const exp[] = {0, 1, 2, 3, 10};
+  test_drop(DISP_OVERFLOW_KEEP_LATEST, 5, exp);
+}
+
+typedef struct{
+  msg_dispatcher_xapp_t* d;
+  atomic_size_t sent;
+} sender_t;
+
+static
+void* block_sender(void* arg)
+{
+  sender_t* s = (sender_t*)arg;
+  for(uint32_t seq = 1; seq <= 10; ++seq){
+    send(s->d, 1, seq, false, cb);
+    atomic_fetch_add(&s->sent, 1);
+  }
+  return NULL;
+}
+
+// The sender waits for room, and nothing is lost
+static
+void test_block(void)
+{
+  reset();
+
+  msg_dispatcher_xapp_t d = {0};
+  init_msg_dispatcher(&d, (disp_conf_xapp_t){.cap = 2, .overflow = DISP_OVERFLOW_BLOCK, .workers = 1});
+  add_sub_msg_dispatcher(&d, 1);
+
+  send(&d, 1, 0, true, cb);
+  wait_len(&gate_started, 1);
+
+  sender_t s = {.d = &d};
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, block_sender, &s);
+  assert(rc == 0);
+
+  wait_len(&s.sent, 2);
+  usleep(50*1000);
+  assert(atomic_load(&s.sent) == 2 && "Sender not blocked on a full queue");
+  assert(stats_msg_dispatcher(&d).depth == 2);
+
+  atomic_store(&gate_open, true);
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  wait_len(&len_delivered[1], 11);
+  uint32_t exp[11];
+  for(uint32_t i = 0; i < 11; ++i)
+    exp[i] = i;
+  check_delivered(1, 11, exp);
+
+  disp_stats_xapp_t const st = wait_done(&d, 11);
+  assert(st.enq == 11 && st.drop == 0 && st.depth == 0 && st.max_depth == 2);
+
+  free_msg_dispatcher(&d);
+  check_released(1, 11);
+}
+
+// The queued indications of a removed subscription are still delivered.
+// The ones after it, or for a subscription never added, are dropped and
+// do not bring it back
+static
+void test_rm_sub(void)
+{
+  reset();
+
+  msg_dispatcher_xapp_t d = {0};
+  init_msg_dispatcher(&d, (disp_conf_xapp_t){.cap = 8, .overflow = DISP_OVERFLOW_DROP_OLDEST, .workers = 1});
+  add_sub_msg_dispatcher(&d, 1);
+
+  send(&d, 2, 0, false, cb);
+  disp_stats_xapp_t st = {0};
+  assert(stats_sub_msg_dispatcher(&d, 2, &st) == false);
+
+  send(&d, 1, 0, true, cb);
+  wait_len(&gate_started, 1);
+  send(&d, 1, 1, false, cb);
+  send(&d, 1, 2, false, cb);
+  rm_sub_msg_dispatcher(&d, 1);
+  send(&d, 1, 3, false, cb);
+  assert(stats_sub_msg_dispatcher(&d, 1, &st) == false);
+
+  atomic_store(&gate_open, true);
+  wait_len(&len_delivered[1], 3);
+  st = wait_done(&d, 3);
+
+  // Drained, and hence erased
+  send(&d, 1, 4, false, cb);
+  assert(stats_sub_msg_dispatcher(&d, 1, &st) == false);
+
+  // Subscribed again
+  add_sub_msg_dispatcher(&d, 1);
+  send(&d, 1, 5, false, cb);
+  wait_len(&len_delivered[1], 4);
+  uint32_t const exp[] = {0, 1, 2, 5};
+  check_delivered(1, 4, exp);
+  assert(atomic_load(&len_delivered[2]) == 0);
+
+  st = wait_done(&d, 4);
+  assert(st.enq == 4 && st.drop == 3);
+  bool const ok = stats_sub_msg_dispatcher(&d, 1, &st);
+  assert(ok && st.enq == 1 && st.done == 1 && st.drop == 0);
+
+  free_msg_dispatcher(&d);
+  check_released(1, 6);
+  check_released(2, 1);
+}
+
+#define NUM_POOL_SUBS 8
+#define NUM_POOL_IND 100
+
+static
+void* pool_sender(void* arg)
+{
+  msg_dispatcher_xapp_t* d = (msg_dispatcher_xapp_t*)arg;
+  for(uint32_t seq = 0; seq < NUM_POOL_IND; ++seq){
+    for(uint16_t sub = 0; sub < NUM_POOL_SUBS; ++sub)
+      send(d, sub, seq, false, slow_cb);
+  }
+  return NULL;
+}
+
+// The subscriptions spread over the workers. Every one in order, and the
+// callbacks of different workers overlap
+static
+void test_pool(void)
+{
+  reset();
+
+  msg_dispatcher_xapp_t d = {0};
+  init_msg_dispatcher(&d, (disp_conf_xapp_t){.cap = NUM_POOL_IND, .overflow = DISP_OVERFLOW_BLOCK, .workers = 4});
+  for(uint16_t sub = 0; sub < NUM_POOL_SUBS; ++sub)
+    add_sub_msg_dispatcher(&d, sub);
+
+  pthread_t t;
+  int rc = pthread_create(&t, NULL, pool_sender, &d);
+  assert(rc == 0);
+  rc = pthread_join(t, NULL);
+  assert(rc == 0);
+
+  uint32_t exp[NUM_POOL_IND];
+  for(uint32_t i = 0; i < NUM_POOL_IND; ++i)
+    exp[i] = i;
+  for(uint16_t sub = 0; sub < NUM_POOL_SUBS; ++sub){
+    wait_len(&len_delivered[sub], NUM_POOL_IND);
+    check_delivered(sub, NUM_POOL_IND, exp);
+  }
+  assert(atomic_load(&max_in_cb) > 1 && "Workers not concurrent");
+
+  uint64_t const total = NUM_POOL_SUBS*NUM_POOL_IND;
+  disp_stats_xapp_t const st = wait_done(&d, total);
+  assert(st.enq == total && st.drop == 0 && st.depth == 0);
+  assert(sum_hist(st.wait_us) == total && sum_hist(st.cb_us) == total);
+  // The callbacks take at least 1 ms, i.e., [512, 1024) us or above
+  for(size_t i = 0; i < 10; ++i)
+    assert(st.cb_us[i] == 0);
+
+  for(uint16_t sub = 0; sub < NUM_POOL_SUBS; ++sub){
+    disp_stats_xapp_t s = {0};
+    bool const ok = stats_sub_msg_dispatcher(&d, sub, &s);
+    assert(ok);
+    assert(s.enq == NUM_POOL_IND && s.done == NUM_POOL_IND && s.drop == 0);
+    assert(sum_hist(s.wait_us) == NUM_POOL_IND && sum_hist(s.cb_us) == NUM_POOL_IND);
+  }
+
+  free_msg_dispatcher(&d);
+  for(uint16_t sub = 0; sub < NUM_POOL_SUBS; ++sub)
+    check_released(sub, NUM_POOL_IND);
+}
+
+int main()
+{
+  test_drop_oldest();
+  test_keep_latest();
+  test_block();
+  test_rm_sub();
+  test_pool();
+
+  printf("Message dispatcher test succeeded\n");
+  return EXIT_SUCCESS;
+}